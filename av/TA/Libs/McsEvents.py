@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# Copyright 2024 Sophos Limited. All rights reserved.
+
+import os
+
+SPOOL_SUFFIX = ".spool"
+EVENT_FILE_SEPARATOR = "_event-"
+
+
+def read_mcs_events(event_dir):
+    """
+    Returns (appId, path, ctime, event xml) for every event waiting for mcsrouter, including each event in a
+    spool file written by Management Agent
+    """
+    events = []
+    for f in sorted(os.listdir(event_dir)):
+        path = os.path.join(event_dir, f)
+        try:
+            ctime = os.path.getctime(path)
+            if not f.endswith(SPOOL_SUFFIX):
+                with open(path) as event_file:
+                    events.append((f.split(EVENT_FILE_SEPARATOR)[0], path, ctime, event_file.read()))
+                continue
+
+            with open(path, "rb") as spool_file:
+                spool = spool_file.read()
+        except FileNotFoundError:
+            # mcsrouter has sent it since the directory was listed
+            continue
+
+        offset = 0
+        while offset < len(spool):
+            header_end = spool.index(b"\n", offset)
+            app_id, length = spool[offset:header_end].split(b" ")
+            body_start = header_end + 1
+            body_end = body_start + int(length)
+            events.append((app_id.decode("utf-8"), path, ctime, spool[body_start:body_end].decode("utf-8")))
+            offset = body_end + 1
+    return events
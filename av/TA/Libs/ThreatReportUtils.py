@@ -1,6 +1,6 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
-# Copyright (C) 2021-2022 Sophos Plc, Oxford, England.
+# Copyright (C) 2021-2024 Sophos Plc, Oxford, England.
 # All rights reserved.
 
 import os
@@ -19,8 +19,10 @@ except ImportError:
 
 try:
     from . import LogHandler
+    from . import McsEvents
 except ImportError:
     import LogHandler
+    import McsEvents
 
 GL_MCS_EVENTS_DIRECTORY = "/opt/sophos-spl/base/mcs/event/"
 
@@ -101,8 +103,8 @@ def find_eicars(eicar_directory):
     return ret
 
 
-def get_filepath_notification_event(p):
-    dom = xml.dom.minidom.parse(p)
+def get_filepath_notification_event(event_xml):
+    dom = xml.dom.minidom.parseString(event_xml)
     try:
         items = dom.getElementsByTagName("path")
         assert len(items) == 1
@@ -112,20 +114,15 @@ def get_filepath_notification_event(p):
         dom.unlink()
 
 
-def is_core_detection_event(event_file_path: str):
-    with open(event_file_path, 'r') as event_fle:
-        contents = event_fle.read()
-        return 'type="sophos.core.detection"' in contents
+def is_core_detection_event(event_xml: str):
+    return 'type="sophos.core.detection"' in event_xml
 
 
 def get_eicars_from_notifications_events():
-    events_list = os.listdir(GL_MCS_EVENTS_DIRECTORY)
-    events_list = list(filter(lambda event: event.startswith('CORE'), events_list))
     ret = []
-    for e in events_list:
-        path = os.path.join(GL_MCS_EVENTS_DIRECTORY, e)
-        if is_core_detection_event(path):
-            ret.append(get_filepath_notification_event(path))
+    for app_id, path, ctime, event_xml in McsEvents.read_mcs_events(GL_MCS_EVENTS_DIRECTORY):
+        if app_id == "CORE" and is_core_detection_event(event_xml):
+            ret.append(get_filepath_notification_event(event_xml))
     return ret
 
 def safe_to_unicode(s):
@@ -4,14 +4,17 @@ import time
 import grp
 import pwd
 import glob
+import tempfile
 import xml.etree.ElementTree
 
 try:
     from . import Paths
     from . import TestBase
+    from .. import McsEvents
 except ImportError:
     import Paths
     import TestBase
+    import McsEvents
 
 import logging
 logger = logging.getLogger("AVPlugin")
@@ -45,9 +48,8 @@ def _file_content(path):
     with open(path, 'r') as f:
         return f.read()
 
-def _is_event_xml(path):
-    tree = xml.etree.ElementTree.parse(path)
-    root = tree.getroot()
+def _is_event_xml(path, event_xml):
+    root = xml.etree.ElementTree.fromstring(event_xml)
     if root.tag == "event" or root.tag == "{http://www.sophos.com/EE/EESavEvent}event":
         return True
     logger.info("%s has root element: %s", path, root.tag)
@@ -152,20 +154,28 @@ class AVPlugin(TestBase.TestBase):
             after = int(after)
 
         full_path = os.path.join(_sophos_spl_path(), relative_path)
-        xml_files = glob.iglob(f'{full_path}/SAV_event-*.xml')
-        current_xml_files = [ x for x in xml_files if os.path.getctime(x) >= after ]
-        if len(current_xml_files) == 0:
-            logger.fatal("All %d XML files older than %d", len(xml_files), after)
-            raise Exception("No XML files after %d", after)
-
-        xml_files = current_xml_files
-        xml_files.sort(key=os.path.getctime, reverse=True)
-        logger.debug("Found %d XML files", len(xml_files))
-        for xml_file in xml_files:
-            if _is_event_xml(xml_file):
-                logger.debug("Found Event XML %s", xml_file)
-                return xml_file
-            else:
-                logger.info("Ignoring %s as not event XML", xml_file)
+        # Events can be in their own file or in a spool file shared with other events
+        sav_events = [e for e in McsEvents.read_mcs_events(full_path) if e[0] == "SAV"]
+        current_events = [e for e in sav_events if e[2] >= after]
+        if len(current_events) == 0:
+            logger.fatal("All %d SAV events older than %d", len(sav_events), after)
+            raise Exception("No SAV events after %d", after)
+
+        # Newest first, and the last event in a spool is the newest in it
+        current_events.reverse()
+        current_events.sort(key=lambda e: e[2], reverse=True)
+        logger.debug("Found %d SAV events", len(current_events))
+        for app_id, path, ctime, event_xml in current_events:
+            if not _is_event_xml(path, event_xml):
+                logger.info("Ignoring event in %s as not event XML", path)
+                continue
+            logger.debug("Found Event XML in %s", path)
+            if not path.endswith(McsEvents.SPOOL_SUFFIX):
+                return path
+            # Callers read the event from a file, and the spool will be removed once mcsrouter sends it
+            fd, event_path = tempfile.mkstemp(prefix="SAV_event-", suffix=".xml")
+            with os.fdopen(fd, "w") as event_file:
+                event_file.write(event_xml)
+            return event_path
         logger.fatal("No event XML found")
         raise Exception("No Event XML found")
@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "ClientSocketWrapper.h"
 #include "ReconnectSettings.h"
@@ -152,6 +152,11 @@ namespace avscanner::avscannerimpl
         }
     }
 
+    void ClientSocketWrapper::pause(duration_t pauseTime)
+    {
+        stoppableSleep(pauseTime);
+    }
+
     bool ClientSocketWrapper::stoppableSleep(common::StoppableSleeper::duration_t sleepTime)
     {
         struct pollfd fds[] {
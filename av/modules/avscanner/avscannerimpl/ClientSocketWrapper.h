@@ -1,4 +1,4 @@
-//Copyright 2022, Sophos Limited.  All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -28,6 +28,11 @@ namespace avscanner::avscannerimpl
 
         scan_messages::ScanResponse scan(scan_messages::ClientScanRequestPtr request) override;
 
+        /**
+         * Waits before the next scan, throwing if the scan is aborted while waiting
+         */
+        void pause(duration_t pauseTime);
+
     private:
         void connect();
         scan_messages::ScanResponse attemptScan(const scan_messages::ClientScanRequestPtr& request);
@@ -1,21 +1,30 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "NamedScanRunner.h"
 
 #include "BaseFileWalkCallbacks.h"
 #include "ScanCallbackImpl.h"
 #include "ScanClient.h"
+#include "ScanIndex.h"
+#include "ScanThrottle.h"
+#include "ScheduledScanSettings.h"
 
 #include "mount_monitor/mountinfoimpl/Mounts.h"
 
 #include <capnp/message.h>
 #include "common/AbortScanException.h"
+#include "common/ApplicationPaths.h"
 #include "common/StringUtils.h"
 #include "filewalker/FileWalker.h"
 
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
 #include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
 
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <set>
 
@@ -71,6 +80,58 @@ namespace avscanner::avscannerimpl
         private:
             NamedScanConfig& m_config;
         };
+
+        std::shared_ptr<ScanIndex> openScanIndex(const NamedScanConfig& config, int fullScanIntervalDays)
+        {
+            // A file that was clean with these settings may not be clean with different ones
+            std::ostringstream settings;
+            settings << "archives=" << config.m_scanArchives << " images=" << config.m_scanImages
+                     << " pua=" << config.m_detectPUAs << "\n";
+            auto* fileSystem = Common::FileSystem::fileSystem();
+            try
+            {
+                if (fileSystem->isFile(Plugin::getSusiStartupSettingsPath()))
+                {
+                    settings << fileSystem->readFile(Plugin::getSusiStartupSettingsPath());
+                }
+            }
+            catch (const Common::FileSystem::IFileSystemException& e)
+            {
+                LOGWARN("Failed to read SUSI settings, all files will be scanned: " << e.what());
+                return nullptr;
+            }
+
+            auto dataVersion = ScanIndex::dataVersion(Plugin::getSusiUpdateSourcePath(), settings.str());
+            return std::make_shared<ScanIndex>(
+                Plugin::getScanIndexPath(config.m_scanName), dataVersion, std::chrono::hours(24 * fullScanIntervalDays));
+        }
+
+        std::shared_ptr<ScanThrottle> createThrottle(const ThrottleSettings& settings)
+        {
+            auto cpus = ScanThrottle::availableCpus();
+            LOGINFO(
+                "Throttling scan: CPU limit " << settings.cpuLimitPercent << "% of " << cpus << " CPUs, IO limit "
+                                              << settings.ioBytesPerSecond / (1024 * 1024) << "MB/s, "
+                                              << settings.iopsLimit << " files/s, pressure threshold "
+                                              << settings.pressureThresholdPercent << "% (0 is unlimited)");
+            ScanThrottle::lowerProcessPriority();
+            return std::make_shared<ScanThrottle>(settings, cpus);
+        }
+
+        void writeScanStatistics(const std::string& scanName, const nlohmann::json& stats)
+        {
+            try
+            {
+                auto* fileSystem = Common::FileSystem::fileSystem();
+                fileSystem->makedirs(Plugin::getScanIndexDirPath());
+                fileSystem->writeFileAtomically(
+                    Plugin::getScheduledScanStatsPath(scanName), stats.dump(), Plugin::getScanIndexDirPath(), 0640);
+            }
+            catch (const Common::FileSystem::IFileSystemException& e)
+            {
+                LOGWARN("Failed to write scan statistics: " << e.what());
+            }
+        }
     }
 
     NamedScanRunner::NamedScanRunner(const std::string& configPath) :
@@ -157,6 +218,28 @@ namespace avscanner::avscannerimpl
             m_config.m_scanImages,
             m_config.m_detectPUAs,
             E_SCAN_TYPE_SCHEDULED);
+
+        std::shared_ptr<ScanIndex> scanIndex;
+        auto settings = readScheduledScanSettings(Plugin::getScheduledScanLocalSettingsPath());
+        if (settings.incrementalScans)
+        {
+            scanIndex = openScanIndex(m_config, settings.fullScanIntervalDays);
+            if (scanIndex)
+            {
+                LOGINFO((scanIndex->isFullScan() ? "Incremental scan is due a full scan"
+                                                 : "Skipping files unchanged since they were scanned clean"));
+                scanner->setScanIndex(scanIndex);
+            }
+        }
+
+        std::shared_ptr<ScanThrottle> throttle;
+        if (settings.throttle.enabled())
+        {
+            throttle = createThrottle(settings.throttle);
+            scanner->setThrottle(throttle);
+        }
+        auto scanStart = std::chrono::steady_clock::now();
+
         NamedScanWalkerCallbackImpl callbacks(scanner, excludedMountPoints, m_config);
 
         filewalker::FileWalker walker(callbacks);
@@ -201,6 +284,49 @@ namespace avscanner::avscannerimpl
         }
 
         m_scanCallbacks->logSummary();
+
+        nlohmann::json stats;
+        if (scanIndex)
+        {
+            auto skipped = scanIndex->filesSkipped();
+            LOGINFO(skipped << common::pluralize(static_cast<int>(skipped), " file", " files")
+                                              << " skipped as unchanged since they were scanned clean");
+            // An aborted scan hasn't seen every file, so keep the index from the last complete scan
+            if (!scanAborted)
+            {
+                try
+                {
+                    scanIndex->save();
+                }
+                catch (const std::runtime_error& e)
+                {
+                    LOGWARN("Failed to save scan index: " << e.what());
+                }
+            }
+            stats["fullScan"] = scanIndex->isFullScan();
+            stats["filesSkipped"] = skipped;
+        }
+        if (throttle)
+        {
+            using namespace std::chrono;
+            auto elapsed = duration_cast<milliseconds>(steady_clock::now() - scanStart);
+            auto throttled = duration_cast<milliseconds>(throttle->throttledTime());
+            double seconds = std::max(duration_cast<duration<double>>(elapsed).count(), 0.001);
+            LOGINFO(
+                "Scanned " << throttle->bytesScanned() / (1024 * 1024) << "MB at "
+                           << throttle->bytesScanned() / seconds / (1024 * 1024) << "MB/s and "
+                           << throttle->filesScanned() / seconds << " files/s, paused for " << throttled.count()
+                           << "ms by throttling");
+            stats["bytesScanned"] = throttle->bytesScanned();
+            stats["durationMs"] = elapsed.count();
+            stats["throttledMs"] = throttled.count();
+        }
+        if (!stats.empty() && !scanAborted)
+        {
+            stats["filesScanned"] = m_scanCallbacks->getNoOfScannedFiles();
+            writeScanStatistics(m_config.m_scanName, stats);
+        }
+
         if(scanAborted)
         {
             //we might break from the loop before we assign m_returnCode
@@ -1,4 +1,4 @@
-// Copyright 2020-2022, Sophos Limited.  All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -26,13 +26,13 @@ namespace avscanner::avscannerimpl
         common::E_ERROR_CODES returnCode();
         void scanStarted() override { m_startTime = time(nullptr); }
         void logSummary() override;
+        [[nodiscard]] int getNoOfScannedFiles() const { return m_noOfCleanFiles + m_noOfInfectedFiles; }
 
     protected:
         [[nodiscard]] time_t  getStartTime() const { return m_startTime; }
         [[nodiscard]] int getNoOfInfectedFiles() const { return m_noOfInfectedFiles; }
         [[nodiscard]] int getNoOfScanErrors() const { return m_noOfErrors; }
         [[nodiscard]] int getNoOfCleanFiles() const { return m_noOfCleanFiles; }
-        [[nodiscard]] int getNoOfScannedFiles() const { return m_noOfCleanFiles + m_noOfInfectedFiles; }
         [[nodiscard]] std::map<std::string, int> getThreatTypes() { return m_threatCounter; }
 
         void incrementInfectedFileCount() { m_noOfInfectedFiles++; }
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "ScanClient.h"
 
@@ -10,8 +10,10 @@
 #include "common/StringUtils.h"
 #include "common/ErrorCodes.h"
 
+#include <chrono>
 #include <string>
 #include <fcntl.h>
+#include <unistd.h>
 
 using namespace avscanner::avscannerimpl;
 namespace fs = sophos_filesystem;
@@ -71,6 +73,17 @@ scan_messages::ScanResponse ScanClient::scan(const sophos_filesystem::path& file
         return {};
     }
 
+    std::optional<ScanIndex::FileState> fileState;
+    if (m_scanIndex || m_throttle)
+    {
+        fileState = ScanIndex::stateOf(file_fd);
+    }
+    if (m_scanIndex && fileState && m_scanIndex->skipIfUnchanged(*fileState))
+    {
+        ::close(file_fd);
+        return {};
+    }
+
     auto request = std::make_shared<scan_messages::ClientScanRequest>();
     request->setPath(fileToScanPath);
     request->setScanInsideArchives(m_scanInArchives);
@@ -82,7 +95,14 @@ scan_messages::ScanResponse ScanClient::scan(const sophos_filesystem::path& file
     const char* user = std::getenv("USER");
     request->setUserID(user ? user : "root");
 
+    auto scanStart = std::chrono::steady_clock::now();
     auto response = m_socket.scan(request);
+    auto throttleDelay = std::chrono::steady_clock::duration::zero();
+    if (m_throttle)
+    {
+        throttleDelay =
+            m_throttle->scanned(fileState ? fileState->size : 0, std::chrono::steady_clock::now() - scanStart);
+    }
 
     if (m_callbacks)
     {
@@ -102,6 +122,10 @@ scan_messages::ScanResponse ScanClient::scan(const sophos_filesystem::path& file
             else
             {
                 m_callbacks->cleanFile(fileToScanPath);
+                if (m_scanIndex && fileState)
+                {
+                    m_scanIndex->recordClean(*fileState);
+                }
             }
         }
         else
@@ -120,5 +144,11 @@ scan_messages::ScanResponse ScanClient::scan(const sophos_filesystem::path& file
             m_callbacks->infectedFile(detections, fileToScanPath, scan_messages::getScanTypeAsStr(request->getScanType()), isSymlink);
         }
     }
+
+    // After reporting the result, so an abort while paused doesn't lose it
+    if (throttleDelay > std::chrono::steady_clock::duration::zero())
+    {
+        m_socket.pause(throttleDelay);
+    }
     return response;
 }
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -6,6 +6,8 @@
 #include "IScanClient.h"
 #include "NamedScanConfig.h"
 #include "PuaExclusions.h"
+#include "ScanIndex.h"
+#include "ScanThrottle.h"
 
 #include "datatypes/sophos_filesystem.h"
 #include "scan_messages/ThreatDetected.h"
@@ -59,6 +61,22 @@ namespace avscanner::avscannerimpl
             puaExclusions_ = std::move(exclusions);
         }
 
+        /**
+         * Files that the index has seen clean and are unchanged are not sent for scanning
+         */
+        void setScanIndex(std::shared_ptr<ScanIndex> scanIndex)
+        {
+            m_scanIndex = std::move(scanIndex);
+        }
+
+        /**
+         * Paces scan requests to stay within the throttle's budgets
+         */
+        void setThrottle(std::shared_ptr<ScanThrottle> throttle)
+        {
+            m_throttle = std::move(throttle);
+        }
+
         /**
          *
          * Calls IScanCallbacks if provided
@@ -90,6 +108,8 @@ namespace avscanner::avscannerimpl
 
     private:
         pua_exclusion_t puaExclusions_;
+        std::shared_ptr<ScanIndex> m_scanIndex;
+        std::shared_ptr<ScanThrottle> m_throttle;
         ClientSocketWrapper m_socket;
         std::shared_ptr<IScanCallbacks> m_callbacks;
         bool m_scanInArchives;
@@ -0,0 +1,296 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "ScanIndex.h"
+
+#include "Logger.h"
+
+#include "common/SaferStrerror.h"
+#include "datatypes/AutoFd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = sophos_filesystem;
+
+namespace avscanner::avscannerimpl
+{
+    namespace
+    {
+        constexpr char INDEX_MAGIC[8] = { 'S', 'P', 'L', 'S', 'I', 'D', 'X', '1' };
+
+        struct IndexHeader
+        {
+            char magic[8];
+            std::uint64_t dataVersion;
+            std::int64_t lastFullScanTime;
+            std::uint64_t entryCount;
+        };
+
+        static_assert(sizeof(IndexHeader) == 32);
+        static_assert(sizeof(ScanIndex::FileState) == 40);
+
+        bool keyLess(const ScanIndex::FileState& lhs, const ScanIndex::FileState& rhs)
+        {
+            return std::tie(lhs.dev, lhs.ino) < std::tie(rhs.dev, rhs.ino);
+        }
+
+        std::int64_t toNanoseconds(const timespec& time)
+        {
+            return static_cast<std::int64_t>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+        }
+
+        // FNV-1a
+        void hashInto(std::uint64_t& hash, const std::string& value)
+        {
+            for (unsigned char c : value)
+            {
+                hash ^= c;
+                hash *= 0x100000001b3ULL;
+            }
+            hash ^= 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+
+        void writeAll(int fd, const void* data, std::size_t size, const fs::path& path)
+        {
+            const auto* bytes = static_cast<const char*>(data);
+            while (size > 0)
+            {
+                auto written = ::write(fd, bytes, size);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    throw std::runtime_error("Failed to write " + path.string() + ": " + common::safer_strerror(errno));
+                }
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+        }
+    } // namespace
+
+    ScanIndex::ScanIndex(
+        fs::path indexPath,
+        std::uint64_t dataVersion,
+        std::chrono::seconds fullScanInterval,
+        std::size_t maxEntries) :
+        m_indexPath(std::move(indexPath)),
+        m_dataVersion(dataVersion),
+        m_maxEntries(maxEntries),
+        m_startTime(std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count())
+    {
+        load();
+        auto sinceFullScan = m_startTime - m_lastFullScanTime;
+        m_fullScan = m_entries == nullptr || sinceFullScan < 0 || sinceFullScan >= fullScanInterval.count();
+        if (m_fullScan)
+        {
+            unmap();
+        }
+    }
+
+    ScanIndex::~ScanIndex()
+    {
+        unmap();
+    }
+
+    void ScanIndex::load()
+    {
+        datatypes::AutoFd fd(::open(m_indexPath.c_str(), O_RDONLY | O_CLOEXEC));
+        if (!fd.valid())
+        {
+            if (errno != ENOENT)
+            {
+                LOGWARN("Failed to open scan index " << m_indexPath << ": " << common::safer_strerror(errno));
+            }
+            return;
+        }
+
+        struct stat st{};
+        if (::fstat(fd.get(), &st) != 0 || st.st_size < static_cast<off_t>(sizeof(IndexHeader)))
+        {
+            LOGWARN("Ignoring truncated scan index " << m_indexPath);
+            return;
+        }
+
+        auto size = static_cast<std::size_t>(st.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (mapped == MAP_FAILED)
+        {
+            LOGWARN("Failed to map scan index " << m_indexPath << ": " << common::safer_strerror(errno));
+            return;
+        }
+        m_mapped = mapped;
+        m_mappedSize = size;
+
+        IndexHeader header{};
+        std::memcpy(&header, mapped, sizeof(header));
+        if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+            header.entryCount != (size - sizeof(IndexHeader)) / sizeof(FileState) ||
+            (size - sizeof(IndexHeader)) % sizeof(FileState) != 0)
+        {
+            LOGWARN("Ignoring invalid scan index " << m_indexPath);
+            unmap();
+            return;
+        }
+
+        if (header.dataVersion != m_dataVersion)
+        {
+            LOGINFO("Detection data or settings have changed since the last scan, so all files will be scanned");
+            unmap();
+            return;
+        }
+
+        m_lastFullScanTime = header.lastFullScanTime;
+        m_entries = reinterpret_cast<const FileState*>(static_cast<const char*>(mapped) + sizeof(IndexHeader));
+        m_entryCount = header.entryCount;
+    }
+
+    void ScanIndex::unmap()
+    {
+        if (m_mapped != nullptr)
+        {
+            ::munmap(m_mapped, m_mappedSize);
+        }
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+        m_entries = nullptr;
+        m_entryCount = 0;
+    }
+
+    const ScanIndex::FileState* ScanIndex::find(const FileState& state) const
+    {
+        const auto* end = m_entries + m_entryCount;
+        const auto* entry = std::lower_bound(m_entries, end, state, keyLess);
+        if (entry == end || entry->dev != state.dev || entry->ino != state.ino)
+        {
+            return nullptr;
+        }
+        return entry;
+    }
+
+    bool ScanIndex::skipIfUnchanged(const FileState& state)
+    {
+        if (m_fullScan)
+        {
+            return false;
+        }
+
+        const auto* entry = find(state);
+        if (entry == nullptr || entry->size != state.size || entry->mtimeNs != state.mtimeNs ||
+            entry->ctimeNs != state.ctimeNs)
+        {
+            return false;
+        }
+
+        recordClean(state);
+        m_filesSkipped++;
+        return true;
+    }
+
+    void ScanIndex::recordClean(const FileState& state)
+    {
+        if (m_recorded.size() >= m_maxEntries)
+        {
+            if (!m_entryLimitReached)
+            {
+                LOGINFO("Scan index is full, further clean files will be scanned again by the next scan");
+                m_entryLimitReached = true;
+            }
+            return;
+        }
+        m_recorded.push_back(state);
+    }
+
+    void ScanIndex::save()
+    {
+        std::sort(m_recorded.begin(), m_recorded.end(), keyLess);
+        // Hard links are scanned once per path, keep one entry per inode
+        m_recorded.erase(
+            std::unique(
+                m_recorded.begin(),
+                m_recorded.end(),
+                [](const FileState& lhs, const FileState& rhs) { return lhs.dev == rhs.dev && lhs.ino == rhs.ino; }),
+            m_recorded.end());
+
+        IndexHeader header{};
+        std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        header.dataVersion = m_dataVersion;
+        header.lastFullScanTime = m_fullScan ? m_startTime : m_lastFullScanTime;
+        header.entryCount = m_recorded.size();
+
+        std::error_code ec;
+        fs::create_directories(m_indexPath.parent_path(), ec);
+
+        fs::path tmpPath = m_indexPath;
+        tmpPath += ".tmp";
+        {
+            datatypes::AutoFd fd(::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+            if (!fd.valid())
+            {
+                throw std::runtime_error("Failed to create " + tmpPath.string() + ": " + common::safer_strerror(errno));
+            }
+            writeAll(fd.get(), &header, sizeof(header), tmpPath);
+            writeAll(fd.get(), m_recorded.data(), m_recorded.size() * sizeof(FileState), tmpPath);
+        }
+
+        // The old index may still be mapped, which is fine as rename doesn't change the mapped inode
+        if (::rename(tmpPath.c_str(), m_indexPath.c_str()) != 0)
+        {
+            int error = errno;
+            fs::remove(tmpPath, ec);
+            throw std::runtime_error("Failed to replace " + m_indexPath.string() + ": " + common::safer_strerror(error));
+        }
+    }
+
+    std::optional<ScanIndex::FileState> ScanIndex::stateOf(int fd)
+    {
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            return std::nullopt;
+        }
+        return FileState{ static_cast<std::uint64_t>(st.st_dev),
+                          static_cast<std::uint64_t>(st.st_ino),
+                          static_cast<std::int64_t>(st.st_size),
+                          toNanoseconds(st.st_mtim),
+                          toNanoseconds(st.st_ctim) };
+    }
+
+    std::uint64_t ScanIndex::dataVersion(const fs::path& updateSource, const std::string& settings)
+    {
+        std::vector<std::string> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(updateSource, ec); !ec && it != fs::recursive_directory_iterator();
+             it.increment(ec))
+        {
+            struct stat st{};
+            if (::stat(it->path().c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                continue;
+            }
+            files.push_back(
+                fs::relative(it->path(), updateSource).string() + ":" + std::to_string(st.st_size) + ":" +
+                std::to_string(toNanoseconds(st.st_mtim)));
+        }
+        std::sort(files.begin(), files.end());
+
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        hashInto(hash, settings);
+        for (const auto& file : files)
+        {
+            hashInto(hash, file);
+        }
+        return hash;
+    }
+} // namespace avscanner::avscannerimpl
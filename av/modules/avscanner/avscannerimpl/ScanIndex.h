@@ -0,0 +1,101 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "datatypes/sophos_filesystem.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace avscanner::avscannerimpl
+{
+    /**
+     * Remembers the files a scheduled scan found clean, so later scans can skip files that have not changed.
+     *
+     * Entries are keyed by device and inode, so a renamed file is still found. A file is only skipped while its
+     * size, mtime and ctime match the entry and the index was written with the same data version, which covers the
+     * SUSI data and the settings that affect detection. Every fullScanInterval no files are skipped, to bound drift.
+     *
+     * The index file is a header followed by fixed size entries sorted by device and inode. It is mapped read-only
+     * and searched in place, and a new index holding only the files seen by this scan is written by save().
+     */
+    class ScanIndex
+    {
+    public:
+        struct FileState
+        {
+            std::uint64_t dev;
+            std::uint64_t ino;
+            std::int64_t size;
+            std::int64_t mtimeNs;
+            std::int64_t ctimeNs;
+        };
+
+        // 40 bytes per entry, so an index is at most 80MB
+        static constexpr std::size_t DEFAULT_MAX_ENTRIES = 2'000'000;
+
+        ScanIndex(
+            sophos_filesystem::path indexPath,
+            std::uint64_t dataVersion,
+            std::chrono::seconds fullScanInterval,
+            std::size_t maxEntries = DEFAULT_MAX_ENTRIES);
+        ~ScanIndex();
+        ScanIndex(const ScanIndex&) = delete;
+        ScanIndex& operator=(const ScanIndex&) = delete;
+
+        /**
+         * @return true if this scan must scan every file, because there is no usable index or a full scan is due
+         */
+        [[nodiscard]] bool isFullScan() const { return m_fullScan; }
+
+        /**
+         * Records the file as clean and returns true if it is unchanged since it was last scanned clean.
+         */
+        bool skipIfUnchanged(const FileState& state);
+
+        /**
+         * Records a file that has been scanned clean. Files beyond the entry limit are not recorded.
+         */
+        void recordClean(const FileState& state);
+
+        /**
+         * Atomically replaces the index file with the files recorded by this scan.
+         * @throws std::runtime_error if the index can't be written
+         */
+        void save();
+
+        [[nodiscard]] std::uint64_t filesSkipped() const { return m_filesSkipped; }
+
+        static std::optional<FileState> stateOf(int fd);
+
+        /**
+         * Combines the names, sizes and modification times of the SUSI update source with the detection settings.
+         * A new data version invalidates every entry in the index.
+         */
+        static std::uint64_t dataVersion(const sophos_filesystem::path& updateSource, const std::string& settings);
+
+    private:
+        void load();
+        void unmap();
+        [[nodiscard]] const FileState* find(const FileState& state) const;
+
+        sophos_filesystem::path m_indexPath;
+        std::uint64_t m_dataVersion;
+        std::size_t m_maxEntries;
+        std::int64_t m_startTime;
+        std::int64_t m_lastFullScanTime = 0;
+        bool m_fullScan = true;
+        bool m_entryLimitReached = false;
+
+        void* m_mapped = nullptr;
+        std::size_t m_mappedSize = 0;
+        const FileState* m_entries = nullptr;
+        std::size_t m_entryCount = 0;
+
+        std::vector<FileState> m_recorded;
+        std::uint64_t m_filesSkipped = 0;
+    };
+} // namespace avscanner::avscannerimpl
@@ -0,0 +1,241 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "ScanThrottle.h"
+
+#include "Logger.h"
+
+#include "common/SaferStrerror.h"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace avscanner::avscannerimpl
+{
+    namespace
+    {
+        using seconds_d = std::chrono::duration<double>;
+
+        // Not in every libc's headers
+        constexpr int IOPRIO_WHO_PROCESS = 1;
+        constexpr int IOPRIO_CLASS_BE = 2;
+        constexpr int IOPRIO_CLASS_SHIFT = 13;
+        constexpr int IOPRIO_LOWEST_BE_LEVEL = 7;
+
+        struct SchedAttr
+        {
+            std::uint32_t size;
+            std::uint32_t schedPolicy;
+            std::uint64_t schedFlags;
+            std::int32_t schedNice;
+            std::uint32_t schedPriority;
+            std::uint64_t schedRuntime;
+            std::uint64_t schedDeadline;
+            std::uint64_t schedPeriod;
+        };
+
+        // Rate of a single stream of scan requests, which keeps at most about one CPU busy
+        constexpr double SINGLE_CPU = 1.0;
+        constexpr double RATE_FACTOR_RECOVERY = 0.1;
+
+        std::optional<double> readSomeAvg10(const std::string& path)
+        {
+            std::ifstream pressure(path);
+            std::string kind;
+            std::string avg10;
+            if (!(pressure >> kind >> avg10) || kind != "some" || avg10.rfind("avg10=", 0) != 0)
+            {
+                return std::nullopt;
+            }
+            try
+            {
+                return std::stod(avg10.substr(6));
+            }
+            catch (const std::exception&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        std::optional<double> readCpuMax(const std::string& path)
+        {
+            std::ifstream cpuMax(path);
+            std::string quota;
+            double period = 0;
+            if (!(cpuMax >> quota >> period) || quota == "max" || period <= 0)
+            {
+                return std::nullopt;
+            }
+            try
+            {
+                return std::stod(quota) / period;
+            }
+            catch (const std::exception&)
+            {
+                return std::nullopt;
+            }
+        }
+    } // namespace
+
+    TokenBucket::TokenBucket(double ratePerSecond, clock::time_point now) :
+        m_rate(ratePerSecond), m_tokens(ratePerSecond), m_lastRefill(now)
+    {
+    }
+
+    void TokenBucket::consume(double amount, double rateFactor, clock::time_point now)
+    {
+        double rate = m_rate * rateFactor;
+        double elapsed = std::max(seconds_d(now - m_lastRefill).count(), 0.0);
+        m_tokens = std::min(m_tokens + elapsed * rate, rate) - amount;
+        m_lastRefill = now;
+    }
+
+    TokenBucket::clock::duration TokenBucket::deficit(double rateFactor) const
+    {
+        if (m_tokens >= 0)
+        {
+            return clock::duration::zero();
+        }
+        return std::chrono::duration_cast<clock::duration>(seconds_d(-m_tokens / (m_rate * rateFactor)));
+    }
+
+    ScanThrottle::ScanThrottle(
+        ThrottleSettings settings,
+        double availableCpus,
+        std::string pressureDir,
+        clock::time_point now) :
+        m_settings(settings), m_pressureDir(std::move(pressureDir)), m_lastPressureSample(now)
+    {
+        if (m_settings.cpuLimitPercent > 0 || m_settings.pressureThresholdPercent > 0)
+        {
+            double cpus = m_settings.cpuLimitPercent > 0 ? availableCpus * m_settings.cpuLimitPercent / 100.0
+                                                         : SINGLE_CPU;
+            m_cpu.emplace(std::min(cpus, SINGLE_CPU), now);
+        }
+        if (m_settings.ioBytesPerSecond > 0)
+        {
+            m_bytes.emplace(static_cast<double>(m_settings.ioBytesPerSecond), now);
+        }
+        if (m_settings.iopsLimit > 0)
+        {
+            m_files.emplace(static_cast<double>(m_settings.iopsLimit), now);
+        }
+    }
+
+    ScanThrottle::clock::duration ScanThrottle::scanned(
+        std::int64_t bytes,
+        clock::duration scanTime,
+        clock::time_point now)
+    {
+        m_bytesScanned += bytes;
+        m_filesScanned++;
+        updateRateFactor(now);
+
+        auto delay = clock::duration::zero();
+        if (m_cpu)
+        {
+            m_cpu->consume(seconds_d(scanTime).count(), m_rateFactor, now);
+            delay = std::max(delay, m_cpu->deficit(m_rateFactor));
+        }
+        if (m_bytes)
+        {
+            m_bytes->consume(static_cast<double>(bytes), m_rateFactor, now);
+            delay = std::max(delay, m_bytes->deficit(m_rateFactor));
+        }
+        if (m_files)
+        {
+            m_files->consume(1, m_rateFactor, now);
+            delay = std::max(delay, m_files->deficit(m_rateFactor));
+        }
+        m_throttledTime += delay;
+        return delay;
+    }
+
+    void ScanThrottle::updateRateFactor(clock::time_point now)
+    {
+        if (m_settings.pressureThresholdPercent <= 0 || now - m_lastPressureSample < PRESSURE_SAMPLE_INTERVAL)
+        {
+            return;
+        }
+        m_lastPressureSample = now;
+
+        auto pressure = hostPressure(m_pressureDir);
+        if (!pressure)
+        {
+            return;
+        }
+
+        double previous = m_rateFactor;
+        if (*pressure > m_settings.pressureThresholdPercent)
+        {
+            m_rateFactor = std::max(m_rateFactor / 2, MIN_RATE_FACTOR);
+        }
+        else
+        {
+            m_rateFactor = std::min(m_rateFactor + RATE_FACTOR_RECOVERY, 1.0);
+        }
+        if (m_rateFactor != previous)
+        {
+            LOGDEBUG("Host pressure " << *pressure << "%, scanning at " << static_cast<int>(m_rateFactor * 100) << "% of budget");
+        }
+    }
+
+    std::optional<double> ScanThrottle::hostPressure(const std::string& pressureDir)
+    {
+        auto cpu = readSomeAvg10(pressureDir + "/cpu");
+        auto io = readSomeAvg10(pressureDir + "/io");
+        if (!cpu && !io)
+        {
+            return std::nullopt;
+        }
+        return std::max(cpu.value_or(0), io.value_or(0));
+    }
+
+    double ScanThrottle::availableCpus(const std::string& procCgroupPath, const std::string& cgroupRoot)
+    {
+        double cpus = std::max(std::thread::hardware_concurrency(), 1U);
+
+        // cgroup v2 has a single "0::<path>" line, and every ancestor's quota also applies
+        std::ifstream procCgroup(procCgroupPath);
+        std::string line;
+        while (std::getline(procCgroup, line))
+        {
+            if (line.rfind("0::", 0) != 0)
+            {
+                continue;
+            }
+            std::string cgroup = line.substr(3);
+            while (!cgroup.empty() && cgroup != "/")
+            {
+                if (auto quota = readCpuMax(cgroupRoot + cgroup + "/cpu.max"))
+                {
+                    cpus = std::min(cpus, *quota);
+                }
+                cgroup = cgroup.substr(0, cgroup.rfind('/'));
+            }
+        }
+        return cpus;
+    }
+
+    void ScanThrottle::lowerProcessPriority()
+    {
+        int ioprio = (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | IOPRIO_LOWEST_BE_LEVEL;
+        if (::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio) != 0)
+        {
+            LOGWARN("Failed to lower IO priority: " << common::safer_strerror(errno));
+        }
+
+        SchedAttr attr{};
+        attr.size = sizeof(attr);
+        attr.schedPolicy = SCHED_BATCH;
+        attr.schedNice = 19;
+        if (::syscall(SYS_sched_setattr, 0, &attr, 0) != 0)
+        {
+            LOGWARN("Failed to lower CPU priority: " << common::safer_strerror(errno));
+        }
+    }
+} // namespace avscanner::avscannerimpl
@@ -0,0 +1,112 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace avscanner::avscannerimpl
+{
+    struct ThrottleSettings
+    {
+        // Percentage of the CPUs available to the product's cgroup, 0 for no limit
+        int cpuLimitPercent = 0;
+        // File bytes sent for scanning per second, 0 for no limit
+        std::int64_t ioBytesPerSecond = 0;
+        // Files sent for scanning per second, 0 for no limit
+        int iopsLimit = 0;
+        // Slow down while the CPU or IO pressure stall average exceeds this percentage, 0 to ignore pressure
+        int pressureThresholdPercent = 0;
+
+        [[nodiscard]] bool enabled() const
+        {
+            return cpuLimitPercent > 0 || ioBytesPerSecond > 0 || iopsLimit > 0 || pressureThresholdPercent > 0;
+        }
+    };
+
+    /**
+     * Rate that refills continuously up to a capacity of one second's worth, and can be overdrawn.
+     */
+    class TokenBucket
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        TokenBucket(double ratePerSecond, clock::time_point now);
+
+        void consume(double amount, double rateFactor, clock::time_point now);
+
+        /**
+         * @return time until the bucket is no longer overdrawn
+         */
+        [[nodiscard]] clock::duration deficit(double rateFactor) const;
+
+    private:
+        double m_rate;
+        double m_tokens;
+        clock::time_point m_lastRefill;
+    };
+
+    /**
+     * Paces scan requests sent to sophos_threat_detector, which reads and scans the file, so that scheduled scans
+     * stay within CPU and IO budgets. Time waiting for a scan response is counted as CPU time. While host pressure
+     * stall information reports contention the budgets are cut back, and restored gradually once it falls.
+     */
+    class ScanThrottle
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        ScanThrottle(
+            ThrottleSettings settings,
+            double availableCpus,
+            std::string pressureDir = "/proc/pressure",
+            clock::time_point now = clock::now());
+
+        /**
+         * Charges a completed scan against the budgets.
+         * @return how long to wait before sending the next request
+         */
+        clock::duration scanned(std::int64_t bytes, clock::duration scanTime, clock::time_point now = clock::now());
+
+        /**
+         * Lowers the priority of the calling process's own CPU and IO, which is mostly walking directories.
+         */
+        static void lowerProcessPriority();
+
+        /**
+         * @return CPUs the cgroup v2 cpu.max quotas of this process allow, or the number of CPUs if there are none
+         */
+        static double availableCpus(const std::string& procCgroupPath = "/proc/self/cgroup", const std::string& cgroupRoot = "/sys/fs/cgroup");
+
+        /**
+         * @return the larger of the "some avg10" CPU and IO pressure percentages, if the kernel reports them
+         */
+        static std::optional<double> hostPressure(const std::string& pressureDir);
+
+        [[nodiscard]] double rateFactor() const { return m_rateFactor; }
+        [[nodiscard]] std::int64_t bytesScanned() const { return m_bytesScanned; }
+        [[nodiscard]] std::int64_t filesScanned() const { return m_filesScanned; }
+        [[nodiscard]] clock::duration throttledTime() const { return m_throttledTime; }
+
+        static constexpr std::chrono::seconds PRESSURE_SAMPLE_INTERVAL{ 1 };
+        static constexpr double MIN_RATE_FACTOR = 0.05;
+
+    private:
+        void updateRateFactor(clock::time_point now);
+
+        ThrottleSettings m_settings;
+        std::string m_pressureDir;
+        std::optional<TokenBucket> m_cpu;
+        std::optional<TokenBucket> m_bytes;
+        std::optional<TokenBucket> m_files;
+        double m_rateFactor = 1.0;
+        clock::time_point m_lastPressureSample;
+
+        std::int64_t m_bytesScanned = 0;
+        std::int64_t m_filesScanned = 0;
+        clock::duration m_throttledTime{ 0 };
+    };
+} // namespace avscanner::avscannerimpl
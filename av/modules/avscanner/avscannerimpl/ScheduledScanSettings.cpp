@@ -0,0 +1,71 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "ScheduledScanSettings.h"
+
+#include "Logger.h"
+
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+
+namespace avscanner::avscannerimpl
+{
+    namespace
+    {
+        template<typename T>
+        T toLimited(const nlohmann::json& settings, const std::string& key, T defaultValue, T min, T max)
+        {
+            T value = settings.value(key, defaultValue);
+            T limited = std::clamp(value, min, max);
+            if (limited != value)
+            {
+                LOGWARN(key << " of " << value << " is out of range, using " << limited);
+            }
+            return limited;
+        }
+    } // namespace
+
+    ScheduledScanSettings readScheduledScanSettings(const std::string& settingsPath)
+    {
+        ScheduledScanSettings settings;
+
+        auto* fileSystem = Common::FileSystem::fileSystem();
+        if (!fileSystem->isFile(settingsPath))
+        {
+            return settings;
+        }
+
+        try
+        {
+            auto parsed = nlohmann::json::parse(fileSystem->readFile(settingsPath));
+            settings.incrementalScans = parsed.value("incrementalScans", settings.incrementalScans);
+            settings.fullScanIntervalDays = toLimited(
+                parsed,
+                "fullScanIntervalDays",
+                settings.fullScanIntervalDays,
+                MIN_FULL_SCAN_INTERVAL_DAYS,
+                MAX_FULL_SCAN_INTERVAL_DAYS);
+
+            auto& throttle = settings.throttle;
+            throttle.cpuLimitPercent = toLimited(parsed, "cpuLimitPercent", throttle.cpuLimitPercent, 0, 100);
+            throttle.ioBytesPerSecond =
+                toLimited(parsed, "ioLimitMBps", 0, 0, MAX_IO_LIMIT_MBPS) * std::int64_t{ 1024 * 1024 };
+            throttle.iopsLimit = toLimited(parsed, "iopsLimit", throttle.iopsLimit, 0, MAX_IOPS_LIMIT);
+            throttle.pressureThresholdPercent =
+                toLimited(parsed, "pressureThresholdPercent", throttle.pressureThresholdPercent, 0, 100);
+        }
+        catch (const Common::FileSystem::IFileSystemException& e)
+        {
+            LOGWARN("Failed to read scheduled scan local settings: " << e.what());
+        }
+        catch (const nlohmann::json::exception& e)
+        {
+            LOGWARN("Failed to parse scheduled scan local settings: " << e.what());
+            settings = {};
+        }
+        return settings;
+    }
+} // namespace avscanner::avscannerimpl
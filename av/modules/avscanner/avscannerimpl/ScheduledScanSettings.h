@@ -0,0 +1,29 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "ScanThrottle.h"
+
+#include <string>
+
+namespace avscanner::avscannerimpl
+{
+    struct ScheduledScanSettings
+    {
+        // Skip files that are unchanged since they were last scanned clean
+        bool incrementalScans = false;
+        // Days between scheduled scans that scan every file, when incremental scans are enabled
+        int fullScanIntervalDays = 7;
+        ThrottleSettings throttle;
+    };
+
+    constexpr int MIN_FULL_SCAN_INTERVAL_DAYS = 1;
+    constexpr int MAX_FULL_SCAN_INTERVAL_DAYS = 90;
+    constexpr int MAX_IO_LIMIT_MBPS = 10000;
+    constexpr int MAX_IOPS_LIMIT = 1000000;
+
+    /**
+     * Reads var/scheduled_scan_local_settings.json, returning the defaults if it is missing or invalid.
+     */
+    ScheduledScanSettings readScheduledScanSettings(const std::string& settingsPath);
+} // namespace avscanner::avscannerimpl
@@ -1,12 +1,26 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "ApplicationPaths.h"
 
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
 
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <stdexcept>
 
+namespace
+{
+    // Scan names come from policy, so only keep characters that are safe in a file name
+    std::string scanFileStem(const std::string& scanName)
+    {
+        std::string stem = scanName;
+        std::replace_if(
+            stem.begin(), stem.end(), [](unsigned char c) { return !std::isalnum(c) && c != '-'; }, '_');
+        return stem;
+    }
+} // namespace
+
 namespace Plugin
 {
     std::string getMetadataRescanSocketPath()
@@ -109,6 +123,11 @@ namespace Plugin
         return getPluginChrootVarDirPath() + "/update_status.json";
     }
 
+    std::string getThreatDetectorStartupStatusPath()
+    {
+        return getPluginChrootVarDirPath() + "/startup_status.json";
+    }
+
     std::string getRelativeSafeStoreRescanIntervalConfigPath()
     {
         return "/var/safeStoreRescanInterval";
@@ -139,9 +158,39 @@ namespace Plugin
         return getPluginVarDirPath() + "/persist-threatDatabase";
     }
 
+    std::string getPersistThreatDatabaseJournalFilePath()
+    {
+        return getPersistThreatDatabaseFilePath() + ".journal";
+    }
+
     std::string getSusiStartupSettingsPath()
     {
         auto pluginInstall = getPluginInstall();
         return pluginInstall + "/var/susi_startup_settings.json";
     }
+
+    std::string getSusiUpdateSourcePath()
+    {
+        return getPluginChrootDirPath() + "/susi/update_source";
+    }
+
+    std::string getScheduledScanLocalSettingsPath()
+    {
+        return getPluginVarDirPath() + "/scheduled_scan_local_settings.json";
+    }
+
+    std::string getScanIndexDirPath()
+    {
+        return getPluginVarDirPath() + "/scan_index";
+    }
+
+    std::string getScanIndexPath(const std::string& scanName)
+    {
+        return getScanIndexDirPath() + "/" + scanFileStem(scanName) + ".index";
+    }
+
+    std::string getScheduledScanStatsPath(const std::string& scanName)
+    {
+        return getScanIndexDirPath() + "/" + scanFileStem(scanName) + ".stats.json";
+    }
 } // namespace Plugin
\ No newline at end of file
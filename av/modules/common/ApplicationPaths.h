@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -10,7 +10,9 @@ namespace Plugin
     std::string getOnAccessUnhealthyFlagPath();
     std::string getThreatDetectorUnhealthyFlagPath();
     std::string getThreatDetectorSusiUpdateStatusPath();
+    std::string getThreatDetectorStartupStatusPath();
     std::string getPersistThreatDatabaseFilePath();
+    std::string getPersistThreatDatabaseJournalFilePath();
     std::string getPluginChrootDirPath();
     std::string getPluginChrootVarDirPath();
     std::string getPluginInstall();
@@ -31,4 +33,9 @@ namespace Plugin
     std::string getDisableSafestorePath();
     std::string getSusiStartupSettingsPath();
     std::string getScanningSocketPath();
+    std::string getSusiUpdateSourcePath();
+    std::string getScheduledScanLocalSettingsPath();
+    std::string getScanIndexDirPath();
+    std::string getScanIndexPath(const std::string& scanName);
+    std::string getScheduledScanStatsPath(const std::string& scanName);
 } // namespace Plugin
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 
 // File
@@ -6,14 +6,19 @@
 // Module
 #include "Logger.h"
 // Product
+#include "common/ApplicationPaths.h"
 #include "common/ErrorCodes.h"
 #include "datatypes/sophos_filesystem.h"
 #include "datatypes/Time.h"
 // Base
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
 #include "Common/Process/IProcess.h"
+#include "Common/TelemetryHelperImpl/TelemetryHelper.h"
 #include "Common/UtilityImpl/StringUtils.h" // String replacer
 // 3rd party
+#include <nlohmann/json.hpp>
 // C++ std
 #include <chrono>
 #include <fstream>
@@ -66,6 +71,18 @@ void ScanRunner::run()
         return;
     }
 
+    std::string statsPath;
+    try
+    {
+        statsPath = Plugin::getScheduledScanStatsPath(m_name);
+        // Incremental and throttled scans write new statistics, so don't report ones left by an earlier scan
+        Common::FileSystem::fileSystem()->removeFile(statsPath, true);
+    }
+    catch (const std::exception& e)
+    {
+        LOGWARN("Failed to remove scan statistics: " << e.what());
+    }
+
     LOGINFO("Starting scan " << m_name);
 
     // Start file walker process
@@ -128,6 +145,11 @@ void ScanRunner::run()
         LOGERROR("Failed to remove "<< config_file << ": " << ec.message());
     }
 
+    if (!statsPath.empty())
+    {
+        recordScheduledScanTelemetry(statsPath);
+    }
+
     LOGINFO("Sending scan complete event to Central");
     std::string scanCompletedXml = generateScanCompleteXml(m_name);
     LOGDEBUG("XML" << scanCompletedXml);
@@ -137,6 +159,59 @@ void ScanRunner::run()
     LOGDEBUG("Exiting scan thread");
 }
 
+void manager::scheduler::recordScheduledScanTelemetry(const std::string& statsPath)
+{
+    auto* fileSystem = Common::FileSystem::fileSystem();
+    if (!fileSystem->isFile(statsPath))
+    {
+        return;
+    }
+
+    try
+    {
+        auto stats = nlohmann::json::parse(fileSystem->readFile(statsPath));
+        auto scanned = stats.value("filesScanned", 0UL);
+        auto& telemetry = Common::Telemetry::TelemetryHelper::getInstance();
+        telemetry.increment("scheduled-scan-files-scanned", scanned);
+
+        if (stats.contains("filesSkipped"))
+        {
+            auto skipped = stats.value("filesSkipped", 0UL);
+            telemetry.increment("scheduled-scan-files-skipped", skipped);
+            if (stats.value("fullScan", false))
+            {
+                telemetry.increment("scheduled-scan-full-count", 1UL);
+            }
+            if (scanned + skipped > 0)
+            {
+                telemetry.set(
+                    "scheduled-scan-skip-ratio", static_cast<double>(skipped) / static_cast<double>(scanned + skipped));
+            }
+            LOGINFO("Incremental scan skipped " << skipped << " of " << scanned + skipped << " files");
+        }
+
+        if (stats.contains("bytesScanned"))
+        {
+            auto bytes = stats.value("bytesScanned", 0UL);
+            auto durationMs = stats.value("durationMs", 0UL);
+            telemetry.increment("scheduled-scan-throttled-ms", stats.value("throttledMs", 0UL));
+            if (durationMs > 0)
+            {
+                telemetry.set("scheduled-scan-throughput-bytes-per-second", bytes * 1000 / durationMs);
+            }
+        }
+        fileSystem->removeFile(statsPath);
+    }
+    catch (const Common::FileSystem::IFileSystemException& e)
+    {
+        LOGWARN("Failed to read scan statistics: " << e.what());
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        LOGWARN("Failed to parse scan statistics: " << e.what());
+    }
+}
+
 std::string manager::scheduler::generateScanCompleteXml(const std::string& name)
 {
     return Common::UtilityImpl::StringUtils::orderedStringReplace(
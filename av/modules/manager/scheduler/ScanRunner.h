@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -16,6 +16,11 @@ namespace manager::scheduler
     std::string generateScanCompleteXml(const std::string& name);
     std::string generateTimeStamp();
 
+    /**
+     * Adds the statistics written by an incremental or throttled scan to telemetry, then removes the file.
+     */
+    void recordScheduledScanTelemetry(const std::string& statsPath);
+
     class ScanRunner : public Common::Threads::AbstractThread
     {
     public:
@@ -1,9 +1,18 @@
-// Copyright 2022, Sophos Limited.  All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "DetectionQueue.h"
 
 #include "Common/TelemetryHelperImpl/TelemetryHelper.h"
 
+namespace
+{
+    // Every detection the queue has no room for is counted, whichever push it came through
+    void recordDropped(unsigned long count)
+    {
+        Common::Telemetry::TelemetryHelper::getInstance().increment("detections-dropped-from-safestore-queue", count);
+    }
+} // namespace
+
 namespace Plugin
 {
     void DetectionQueue::setMaxSize(uint newMaxSize)
@@ -20,10 +29,33 @@ namespace Plugin
             m_cond.notify_one();
             return true;
         }
-        Common::Telemetry::TelemetryHelper::getInstance().increment("detections-dropped-from-safestore-queue", 1ul);
+        lck.unlock();
+        recordDropped(1ul);
         return false;
     }
 
+    size_t DetectionQueue::push(std::vector<scan_messages::ThreatDetected>& tasks)
+    {
+        size_t pushed = 0;
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            while (pushed < tasks.size() && !isFullLocked(lck))
+            {
+                m_list.push(std::move(tasks[pushed++]));
+            }
+        }
+        if (pushed > 0)
+        {
+            m_cond.notify_one();
+        }
+        tasks.erase(tasks.begin(), tasks.begin() + static_cast<std::ptrdiff_t>(pushed));
+        if (!tasks.empty())
+        {
+            recordDropped(static_cast<unsigned long>(tasks.size()));
+        }
+        return pushed;
+    }
+
     std::optional<scan_messages::ThreatDetected> DetectionQueue::pop()
     {
         std::unique_lock<std::mutex> lck(m_mutex);
@@ -1,4 +1,4 @@
-// Copyright 2022, Sophos Limited.  All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -13,6 +13,7 @@
 #include <queue>
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace Plugin
 {
@@ -37,6 +38,13 @@ namespace Plugin
          */
         bool push(scan_messages::ThreatDetected&);
 
+        /** Pushes as many of the detections as fit, in order, under one lock.
+         *
+         * @return the number pushed; those detections are moved and erased from the front of the vector, leaving
+         * only the detections that did not fit
+         */
+        size_t push(std::vector<scan_messages::ThreatDetected>&);
+
         std::optional<scan_messages::ThreatDetected> pop();
         bool isEmpty();
         bool isFull();
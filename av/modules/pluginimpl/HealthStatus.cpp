@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "HealthStatus.h"
 
@@ -44,3 +44,47 @@ bool Plugin::susiUpdateFailed()
     }
     return false;
 }
+
+std::optional<Plugin::SusiUpdateTimings> Plugin::lastSusiUpdateTimings()
+{
+    auto* fileSystem = Common::FileSystem::fileSystem();
+
+    try
+    {
+        auto contents = fileSystem->readFile(Plugin::getThreatDetectorSusiUpdateStatusPath());
+        auto json = nlohmann::json::parse(contents);
+        return SusiUpdateTimings{ json.at("lockWaitMs").get<long>(), json.at("updateDurationMs").get<long>() };
+    }
+    catch (const Common::FileSystem::IFileNotFoundException&)
+    {
+        // No update has been done yet
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        // Written by an older threat detector, or not valid JSON
+    }
+    return std::nullopt;
+}
+
+std::optional<Plugin::ThreatDetectorStartupTimings> Plugin::lastThreatDetectorStartupTimings()
+{
+    auto* fileSystem = Common::FileSystem::fileSystem();
+
+    try
+    {
+        auto contents = fileSystem->readFile(Plugin::getThreatDetectorStartupStatusPath());
+        auto json = nlohmann::json::parse(contents);
+        return ThreatDetectorStartupTimings{
+            json.at("setupMs").get<long>(), json.at("warmUpMs").get<long>(), json.at("totalMs").get<long>()
+        };
+    }
+    catch (const Common::FileSystem::IFileNotFoundException&)
+    {
+        // Threat detector hasn't started yet
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        // Not valid JSON, or missing timings
+    }
+    return std::nullopt;
+}
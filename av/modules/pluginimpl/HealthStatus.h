@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 /******************************************************************************************************
 
 Copyright 2021, Sophos Limited.  All rights reserved.
@@ -7,6 +7,7 @@ Copyright 2021, Sophos Limited.  All rights reserved.
 
 #pragma once
 
+#include <optional>
 #include <string_view>
 
 namespace Plugin
@@ -27,5 +28,32 @@ namespace Plugin
 
 
     bool susiUpdateFailed();
+
+    struct SusiUpdateTimings
+    {
+        long lockWaitMs;
+        // Time spent in SUSI_Update, which is when scans can be held up
+        long updateDurationMs;
+    };
+
+    /**
+     * Timings of the last SUSI update, as recorded by sophos_threat_detector
+     * @return std::nullopt if the status file is missing or doesn't have them
+     */
+    std::optional<SusiUpdateTimings> lastSusiUpdateTimings();
+
+    struct ThreatDetectorStartupTimings
+    {
+        long setupMs;
+        // Initialising SUSI and creating scanners before accepting scan requests
+        long warmUpMs;
+        long totalMs;
+    };
+
+    /**
+     * Timings of the last sophos_threat_detector start, as recorded by sophos_threat_detector
+     * @return std::nullopt if the status file is missing or doesn't have them
+     */
+    std::optional<ThreatDetectorStartupTimings> lastThreatDetectorStartupTimings();
 }
 
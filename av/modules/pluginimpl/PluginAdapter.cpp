@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "PluginAdapter.h"
 
@@ -51,37 +51,56 @@ namespace Plugin
 
             void processMessage(scan_messages::ThreatDetected detection) override
             {
-                const std::string escapedPath = common::pathForLogging(detection.filePath);
-                bool shouldQuarantine = true;
-
-                if (
-                    detection.reportSource == common::CentralEnums::ReportSource::ml &&
-                    !m_adapter.shouldSafeStoreQuarantineMl())
-                {
-                    LOGINFO(escapedPath << " was not quarantined due to being reported as an ML detection");
-                    shouldQuarantine = false;
-                }
+                std::vector<scan_messages::ThreatDetected> detections;
+                detections.push_back(std::move(detection));
+                processMessages(std::move(detections));
+            }
 
+            void processMessages(std::vector<scan_messages::ThreatDetected> detections) override
+            {
+                bool safeStoreDisabled = false;
                 try
                 {
-                    if (Common::FileSystem::fileSystem()->isFile(Plugin::getDisableSafestorePath()))
-                    {
-                        shouldQuarantine = false;
-                    }
+                    safeStoreDisabled = Common::FileSystem::fileSystem()->isFile(Plugin::getDisableSafestorePath());
                 }
                 catch (Common::FileSystem::IFileSystemException &ex)
                 {
                     LOGWARN("Failed to check for safestore disable path with error: " << ex.what());
                 }
 
-                // detection is not moved if the push fails, so can still be used by processDetectionReport
-                if (!shouldQuarantine || !m_adapter.getDetectionQueue()->push(detection))
+                std::vector<scan_messages::ThreatDetected> toQuarantine;
+                std::vector<scan_messages::ThreatDetected> notQuarantined;
+                for (auto& detection : detections)
                 {
-                    if (shouldQuarantine) // i.e. failed to push
+                    if (
+                        detection.reportSource == common::CentralEnums::ReportSource::ml &&
+                        !m_adapter.shouldSafeStoreQuarantineMl())
+                    {
+                        LOGINFO(
+                            common::pathForLogging(detection.filePath)
+                            << " was not quarantined due to being reported as an ML detection");
+                        notQuarantined.push_back(std::move(detection));
+                    }
+                    else if (safeStoreDisabled)
+                    {
+                        notQuarantined.push_back(std::move(detection));
+                    }
+                    else
                     {
-                        LOGWARN("SafeStore queue is full, unable to quarantine " << escapedPath);
+                        toQuarantine.push_back(std::move(detection));
                     }
+                }
 
+                // Detections that are pushed are removed, leaving those the queue had no room for
+                m_adapter.getDetectionQueue()->push(toQuarantine);
+                for (auto& detection : toQuarantine)
+                {
+                    LOGWARN("SafeStore queue is full, unable to quarantine " << common::pathForLogging(detection.filePath));
+                    notQuarantined.push_back(std::move(detection));
+                }
+
+                for (auto& detection : notQuarantined)
+                {
                     // The quarantine is reported as a failure. Ideally we should use a more accurate reason than
                     // 'failed to delete file' but Central doesn't support anything better currently.
                     detection.quarantineResult = common::CentralEnums::QuarantineResult::FAILED_TO_DELETE_FILE;
@@ -230,22 +249,23 @@ namespace Plugin
                         processAction(task.Content);
                         break;
 
+                    // Events and status are queued so a busy Management Agent doesn't hold up this loop
                     case Task::TaskType::ScanComplete:
-                        m_baseService->sendEvent("SAV", task.Content);
+                        m_baseService->sendEventAsync("SAV", task.Content);
                         break;
 
                     case Task::TaskType::ThreatDetected:
                     case Task::TaskType::SendCleanEvent:
-                        m_baseService->sendEvent("CORE", task.Content);
+                        m_baseService->sendEventAsync("CORE", task.Content);
                         break;
 
                     case Task::TaskType::SendRestoreEvent:
                         LOGDEBUG("Sending Restore Event to Central: " << task.Content);
-                        m_baseService->sendEvent("CORE", task.Content);
+                        m_baseService->sendEventAsync("CORE", task.Content);
                         break;
 
                     case Task::TaskType::SendStatus:
-                        m_baseService->sendStatus("SAV", task.Content, task.Content);
+                        m_baseService->sendStatusAsync("SAV", task.Content, task.Content);
                         break;
                 }
 
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 // Class
 #include "PluginCallback.h"
@@ -125,6 +125,19 @@ namespace Plugin
         auto health = calculateHealth(sysCalls);
         telemetry.set("health", health);
 
+        if (auto timings = lastSusiUpdateTimings())
+        {
+            telemetry.set("susi-update-stall-ms", timings->updateDurationMs);
+            telemetry.set("susi-update-lock-wait-ms", timings->lockWaitMs);
+        }
+
+        if (auto timings = lastThreatDetectorStartupTimings())
+        {
+            telemetry.set("threat-detector-startup-setup-ms", timings->setupMs);
+            telemetry.set("threat-detector-startup-warm-up-ms", timings->warmUpMs);
+            telemetry.set("threat-detector-startup-ms", timings->totalMs);
+        }
+
         auto* fileSystem = Common::FileSystem::fileSystem();
         Telemetry telemetryCalculator{sysCalls, fileSystem};
         auto telemetryJson = telemetryCalculator.getTelemetry();
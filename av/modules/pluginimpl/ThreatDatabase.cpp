@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "ThreatDatabase.h"
 
@@ -14,20 +14,96 @@
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <vector>
 
 namespace Plugin
 {
-    ThreatDatabase::ThreatDatabase(const std::string& path) : m_databaseInString(path, "threatDatabase", "{}")
+    namespace
+    {
+        namespace JournalKeys
+        {
+            constexpr auto change = "change";
+            constexpr auto add = "add";
+            constexpr auto remove = "remove";
+        } // namespace JournalKeys
+
+        long toSeconds(std::chrono::system_clock::time_point time)
+        {
+            return std::chrono::time_point_cast<std::chrono::seconds>(time).time_since_epoch().count();
+        }
+    } // namespace
+
+    ThreatDatabase::ThreatIndex::map_type::const_iterator ThreatDatabase::ThreatIndex::findCorrelationId(
+        const std::string& correlationId) const
+    {
+        auto itr = m_threatIdByCorrelationId.find(correlationId);
+        if (itr == m_threatIdByCorrelationId.end())
+        {
+            return m_threats.end();
+        }
+        return m_threats.find(itr->second);
+    }
+
+    void ThreatDatabase::ThreatIndex::insertOrAssign(const std::string& threatId, ThreatDetails details)
+    {
+        auto itr = m_threats.find(threatId);
+        if (itr != m_threats.end())
+        {
+            eraseCorrelationId(itr->second.correlationId, threatId);
+            itr->second = std::move(details);
+        }
+        else
+        {
+            itr = m_threats.emplace(threatId, std::move(details)).first;
+        }
+        m_threatIdByCorrelationId[itr->second.correlationId] = threatId;
+    }
+
+    bool ThreatDatabase::ThreatIndex::erase(const std::string& threatId)
+    {
+        auto itr = m_threats.find(threatId);
+        if (itr == m_threats.end())
+        {
+            return false;
+        }
+        eraseCorrelationId(itr->second.correlationId, threatId);
+        m_threats.erase(itr);
+        return true;
+    }
+
+    void ThreatDatabase::ThreatIndex::eraseCorrelationId(const std::string& correlationId, const std::string& threatId)
+    {
+        // A later threat may have been given the same correlation ID, and then the mapping is its
+        auto correlationItr = m_threatIdByCorrelationId.find(correlationId);
+        if (correlationItr != m_threatIdByCorrelationId.end() && correlationItr->second == threatId)
+        {
+            m_threatIdByCorrelationId.erase(correlationItr);
+        }
+    }
+
+    void ThreatDatabase::ThreatIndex::clear()
+    {
+        m_threats.clear();
+        m_threatIdByCorrelationId.clear();
+    }
+
+    ThreatDatabase::ThreatDatabase(const std::string& path) :
+        m_databaseInString(path, "threatDatabase", "{}"),
+        m_journalPath(Common::FileSystem::join(path, "persist-threatDatabase.journal"))
     {
         if (!m_databaseInString.getError().empty())
         {
             LOGERROR("Resetting ThreatDatabase as it failed to load: " << m_databaseInString.getError());
         }
         convertStringToDatabase();
+
+        auto database = m_database.lock();
+        replayJournal(*database);
     }
 
     ThreatDatabase::~ThreatDatabase()
     {
+        // The journal is kept, replaying it over the snapshot stored by m_databaseInString is harmless
         convertDatabaseToString();
     }
 
@@ -35,39 +111,41 @@ namespace Plugin
     {
         auto database = m_database.lock();
         auto dbItr = database->find(threatID);
+        ThreatDetails details(correlationID);
         if (dbItr != database->end())
         {
-            auto now = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now());
-            long duration = std::chrono::duration_cast<std::chrono::seconds>(now - dbItr->second.lastDetection).count();
+            long duration =
+                std::chrono::duration_cast<std::chrono::seconds>(details.lastDetection - dbItr->second.lastDetection).count();
             LOGDEBUG(
                 "ThreatId: " << threatID << " already existed. Overwriting correlationId: "
                              << dbItr->second.correlationId << ", age: " << duration << " with " << correlationID);
-
-            dbItr->second.correlationId = correlationID;
-            dbItr->second.lastDetection = now;
         }
         else
         {
-            auto newThreatDetails = ThreatDetails(correlationID);
-            database->emplace(threatID, std::move(newThreatDetails));
             LOGDEBUG("Added threat " << threatID << " with correlationId " << correlationID << " to threat database");
         }
+
+        nlohmann::json change = { { JournalKeys::change, JournalKeys::add },
+                                  { JsonKeys::threatId, threatID },
+                                  { JsonKeys::correlationId, correlationID },
+                                  { JsonKeys::timestamp, toSeconds(details.lastDetection) } };
+        database->insertOrAssign(threatID, std::move(details));
+        journal(*database, change.dump());
     }
 
     void ThreatDatabase::removeCorrelationID(const std::string& correlationID)
     {
         auto database = m_database.lock();
 
-        for (auto threatItr = database->begin(); threatItr != database->end(); ++threatItr)
+        auto threatItr = database->findCorrelationId(correlationID);
+        if (threatItr != database->end())
         {
-            if (threatItr->second.correlationId == correlationID)
-            {
-                LOGDEBUG(
-                    "Removing threat " << threatItr->first << " with correlationId " << correlationID
-                                       << " from database");
-                database->erase(threatItr);
-                return;
-            }
+            std::string threatId = threatItr->first;
+            LOGDEBUG("Removing threat " << threatId << " with correlationId " << correlationID << " from database");
+            database->erase(threatId);
+            nlohmann::json change = { { JournalKeys::change, JournalKeys::remove }, { JsonKeys::threatId, threatId } };
+            journal(*database, change.dump());
+            return;
         }
 
         LOGINFO("Cannot remove correlationId: " << correlationID << " from database as it cannot be found");
@@ -77,11 +155,11 @@ namespace Plugin
     {
         auto database = m_database.lock();
 
-        auto threatItr = database->find(threatID);
-        if (threatItr != database->end())
+        if (database->erase(threatID))
         {
-            database->erase(threatItr);
             LOGDEBUG("Removed threatId " << threatID << " from database");
+            nlohmann::json change = { { JournalKeys::change, JournalKeys::remove }, { JsonKeys::threatId, threatID } };
+            journal(*database, change.dump());
         }
         else if (!ignoreNotInDatabase)
         {
@@ -101,13 +179,8 @@ namespace Plugin
     {
         auto database = m_database.lock();
 
-        if (database->empty())
-        {
-            return false;
-        }
-
         auto threatItr = database->find(threatId);
-        if (threatItr == database->cend())
+        if (threatItr == database->end())
         {
             return false;
         }
@@ -127,6 +200,8 @@ namespace Plugin
         try
         {
             m_databaseInString.setValueAndForceStore("{}");
+            Common::FileSystem::fileSystem()->removeFile(m_journalPath, true);
+            m_journalEntries = 0;
             LOGDEBUG("Threat Database has been reset");
         }
         catch (Common::FileSystem::IFileSystemException& ex)
@@ -138,36 +213,120 @@ namespace Plugin
     std::optional<std::string> ThreatDatabase::hasThreat(const std::string& threatId) const
     {
         auto database = m_database.lock();
-        for (auto const& entry : *database)
+        auto threatItr = database->find(threatId);
+        if (threatItr != database->end())
         {
-            if (entry.first == threatId)
-            {
-                return entry.second.correlationId;
-            }
+            return threatItr->second.correlationId;
         }
 
         return {};
     }
 
-    void ThreatDatabase::convertDatabaseToString()
+    std::string ThreatDatabase::serialise(const ThreatIndex& database)
     {
-        auto database = m_database.lock();
         nlohmann::json j;
 
-        for (const auto& key : *database)
+        for (const auto& [threatId, details] : database)
         {
-            long timeStamp =
-                std::chrono::time_point_cast<std::chrono::seconds>(key.second.lastDetection).time_since_epoch().count();
-            j[key.first] = { { JsonKeys::correlationId, key.second.correlationId },
-                             { JsonKeys::timestamp, timeStamp } };
+            j[threatId] = { { JsonKeys::correlationId, details.correlationId },
+                            { JsonKeys::timestamp, toSeconds(details.lastDetection) } };
         }
         if (j.empty())
         {
-            m_databaseInString.setValue("{}");
+            return "{}";
         }
-        else
+        return j.dump();
+    }
+
+    void ThreatDatabase::convertDatabaseToString()
+    {
+        auto database = m_database.lock();
+        m_databaseInString.setValue(serialise(*database));
+    }
+
+    void ThreatDatabase::journal(ThreatIndex& database, const std::string& change)
+    {
+        try
+        {
+            Common::FileSystem::fileSystem()->appendFile(m_journalPath, change + "\n");
+            m_journalEntries++;
+        }
+        catch (const Common::FileSystem::IFileSystemException& ex)
+        {
+            // The change is still saved with the rest of the database on shutdown
+            LOGDEBUG("Failed to journal threat database change: " << ex.what());
+            return;
+        }
+
+        if (m_journalEntries >= std::max(MIN_JOURNAL_ENTRIES_BEFORE_COMPACTION, 2 * database.size()))
+        {
+            compact(database);
+        }
+    }
+
+    void ThreatDatabase::compact(const ThreatIndex& database)
+    {
+        try
+        {
+            // Store the snapshot first, replaying the journal over it is harmless if we stop before removing it
+            m_databaseInString.setValueAndForceStore(serialise(database));
+            Common::FileSystem::fileSystem()->removeFile(m_journalPath, true);
+            LOGDEBUG("Compacted " << m_journalEntries << " threat database changes");
+            m_journalEntries = 0;
+        }
+        catch (const Common::FileSystem::IFileSystemException& ex)
         {
-            m_databaseInString.setValue(j.dump());
+            LOGWARN("Failed to compact threat database: " << ex.what());
+        }
+    }
+
+    void ThreatDatabase::replayJournal(ThreatIndex& database)
+    {
+        auto* fileSystem = Common::FileSystem::fileSystem();
+        std::vector<std::string> changes;
+        try
+        {
+            if (!fileSystem->isFile(m_journalPath))
+            {
+                return;
+            }
+            changes = fileSystem->readLines(m_journalPath);
+        }
+        catch (const Common::FileSystem::IFileSystemException& ex)
+        {
+            LOGWARN("Failed to read threat database journal: " << ex.what());
+            return;
+        }
+
+        for (const auto& line : changes)
+        {
+            try
+            {
+                auto change = nlohmann::json::parse(line);
+                std::string threatId = change.at(JsonKeys::threatId);
+                if (change.at(JournalKeys::change) == JournalKeys::add)
+                {
+                    database.insertOrAssign(
+                        threatId,
+                        ThreatDetails(change.at(JsonKeys::correlationId), change.at(JsonKeys::timestamp).get<long>()));
+                }
+                else
+                {
+                    database.erase(threatId);
+                }
+            }
+            catch (const nlohmann::json::exception& ex)
+            {
+                // Most likely the last line, cut short when we stopped
+                LOGWARN("Ignoring corrupt threat database journal entry: " << ex.what());
+            }
+        }
+
+        m_journalEntries = changes.size();
+        if (m_journalEntries > 0)
+        {
+            LOGINFO("Replayed " << m_journalEntries << " threat database changes");
+            compact(database);
         }
     }
 
@@ -190,7 +349,7 @@ namespace Plugin
             }
         }
 
-        std::map<std::string, ThreatDetails> tempdatabase;
+        ThreatIndex tempdatabase;
 
         for (const auto& threatItr : j.items())
         {
@@ -222,11 +381,13 @@ namespace Plugin
                 Common::Telemetry::TelemetryHelper::getInstance().set("corrupt-threat-database", true);
             }
 
-            ThreatDetails details(correlationId, timeStamp);
-            tempdatabase.try_emplace(threatItr.key(), details);
+            if (tempdatabase.find(threatItr.key()) == tempdatabase.end())
+            {
+                tempdatabase.insertOrAssign(threatItr.key(), ThreatDetails(correlationId, timeStamp));
+            }
         }
 
-        database->swap(tempdatabase);
+        *database = std::move(tempdatabase);
         LOGINFO("Initialised Threat Database");
     }
 } // namespace Plugin
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Copyright 2022 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -11,8 +11,9 @@
 #include "Common/PersistentValue/PersistentValue.h"
 
 #include <chrono>
-#include <list>
-#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 namespace Plugin
 {
@@ -61,9 +62,57 @@ namespace Plugin
             }
         };
 
+        /**
+         * Threats keyed by threat ID, with an index from correlation ID back to threat ID
+         */
+        class ThreatIndex
+        {
+        public:
+            using map_type = std::unordered_map<std::string, ThreatDetails>;
+
+            [[nodiscard]] std::size_t size() const { return m_threats.size(); }
+            [[nodiscard]] bool empty() const { return m_threats.empty(); }
+            [[nodiscard]] map_type::const_iterator begin() const { return m_threats.begin(); }
+            [[nodiscard]] map_type::const_iterator end() const { return m_threats.end(); }
+            [[nodiscard]] map_type::const_iterator find(const std::string& threatId) const
+            {
+                return m_threats.find(threatId);
+            }
+            [[nodiscard]] const ThreatDetails& at(const std::string& threatId) const { return m_threats.at(threatId); }
+            [[nodiscard]] map_type::const_iterator findCorrelationId(const std::string& correlationId) const;
+
+            /**
+             * Adds the threat, or replaces the correlation ID and detection time of an existing one
+             */
+            void insertOrAssign(const std::string& threatId, ThreatDetails details);
+            bool erase(const std::string& threatId);
+            void clear();
+
+        private:
+            void eraseCorrelationId(const std::string& correlationId, const std::string& threatId);
+
+            map_type m_threats;
+            std::unordered_map<std::string, std::string> m_threatIdByCorrelationId;
+        };
+
+        // Journal entries written since the last snapshot before the database is compacted
+        static constexpr std::size_t MIN_JOURNAL_ENTRIES_BEFORE_COMPACTION = 1000;
+
         void convertDatabaseToString();
         void convertStringToDatabase();
-        mutable common::LockableData<std::map<std::string, ThreatDetails>> m_database;
+        static std::string serialise(const ThreatIndex& database);
+
+        /**
+         * Appends a change to the journal, compacting it into the snapshot once it is large.
+         * Must be called with m_database locked.
+         */
+        void journal(ThreatIndex& database, const std::string& change);
+        void compact(const ThreatIndex& database);
+        void replayJournal(ThreatIndex& database);
+
+        mutable common::LockableData<ThreatIndex> m_database;
         Common::PersistentValue<std::string> m_databaseInString;
+        std::string m_journalPath;
+        std::size_t m_journalEntries = 0;
     };
 } // namespace Plugin
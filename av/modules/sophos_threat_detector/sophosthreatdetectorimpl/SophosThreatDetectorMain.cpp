@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 // Class
 #include "SophosThreatDetectorMain.h"
@@ -28,15 +28,20 @@
 // SPL Base
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
 #include "Common/Exceptions/IException.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
 
 // C++ 3rd Party
 #ifdef INIT_BOOST
 #define BOOST_LOCALE_HIDE_AUTO_PTR
 #include <boost/locale.hpp>
 #endif
+#include <nlohmann/json.hpp>
 
 // C++ standard
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
 #include <fstream>
@@ -235,6 +240,89 @@ namespace sspl::sophosthreatdetectorimpl
             ofs.close();
         }
 
+        /*
+         * Number of scanners to create before accepting scan requests, from "warmStartScanners" in the threat
+         * detector config. Warm start loads SUSI on every start, including the idle restarts that lazy loading
+         * keeps cheap, so it is off unless configured.
+         */
+        int warm_start_scanners(const fs::path& configFile)
+        {
+            auto* fileSystem = Common::FileSystem::fileSystem();
+            try
+            {
+                if (!fileSystem->isFile(configFile))
+                {
+                    return 0;
+                }
+                auto settings = nlohmann::json::parse(fileSystem->readFile(configFile));
+                return std::max(0, settings.value("warmStartScanners", 0));
+            }
+            catch (const Common::FileSystem::IFileSystemException& ex)
+            {
+                LOGWARN("Failed to read threat detector config: " << ex.what());
+            }
+            catch (const nlohmann::json::exception& ex)
+            {
+                LOGWARN("Unexpected error when reading threat detector config: " << ex.what());
+            }
+            return 0;
+        }
+
+        /*
+         * Warm scanners are only handed to scan requests with the same configuration, and on-access asks for PUA
+         * detection according to its policy. The policy is outside the chroot, so this has to be read first.
+         */
+        bool on_access_detects_puas(const fs::path& pluginInstall)
+        {
+            auto* fileSystem = Common::FileSystem::fileSystem();
+            const fs::path policyPath = pluginInstall / "var/on_access_policy.json";
+            try
+            {
+                if (fileSystem->isFile(policyPath))
+                {
+                    auto policy = nlohmann::json::parse(fileSystem->readFile(policyPath));
+                    auto detectPUAs = policy.value("detectPUAs", nlohmann::json(true));
+                    return detectPUAs.is_string() ? detectPUAs.get<std::string>() != "false" : detectPUAs != false;
+                }
+            }
+            catch (const Common::FileSystem::IFileSystemException& ex)
+            {
+                LOGDEBUG("Failed to read on-access policy for warm start: " << ex.what());
+            }
+            catch (const nlohmann::json::exception& ex)
+            {
+                LOGDEBUG("Failed to parse on-access policy for warm start: " << ex.what());
+            }
+            return true;
+        }
+
+        long toMilliseconds(std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+        }
+
+        // Read by the AV plugin for telemetry
+        void record_startup_timings(
+            const fs::path& chrootPath,
+            std::chrono::steady_clock::duration setup,
+            std::chrono::steady_clock::duration warmUp,
+            std::chrono::steady_clock::duration total)
+        {
+            nlohmann::json record;
+            record["setupMs"] = toMilliseconds(setup);
+            record["warmUpMs"] = toMilliseconds(warmUp);
+            record["totalMs"] = toMilliseconds(total);
+
+            try
+            {
+                Common::FileSystem::fileSystem()->writeFileAtomically(
+                    chrootPath / "var/startup_status.json", record.dump(), chrootPath / "tmp", 0640);
+            }
+            catch (const Common::FileSystem::IFileSystemException& ex)
+            {
+                LOGWARN("Failed to record startup timings: " << ex.what());
+            }
+        }
 
     } // namespace
 
@@ -356,6 +444,7 @@ namespace sspl::sophosthreatdetectorimpl
     int SophosThreatDetectorMain::inner_main(const IThreatDetectorResourcesSharedPtr& resources)
     {
         assert(resources);
+        const auto startTime = std::chrono::steady_clock::now();
         m_sysCallWrapper = resources->createSystemCallWrapper();
 
         auto processForceExitTimer = std::make_shared<ProcessForceExitTimer>(10s, m_sysCallWrapper);
@@ -376,6 +465,9 @@ namespace sspl::sophosthreatdetectorimpl
         // Load proxy settings
         setProxyFromConfigFile();
 
+        const int warmStartScanners = warm_start_scanners(threat_detector_config(pluginInstall));
+        const bool onAccessDetectsPUAs = warmStartScanners > 0 && on_access_detects_puas(pluginInstall);
+
 
         LOGDEBUG("Preparing to enter chroot at: " << chrootPath);
 #ifdef USE_CHROOT
@@ -480,6 +572,7 @@ namespace sspl::sophosthreatdetectorimpl
             return common::E_CLEAN_SUCCESS;
         }
 
+        const auto setupDuration = std::chrono::steady_clock::now() - startTime;
         if(!m_scannerFactory->update()) // always force an update during start-up
         {
             LOGFATAL("Update of scanner at startup failed exiting threat detector main");
@@ -496,6 +589,19 @@ namespace sspl::sophosthreatdetectorimpl
 
         auto usr1Monitor = resources->createUsr1Monitor(m_reloader);
 
+        // If configured, initialise SUSI and create scanners before accepting scan requests, otherwise the first
+        // on-access events after a start or restart wait several seconds for SUSI
+        const auto warmUpStart = std::chrono::steady_clock::now();
+        if (warmStartScanners > 0)
+        {
+            m_scannerFactory->loadSusiSettingsIfRequired();
+            if (m_scannerFactory->warmUp(warmStartScanners, onAccessDetectsPUAs))
+            {
+                LOGINFO("SUSI initialised before accepting scan requests");
+            }
+        }
+        const auto warmUpDuration = std::chrono::steady_clock::now() - warmUpStart;
+
         auto server = resources->createScanningServerSocket(scanningSocketPath, 0666, m_scannerFactory);
         common::ThreadRunner scanningServerSocketThread (server, "scanningServerSocket", true);
 
@@ -506,7 +612,10 @@ namespace sspl::sophosthreatdetectorimpl
             resources->createMetadataRescanServerSocket(Plugin::getMetadataRescanSocketPath(), 0600, m_scannerFactory);
         common::ThreadRunner metadataRescanServerSocketThread(metadataRescanServer, "metadataRescanServerSocket", true);
 
-        m_scannerFactory->loadSusiSettingsIfRequired();
+        m_updateCompleteNotifier->publishReady();
+        const auto startupDuration = std::chrono::steady_clock::now() - startTime;
+        record_startup_timings(chrootPath, setupDuration, warmUpDuration, startupDuration);
+        LOGINFO("Sophos Threat Detector ready to scan after " << toMilliseconds(startupDuration) << "ms");
 
         int returnCode = common::E_CLEAN_SUCCESS;
 
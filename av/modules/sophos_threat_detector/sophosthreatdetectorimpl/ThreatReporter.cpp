@@ -1,32 +1,154 @@
-// Copyright 2021-2022, Sophos Limited.  All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #include "ThreatReporter.h"
 
 #include "Logger.h"
 
-#include "unixsocket/threatReporterSocket/ThreatReporterClient.h"
+#include "common/StringUtils.h"
 
-namespace fs = sophos_filesystem;
+#include <algorithm>
+#include <iterator>
+#include <vector>
 
-sspl::sophosthreatdetectorimpl::ThreatReporter::ThreatReporter(
-    sspl::sophosthreatdetectorimpl::ThreatReporter::path  threatReporterSocketPath)
-    : m_threatReporterSocketPath(std::move(threatReporterSocketPath))
+using namespace sspl::sophosthreatdetectorimpl;
+
+ThreatReporter::ThreatReporter(ThreatReporter::path threatReporterSocketPath) :
+    m_threatReporterSocketPath(std::move(threatReporterSocketPath)), m_thread(&ThreatReporter::run, this)
 {
+    LOGDEBUG("Threat reporter path " << m_threatReporterSocketPath);
 }
 
-void sspl::sophosthreatdetectorimpl::ThreatReporter::sendThreatReport(
-    const scan_messages::ThreatDetected& threatDetected)
+ThreatReporter::~ThreatReporter()
 {
-    try
     {
-        fs::path threatReporterSocketPath = m_threatReporterSocketPath;
-        LOGDEBUG("Threat reporter path " << threatReporterSocketPath);
-        unixsocket::ThreatReporterClientSocket threatReporterSocket(threatReporterSocketPath);
+        std::lock_guard lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_wakeUp.notify_all();
+    m_spaceAvailable.notify_all();
+    m_thread.join();
+}
 
-        threatReporterSocket.sendThreatDetection(threatDetected);
+void ThreatReporter::sendThreatReport(const scan_messages::ThreatDetected& threatDetected)
+{
+    try
+    {
+        unixsocket::SerialisedThreatDetected report(threatDetected);
+        std::unique_lock lock(m_mutex);
+        // Holding up the scan is better than losing the report while the AV plugin catches up
+        if (!m_spaceAvailable.wait_for(
+                lock, QUEUE_FULL_TIMEOUT, [this] { return m_stopRequested || m_queue.size() < MAX_QUEUED_REPORTS; }) ||
+            m_stopRequested)
+        {
+            LOGERROR(
+                "Threat report queue is full, dropping report of " << threatDetected.threatName << " in "
+                                                                   << common::pathForLogging(threatDetected.filePath));
+            return;
+        }
+        m_queue.push_back(std::move(report));
     }
     catch (const std::exception& e)
     {
         LOGERROR("Failed to send threat report: " << e.what());
+        return;
+    }
+    m_wakeUp.notify_one();
+}
+
+void ThreatReporter::sendQueued(unixsocket::ThreatReporterClientSocket& client, std::unique_lock<std::mutex>& lock)
+{
+    // Everything queued while the previous batch was being sent goes in the next one
+    lock.unlock();
+    std::size_t maxBatchSize = client.acceptsBatches() ? MAX_BATCH_SIZE : 1;
+    lock.lock();
+    auto batchEnd = m_queue.begin() + static_cast<std::ptrdiff_t>(std::min(m_queue.size(), maxBatchSize));
+    std::vector<unixsocket::SerialisedThreatDetected> batch(
+        std::make_move_iterator(m_queue.begin()), std::make_move_iterator(batchEnd));
+    m_queue.erase(m_queue.begin(), batchEnd);
+    m_spaceAvailable.notify_all();
+
+    lock.unlock();
+    try
+    {
+        client.sendThreatDetections(batch);
+        LOGDEBUG("Sent " << batch.size() << " threat reports");
+        lock.lock();
     }
-}
\ No newline at end of file
+    catch (...)
+    {
+        lock.lock();
+        // Put the batch back at the front so that reports keep their order when resent
+        m_queue.insert(m_queue.begin(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        throw;
+    }
+}
+
+void ThreatReporter::run()
+{
+    std::unique_ptr<unixsocket::ThreatReporterClientSocket> client;
+    auto reconnectDelay = MIN_RECONNECT_DELAY;
+
+    std::unique_lock lock(m_mutex);
+    while (true)
+    {
+        m_wakeUp.wait(lock, [this] { return m_stopRequested || !m_queue.empty(); });
+        if (m_stopRequested)
+        {
+            break;
+        }
+
+        if (!client)
+        {
+            // Only one attempt per connection, so that the back-off below can be interrupted when stopping
+            lock.unlock();
+            auto newClient = std::make_unique<unixsocket::ThreatReporterClientSocket>(
+                m_threatReporterSocketPath, unixsocket::BaseClient::DEFAULT_SLEEP_TIME, nullptr, 1);
+            lock.lock();
+
+            if (!newClient->isConnected())
+            {
+                auto delayMs = std::chrono::duration_cast<std::chrono::milliseconds>(reconnectDelay).count();
+                if (reconnectDelay == MIN_RECONNECT_DELAY)
+                {
+                    LOGWARN("Failed to connect to " << m_threatReporterSocketPath << ", retrying in " << delayMs << "ms");
+                }
+                else
+                {
+                    LOGDEBUG("Failed to connect to " << m_threatReporterSocketPath << ", retrying in " << delayMs << "ms");
+                }
+                m_wakeUp.wait_for(lock, reconnectDelay, [this] { return m_stopRequested; });
+                reconnectDelay = std::min(reconnectDelay * 2, MAX_RECONNECT_DELAY);
+                continue;
+            }
+            client = std::move(newClient);
+            reconnectDelay = MIN_RECONNECT_DELAY;
+        }
+
+        try
+        {
+            sendQueued(*client, lock);
+        }
+        catch (const std::exception& e)
+        {
+            LOGWARN("Failed to send threat reports, reconnecting: " << e.what());
+            client.reset();
+        }
+    }
+
+    // Best effort to deliver anything still queued, without reconnecting
+    try
+    {
+        while (client && !m_queue.empty())
+        {
+            sendQueued(*client, lock);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        LOGWARN("Failed to send threat reports while stopping: " << e.what());
+    }
+    if (!m_queue.empty())
+    {
+        LOGERROR("Discarding " << m_queue.size() << " unsent threat reports");
+    }
+}
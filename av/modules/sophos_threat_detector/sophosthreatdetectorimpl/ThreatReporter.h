@@ -1,22 +1,59 @@
-// Copyright 2021-2022, Sophos Limited.  All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "sophos_threat_detector/threat_scanner/IThreatReporter.h"
 
+#include "unixsocket/threatReporterSocket/ThreatReporterClient.h"
+
 #include "datatypes/sophos_filesystem.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace sspl::sophosthreatdetectorimpl
 {
+    /**
+     * Sends threat reports to the AV plugin over one long-lived connection.
+     *
+     * Reports are queued by sendThreatReport and sent from a background thread, several to a frame when they
+     * arrive faster than they can be sent and the AV plugin has said it reads batches. If the connection fails the
+     * thread reconnects with exponential back-off, keeping up to MAX_QUEUED_REPORTS reports. When the queue is full
+     * sendThreatReport waits up to QUEUE_FULL_TIMEOUT for space, and logs the report as dropped if there is none.
+     */
     class ThreatReporter : public threat_scanner::IThreatReporter
     {
     public:
         using path = sophos_filesystem::path;
+        using clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t MAX_QUEUED_REPORTS = 256;
+        static constexpr std::size_t MAX_BATCH_SIZE = 64;
+        static constexpr clock::duration QUEUE_FULL_TIMEOUT = std::chrono::seconds{ 1 };
+        static constexpr clock::duration MIN_RECONNECT_DELAY = std::chrono::milliseconds{ 100 };
+        static constexpr clock::duration MAX_RECONNECT_DELAY = std::chrono::seconds{ 10 };
+
         explicit ThreatReporter(path threatReporterSocketPath);
+        ~ThreatReporter() override;
 
         void sendThreatReport(const scan_messages::ThreatDetected& threatDetected) override;
 
     private:
+        void run();
+        void sendQueued(unixsocket::ThreatReporterClientSocket& client, std::unique_lock<std::mutex>& lock);
+
         sophos_filesystem::path m_threatReporterSocketPath;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::condition_variable m_spaceAvailable;
+        std::deque<unixsocket::SerialisedThreatDetected> m_queue;
+        bool m_stopRequested = false;
+
+        // Last, so it starts after everything it uses is constructed
+        std::thread m_thread;
     };
 } // namespace sspl::sophosthreatdetectorimpl
@@ -1,4 +1,4 @@
-// Copyright 2020-2022 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -16,6 +16,8 @@ namespace threat_scanner
         virtual ~ISusiWrapperFactory() = default;
 
         virtual bool update() = 0;
+        // True if the last update found the data already up to date
+        virtual bool lastUpdateWasUpToDate() = 0;
         virtual bool reload() = 0;
         virtual void shutdown() = 0;
         virtual bool susiIsInitialized() = 0;
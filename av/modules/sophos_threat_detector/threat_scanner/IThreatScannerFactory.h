@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -19,6 +19,15 @@ namespace threat_scanner
         virtual bool updateSusiConfig() = 0;
         virtual bool detectPUAsEnabled() = 0;
         virtual void loadSusiSettingsIfRequired() = 0;
+
+        /**
+         * Initialise SUSI and create scanners for on-access scan requests, so the first scans after a
+         * start or restart don't have to wait for them.
+         * @param detectPUAs whether on-access asks for PUA detection, since scanners are only reused for
+         * requests with the same configuration
+         * @return false if SUSI couldn't be initialised, in which case it will be retried on the first scan
+         */
+        virtual bool warmUp(int scannerCount, bool detectPUAs) = 0;
     };
     using IThreatScannerFactorySharedPtr = std::shared_ptr<IThreatScannerFactory>;
 }
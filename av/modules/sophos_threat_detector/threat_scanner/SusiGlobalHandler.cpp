@@ -135,32 +135,52 @@ namespace threat_scanner
 
     bool SusiGlobalHandler::update(const std::string& path, const std::string& lockfile)
     {
-        /*
-         * We have to hold the init lock while checking if we have init,
-         * and saving the values if not.
-         *
-         * We have to hold the lock, otherwise we could get interrupted on the "m_updatePath = path;" line, and
-         * init could finish, causing no-one to complete the update.
-         */
-        // We assume update is rare enough to just always take the lock
-        std::lock_guard susiLock(m_globalSusiMutex);
-
-        if (!m_susiInitialised.load(std::memory_order_acquire))
         {
-            m_updatePath = path;
-            m_lockFile = lockfile;
-            m_updatePending.store(true, std::memory_order_release);
-            LOGDEBUG("Threat scanner update is pending");
-            return true;
+            /*
+             * We have to hold the init lock while checking if we have init,
+             * and saving the values if not.
+             *
+             * We have to hold the lock, otherwise we could get interrupted on the "m_updatePath = path;" line, and
+             * init could finish, causing no-one to complete the update.
+             */
+            std::lock_guard susiLock(m_globalSusiMutex);
+
+            if (!m_susiInitialised.load(std::memory_order_acquire))
+            {
+                m_updatePath = path;
+                m_lockFile = lockfile;
+                m_updatePending.store(true, std::memory_order_release);
+                LOGDEBUG("Threat scanner update is pending");
+                return true;
+            }
         }
 
-        return internal_update(path, lockfile);
+        // Once initialised SUSI stays initialised, so we can wait for the updater to finish with update_source
+        // without blocking reloads and scanner creation
+        auto lockStart = std::chrono::steady_clock::now();
+        auto fd = acquireUpdateLock(lockfile);
+        auto lockWait = std::chrono::steady_clock::now() - lockStart;
+
+        std::lock_guard susiLock(m_globalSusiMutex);
+        return applyUpdate(path, lockfile, fd, lockWait);
+    }
+
+    bool SusiGlobalHandler::lastUpdateWasUpToDate()
+    {
+        return m_lastUpdateWasUpToDate.load(std::memory_order_acquire);
     }
 
     bool SusiGlobalHandler::internal_update(const std::string& path, const std::string& lockfile)
+    {
+        auto lockStart = std::chrono::steady_clock::now();
+        auto fd = acquireUpdateLock(lockfile);
+        return applyUpdate(path, lockfile, fd, std::chrono::steady_clock::now() - lockStart);
+    }
+
+    datatypes::AutoFd SusiGlobalHandler::acquireUpdateLock(const std::string& lockfile)
     {
         mode_t mode = S_IRUSR | S_IWUSR;
-        datatypes::AutoFd fd(open(lockfile.c_str(), O_RDWR | O_CREAT, mode));
+        datatypes::AutoFd fd(open(lockfile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, mode));
         if (!fd.valid())
         {
             std::stringstream errorMsg;
@@ -188,14 +208,25 @@ namespace threat_scanner
             nanosleep(&timeout, nullptr);
         }
         LOGDEBUG("Acquired lock on " << lockfile);
+        return fd;
+    }
 
+    bool SusiGlobalHandler::applyUpdate(
+        const std::string& path,
+        const std::string& lockfile,
+        datatypes::AutoFd& lockFd,
+        std::chrono::steady_clock::duration lockWait)
+    {
         assert(m_susiInitialised.load(std::memory_order_acquire));
         // SUSI is always initialised by the time we get here
         LOGDEBUG("Calling SUSI_Update");
+        auto updateStart = std::chrono::steady_clock::now();
         SusiResult updateResult =  m_susiWrapper->SUSI_Update(path.c_str());
-        recordUpdateResult(updateResult);
+        auto updateDuration = std::chrono::steady_clock::now() - updateStart;
+        m_lastUpdateWasUpToDate.store(updateResult == SUSI_I_UPTODATE, std::memory_order_release);
+        recordUpdateResult(updateResult, lockWait, updateDuration);
         m_updatePending.store(false, std::memory_order_release);
-        if (releaseLock(fd))
+        if (releaseLock(lockFd))
         {
             LOGDEBUG("Released lock on " << lockfile);
         }
@@ -494,7 +525,10 @@ namespace threat_scanner
         return false;
     }
 
-    void SusiGlobalHandler::recordUpdateResult(SusiResult updateResult)
+    void SusiGlobalHandler::recordUpdateResult(
+        SusiResult updateResult,
+        std::chrono::steady_clock::duration lockWait,
+        std::chrono::steady_clock::duration updateDuration)
     {
         bool failure = SUSI_FAILURE(updateResult);
 
@@ -503,6 +537,9 @@ namespace threat_scanner
 
         record["result"] = updateResult;
         record["success"] = !failure;
+        // Read by the AV plugin for telemetry: scans can only be held up by SUSI_Update itself
+        record["lockWaitMs"] = std::chrono::duration_cast<std::chrono::milliseconds>(lockWait).count();
+        record["updateDurationMs"] = std::chrono::duration_cast<std::chrono::milliseconds>(updateDuration).count();
 
         if (updateResult == SUSI_I_UPTODATE)
         {
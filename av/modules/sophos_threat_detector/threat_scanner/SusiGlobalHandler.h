@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -13,6 +13,7 @@
 #include "common/ThreatDetector/SusiSettings.h"
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -41,11 +42,20 @@ namespace threat_scanner
         /**
          * Update SUSI if initialized, otherwise store the update for later.
          *
+         * Waits for the update lock before taking the global SUSI lock, so that reloads and scanner creation are
+         * only held up for the SUSI_Update call itself.
+         *
          * @param path
          * @return true if the update was successful or wasn't attempted.
          */
         bool update(const std::string& path, const std::string& lockfile);
 
+        /**
+         * @return true if the last update found SUSI already up to date, so results cached from the current data are
+         * still valid
+         */
+        bool lastUpdateWasUpToDate();
+
         /**
          * Reload SUSI global config if SUSI is initialized.
          *
@@ -125,6 +135,7 @@ namespace threat_scanner
         std::atomic_bool m_susiInitialised = false;
         std::atomic_bool m_updatePending = false;
         std::atomic_bool m_shuttingDown = false;
+        std::atomic_bool m_lastUpdateWasUpToDate = false;
         std::string m_updatePath;
         std::string m_lockFile;
         std::mutex m_globalSusiMutex;
@@ -145,12 +156,31 @@ namespace threat_scanner
          */
         bool internal_update(const std::string& path, const std::string& lockfile);
 
+        /**
+         * Opens and locks the update lock file, retrying for up to 10 seconds.
+         * Does not need m_globalSusiMutex.
+         */
+        datatypes::AutoFd acquireUpdateLock(const std::string& lockfile);
+
+        /**
+         * Calls SUSI_Update and releases the update lock. Caller must hold m_globalSusiMutex and the update lock.
+         * @return true if update was successful
+         */
+        bool applyUpdate(
+            const std::string& path,
+            const std::string& lockfile,
+            datatypes::AutoFd& lockFd,
+            std::chrono::steady_clock::duration lockWait);
+
         static bool acquireLock(datatypes::AutoFd& fd);
         static bool releaseLock(datatypes::AutoFd& fd);
 
         void logSusiVersion();
 
-        void recordUpdateResult(SusiResult);
+        void recordUpdateResult(
+            SusiResult,
+            std::chrono::steady_clock::duration lockWait,
+            std::chrono::steady_clock::duration updateDuration);
 
         void loadSusiSettingsIfRequiredLocked(std::lock_guard<std::mutex>& lock);
 
@@ -1,4 +1,4 @@
-// Copyright 2020-2022 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "SusiScannerFactory.h"
 
@@ -6,8 +6,11 @@
 #include "ScannerInfo.h"
 #include "SusiScanner.h"
 #include "SusiWrapperFactory.h"
+#include "ThreatScannerException.h"
 #include "UnitScanner.h"
 
+#include "common/FailedToInitializeSusiException.h"
+
 #include <utility>
 
 namespace threat_scanner
@@ -16,13 +19,63 @@ namespace threat_scanner
     {
         m_detectPUAs = detectPUAs;
         std::string scannerConfig = "{" + createScannerInfo(scanArchives, scanImages, detectPUAs, m_wrapperFactory->isMachineLearningEnabled()) + "}";
-        auto unitScanner = std::make_unique<UnitScanner>(m_wrapperFactory->createSusiWrapper(scannerConfig));
+        auto susiWrapper = takeWarmScanner(scannerConfig);
+        if (!susiWrapper)
+        {
+            susiWrapper = m_wrapperFactory->createSusiWrapper(scannerConfig);
+        }
+        auto unitScanner = std::make_unique<UnitScanner>(std::move(susiWrapper));
         return std::make_unique<SusiScanner>(std::move(unitScanner),
                                              m_reporter,
                                              m_shutdownTimer,
                                              m_wrapperFactory->accessGlobalHandler());
     }
 
+    ISusiWrapperSharedPtr SusiScannerFactory::takeWarmScanner(const std::string& scannerConfig)
+    {
+        std::lock_guard lock(m_warmScannersMutex);
+        if (m_warmScanners.empty() || scannerConfig != m_warmScannerConfig)
+        {
+            return nullptr;
+        }
+        auto susiWrapper = std::move(m_warmScanners.back());
+        m_warmScanners.pop_back();
+        return susiWrapper;
+    }
+
+    bool SusiScannerFactory::warmUp(int scannerCount, bool detectPUAs)
+    {
+        // Matches the scan requests sent by on-access, which is what needs to be fast after a restart
+        std::string scannerConfig =
+            "{" + createScannerInfo(false, false, detectPUAs, m_wrapperFactory->isMachineLearningEnabled()) + "}";
+
+        std::vector<ISusiWrapperSharedPtr> scanners;
+        try
+        {
+            for (int i = 0; i < scannerCount; ++i)
+            {
+                scanners.push_back(m_wrapperFactory->createSusiWrapper(scannerConfig));
+            }
+        }
+        catch (const FailedToInitializeSusiException& ex)
+        {
+            LOGWARN("Failed to initialise SUSI during warm start: " << ex.what());
+            return false;
+        }
+        catch (const ThreatScannerException& ex)
+        {
+            // SUSI is initialised, so scans can still create their own scanners
+            LOGWARN("Failed to create scanners during warm start: " << ex.what());
+            return true;
+        }
+
+        std::lock_guard lock(m_warmScannersMutex);
+        m_warmScannerConfig = std::move(scannerConfig);
+        m_warmScanners = std::move(scanners);
+        LOGDEBUG("Created " << m_warmScanners.size() << " scanners ahead of scan requests");
+        return true;
+    }
+
     SusiScannerFactory::SusiScannerFactory(
         ISusiWrapperFactorySharedPtr wrapperFactory,
         IThreatReporterSharedPtr reporter,
@@ -50,7 +103,12 @@ namespace threat_scanner
     bool SusiScannerFactory::update()
     {
         bool updated = m_wrapperFactory->update();
-        if (updated && m_updateCompleteCallback)
+        if (updated && m_wrapperFactory->lastUpdateWasUpToDate())
+        {
+            // Results cached by on-access were scanned with the current data, so there is no need to flush them
+            LOGDEBUG("SUSI data unchanged by update, not notifying clients");
+        }
+        else if (updated && m_updateCompleteCallback)
         {
             LOGDEBUG("Notify clients that the update has completed");
             m_updateCompleteCallback->updateComplete();
@@ -73,6 +131,11 @@ namespace threat_scanner
 
     void SusiScannerFactory::shutdown()
     {
+        {
+            // Unused scanners have to be destroyed before SUSI is terminated
+            std::lock_guard lock(m_warmScannersMutex);
+            m_warmScanners.clear();
+        }
         m_wrapperFactory->shutdown();
     }
 
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -9,6 +9,9 @@
 #include "IUpdateCompleteCallback.h"
 #include "SusiWrapperFactory.h"
 
+#include <mutex>
+#include <vector>
+
 #ifndef TEST_PUBLIC
 # define TEST_PUBLIC private
 #endif
@@ -42,11 +45,19 @@ namespace threat_scanner
             m_wrapperFactory->accessGlobalHandler()->loadSusiSettingsIfRequired();
         }
 
+        bool warmUp(int scannerCount, bool detectPUAs) override;
+
     private:
+        ISusiWrapperSharedPtr takeWarmScanner(const std::string& scannerConfig);
+
         ISusiWrapperFactorySharedPtr m_wrapperFactory;
         IThreatReporterSharedPtr m_reporter;
         IScanNotificationSharedPtr m_shutdownTimer;
         IUpdateCompleteCallbackPtr m_updateCompleteCallback;
         bool m_detectPUAs = true;
+
+        std::mutex m_warmScannersMutex;
+        std::string m_warmScannerConfig;
+        std::vector<ISusiWrapperSharedPtr> m_warmScanners;
     };
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "SusiWrapperFactory.h"
 
@@ -150,6 +150,11 @@ namespace threat_scanner
             pluginInstall() / "chroot/susi/update_source", pluginInstall() / "chroot/var/susi_update.lock");
     }
 
+    bool SusiWrapperFactory::lastUpdateWasUpToDate()
+    {
+        return m_globalHandler->lastUpdateWasUpToDate();
+    }
+
     bool SusiWrapperFactory::reload()
     {
         auto susiSettings = m_globalHandler->accessSusiSettings();
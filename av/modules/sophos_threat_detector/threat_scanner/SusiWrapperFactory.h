@@ -1,4 +1,4 @@
-// Copyright 2020-2022 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -14,6 +14,7 @@ namespace threat_scanner
         std::shared_ptr<ISusiWrapper> createSusiWrapper(const std::string& scannerConfig) override;
 
         bool update() override;
+        bool lastUpdateWasUpToDate() override;
         bool susiIsInitialized() override;
         bool reload() override;
         void shutdown() override;
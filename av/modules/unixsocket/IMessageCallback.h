@@ -1,14 +1,24 @@
-// Copyright 2020-2022, Sophos Limited.  All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "scan_messages/ThreatDetected.h"
 
 #include <string>
+#include <vector>
 
 class IMessageCallback
 {
 public:
     virtual ~IMessageCallback() = default;
     virtual void processMessage(scan_messages::ThreatDetected detection) = 0;
+
+    // Detections that arrived together in one batch; by default each is processed on its own
+    virtual void processMessages(std::vector<scan_messages::ThreatDetected> detections)
+    {
+        for (auto& detection : detections)
+        {
+            processMessage(std::move(detection));
+        }
+    }
 };
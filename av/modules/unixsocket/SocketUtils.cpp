@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "SocketUtils.h"
 
@@ -12,6 +12,7 @@
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -181,6 +182,126 @@ ssize_t unixsocket::send_fd(int socket, int fd)  // send fd by socket
     return sendmsg(socket, &msg, MSG_NOSIGNAL);
 }
 
+/**
+ * Receive several file descriptors sent together by send_fds
+ */
+std::vector<int> unixsocket::recv_fds(
+    Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper,
+    int socket,
+    std::size_t count)
+{
+    assert(count > 0 && count <= MAX_FDS_PER_MESSAGE);
+
+    // operator new aligns the buffer suitably for cmsghdr
+    std::vector<char> buf(CMSG_SPACE(sizeof(int) * count));
+    int dup = 0;
+    struct iovec io = { .iov_base = &dup, .iov_len = sizeof(dup) };
+
+    struct msghdr msg = {};
+    msg.msg_iov = &io;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf.data();
+    msg.msg_controllen = buf.size();
+
+    ssize_t ret = systemCallWrapper.recvmsg(socket, &msg, 0);
+    if (ret < 0)
+    {
+        LOGDEBUG("Failed to receive fds: " << common::safer_strerror(errno));
+        return {};
+    }
+
+    if (msg.msg_flags & MSG_CTRUNC)
+    {
+        LOGERROR("Control data was truncated when receiving fds");
+    }
+
+    std::vector<int> fds;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+        std::size_t received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        std::size_t offset = fds.size();
+        fds.resize(offset + received);
+        memcpy(fds.data() + offset, CMSG_DATA(cmsg), received * sizeof(int));
+    }
+
+    if (fds.size() != count)
+    {
+        LOGERROR("Failed to receive fds: expected " << count << " but got " << fds.size());
+        // close any fds we did receive, else we leak them
+        for (int temp_fd : fds)
+        {
+            close(temp_fd);
+        }
+        return {};
+    }
+    return fds;
+}
+
+ssize_t unixsocket::send_fds(int socket, const std::vector<int>& fds)
+{
+    assert(!fds.empty() && fds.size() <= MAX_FDS_PER_MESSAGE);
+
+    std::vector<char> buf(CMSG_SPACE(sizeof(int) * fds.size()));
+    int dup = 0;
+    struct iovec io = { .iov_base = &dup, .iov_len = sizeof(dup) };
+
+    struct msghdr msg = {};
+    msg.msg_iov = &io;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf.data();
+    msg.msg_controllen = buf.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    return sendmsg(socket, &msg, MSG_NOSIGNAL);
+}
+
+void unixsocket::writeBatch(
+    Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper,
+    int socket_fd,
+    const std::vector<std::string_view>& buffers)
+{
+    size_t markerSize;
+    auto marker = getLength(BATCH_MARKER, markerSize);
+    size_t countSize;
+    auto count = getLength(buffers.size(), countSize);
+
+    std::vector<buffer_ptr_t> lengths;
+    lengths.reserve(buffers.size());
+    std::vector<struct iovec> iov;
+    iov.reserve(2 + 2 * buffers.size());
+    iov.push_back({ .iov_base = marker.get(), .iov_len = markerSize });
+    iov.push_back({ .iov_base = count.get(), .iov_len = countSize });
+    size_t total = markerSize + countSize;
+    for (const auto& buffer : buffers)
+    {
+        size_t lengthSize;
+        lengths.push_back(getLength(buffer.size(), lengthSize));
+        iov.push_back({ .iov_base = lengths.back().get(), .iov_len = lengthSize });
+        iov.push_back({ .iov_base = const_cast<char*>(buffer.data()), .iov_len = buffer.size() });
+        total += lengthSize + buffer.size();
+    }
+
+    struct msghdr message{};
+    message.msg_iov = iov.data();
+    message.msg_iovlen = iov.size();
+
+    ssize_t bytes_written = systemCallWrapper.sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+    if (bytes_written < 0 || static_cast<size_t>(bytes_written) != total)
+    {
+        throw EnvironmentInterruption(__FUNCTION__);
+    }
+}
+
 bool unixsocket::writeLengthAndBufferAndFd(
     Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper,
     int socket_fd,
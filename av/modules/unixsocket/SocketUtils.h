@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -7,9 +7,12 @@
 #include "Common/SystemCallWrapper/ISystemCallWrapper.h"
 
 #include <chrono>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 namespace unixsocket
 {
@@ -21,6 +24,35 @@ namespace unixsocket
         const std::string& buffer);
     int recv_fd(Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper, int socket);
     ssize_t send_fd(int socket, int fd);
+
+    // The kernel's limit on file descriptors passed in one message (SCM_MAX_FD)
+    constexpr std::size_t MAX_FDS_PER_MESSAGE = 253;
+
+    /**
+     * Receives exactly count file descriptors sent in a single message by send_fds.
+     * Returns an empty vector on failure, closing any descriptors that were received.
+     */
+    std::vector<int> recv_fds(
+        Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper,
+        int socket,
+        std::size_t count);
+    ssize_t send_fds(int socket, const std::vector<int>& fds);
+
+    // The length that introduces a batch. A zero length is a keepalive, and Cap'n Proto messages are a whole number
+    // of 8 byte words, so no single message can have a length of 1.
+    constexpr std::size_t BATCH_MARKER = 1;
+    // Written by a server to each client that connects, if it reads batches. Older servers send nothing, so clients
+    // only send batches once they have seen it.
+    constexpr char BATCHES_ACCEPTED = 1;
+
+    /**
+     * Writes a batch in a single sendmsg: BATCH_MARKER, the number of buffers, then each buffer prefixed by its
+     * length. Throws EnvironmentInterruption if the batch is not written completely.
+     */
+    void writeBatch(
+        Common::SystemCallWrapper::ISystemCallWrapper& systemCallWrapper,
+        int socket_fd,
+        const std::vector<std::string_view>& buffers);
     ssize_t readFully(
         const Common::SystemCallWrapper::ISystemCallWrapperSharedPtr&,
         int socket_fd, char* buf, ssize_t bytes, std::chrono::milliseconds timeout);
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "ThreatReporterClient.h"
 
@@ -10,17 +10,31 @@
 
 #include "Common/SystemCallWrapper/SystemCallWrapper.h"
 
+#include <fcntl.h>
+#include <sys/socket.h>
+
 #include <cassert>
 #include <sstream>
 #include <string>
 
+unixsocket::SerialisedThreatDetected::SerialisedThreatDetected(const scan_messages::ThreatDetected& detection) :
+    message(detection.serialise()), fd(::fcntl(detection.autoFd.get(), F_DUPFD_CLOEXEC, 0))
+{
+    if (fd.get() < 0)
+    {
+        throw unixsocket::UnixSocketException(
+            LOCATION, "Failed to duplicate detection file descriptor: " + common::safer_strerror(errno));
+    }
+}
+
 unixsocket::ThreatReporterClientSocket::ThreatReporterClientSocket(
     std::string socket_path,
     const duration_t& sleepTime,
-    IStoppableSleeperSharedPtr sleeper)
+    IStoppableSleeperSharedPtr sleeper,
+    int maxRetries)
     : BaseClient(std::move(socket_path), "ThreatReporterClient", sleepTime, std::move(sleeper))
 {
-    connectWithRetries();
+    connectWithRetries(maxRetries);
 }
 
 void unixsocket::ThreatReporterClientSocket::sendThreatDetection(const scan_messages::ThreatDetected& detection)
@@ -48,4 +62,69 @@ void unixsocket::ThreatReporterClientSocket::sendThreatDetection(const scan_mess
     {
         LOGERROR(m_name << " failed to write to socket. Exception caught: " << e.what());
     }
-}
\ No newline at end of file
+}
+
+bool unixsocket::ThreatReporterClientSocket::acceptsBatches()
+{
+    if (!m_acceptsBatches && m_socket_fd >= 0)
+    {
+        char announcement = 0;
+        m_acceptsBatches = ::recv(m_socket_fd, &announcement, 1, MSG_DONTWAIT) == 1 && announcement == BATCHES_ACCEPTED;
+    }
+    return m_acceptsBatches;
+}
+
+void unixsocket::ThreatReporterClientSocket::sendThreatDetections(
+    const std::vector<SerialisedThreatDetected>& detections)
+{
+    assert(m_socket_fd >= 0);
+    assert(!detections.empty() && detections.size() <= MAX_FDS_PER_MESSAGE);
+
+    if (detections.size() == 1)
+    {
+        Common::SystemCallWrapper::SystemCallWrapper systemCallWrapper;
+        try
+        {
+            writeLengthAndBuffer(systemCallWrapper, m_socket_fd, detections.front().message);
+        }
+        catch (unixsocket::EnvironmentInterruption&)
+        {
+            std::stringstream errMsg;
+            errMsg << m_name << " failed to write to socket [" << common::safer_strerror(errno) << "]";
+            throw unixsocket::UnixSocketException(LOCATION, errMsg.str());
+        }
+        if (send_fd(m_socket_fd, detections.front().fd.get()) < 0)
+        {
+            throw unixsocket::UnixSocketException(LOCATION, m_name + " failed to write file descriptor to socket");
+        }
+        return;
+    }
+    assert(m_acceptsBatches);
+
+    std::vector<std::string_view> messages;
+    std::vector<int> fds;
+    messages.reserve(detections.size());
+    fds.reserve(detections.size());
+    for (const auto& detection : detections)
+    {
+        messages.push_back(detection.message);
+        fds.push_back(detection.fd.get());
+    }
+
+    try
+    {
+        Common::SystemCallWrapper::SystemCallWrapper systemCallWrapper;
+        writeBatch(systemCallWrapper, m_socket_fd, messages);
+    }
+    catch (unixsocket::EnvironmentInterruption&)
+    {
+        std::stringstream errMsg;
+        errMsg << m_name << " failed to write to socket [" << common::safer_strerror(errno) << "]";
+        throw unixsocket::UnixSocketException(LOCATION, errMsg.str());
+    }
+
+    if (send_fds(m_socket_fd, fds) < 0)
+    {
+        throw unixsocket::UnixSocketException(LOCATION, m_name + " failed to write file descriptors to socket");
+    }
+}
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -11,14 +11,49 @@
 #include "datatypes/AutoFd.h"
 
 #include <string>
+#include <vector>
 
 namespace unixsocket
 {
+    /**
+     * A detection serialised ready to send, holding its own duplicate of the detection's file descriptor so it can
+     * be queued after the original has been closed.
+     */
+    struct SerialisedThreatDetected
+    {
+        explicit SerialisedThreatDetected(const scan_messages::ThreatDetected& detection);
+
+        std::string message;
+        datatypes::AutoFd fd;
+    };
+
     class ThreatReporterClientSocket final : public BaseClient
     {
     public:
-        explicit ThreatReporterClientSocket(std::string socket_path, const duration_t& sleepTime=DEFAULT_SLEEP_TIME, IStoppableSleeperSharedPtr sleeper={});
+        explicit ThreatReporterClientSocket(
+            std::string socket_path,
+            const duration_t& sleepTime = DEFAULT_SLEEP_TIME,
+            IStoppableSleeperSharedPtr sleeper = {},
+            int maxRetries = DEFAULT_MAX_RETRIES);
 
         void sendThreatDetection(const scan_messages::ThreatDetected& detection);
+
+        /**
+         * Whether the server has said it reads batches. Checked without blocking, so it can be false for a moment
+         * after connecting to a server that does.
+         */
+        bool acceptsBatches();
+
+        /**
+         * Sends the detections as one batch, with all of their file descriptors in a single message. A single
+         * detection is sent in the same frame as sendThreatDetection, so any server can read it. More than one
+         * requires acceptsBatches().
+         * Unlike sendThreatDetection, throws UnixSocketException if the connection fails part way, so that the
+         * caller can reconnect and resend.
+         */
+        void sendThreatDetections(const std::vector<SerialisedThreatDetected>& detections);
+
+    private:
+        bool m_acceptsBatches = false;
     };
 }
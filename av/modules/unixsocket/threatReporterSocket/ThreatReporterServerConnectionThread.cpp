@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "ThreatReporterServerConnectionThread.h"
 
@@ -18,9 +18,9 @@
 #include <capnp/serialize.h>
 
 #include <cassert>
-#include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 using namespace unixsocket;
 
@@ -121,6 +121,57 @@ void ThreatReporterServerConnectionThread::inner_run()
     bool loggedLengthOfZero = false;
     auto sysCalls = std::make_shared<Common::SystemCallWrapper::SystemCallWrapper>();
 
+    // Tells the client it can send batches. Clients that don't send them never read it.
+    if (::send(socket_fd, &unixsocket::BATCHES_ACCEPTED, 1, MSG_NOSIGNAL | MSG_DONTWAIT) != 1)
+    {
+        LOGDEBUG(m_threadName << " failed to announce batch support: " << common::safer_strerror(errno));
+    }
+
+    auto readDetection = [&](ssize_t length, std::vector<scan_messages::ThreatDetected>& detections)
+    {
+        // read capn proto
+        if (static_cast<uint32_t>(length) > (buffer_size * sizeof(capnp::word)))
+        {
+            buffer_size = 1 + length / sizeof(capnp::word);
+            proto_buffer = kj::heapArray<capnp::word>(buffer_size);
+            loggedLengthOfZero = false;
+        }
+
+        ssize_t bytes_read = unixsocket::readFully(sysCalls,
+                                                   socket_fd,
+                                                   reinterpret_cast<char*>(proto_buffer.begin()),
+                                                   length,
+                                                   readTimeout_);
+        if (bytes_read < 0)
+        {
+            LOGERROR("Aborting " << m_threadName << ": " << errno);
+            return false;
+        }
+        else if (bytes_read != length)
+        {
+            LOGERROR("Aborting " << m_threadName << ": failed to read entire message");
+            return false;
+        }
+
+        LOGDEBUG("Read capn of " << bytes_read);
+
+        try
+        {
+            detections.push_back(parseDetection(proto_buffer, bytes_read));
+        }
+        catch (const std::exception& e)
+        {
+            LOGERROR("Aborting " << m_threadName << ": Failed to parse detection: " << e.what());
+            return false;
+        }
+
+        if (detections.back().filePath.empty())
+        {
+            LOGERROR(m_threadName << " missing file path in detection report ( size=" << bytes_read << ")");
+        }
+        return true;
+    };
+
     while (true)
     {
         auto ret = m_sysCalls->ppoll(fds, std::size(fds), nullptr, nullptr);
@@ -178,59 +229,73 @@ void ThreatReporterServerConnectionThread::inner_run()
                 continue;
             }
 
-            // read capn proto
-            if (static_cast<uint32_t>(length) > (buffer_size * sizeof(capnp::word)))
-            {
-                buffer_size = 1 + length / sizeof(capnp::word);
-                proto_buffer = kj::heapArray<capnp::word>(buffer_size);
-                loggedLengthOfZero = false;
-            }
-
-            ssize_t bytes_read = unixsocket::readFully(sysCalls,
-                                                       socket_fd,
-                                                       reinterpret_cast<char*>(proto_buffer.begin()),
-                                                       length,
-                                                       readTimeout_);
-            if (bytes_read < 0)
+            std::vector<scan_messages::ThreatDetected> detections;
+            if (static_cast<size_t>(length) == unixsocket::BATCH_MARKER)
             {
-                LOGERROR("Aborting " << m_threadName << ": " << errno);
-                break;
-            }
-            else if (bytes_read != length)
-            {
-                LOGERROR("Aborting " << m_threadName << ": failed to read entire message");
-                break;
-            }
+                // A batch: the number of detections, each detection prefixed by its length, and then the file
+                // descriptors for all of them in one message
+                auto count = unixsocket::readLength(socket_fd);
+                if (count == -2)
+                {
+                    LOGDEBUG(m_threadName << " closed: EOF");
+                    break;
+                }
+                else if (count <= 0 || static_cast<size_t>(count) > unixsocket::MAX_FDS_PER_MESSAGE)
+                {
+                    LOGERROR("Aborting " << m_threadName << ": failed to read batch size");
+                    break;
+                }
 
-            LOGDEBUG("Read capn of " << bytes_read);
+                detections.reserve(count);
+                for (ssize_t i = 0; i < count; ++i)
+                {
+                    length = unixsocket::readLength(socket_fd);
+                    if (length <= 0)
+                    {
+                        LOGERROR("Aborting " << m_threadName << ": failed to read length");
+                        break;
+                    }
+                    if (!readDetection(length, detections))
+                    {
+                        break;
+                    }
+                }
+                if (detections.size() != static_cast<size_t>(count))
+                {
+                    break;
+                }
 
-            std::optional<scan_messages::ThreatDetected> threatDetectedOptional;
-            try
-            {
-                threatDetectedOptional = parseDetection(proto_buffer, bytes_read);
+                auto received = unixsocket::recv_fds(*sysCalls, socket_fd, detections.size());
+                if (received.size() != detections.size())
+                {
+                    LOGERROR("Aborting " << m_threadName << ": failed to read fds");
+                    break;
+                }
+                for (size_t i = 0; i < detections.size(); ++i)
+                {
+                    detections[i].autoFd.reset(received[i]);
+                }
+                LOGDEBUG(m_threadName << " received batch of " << count << " detections");
             }
-            catch (const std::exception& e)
+            else
             {
-                LOGERROR("Aborting " << m_threadName << ": Failed to parse detection: " << e.what());
-                break;
-            }
-            scan_messages::ThreatDetected detectionReader = std::move(threatDetectedOptional.value());
+                if (!readDetection(length, detections))
+                {
+                    break;
+                }
 
-            // read fd
-            datatypes::AutoFd file_fd(unixsocket::recv_fd(*sysCalls, socket_fd));
-            if (file_fd.get() < 0)
-            {
-                LOGERROR("Aborting " << m_threadName << ": failed to read fd");
-                break;
+                // read fd
+                datatypes::AutoFd file_fd(unixsocket::recv_fd(*sysCalls, socket_fd));
+                if (file_fd.get() < 0)
+                {
+                    LOGERROR("Aborting " << m_threadName << ": failed to read fd");
+                    break;
+                }
+                LOGDEBUG(m_threadName << " managed to get file descriptor: " << file_fd.get());
+                detections.front().autoFd = std::move(file_fd);
             }
-            LOGDEBUG(m_threadName << " managed to get file descriptor: " << file_fd.get());
-            detectionReader.autoFd = std::move(file_fd);
 
-            if (detectionReader.filePath.empty())
-            {
-                LOGERROR(m_threadName << " missing file path in detection report ( size=" << bytes_read << ")");
-            }
-            m_threatReportCallback->processMessage(std::move(detectionReader));
+            m_threatReportCallback->processMessages(std::move(detections));
         }
     }
 }
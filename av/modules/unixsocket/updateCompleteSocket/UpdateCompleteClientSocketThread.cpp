@@ -1,7 +1,9 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "UpdateCompleteClientSocketThread.h"
 
+#include "UpdateCompleteNotifications.h"
+
 #include "unixsocket/Logger.h"
 
 #include "common/SaferStrerror.h"
@@ -82,10 +84,14 @@ void unixsocket::updateCompleteSocket::UpdateCompleteClientSocketThread::run()
             {
                 char buffer[1];
                 auto charsRead = ::read(m_socket_fd.get(), buffer, 1);
-                if (charsRead == 1 && buffer[0] == '1')
+                if (charsRead == 1 && buffer[0] == UPDATE_COMPLETE)
                 {
                     m_callback->updateComplete();
                 }
+                else if (charsRead == 1 && buffer[0] == READY)
+                {
+                    LOGINFO(m_name << " Sophos Threat Detector is ready");
+                }
                 else
                 {
                     m_socket_fd.close();
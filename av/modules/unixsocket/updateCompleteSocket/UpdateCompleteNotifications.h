@@ -0,0 +1,10 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+namespace unixsocket::updateCompleteSocket
+{
+    // Single byte notifications sent from sophos_threat_detector to its clients
+    constexpr char UPDATE_COMPLETE = '1';
+    constexpr char READY = '2';
+}
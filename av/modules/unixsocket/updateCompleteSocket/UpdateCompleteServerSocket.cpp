@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "UpdateCompleteServerSocket.h"
 
@@ -17,9 +17,33 @@ bool UpdateCompleteServerSocket::handleConnection(datatypes::AutoFd& fd)
 {
     std::scoped_lock lock(m_connectionsLock);
     LOGINFO(m_socketName << " got a new connection on " << fd.get() << " to be notified about SUSI updates");
+    if (m_ready && !trySend(fd, READY))
+    {
+        LOGINFO(m_socketName << " connection " << fd.get() << " has disconnected");
+        return false;
+    }
     m_connections.push_back(std::move(fd));
     return false;
 }
+
+void UpdateCompleteServerSocket::publishReady()
+{
+    std::scoped_lock lock(m_connectionsLock);
+    m_ready = true;
+    for (auto it = m_connections.begin(); it != m_connections.end() ;)
+    {
+        if (trySend(*it, READY))
+        {
+            LOGDEBUG(m_socketName << " sent ready to " << (*it).get());
+            ++it;
+        }
+        else
+        {
+            LOGINFO(m_socketName << " connection " << (*it).get() << " has disconnected");
+            it = m_connections.erase(it);
+        }
+    }
+}
 void UpdateCompleteServerSocket::publishUpdateComplete()
 {
     std::scoped_lock lock(m_connectionsLock);
@@ -42,7 +66,12 @@ void UpdateCompleteServerSocket::publishUpdateComplete()
 
 bool UpdateCompleteServerSocket::trySendUpdateComplete(datatypes::AutoFd& fd)
 {
-    auto ret = ::write(fd.get(), "1", 1);
+    return trySend(fd, UPDATE_COMPLETE);
+}
+
+bool UpdateCompleteServerSocket::trySend(datatypes::AutoFd& fd, char notification)
+{
+    auto ret = ::write(fd.get(), &notification, 1);
     return ret == 1;
 }
 
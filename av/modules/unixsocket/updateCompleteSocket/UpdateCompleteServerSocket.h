@@ -1,7 +1,9 @@
-// Copyright 2022, Sophos Limited.  All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include "UpdateCompleteNotifications.h"
+
 #include "unixsocket/BaseServerSocket.h"
 
 #include "sophos_threat_detector/threat_scanner/IUpdateCompleteCallback.h"
@@ -22,6 +24,12 @@ namespace unixsocket::updateCompleteSocket
         void updateComplete() override;
         void publishUpdateComplete();
 
+        /**
+         * Publish that the threat detector has finished starting and can scan without delay.
+         * Clients that connect later are told as soon as they connect.
+         */
+        virtual void publishReady();
+
         [[nodiscard]] ConnectionVector::size_type clientCount() const;
 
     protected:
@@ -35,8 +43,10 @@ namespace unixsocket::updateCompleteSocket
 
     private:
         bool trySendUpdateComplete(datatypes::AutoFd& fd);
+        static bool trySend(datatypes::AutoFd& fd, char notification);
         ConnectionVector m_connections;
         mutable std::mutex m_connectionsLock;
+        bool m_ready = false;
     };
     using UpdateCompleteServerSocketPtr = std::shared_ptr<UpdateCompleteServerSocket>;
 }
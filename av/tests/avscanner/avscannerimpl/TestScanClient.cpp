@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "avscanner/avscannerimpl/ScanClient.h"
 
@@ -383,3 +383,48 @@ TEST(TestScanClient, TestFailedToOpenMessages)
     EXPECT_EQ(ScanClient::failedToOpen(EOVERFLOW), "Failed to open as the file is too large: ");
     EXPECT_EQ(ScanClient::failedToOpen(2021), "Failed to open with error 2021: ");
 }
+
+TEST(TestScanClient, TestUnchangedCleanFileIsSkippedWithScanIndex)
+{
+    fs::path indexPath = fs::temp_directory_path() / "TestScanClient.index";
+    fs::remove(indexPath);
+
+    StrictMock<MockIScanningClientSocket> mock_socket;
+    scan_messages::ScanResponse response;
+
+    EXPECT_CALL(mock_socket, connect)
+        .Times(1)
+        .WillOnce(Return(0));
+    EXPECT_CALL(mock_socket, socketFd)
+        .Times(1);
+    EXPECT_CALL(mock_socket, sendRequest(_))
+        .Times(1)
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_socket, receiveResponse(_))
+        .Times(1)
+        .WillOnce(testing::DoAll(
+            testing::SetArgReferee<0>(response),
+            Return(true)
+                ));
+
+    std::shared_ptr<StrictMock<MockIScanCallbacks> > mock_callbacks(
+            new StrictMock<MockIScanCallbacks>()
+    );
+
+    EXPECT_CALL(*mock_callbacks, cleanFile(Eq("/etc/passwd")))
+        .Times(1);
+
+    ScanClient s(mock_socket, mock_callbacks, false, false, true, E_SCAN_TYPE_SCHEDULED);
+    auto firstIndex = std::make_shared<ScanIndex>(indexPath, 1, std::chrono::hours(24));
+    s.setScanIndex(firstIndex);
+    s.scan("/etc/passwd");
+    firstIndex->save();
+
+    auto secondIndex = std::make_shared<ScanIndex>(indexPath, 1, std::chrono::hours(24));
+    s.setScanIndex(secondIndex);
+    auto result = s.scan("/etc/passwd");
+    EXPECT_TRUE(result.allClean());
+    EXPECT_EQ(secondIndex->filesSkipped(), 1);
+
+    fs::remove(indexPath);
+}
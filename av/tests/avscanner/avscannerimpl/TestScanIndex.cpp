@@ -0,0 +1,171 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "avscanner/avscannerimpl/ScanIndex.h"
+
+#include "datatypes/AutoFd.h"
+#include "tests/common/LogInitializedTests.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace avscanner::avscannerimpl;
+namespace fs = sophos_filesystem;
+
+namespace
+{
+    class TestScanIndex : public LogInitializedTests
+    {
+    protected:
+        void SetUp() override
+        {
+            const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+            m_testDir = fs::temp_directory_path() / "TestScanIndex" / testInfo->name();
+            fs::remove_all(m_testDir);
+            fs::create_directories(m_testDir);
+            m_indexPath = m_testDir / "scan.index";
+        }
+
+        void TearDown() override
+        {
+            fs::remove_all(m_testDir);
+        }
+
+        void saveIndexWith(const std::vector<ScanIndex::FileState>& files, std::uint64_t dataVersion = 1)
+        {
+            ScanIndex index(m_indexPath, dataVersion, WEEK);
+            for (const auto& file : files)
+            {
+                index.recordClean(file);
+            }
+            index.save();
+        }
+
+        static constexpr std::chrono::seconds WEEK { 7 * 24 * 60 * 60 };
+        static constexpr ScanIndex::FileState FILE_A { 1, 100, 10, 1000, 1000 };
+        static constexpr ScanIndex::FileState FILE_B { 1, 50, 20, 2000, 2000 };
+        fs::path m_testDir;
+        fs::path m_indexPath;
+    };
+} // namespace
+
+TEST_F(TestScanIndex, missingIndexScansAllFiles)
+{
+    ScanIndex index(m_indexPath, 1, WEEK);
+    EXPECT_TRUE(index.isFullScan());
+    EXPECT_FALSE(index.skipIfUnchanged(FILE_A));
+    EXPECT_EQ(index.filesSkipped(), 0);
+}
+
+TEST_F(TestScanIndex, unchangedFilesAreSkipped)
+{
+    saveIndexWith({ FILE_A, FILE_B });
+
+    ScanIndex index(m_indexPath, 1, WEEK);
+    EXPECT_FALSE(index.isFullScan());
+    EXPECT_TRUE(index.skipIfUnchanged(FILE_A));
+    EXPECT_TRUE(index.skipIfUnchanged(FILE_B));
+    EXPECT_EQ(index.filesSkipped(), 2);
+}
+
+TEST_F(TestScanIndex, changedFilesAreNotSkipped)
+{
+    saveIndexWith({ FILE_A });
+
+    ScanIndex index(m_indexPath, 1, WEEK);
+    auto modified = FILE_A;
+    modified.mtimeNs++;
+    EXPECT_FALSE(index.skipIfUnchanged(modified));
+    auto resized = FILE_A;
+    resized.size++;
+    EXPECT_FALSE(index.skipIfUnchanged(resized));
+    auto otherInode = FILE_A;
+    otherInode.ino++;
+    EXPECT_FALSE(index.skipIfUnchanged(otherInode));
+}
+
+TEST_F(TestScanIndex, skippedFilesAreKeptAndUnseenFilesAreDropped)
+{
+    saveIndexWith({ FILE_A, FILE_B });
+    {
+        ScanIndex index(m_indexPath, 1, WEEK);
+        EXPECT_TRUE(index.skipIfUnchanged(FILE_A));
+        index.save();
+    }
+
+    ScanIndex index(m_indexPath, 1, WEEK);
+    EXPECT_TRUE(index.skipIfUnchanged(FILE_A));
+    EXPECT_FALSE(index.skipIfUnchanged(FILE_B));
+}
+
+TEST_F(TestScanIndex, newDataVersionScansAllFiles)
+{
+    saveIndexWith({ FILE_A }, 1);
+
+    ScanIndex index(m_indexPath, 2, WEEK);
+    EXPECT_TRUE(index.isFullScan());
+    EXPECT_FALSE(index.skipIfUnchanged(FILE_A));
+}
+
+TEST_F(TestScanIndex, fullScanIsDoneEveryInterval)
+{
+    saveIndexWith({ FILE_A });
+
+    ScanIndex index(m_indexPath, 1, std::chrono::seconds(0));
+    EXPECT_TRUE(index.isFullScan());
+    EXPECT_FALSE(index.skipIfUnchanged(FILE_A));
+}
+
+TEST_F(TestScanIndex, filesBeyondTheEntryLimitAreNotRecorded)
+{
+    {
+        ScanIndex index(m_indexPath, 1, WEEK, 1);
+        index.recordClean(FILE_A);
+        index.recordClean(FILE_B);
+        index.save();
+    }
+
+    ScanIndex index(m_indexPath, 1, WEEK);
+    EXPECT_TRUE(index.skipIfUnchanged(FILE_A));
+    EXPECT_FALSE(index.skipIfUnchanged(FILE_B));
+}
+
+TEST_F(TestScanIndex, invalidIndexScansAllFiles)
+{
+    std::ofstream(m_indexPath) << "not an index file at all, but long enough for a header";
+
+    ScanIndex index(m_indexPath, 1, WEEK);
+    EXPECT_TRUE(index.isFullScan());
+}
+
+TEST_F(TestScanIndex, stateOfMatchesFile)
+{
+    auto filePath = m_testDir / "file";
+    std::ofstream(filePath) << "content";
+    datatypes::AutoFd fd(::open(filePath.c_str(), O_RDONLY));
+
+    auto state = ScanIndex::stateOf(fd.get());
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(state->size, 7);
+    struct stat st{};
+    ASSERT_EQ(::stat(filePath.c_str(), &st), 0);
+    EXPECT_EQ(state->dev, st.st_dev);
+    EXPECT_EQ(state->ino, st.st_ino);
+}
+
+TEST_F(TestScanIndex, dataVersionChangesWithUpdateSourceAndSettings)
+{
+    auto updateSource = m_testDir / "update_source";
+    fs::create_directories(updateSource / "vdl");
+    std::ofstream(updateSource / "vdl" / "data.ide") << "data";
+
+    auto version = ScanIndex::dataVersion(updateSource, "settings");
+    EXPECT_EQ(ScanIndex::dataVersion(updateSource, "settings"), version);
+    EXPECT_NE(ScanIndex::dataVersion(updateSource, "other settings"), version);
+
+    std::ofstream(updateSource / "vdl" / "new.ide") << "new data";
+    EXPECT_NE(ScanIndex::dataVersion(updateSource, "settings"), version);
+}
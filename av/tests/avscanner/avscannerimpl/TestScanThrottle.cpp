@@ -0,0 +1,145 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "avscanner/avscannerimpl/ScanThrottle.h"
+
+#include "datatypes/sophos_filesystem.h"
+#include "tests/common/LogInitializedTests.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+using namespace avscanner::avscannerimpl;
+using namespace std::chrono_literals;
+namespace fs = sophos_filesystem;
+
+namespace
+{
+    class TestScanThrottle : public LogInitializedTests
+    {
+    protected:
+        void SetUp() override
+        {
+            const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+            m_testDir = fs::temp_directory_path() / "TestScanThrottle" / testInfo->name();
+            fs::remove_all(m_testDir);
+            fs::create_directories(m_testDir);
+        }
+
+        void TearDown() override
+        {
+            fs::remove_all(m_testDir);
+        }
+
+        void writePressure(double cpu, double io)
+        {
+            std::ofstream(m_testDir / "cpu") << "some avg10=" << cpu << " avg60=0.00 avg300=0.00 total=0\n"
+                                             << "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+            std::ofstream(m_testDir / "io") << "some avg10=" << io << " avg60=0.00 avg300=0.00 total=0\n";
+        }
+
+        fs::path m_testDir;
+        ScanThrottle::clock::time_point m_start = ScanThrottle::clock::now();
+    };
+} // namespace
+
+TEST_F(TestScanThrottle, noLimitsIsNotEnabled)
+{
+    EXPECT_FALSE(ThrottleSettings{}.enabled());
+
+    ScanThrottle throttle(ThrottleSettings{}, 4, m_testDir);
+    EXPECT_EQ(throttle.scanned(1'000'000'000, 10s, m_start), ScanThrottle::clock::duration::zero());
+}
+
+TEST_F(TestScanThrottle, cpuLimitPausesInProportionToScanTime)
+{
+    ThrottleSettings settings;
+    settings.cpuLimitPercent = 50;
+    ScanThrottle throttle(settings, 1, m_testDir, m_start);
+
+    EXPECT_EQ(throttle.scanned(0, 1s, m_start + 1s), 1s);
+    EXPECT_EQ(throttle.scanned(0, 1s, m_start + 3s), 1s);
+    EXPECT_EQ(throttle.throttledTime(), 2s);
+}
+
+TEST_F(TestScanThrottle, cpuLimitIsShareOfAvailableCpus)
+{
+    ThrottleSettings settings;
+    settings.cpuLimitPercent = 50;
+    ScanThrottle throttle(settings, 4, m_testDir, m_start);
+
+    // Two CPUs is more than one stream of scan requests can use
+    EXPECT_EQ(throttle.scanned(0, 1s, m_start + 1s), ScanThrottle::clock::duration::zero());
+}
+
+TEST_F(TestScanThrottle, ioLimitPacesBytes)
+{
+    ThrottleSettings settings;
+    settings.ioBytesPerSecond = 1000;
+    ScanThrottle throttle(settings, 1, m_testDir, m_start);
+
+    EXPECT_EQ(throttle.scanned(3000, 0s, m_start), 2s);
+    EXPECT_EQ(throttle.bytesScanned(), 3000);
+}
+
+TEST_F(TestScanThrottle, iopsLimitPacesFiles)
+{
+    ThrottleSettings settings;
+    settings.iopsLimit = 2;
+    ScanThrottle throttle(settings, 1, m_testDir, m_start);
+
+    EXPECT_EQ(throttle.scanned(0, 0s, m_start), ScanThrottle::clock::duration::zero());
+    EXPECT_EQ(throttle.scanned(0, 0s, m_start), ScanThrottle::clock::duration::zero());
+    EXPECT_EQ(throttle.scanned(0, 0s, m_start), 500ms);
+    EXPECT_EQ(throttle.filesScanned(), 3);
+}
+
+TEST_F(TestScanThrottle, hostPressureIsLargerOfCpuAndIo)
+{
+    writePressure(12.5, 40.25);
+    EXPECT_DOUBLE_EQ(ScanThrottle::hostPressure(m_testDir).value(), 40.25);
+    EXPECT_FALSE(ScanThrottle::hostPressure(m_testDir / "missing").has_value());
+}
+
+TEST_F(TestScanThrottle, backsOffUnderPressureAndRecovers)
+{
+    ThrottleSettings settings;
+    settings.pressureThresholdPercent = 10;
+    ScanThrottle throttle(settings, 1, m_testDir, m_start);
+
+    writePressure(50, 0);
+    throttle.scanned(0, 0s, m_start + 2s);
+    EXPECT_DOUBLE_EQ(throttle.rateFactor(), 0.5);
+
+    // Only sampled once per interval
+    throttle.scanned(0, 0s, m_start + 2s + 100ms);
+    EXPECT_DOUBLE_EQ(throttle.rateFactor(), 0.5);
+
+    writePressure(1, 1);
+    throttle.scanned(0, 0s, m_start + 4s);
+    EXPECT_DOUBLE_EQ(throttle.rateFactor(), 0.6);
+}
+
+TEST_F(TestScanThrottle, pressurePausesScansWithoutLimits)
+{
+    ThrottleSettings settings;
+    settings.pressureThresholdPercent = 10;
+    ScanThrottle throttle(settings, 1, m_testDir, m_start);
+    writePressure(50, 0);
+
+    // Half of one CPU, and the bucket's one second capacity is now half a second
+    EXPECT_EQ(throttle.scanned(0, 1s, m_start + 2s), 1s);
+}
+
+TEST_F(TestScanThrottle, availableCpusUsesCgroupQuotas)
+{
+    std::ofstream(m_testDir / "cgroup") << "0::/a/b\n";
+    fs::create_directories(m_testDir / "root/a/b");
+    std::ofstream(m_testDir / "root/a/b/cpu.max") << "max 100000\n";
+    std::ofstream(m_testDir / "root/a/cpu.max") << "150000 100000\n";
+
+    double cpus = std::max(std::thread::hardware_concurrency(), 1U);
+    EXPECT_DOUBLE_EQ(ScanThrottle::availableCpus(m_testDir / "cgroup", m_testDir / "root"), std::min(cpus, 1.5));
+    EXPECT_DOUBLE_EQ(ScanThrottle::availableCpus(m_testDir / "missing", m_testDir / "root"), cpus);
+}
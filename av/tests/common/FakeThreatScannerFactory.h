@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -40,5 +40,10 @@ namespace
         void loadSusiSettingsIfRequired() override
         {
         }
+
+        bool warmUp(int, bool) override
+        {
+            return true;
+        }
     };
 }
\ No newline at end of file
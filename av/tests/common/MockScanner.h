@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -30,4 +30,5 @@ public:
     MOCK_METHOD(bool, updateSusiConfig, ());
     MOCK_METHOD(bool, detectPUAsEnabled, ());
     MOCK_METHOD(void, loadSusiSettingsIfRequired, (), (override));
+    MOCK_METHOD(bool, warmUp, (int scannerCount, bool detectPUAs), (override));
 };
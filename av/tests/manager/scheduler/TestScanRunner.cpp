@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
@@ -8,11 +8,16 @@
 #include "tests/common/LogInitializedTests.h"
 
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
+#include "Common/TelemetryHelperImpl/TelemetryHelper.h"
+
+#include <nlohmann/json.hpp>
 
 #include <chrono>
+#include <fstream>
 #include <thread>
 
 using namespace manager::scheduler;
+namespace fs = sophos_filesystem;
 
 class TestScanRunner : public LogInitializedTests
 {
@@ -72,3 +77,34 @@ TEST_F(TestScanRunner, testTimestampGeneration)
     EXPECT_THAT(timestamp2, ::testing::MatchesRegex("[0-9]{8} [0-9]{6}"));
 }
 
+
+TEST_F(TestScanRunner, incrementalScanStatisticsAreAddedToTelemetry)
+{
+    fs::path statsPath = fs::temp_directory_path() / "TestScanRunner.stats.json";
+    std::ofstream(statsPath) << R"({"fullScan":false,"filesScanned":25,"filesSkipped":75})";
+    Common::Telemetry::TelemetryHelper::getInstance().reset();
+
+    recordScheduledScanTelemetry(statsPath);
+
+    auto telemetry = nlohmann::json::parse(Common::Telemetry::TelemetryHelper::getInstance().serialiseAndReset());
+    EXPECT_EQ(telemetry["scheduled-scan-files-scanned"], 25);
+    EXPECT_EQ(telemetry["scheduled-scan-files-skipped"], 75);
+    EXPECT_EQ(telemetry["scheduled-scan-skip-ratio"], 0.75);
+    EXPECT_FALSE(telemetry.contains("scheduled-scan-full-count"));
+    EXPECT_FALSE(fs::exists(statsPath));
+}
+
+TEST_F(TestScanRunner, throttledScanStatisticsAreAddedToTelemetry)
+{
+    fs::path statsPath = fs::temp_directory_path() / "TestScanRunner.stats.json";
+    std::ofstream(statsPath) << R"({"filesScanned":10,"bytesScanned":4000,"durationMs":2000,"throttledMs":1500})";
+    Common::Telemetry::TelemetryHelper::getInstance().reset();
+
+    recordScheduledScanTelemetry(statsPath);
+
+    auto telemetry = nlohmann::json::parse(Common::Telemetry::TelemetryHelper::getInstance().serialiseAndReset());
+    EXPECT_EQ(telemetry["scheduled-scan-files-scanned"], 10);
+    EXPECT_EQ(telemetry["scheduled-scan-throttled-ms"], 1500);
+    EXPECT_EQ(telemetry["scheduled-scan-throughput-bytes-per-second"], 2000);
+    EXPECT_FALSE(telemetry.contains("scheduled-scan-files-skipped"));
+}
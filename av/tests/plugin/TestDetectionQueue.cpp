@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "pluginimpl/DetectionQueue.h"
 #include "pluginimpl/PluginCallback.h"
@@ -12,6 +12,8 @@
 
 #include <future>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 using json = nlohmann::json;
 using namespace common::CentralEnums;
@@ -160,4 +162,27 @@ TEST_F(TestDetectionQueue, testPushedDataIsCorrectlyQueuedAndReturnedWhenPopped)
     auto poppedData = queue.pop();
 
     ASSERT_EQ(poppedData, detectionPopped);
-}
\ No newline at end of file
+}
+TEST_F(TestDetectionQueue, TestBatchPushQueuesDetectionsThatFitInOrderAndLeavesTheRest)
+{
+    Plugin::DetectionQueue queue;
+    std::shared_ptr<Plugin::TaskQueue> task = nullptr;
+    std::shared_ptr<Plugin::PluginCallback> m_pluginCallback = std::make_shared<Plugin::PluginCallback>(task);
+    std::ignore = m_pluginCallback->getTelemetry();
+    queue.setMaxSize(2);
+
+    std::vector<scan_messages::ThreatDetected> detections;
+    detections.push_back(createThreatDetected({ .filePath = "/first" }));
+    detections.push_back(createThreatDetected({ .filePath = "/second" }));
+    detections.push_back(createThreatDetected({ .filePath = "/third" }));
+
+    EXPECT_EQ(queue.push(detections), 2u);
+    ASSERT_EQ(detections.size(), 1u);
+    EXPECT_EQ(detections[0].filePath, "/third");
+    EXPECT_TRUE(queue.isFull());
+    EXPECT_EQ(queue.pop()->filePath, "/first");
+    EXPECT_EQ(queue.pop()->filePath, "/second");
+
+    json modifiedTelemetry = json::parse(m_pluginCallback->getTelemetry());
+    EXPECT_EQ(modifiedTelemetry["detections-dropped-from-safestore-queue"], 1);
+}
@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 # define TEST_PUBLIC public
 
@@ -93,3 +93,40 @@ TEST_F(TestHealthStatus, susiUpdateFailed_false)
     Tests::ScopedReplaceFileSystem scopedReplaceFileSystem{std::move(mockFileSystem_)};
     EXPECT_FALSE(Plugin::susiUpdateFailed());
 }
+
+TEST_F(TestHealthStatus, lastSusiUpdateTimings_readsTimingsFromStatusFile)
+{
+    expectReadStatusFileAndReturn(R"({"success":true,"lockWaitMs":1500,"updateDurationMs":42})");
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem{std::move(mockFileSystem_)};
+    auto timings = Plugin::lastSusiUpdateTimings();
+    ASSERT_TRUE(timings.has_value());
+    EXPECT_EQ(timings->lockWaitMs, 1500);
+    EXPECT_EQ(timings->updateDurationMs, 42);
+}
+
+TEST_F(TestHealthStatus, lastSusiUpdateTimings_missingFromOlderStatusFile)
+{
+    expectReadStatusFileAndReturn("{\"success\":true}");
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem{std::move(mockFileSystem_)};
+    EXPECT_FALSE(Plugin::lastSusiUpdateTimings().has_value());
+}
+
+TEST_F(TestHealthStatus, lastThreatDetectorStartupTimings_readsTimingsFromStartupStatusFile)
+{
+    EXPECT_CALL(*mockFileSystem_, readFile(StrEq(Plugin::getThreatDetectorStartupStatusPath())))
+        .WillOnce(Return(R"({"setupMs":120,"warmUpMs":3400,"totalMs":3530})"));
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem{std::move(mockFileSystem_)};
+    auto timings = Plugin::lastThreatDetectorStartupTimings();
+    ASSERT_TRUE(timings.has_value());
+    EXPECT_EQ(timings->setupMs, 120);
+    EXPECT_EQ(timings->warmUpMs, 3400);
+    EXPECT_EQ(timings->totalMs, 3530);
+}
+
+TEST_F(TestHealthStatus, lastThreatDetectorStartupTimings_absentFile)
+{
+    EXPECT_CALL(*mockFileSystem_, readFile(StrEq(Plugin::getThreatDetectorStartupStatusPath())))
+        .WillOnce(Throw(Common::FileSystem::IFileNotFoundException("FOOBAR")));
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem{std::move(mockFileSystem_)};
+    EXPECT_FALSE(Plugin::lastThreatDetectorStartupTimings().has_value());
+}
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #define PLUGIN_INTERNAL public
 
@@ -205,6 +205,7 @@ TEST_F(TestPluginAdapter, testProcessPolicy)
     auto mockIFileSystemPtr = std::make_unique<StrictMock<MockFileSystem>>();
     EXPECT_CALL(*mockIFileSystemPtr, readlink(_)).WillRepeatedly(::testing::Return(std::nullopt));
     EXPECT_CALL(*mockIFileSystemPtr, isFile(_)).WillOnce(Return(false));
+    EXPECT_CALL(*mockIFileSystemPtr, isFile(Plugin::getPersistThreatDatabaseJournalFilePath())).WillOnce(Return(false));
 
     fs::path testDir = tmpdir();
     const std::string susiStartupSettingsPath = testDir / "var/susi_startup_settings.json";
@@ -281,6 +282,7 @@ TEST_F(TestPluginAdapter, testProcessPolicy_ignoresDuplicates)
     auto mockIFileSystemPtr = std::make_unique<StrictMock<MockFileSystem>>();
     EXPECT_CALL(*mockIFileSystemPtr, readlink(_)).WillRepeatedly(::testing::Return(std::nullopt));
     EXPECT_CALL(*mockIFileSystemPtr, isFile(_)).WillOnce(Return(false));
+    EXPECT_CALL(*mockIFileSystemPtr, isFile(Plugin::getPersistThreatDatabaseJournalFilePath())).WillOnce(Return(false));
 
     fs::path testDir = tmpdir();
     const std::string susiStartupSettingsPath = testDir / "var/susi_startup_settings.json";
@@ -420,6 +422,7 @@ TEST_F(TestPluginAdapter, testProcessUpdatePolicy)
     auto mockIFileSystemPtr = std::make_unique<StrictMock<MockFileSystem>>();
     EXPECT_CALL(*mockIFileSystemPtr, readlink(_)).WillRepeatedly(::testing::Return(std::nullopt));
     EXPECT_CALL(*mockIFileSystemPtr, isFile(_)).WillOnce(Return(false));
+    EXPECT_CALL(*mockIFileSystemPtr, isFile(Plugin::getPersistThreatDatabaseJournalFilePath())).WillOnce(Return(false));
 
     fs::path testDir = pluginInstall();
     const std::string expectedMd5 = "a1c0f318e58aad6bf90d07cabda54b7d"; // md5(md5("B:A"))
@@ -594,6 +597,7 @@ TEST_F(TestPluginAdapter, testProcessUpdatePolicy_ignoresPolicyWithWrongID)
     auto mockIFileSystemPtr = std::make_unique<StrictMock<MockFileSystem>>();
     EXPECT_CALL(*mockIFileSystemPtr, readlink(_)).WillRepeatedly(::testing::Return(std::nullopt));
     EXPECT_CALL(*mockIFileSystemPtr, isFile(_)).WillOnce(Return(false));
+    EXPECT_CALL(*mockIFileSystemPtr, isFile(Plugin::getPersistThreatDatabaseJournalFilePath())).WillOnce(Return(false));
 
     fs::path testDir = pluginInstall();
     const std::string expectedMd5 = "a1c0f318e58aad6bf90d07cabda54b7d"; // md5(md5("B:A"))
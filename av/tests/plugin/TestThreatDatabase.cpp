@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #define TEST_PUBLIC public
 
@@ -788,4 +788,83 @@ TEST_F(TestThreatDatabase, threatDatabaseReturnsFalseIfThreatAddedOverTimeout)
     EXPECT_TRUE(waitForLog("Initialised Threat Database"));
 
     EXPECT_FALSE(database.isThreatInDatabaseWithinTime("threatID", std::chrono::seconds{60}));
-}
\ No newline at end of file
+}
+
+TEST_F(TestThreatDatabase, removeCorrelationIDFindsThreatByLatestCorrelationID)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    Plugin::ThreatDatabase database{ m_testDir.string() };
+    database.addThreat("threatID", "correlationID1");
+    database.addThreat("threatID", "correlationID2");
+
+    database.removeCorrelationID("correlationID1");
+    EXPECT_TRUE(waitForLog("Cannot remove correlationId: correlationID1 from database as it cannot be found"));
+    EXPECT_FALSE(database.isDatabaseEmpty());
+
+    database.removeCorrelationID("correlationID2");
+    EXPECT_TRUE(database.isDatabaseEmpty());
+}
+
+TEST_F(TestThreatDatabase, reassigningCorrelationIDKeepsAnotherThreatsMapping)
+{
+    Plugin::ThreatDatabase database{ m_testDir.string() };
+    database.addThreat("threatID1", "correlationID1");
+    database.addThreat("threatID2", "correlationID1");
+    database.addThreat("threatID1", "correlationID2");
+
+    database.removeCorrelationID("correlationID1");
+    EXPECT_FALSE(database.isThreatInDatabaseWithinTime("threatID2", std::chrono::seconds{ 60 }));
+
+    database.removeCorrelationID("correlationID2");
+    EXPECT_TRUE(database.isDatabaseEmpty());
+}
+
+TEST_F(TestThreatDatabase, journalIsReplayedWhenSnapshotWasNotSaved)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    const std::string snapshotPath = m_testDir.string() + "/persist-threatDatabase";
+    const std::string journalPath = m_testDir.string() + "/persist-threatDatabase.journal";
+    auto fileSystem = Common::FileSystem::fileSystem();
+    std::string journal;
+    {
+        Plugin::ThreatDatabase database{ m_testDir.string() };
+        database.addThreat("threat1", "correlation1");
+        database.addThreat("threat2", "correlation2");
+        database.removeThreatID("threat1");
+        journal = fileSystem->readFile(journalPath);
+    }
+
+    // As if the plugin stopped without storing the snapshot
+    fileSystem->writeFile(snapshotPath, "{}");
+    fileSystem->writeFile(journalPath, journal);
+
+    Plugin::ThreatDatabase database{ m_testDir.string() };
+    EXPECT_TRUE(waitForLog("Replayed 3 threat database changes"));
+    EXPECT_FALSE(database.hasThreat("threat1").has_value());
+    EXPECT_EQ(database.hasThreat("threat2"), "correlation2");
+
+    // Replaying compacts the journal into the snapshot
+    EXPECT_FALSE(fs::exists(journalPath));
+    auto snapshot = nlohmann::json::parse(fileSystem->readFile(snapshotPath));
+    EXPECT_EQ(snapshot["threat2"][JsonKeys::correlationId], "correlation2");
+}
+
+TEST_F(TestThreatDatabase, journalIsCompactedAfterManyChanges)
+{
+    const std::string journalPath = m_testDir.string() + "/persist-threatDatabase.journal";
+
+    Plugin::ThreatDatabase database{ m_testDir.string() };
+    for (std::size_t i = 1; i < Plugin::ThreatDatabase::MIN_JOURNAL_ENTRIES_BEFORE_COMPACTION; ++i)
+    {
+        database.addThreat("threatID", "correlationID" + std::to_string(i));
+    }
+    EXPECT_TRUE(fs::exists(journalPath));
+
+    database.addThreat("threatID", "correlationID");
+    EXPECT_FALSE(fs::exists(journalPath));
+    auto snapshot = nlohmann::json::parse(database.m_databaseInString.getValue());
+    EXPECT_EQ(snapshot["threatID"][JsonKeys::correlationId], "correlationID");
+    EXPECT_EQ(database.hasThreat("threatID"), "correlationID");
+}
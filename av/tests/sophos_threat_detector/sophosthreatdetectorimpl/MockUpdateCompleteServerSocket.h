@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "unixsocket/updateCompleteSocket/UpdateCompleteServerSocket.h"
 
@@ -19,5 +19,6 @@ namespace
                 };
 
             MOCK_METHOD(void, updateComplete, (), (override));
+            MOCK_METHOD(void, publishReady, (), (override));
     };
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #define TEST_PUBLIC public
 // class under test
@@ -55,6 +55,16 @@ namespace {
             m_mockThreatDetectorResources->setThreatDetectorCallback(callback);
         }
 
+        void enableWarmStart(MockFileSystem& filesystemMock, const std::string& config, const std::string& onAccessPolicy)
+        {
+            const fs::path configPath = fs::path(m_pluginInstall) / "chroot/etc/threat_detector_config";
+            const fs::path policyPath = fs::path(m_pluginInstall) / "var/on_access_policy.json";
+            ON_CALL(filesystemMock, isFile(configPath.string())).WillByDefault(Return(true));
+            ON_CALL(filesystemMock, readFile(configPath.string())).WillByDefault(Return(config));
+            ON_CALL(filesystemMock, isFile(policyPath.string())).WillByDefault(Return(true));
+            ON_CALL(filesystemMock, readFile(policyPath.string())).WillByDefault(Return(onAccessPolicy));
+        }
+
         std::shared_ptr<SophosThreatDetectorMain> createSophosThreatDetector()
         {
             auto threatDetectorMain = std::make_shared<SophosThreatDetectorMain>();
@@ -742,3 +752,94 @@ TEST_F(TestSophosThreatDetectorMain, CreatesMetadataRescanServerSocket)
     auto threatDetectorMain = SophosThreatDetectorMain();
     threatDetectorMain.inner_main(m_mockThreatDetectorResources);
 }
+
+TEST_F(TestSophosThreatDetectorMain, scannersAreNotWarmedUpUnlessConfigured)
+{
+    auto mockSusiScannerFactory = std::make_shared<NiceMock<MockSusiScannerFactory>>();
+    ON_CALL(*m_mockThreatDetectorResources, createSusiScannerFactory).WillByDefault(Return(mockSusiScannerFactory));
+
+    auto treatDetectorMain = createSophosThreatDetector();
+    EXPECT_CALL(*mockSusiScannerFactory, loadSusiSettingsIfRequired()).Times(0);
+    EXPECT_CALL(*mockSusiScannerFactory, warmUp(_, _)).Times(0);
+    EXPECT_CALL(*m_mockSystemCallWrapper, ppoll(_,_,_,_)).WillOnce(pollReturnsWithRevents(0, POLLIN));
+
+    EXPECT_EQ(common::E_CLEAN_SUCCESS, treatDetectorMain->inner_main(m_mockThreatDetectorResources));
+}
+
+TEST_F(TestSophosThreatDetectorMain, scannersAreWarmedUpBeforeScanningSocketIsCreated)
+{
+    auto mockSusiScannerFactory = std::make_shared<NiceMock<MockSusiScannerFactory>>();
+    ON_CALL(*m_mockThreatDetectorResources, createSusiScannerFactory).WillByDefault(Return(mockSusiScannerFactory));
+
+    auto* filesystemMock = new NiceMock<MockFileSystem>();
+    enableWarmStart(*filesystemMock, R"({"warmStartScanners":2})", R"({"detectPUAs":true})");
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem { std::unique_ptr<Common::FileSystem::IFileSystem>(filesystemMock) };
+
+    auto treatDetectorMain = createSophosThreatDetector();
+    {
+        InSequence sequence;
+        EXPECT_CALL(*mockSusiScannerFactory, loadSusiSettingsIfRequired());
+        EXPECT_CALL(*mockSusiScannerFactory, warmUp(2, true)).WillOnce(Return(true));
+        EXPECT_CALL(*m_mockThreatDetectorResources, createScanningServerSocket(_,_,_));
+    }
+    EXPECT_CALL(*m_mockSystemCallWrapper, ppoll(_,_,_,_)).WillOnce(pollReturnsWithRevents(0, POLLIN));
+
+    EXPECT_EQ(common::E_CLEAN_SUCCESS, treatDetectorMain->inner_main(m_mockThreatDetectorResources));
+}
+
+TEST_F(TestSophosThreatDetectorMain, warmScannersMatchOnAccessPUADetection)
+{
+    auto mockSusiScannerFactory = std::make_shared<NiceMock<MockSusiScannerFactory>>();
+    ON_CALL(*m_mockThreatDetectorResources, createSusiScannerFactory).WillByDefault(Return(mockSusiScannerFactory));
+
+    auto* filesystemMock = new NiceMock<MockFileSystem>();
+    enableWarmStart(*filesystemMock, R"({"warmStartScanners":1})", R"({"detectPUAs":false})");
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem { std::unique_ptr<Common::FileSystem::IFileSystem>(filesystemMock) };
+
+    auto treatDetectorMain = createSophosThreatDetector();
+    EXPECT_CALL(*mockSusiScannerFactory, warmUp(1, false)).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockSystemCallWrapper, ppoll(_,_,_,_)).WillOnce(pollReturnsWithRevents(0, POLLIN));
+
+    EXPECT_EQ(common::E_CLEAN_SUCCESS, treatDetectorMain->inner_main(m_mockThreatDetectorResources));
+}
+
+TEST_F(TestSophosThreatDetectorMain, failedWarmUpStillStartsScanningSocket)
+{
+    auto mockSusiScannerFactory = std::make_shared<NiceMock<MockSusiScannerFactory>>();
+    ON_CALL(*m_mockThreatDetectorResources, createSusiScannerFactory).WillByDefault(Return(mockSusiScannerFactory));
+
+    auto* filesystemMock = new NiceMock<MockFileSystem>();
+    enableWarmStart(*filesystemMock, R"({"warmStartScanners":2})", R"({"detectPUAs":true})");
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem { std::unique_ptr<Common::FileSystem::IFileSystem>(filesystemMock) };
+
+    auto treatDetectorMain = createSophosThreatDetector();
+    {
+        InSequence sequence;
+        EXPECT_CALL(*mockSusiScannerFactory, warmUp(_, _)).WillOnce(Return(false));
+        EXPECT_CALL(*m_mockThreatDetectorResources, createScanningServerSocket(_,_,_));
+    }
+    EXPECT_CALL(*m_mockSystemCallWrapper, ppoll(_,_,_,_)).WillOnce(pollReturnsWithRevents(0, POLLIN));
+
+    EXPECT_EQ(common::E_CLEAN_SUCCESS, treatDetectorMain->inner_main(m_mockThreatDetectorResources));
+}
+
+TEST_F(TestSophosThreatDetectorMain, readinessIsPublishedAfterSocketsAreCreated)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    auto mockUpdateCompleteServerSocket =
+        std::make_shared<NiceMock<MockUpdateCompleteServerSocket>>(fs::path(m_testDir / "update_socket"), 0777);
+    ON_CALL(*m_mockThreatDetectorResources, createUpdateCompleteNotifier).WillByDefault(Return(mockUpdateCompleteServerSocket));
+
+    auto treatDetectorMain = createSophosThreatDetector();
+    {
+        InSequence sequence;
+        EXPECT_CALL(*m_mockThreatDetectorResources, createScanningServerSocket(_,_,_));
+        EXPECT_CALL(*m_mockThreatDetectorResources, createMetadataRescanServerSocket(_,_,_));
+        EXPECT_CALL(*mockUpdateCompleteServerSocket, publishReady());
+    }
+    EXPECT_CALL(*m_mockSystemCallWrapper, ppoll(_,_,_,_)).WillOnce(pollReturnsWithRevents(0, POLLIN));
+
+    EXPECT_EQ(common::E_CLEAN_SUCCESS, treatDetectorMain->inner_main(m_mockThreatDetectorResources));
+    EXPECT_TRUE(appenderContains("Sophos Threat Detector ready to scan after "));
+}
@@ -1,4 +1,4 @@
-// Copyright 2021-2023 Sophos Limited. All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #include "sophos_threat_detector/sophosthreatdetectorimpl/ThreatReporter.h"
 #include "unixsocket/IMessageCallback.h"
@@ -13,6 +13,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 using namespace ::testing;
 using namespace common::CentralEnums;
 namespace fs = sophos_filesystem;
@@ -61,3 +63,58 @@ TEST_F(TestThreatReporter, testReport)
     threatReporterServer.requestStop();
     threatReporterServer.join();
 }
+
+TEST_F(TestThreatReporter, testReportsQueuedBeforeServerStartsAreDelivered)
+{
+    setupFakeSophosThreatDetectorConfig();
+
+    WaitForEvent serverWaitGuard;
+    std::vector<std::string> receivedPaths;
+
+    auto mockThreatReportCallback = std::make_shared<StrictMock<MockIThreatReportCallbacks>>();
+    EXPECT_CALL(*mockThreatReportCallback, processMessage(_))
+        .Times(2)
+        .WillRepeatedly(Invoke(
+            [&](const scan_messages::ThreatDetected& detection)
+            {
+                receivedPaths.push_back(detection.filePath);
+                if (receivedPaths.size() == 2)
+                {
+                    serverWaitGuard.onEventNoArgs();
+                }
+            }));
+
+    fs::path socket_path = pluginInstall() / "chroot/var/threat_report_socket";
+    sspl::sophosthreatdetectorimpl::ThreatReporter reporterClient(socket_path);
+
+    // Nothing is listening yet, so the reporter has to queue these and reconnect later
+    reporterClient.sendThreatReport(createThreatDetectedWithRealFd({ .filePath = "/first" }));
+    reporterClient.sendThreatReport(createThreatDetectedWithRealFd({ .filePath = "/second" }));
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 250 });
+
+    unixsocket::ThreatReporterServerSocket threatReporterServer(socket_path, 0600, mockThreatReportCallback);
+    threatReporterServer.start();
+
+    serverWaitGuard.wait();
+    EXPECT_THAT(receivedPaths, ElementsAre("/first", "/second"));
+    threatReporterServer.requestStop();
+    threatReporterServer.join();
+}
+
+TEST_F(TestThreatReporter, testReportWaitsForSpaceBeforeBeingDropped)
+{
+    using sspl::sophosthreatdetectorimpl::ThreatReporter;
+    setupFakeSophosThreatDetectorConfig();
+
+    // Nothing is listening, so nothing leaves the queue
+    fs::path socket_path = pluginInstall() / "chroot/var/threat_report_socket";
+    ThreatReporter reporterClient(socket_path);
+    for (std::size_t i = 0; i < ThreatReporter::MAX_QUEUED_REPORTS; ++i)
+    {
+        reporterClient.sendThreatReport(createThreatDetectedWithRealFd({}));
+    }
+
+    auto start = ThreatReporter::clock::now();
+    reporterClient.sendThreatReport(createThreatDetectedWithRealFd({}));
+    EXPECT_GE(ThreatReporter::clock::now() - start, ThreatReporter::QUEUE_FULL_TIMEOUT);
+}
@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -18,6 +18,7 @@ namespace
                 ON_CALL(*this, update).WillByDefault(Return(true));
                 ON_CALL(*this, reload).WillByDefault(Return(true));
                 ON_CALL(*this, susiIsInitialized).WillByDefault(Return(false));
+                ON_CALL(*this, warmUp).WillByDefault(Return(true));
             };
     };
 
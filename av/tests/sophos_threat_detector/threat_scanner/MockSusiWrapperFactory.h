@@ -1,4 +1,4 @@
-// Copyright 2020-2022 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -12,6 +12,7 @@ public:
     MOCK_METHOD1(createSusiWrapper, threat_scanner::ISusiWrapperSharedPtr(const std::string& /*scannerConfig*/));
 
     MOCK_METHOD0(update, bool());
+    MOCK_METHOD(bool, lastUpdateWasUpToDate, (), (override));
     MOCK_METHOD0(reload, bool());
     MOCK_METHOD0(shutdown, void());
     MOCK_METHOD0(susiIsInitialized, bool());
@@ -1,4 +1,4 @@
-// Copyright 2020-2022 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "MockSusiWrapper.h"
 #include "MockSusiWrapperFactory.h"
@@ -16,6 +16,8 @@
 #include "sophos_threat_detector/threat_scanner/ScannerInfo.h"
 #include "sophos_threat_detector/threat_scanner/SusiScannerFactory.h"
 
+#include "common/FailedToInitializeSusiException.h"
+
 using namespace threat_scanner;
 
 namespace{
@@ -128,10 +130,23 @@ TEST_F(TestSusiScannerFactory, callbackAfterSuccessfulUpdate)
 
     EXPECT_CALL(*mockCallback, updateComplete()).Times(1);
     EXPECT_CALL(*wrapperFactory, update()).WillOnce(testing::Return(true));
+    EXPECT_CALL(*wrapperFactory, lastUpdateWasUpToDate()).WillOnce(testing::Return(false));
 
     factory.update();
 }
 
+TEST_F(TestSusiScannerFactory, noCallbackAfterUpdateThatFoundDataUpToDate)
+{
+    auto wrapperFactory = std::make_shared<::testing::StrictMock<MockSusiWrapperFactory>>();
+    auto mockCallback = std::make_shared<::testing::StrictMock<MockUpdateCompleteCallback>>();
+    SusiScannerFactory factory(wrapperFactory, nullptr, nullptr, mockCallback);
+
+    EXPECT_CALL(*wrapperFactory, update()).WillOnce(testing::Return(true));
+    EXPECT_CALL(*wrapperFactory, lastUpdateWasUpToDate()).WillOnce(testing::Return(true));
+
+    EXPECT_TRUE(factory.update());
+}
+
 
 TEST_F(TestSusiScannerFactory, noCallbackAfterSuccessfulUpdate)
 {
@@ -143,3 +158,69 @@ TEST_F(TestSusiScannerFactory, noCallbackAfterSuccessfulUpdate)
 
     factory.update();
 }
+
+TEST_F(TestSusiScannerFactory, warmUpCreatesScannersForOnAccessRequests)
+{
+    using namespace ::testing;
+    auto wrapperFactory = std::make_shared<StrictMock<MockSusiWrapperFactory>>();
+    const auto onAccessScannerConfig = "{" + createScannerInfo(false, false, true, true) + "}";
+
+    auto susiWrapper = std::make_shared<StrictMock<MockSusiWrapper>>();
+    EXPECT_CALL(*wrapperFactory, isMachineLearningEnabled).WillRepeatedly(Return(true));
+    EXPECT_CALL(*wrapperFactory, createSusiWrapper(onAccessScannerConfig)).Times(2).WillRepeatedly(Return(susiWrapper));
+    EXPECT_CALL(*wrapperFactory, accessGlobalHandler()).Times(2).WillRepeatedly(Return(nullptr));
+
+    SusiScannerFactory factory(wrapperFactory, nullptr, nullptr, nullptr);
+    EXPECT_TRUE(factory.warmUp(2, true));
+
+    // Both scanners come from the warm start, so no more are created
+    EXPECT_NO_THROW(auto scanner = factory.createScanner(false, false, true));
+    EXPECT_NO_THROW(auto scanner = factory.createScanner(false, false, true));
+}
+
+TEST_F(TestSusiScannerFactory, warmUpCreatesScannersWithoutPUADetectionIfOnAccessDoesNotAskForIt)
+{
+    using namespace ::testing;
+    auto wrapperFactory = std::make_shared<StrictMock<MockSusiWrapperFactory>>();
+    const auto onAccessScannerConfig = "{" + createScannerInfo(false, false, false, true) + "}";
+
+    auto susiWrapper = std::make_shared<StrictMock<MockSusiWrapper>>();
+    EXPECT_CALL(*wrapperFactory, isMachineLearningEnabled).WillRepeatedly(Return(true));
+    EXPECT_CALL(*wrapperFactory, createSusiWrapper(onAccessScannerConfig)).WillOnce(Return(susiWrapper));
+    EXPECT_CALL(*wrapperFactory, accessGlobalHandler()).WillOnce(Return(nullptr));
+
+    SusiScannerFactory factory(wrapperFactory, nullptr, nullptr, nullptr);
+    EXPECT_TRUE(factory.warmUp(1, false));
+    EXPECT_NO_THROW(auto scanner = factory.createScanner(false, false, false));
+}
+
+TEST_F(TestSusiScannerFactory, warmUpScannersAreNotUsedForOtherConfigurations)
+{
+    using namespace ::testing;
+    auto wrapperFactory = std::make_shared<StrictMock<MockSusiWrapperFactory>>();
+    const auto onAccessScannerConfig = "{" + createScannerInfo(false, false, true, true) + "}";
+    const auto archivesScannerConfig = "{" + createScannerInfo(true, false, true, true) + "}";
+
+    auto susiWrapper = std::make_shared<StrictMock<MockSusiWrapper>>();
+    EXPECT_CALL(*wrapperFactory, isMachineLearningEnabled).WillRepeatedly(Return(true));
+    EXPECT_CALL(*wrapperFactory, createSusiWrapper(onAccessScannerConfig)).WillOnce(Return(susiWrapper));
+    EXPECT_CALL(*wrapperFactory, createSusiWrapper(archivesScannerConfig)).WillOnce(Return(susiWrapper));
+    EXPECT_CALL(*wrapperFactory, accessGlobalHandler()).WillOnce(Return(nullptr));
+
+    SusiScannerFactory factory(wrapperFactory, nullptr, nullptr, nullptr);
+    EXPECT_TRUE(factory.warmUp(1, true));
+    EXPECT_NO_THROW(auto scanner = factory.createScanner(true, false, true));
+}
+
+TEST_F(TestSusiScannerFactory, warmUpReturnsFalseIfSusiFailsToInitialise)
+{
+    using namespace ::testing;
+    auto wrapperFactory = std::make_shared<StrictMock<MockSusiWrapperFactory>>();
+
+    EXPECT_CALL(*wrapperFactory, isMachineLearningEnabled).WillRepeatedly(Return(true));
+    EXPECT_CALL(*wrapperFactory, createSusiWrapper(_))
+        .WillOnce(Throw(FailedToInitializeSusiException(LOCATION, "Failed to initialise SUSI")));
+
+    SusiScannerFactory factory(wrapperFactory, nullptr, nullptr, nullptr);
+    EXPECT_FALSE(factory.warmUp(2, true));
+}
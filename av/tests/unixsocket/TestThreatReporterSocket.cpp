@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "UnixSocketMemoryAppenderUsingTests.h"
 
@@ -7,14 +7,22 @@
 #include "tests/common/Common.h"
 #include "tests/common/WaitForEvent.h"
 #include "tests/scan_messages/SampleThreatDetected.h"
+#include "unixsocket/SocketUtils.h"
 #include "unixsocket/threatReporterSocket/ThreatReporterClient.h"
 #include "unixsocket/threatReporterSocket/ThreatReporterServerSocket.h"
 
 #include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
+#include "Common/SystemCallWrapper/SystemCallWrapper.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstring>
+#include <thread>
+
 using namespace scan_messages;
 using namespace testing;
 using namespace unixsocket;
@@ -109,6 +117,77 @@ TEST_F(TestThreatReporterSocket, TestSendTwoThreatReports)
     // destructor will stop the thread
 }
 
+TEST_F(TestThreatReporterSocket, TestSendBatchOfThreatReports)
+{
+    setupFakeSophosThreatDetectorConfig();
+    WaitForEvent serverWaitGuard;
+
+    auto mockThreatReportCallback = std::make_shared<StrictMock<MockIThreatReportCallbacks>>();
+
+    std::vector<std::string> receivedPaths;
+    EXPECT_CALL(*mockThreatReportCallback, processMessage(_))
+        .Times(3)
+        .WillRepeatedly(Invoke(
+            [&](const scan_messages::ThreatDetected& detection)
+            {
+                EXPECT_GE(detection.autoFd.get(), 0);
+                receivedPaths.push_back(detection.filePath);
+                if (receivedPaths.size() == 3)
+                {
+                    serverWaitGuard.onEventNoArgs();
+                }
+            }));
+
+    ThreatReporterServerSocket threatReporterServer(m_socketPath, 0600, mockThreatReportCallback);
+    threatReporterServer.start();
+
+    ThreatReporterClientSocket threatReporterSocket(m_socketPath);
+    for (int i = 0; i < 500 && !threatReporterSocket.acceptsBatches(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+    }
+    ASSERT_TRUE(threatReporterSocket.acceptsBatches());
+
+    std::vector<SerialisedThreatDetected> batch;
+    for (const auto* path : { "/first", "/second", "/third" })
+    {
+        batch.emplace_back(createThreatDetectedWithRealFd({ .filePath = path }));
+    }
+    threatReporterSocket.sendThreatDetections(batch);
+
+    serverWaitGuard.wait();
+    EXPECT_THAT(receivedPaths, ElementsAre("/first", "/second", "/third"));
+}
+
+TEST_F(TestThreatReporterSocket, TestZeroLengthBeforeThreatReportIsStillAKeepalive)
+{
+    setupFakeSophosThreatDetectorConfig();
+    WaitForEvent serverWaitGuard;
+
+    auto mockThreatReportCallback = std::make_shared<StrictMock<MockIThreatReportCallbacks>>();
+    EXPECT_CALL(*mockThreatReportCallback, processMessage(_))
+        .WillOnce(InvokeWithoutArgs(&serverWaitGuard, &WaitForEvent::onEventNoArgs));
+
+    ThreatReporterServerSocket threatReporterServer(m_socketPath, 0600, mockThreatReportCallback);
+    threatReporterServer.start();
+
+    // Written by hand the way older clients do, without waiting for the server to accept batches
+    datatypes::AutoFd socket_fd(::socket(AF_UNIX, SOCK_STREAM, 0));
+    ASSERT_GE(socket_fd.get(), 0);
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    ::strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(socket_fd.get(), reinterpret_cast<struct sockaddr*>(&address), sizeof(address)), 0);
+
+    SerialisedThreatDetected detection(createThreatDetectedWithRealFd({}));
+    writeLength(socket_fd.get(), 0);
+    Common::SystemCallWrapper::SystemCallWrapper systemCallWrapper;
+    writeLengthAndBuffer(systemCallWrapper, socket_fd.get(), detection.message);
+    ASSERT_GE(send_fd(socket_fd.get(), detection.fd.get()), 0);
+
+    serverWaitGuard.wait();
+}
+
 TEST_F(TestThreatReporterSocket, testClientSocketTriesToReconnect)
 {
     UsingMemoryAppender memoryAppenderHolder(*this);
@@ -1,4 +1,4 @@
-// Copyright 2022-2023 Sophos Limited. All rights reserved.
+// Copyright 2022-2024 Sophos Limited. All rights reserved.
 
 #include "unixsocket/updateCompleteSocket/UpdateCompleteClientSocketThread.h"
 #include "unixsocket/updateCompleteSocket/UpdateCompleteServerSocket.h"
@@ -182,3 +182,27 @@ TEST_F(TestUpdateCompleteClientSocketThread, clientReconnects)
     client.join();
     server2.join();
 }
+
+TEST_F(TestUpdateCompleteClientSocketThread, clientConnectingAfterReadyIsToldThreatDetectorIsReady)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    // Ready isn't an update, so mustn't clear the on-access cache
+    auto callback = std::make_shared<StrictMock<MockUpdateCompleteCallback>>();
+
+    UpdateCompleteServerSocket server(m_socketPath, 0700);
+    server.start();
+    server.publishReady();
+
+    UpdateCompleteClientSocketThread client(m_socketPath, callback);
+    client.start();
+
+    EXPECT_TRUE(waitForLog("UpdateCompleteClient Sophos Threat Detector is ready", 1s));
+    EXPECT_TRUE(client.connected());
+
+    client.tryStop();
+    server.tryStop();
+
+    client.join();
+    server.join();
+}
@@ -94,6 +94,7 @@ namespace Common::ApplicationConfiguration
         [[nodiscard]] virtual std::string getSulDownloaderProcessedReportPath() const = 0;
         [[nodiscard]] virtual std::string getSulDownloaderConfigFilePath() const = 0;
         [[nodiscard]] virtual std::string getSulDownloaderReportGeneratedFilePath() const = 0;
+        [[nodiscard]] virtual std::string getSulDownloaderReportIndexFilePath() const = 0;
         [[nodiscard]] virtual std::string getSulDownloaderLockFilePath() const = 0;
         [[nodiscard]] virtual std::string getSulDownloaderLatestProductUpdateMarkerPath() const = 0;
         [[nodiscard]] virtual std::string getStateMachineRawDataPath() const = 0;
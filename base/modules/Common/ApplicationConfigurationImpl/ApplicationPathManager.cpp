@@ -280,6 +280,12 @@ namespace Common::ApplicationConfigurationImpl
         return Common::FileSystem::join(getSulDownloaderReportPath(), "update_report.json");
     }
 
+    std::string ApplicationPathManager::getSulDownloaderReportIndexFilePath() const
+    {
+        // Must not match update_report*.json, or it would be listed as a report
+        return Common::FileSystem::join(getSulDownloaderReportPath(), "report_index.json");
+    }
+
     std::string ApplicationPathManager::getSulDownloaderLockFilePath() const
     {
         // This lock is in "lock-sophosspl" instead of the root "lock" dir because it needs to be readable by
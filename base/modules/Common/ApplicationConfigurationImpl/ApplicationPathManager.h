@@ -69,6 +69,7 @@ namespace Common::ApplicationConfigurationImpl
         std::string getSulDownloaderProcessedReportPath() const override;
         std::string getSulDownloaderConfigFilePath() const override;
         std::string getSulDownloaderReportGeneratedFilePath() const override;
+        [[nodiscard]] std::string getSulDownloaderReportIndexFilePath() const override;
         std::string getSulDownloaderLockFilePath() const override;
         [[nodiscard]] std::string getSulDownloaderLatestProductUpdateMarkerPath() const override;
         std::string getStateMachineRawDataPath() const override;
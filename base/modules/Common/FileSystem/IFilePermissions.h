@@ -5,9 +5,11 @@
 #include <sys/capability.h>
 #include <sys/types.h>
 
+#include <functional>
 #include <grp.h>
 #include <map>
 #include <memory>
+#include <ostream>
 
 using Path = std::string;
 
@@ -203,4 +205,30 @@ namespace Common::FileSystem
         const std::string& user,
         const std::string& group,
         mode_t mode);
+
+    /**
+     * Callback used to stream file content directly into the temporary file,
+     * avoiding the need to hold the whole content in memory.
+     */
+    using ContentWriter = std::function<void(std::ostream&)>;
+
+    /**helper method to create atomic file with permission to read/write for sophos-spl user and group,
+     * where the content is streamed into the file by writeContent
+     * */
+    void createAtomicFileToSophosUser(
+        const ContentWriter& writeContent,
+        const std::string& finalPath,
+        const std::string& tempDir);
+
+    /**
+     * helper method to create atomic file with specific permissions, where the content is streamed into the
+     * file by writeContent
+     */
+    void createAtomicFileWithPermissions(
+        const ContentWriter& writeContent,
+        const std::string& finalPath,
+        const std::string& tempDir,
+        const std::string& user,
+        const std::string& group,
+        mode_t mode);
 } // namespace Common::FileSystem
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -167,6 +167,21 @@ namespace Common::FileSystem
          */
         virtual std::unique_ptr<std::istream> openFileForRead(const Path& path) const = 0;
 
+        /**
+         * opens a stream to write a new file into, truncating any existing content.
+         * @param path, location of the file to create
+         * @return the file stream
+         */
+        virtual std::unique_ptr<std::ostream> openFileForWrite(const Path& path) const = 0;
+
+        /**
+         * opens a stream that appends to a file, creating it if it does not exist.
+         * The stream stays buffered until it is flushed or destroyed.
+         * @param path, location of the file to append to
+         * @return the file stream
+         */
+        virtual std::unique_ptr<std::ostream> openFileForAppend(const Path& path) const = 0;
+
         /**
          * Writes the given string content into a new file.
          * @param path, location of the file to create
@@ -418,8 +433,7 @@ namespace Common::FileSystem
 
         /**
          * Calculates the digest of a file from a file descriptor.
-         * The file offset of the file descriptor will be changed to the end of the file, unless an error occurs,
-         * which means the offset could be anything.
+         * The whole file is read with pread, so the file offset of the file descriptor is neither used nor changed.
          * This does not close the file descriptor upon completion, so it must be closed independently.
          * @param digestName The type of digest to calculate.
          * @param fd File descriptor.
@@ -427,6 +441,27 @@ namespace Common::FileSystem
          */
         [[nodiscard]] virtual std::string calculateDigest(SslImpl::Digest digestName, int fd) const = 0;
 
+        /**
+         * Calculates several digests of a file, reading it only once.
+         * @param digestNames The types of digest to calculate.
+         * @param path Path to the file.
+         * @return Lowercase hexadecimal representation of each digest, in the same order as digestNames.
+         */
+        [[nodiscard]] virtual std::vector<std::string> calculateDigests(
+            const std::vector<SslImpl::Digest>& digestNames,
+            const Path& path) const = 0;
+
+        /**
+         * Calculates several digests of a file from a file descriptor, reading it only once.
+         * As with calculateDigest, the file offset is neither used nor changed, and the descriptor is not closed.
+         * @param digestNames The types of digest to calculate.
+         * @param fd File descriptor.
+         * @return Lowercase hexadecimal representation of each digest, in the same order as digestNames.
+         */
+        [[nodiscard]] virtual std::vector<std::string> calculateDigests(
+            const std::vector<SslImpl::Digest>& digestNames,
+            int fd) const = 0;
+
         /**
          * Gets the disk space information for a give mount point.
          * @param path Full path to mounted device
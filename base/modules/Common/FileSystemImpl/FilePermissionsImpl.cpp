@@ -512,4 +512,56 @@ void Common::FileSystem::createAtomicFileWithPermissions(
         throw Common::FileSystem::IFileSystemException(
             std::string{ "Failed to create file at: " } + finalPath + ". Reason: " + reason);
     }
-}
\ No newline at end of file
+}
+void Common::FileSystem::createAtomicFileToSophosUser(
+    const ContentWriter& writeContent,
+    const std::string& finalPath,
+    const std::string& tempDir)
+{
+    createAtomicFileWithPermissions(
+        writeContent, finalPath, tempDir, sophos::user(), sophos::group(), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+}
+
+void Common::FileSystem::createAtomicFileWithPermissions(
+    const ContentWriter& writeContent,
+    const std::string& finalPath,
+    const std::string& tempDir,
+    const std::string& user,
+    const std::string& group,
+    mode_t mode)
+{
+    Common::UtilityImpl::UniformIntDistribution uniformIntDistribution(1000, 9999);
+    std::string fileName = Common::FileSystem::basename(finalPath);
+    auto fileSystem = Common::FileSystem::fileSystem();
+    std::string tempFilePath =
+        Common::FileSystem::join(tempDir, fileName + std::to_string(uniformIntDistribution.next()));
+    try
+    {
+        {
+            auto outStream = fileSystem->openFileForWrite(tempFilePath);
+            writeContent(*outStream);
+            outStream->flush();
+            if (!outStream->good())
+            {
+                throw Common::FileSystem::IFileSystemException("Failed to write to " + tempFilePath);
+            }
+        }
+        Common::FileSystem::filePermissions()->chown(tempFilePath, user, group);
+        Common::FileSystem::filePermissions()->chmod(tempFilePath, mode);
+        fileSystem->moveFile(tempFilePath, finalPath);
+    }
+    catch (Common::FileSystem::IFileSystemException& ex)
+    {
+        int ret = ::remove(tempFilePath.c_str());
+        static_cast<void>(ret);
+        std::string reason = ex.what();
+        throw Common::FileSystem::IFileSystemException(
+            std::string{ "Failed to create file at: " } + finalPath + ". Reason: " + reason);
+    }
+    catch (...)
+    {
+        int ret = ::remove(tempFilePath.c_str());
+        static_cast<void>(ret);
+        throw;
+    }
+}
@@ -11,15 +11,17 @@
 #include "Common/SslImpl/Digest.h"
 #include "Common/UtilityImpl/StrError.h"
 
-#include <ext/stdio_filebuf.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <dirent.h>
 #include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <unistd.h>
 
 #define LOGSUPPORT(x) std::cout << x << "\n";
@@ -35,6 +37,90 @@ namespace
         return nameMax <= 255 && sizeof(structdirent) > 256;
     }
 #pragma GCC diagnostic pop
+
+    constexpr size_t DIGEST_READ_SIZE = 1024 * 1024;
+    constexpr size_t DIGEST_READ_ALIGNMENT = 4096;
+
+    /**
+     * Reads the whole file once and feeds every digest from the same buffer. The buffer is page aligned, and no
+     * bigger than the file needs, since most files hashed are small.
+     */
+    std::vector<std::string> calculateFileDigests(
+        const std::vector<Common::SslImpl::Digest>& digestNames,
+        int fd,
+        const std::string& description)
+    {
+        std::vector<std::unique_ptr<Common::SslImpl::StreamingDigest>> digests;
+        for (auto digestName : digestNames)
+        {
+            digests.push_back(std::make_unique<Common::SslImpl::StreamingDigest>(digestName));
+        }
+
+        struct stat statbuf
+        {
+        };
+        if (::fstat(fd, &statbuf) != 0)
+        {
+            throw Common::FileSystem::IFileSystemException(
+                description + " can't be opened for reading: " + Common::UtilityImpl::StrError(errno));
+        }
+        size_t bufferSize = DIGEST_READ_SIZE;
+        if (S_ISREG(statbuf.st_mode))
+        {
+            auto fileSize = static_cast<size_t>(statbuf.st_size);
+            bufferSize = std::clamp(
+                (fileSize + DIGEST_READ_ALIGNMENT - 1) / DIGEST_READ_ALIGNMENT * DIGEST_READ_ALIGNMENT,
+                DIGEST_READ_ALIGNMENT,
+                DIGEST_READ_SIZE);
+            // Only a hint, so failure doesn't matter
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        std::unique_ptr<char, decltype(&free)> buffer(
+            static_cast<char*>(aligned_alloc(DIGEST_READ_ALIGNMENT, bufferSize)), &free);
+        if (!buffer)
+        {
+            throw std::bad_alloc();
+        }
+
+        off_t offset = 0;
+        bool positional = true;
+        while (true)
+        {
+            ssize_t bytes = positional ? ::pread(fd, buffer.get(), bufferSize, offset)
+                                       : ::read(fd, buffer.get(), bufferSize);
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytes < 0 && errno == ESPIPE && positional && offset == 0)
+            {
+                // Pipes and sockets can only be read from where they are
+                positional = false;
+                continue;
+            }
+            if (bytes < 0)
+            {
+                throw Common::FileSystem::IFileSystemException(
+                    description + " can't be read: " + Common::UtilityImpl::StrError(errno));
+            }
+            if (bytes == 0)
+            {
+                break;
+            }
+            for (auto& digest : digests)
+            {
+                digest->update(buffer.get(), static_cast<size_t>(bytes));
+            }
+            offset += bytes;
+        }
+
+        std::vector<std::string> result;
+        for (auto& digest : digests)
+        {
+            result.push_back(digest->finalise());
+        }
+        return result;
+    }
 } // namespace
 
 namespace Common::FileSystem
@@ -419,6 +505,32 @@ namespace Common::FileSystem
         throw IFileSystemException(path + " is not a file");
     }
 
+    std::unique_ptr<std::ostream> FileSystemImpl::openFileForWrite(const Path& path) const
+    {
+        auto outFile = std::make_unique<std::ofstream>(path.c_str(), std::ios::out | std::ios::trunc);
+        if (!outFile->good())
+        {
+            int error = errno;
+            std::string errdesc = StrError(error);
+
+            throw IFileSystemException("Error, Failed to open file for write: '" + path + "', " + errdesc);
+        }
+        return outFile;
+    }
+
+    std::unique_ptr<std::ostream> FileSystemImpl::openFileForAppend(const Path& path) const
+    {
+        auto outFile = std::make_unique<std::ofstream>(path.c_str(), std::ios::out | std::ios::app);
+        if (!outFile->good())
+        {
+            int error = errno;
+            std::string errdesc = StrError(error);
+
+            throw IFileSystemException("Error, Failed to open file for append: '" + path + "', " + errdesc);
+        }
+        return outFile;
+    }
+
     void FileSystemImpl::appendFile(const Path& path, const std::string& content) const
     {
         std::ofstream outFileStream(path.c_str(), std::ios::app);
@@ -1032,38 +1144,42 @@ namespace Common::FileSystem
 
     std::string FileSystemImpl::calculateDigest(SslImpl::Digest digestName, const Path& path) const
     {
-        std::ifstream inFileStream{ path, std::ios::binary };
-
-        if (!inFileStream.is_open() || !inFileStream.good())
-        {
-            throw IFileSystemException("'" + path + "' does not exist or can't be opened for reading");
-        }
-
-        return Common::SslImpl::calculateDigest(digestName, inFileStream);
+        return calculateDigests({ digestName }, path).front();
     }
 
     std::string FileSystemImpl::calculateDigest(SslImpl::Digest digestName, int fd) const
     {
-        // Need to duplicate the file descriptor because the compatibility layer will close it upon destruction
-        int dupFd = dup(fd);
-
-        // Set the file offset of the file descriptor to the start, so we calculate the digest of the whole file.
-        // Both file descriptors point to the same file description, so changing the file offset for one will change
-        // it for the other.
-        lseek(dupFd, 0, SEEK_SET);
-
-        // Non-standard GNU compatibility layer between POSIX file descriptors and std::basic_streambuf
-        // This also ensures that dupFd gets closed.
-        __gnu_cxx::stdio_filebuf<char> fileBuf{ dupFd, std::ios_base::in | std::ios_base::binary };
+        return calculateDigests({ digestName }, fd).front();
+    }
 
-        if (!fileBuf.is_open())
+    std::vector<std::string> FileSystemImpl::calculateDigests(
+        const std::vector<SslImpl::Digest>& digestNames,
+        const Path& path) const
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
         {
-            throw IFileSystemException("File descriptor '" + std::to_string(fd) + "' can't be opened for reading");
+            throw IFileSystemException("'" + path + "' does not exist or can't be opened for reading");
         }
 
-        std::istream inStream{ &fileBuf };
+        try
+        {
+            auto digests = calculateFileDigests(digestNames, fd, "'" + path + "'");
+            ::close(fd);
+            return digests;
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
 
-        return Common::SslImpl::calculateDigest(digestName, inStream);
+    std::vector<std::string> FileSystemImpl::calculateDigests(
+        const std::vector<SslImpl::Digest>& digestNames,
+        int fd) const
+    {
+        return calculateFileDigests(digestNames, fd, "File descriptor '" + std::to_string(fd) + "'");
     }
 
     std::filesystem::space_info FileSystemImpl::getDiskSpaceInfo(const Path& path) const
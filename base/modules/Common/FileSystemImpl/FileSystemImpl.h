@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -71,6 +71,10 @@ namespace Common::FileSystem
 
         std::unique_ptr<std::istream> openFileForRead(const Path& path) const override;
 
+        std::unique_ptr<std::ostream> openFileForWrite(const Path& path) const override;
+
+        std::unique_ptr<std::ostream> openFileForAppend(const Path& path) const override;
+
         void removeFile(const Path& path, bool ignoreAbsent) const override;
 
         void removeFile(const Path& path) const override;
@@ -105,6 +109,14 @@ namespace Common::FileSystem
 
         [[nodiscard]] std::string calculateDigest(SslImpl::Digest digestName, int fd) const override;
 
+        [[nodiscard]] std::vector<std::string> calculateDigests(
+            const std::vector<SslImpl::Digest>& digestNames,
+            const Path& path) const override;
+
+        [[nodiscard]] std::vector<std::string> calculateDigests(
+            const std::vector<SslImpl::Digest>& digestNames,
+            int fd) const override;
+
         [[nodiscard]] std::filesystem::space_info getDiskSpaceInfo(const Path& path) const override;
 
         [[nodiscard]] std::filesystem::space_info getDiskSpaceInfo(const Path& path, std::error_code& ec)
@@ -1,13 +1,13 @@
-/******************************************************************************************************
-
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "IPluginCallbackApi.h"
 
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <string>
 
 namespace Common::PluginApi
@@ -37,6 +37,28 @@ namespace Common::PluginApi
      *  ::sendEvent and ::changeStatus and ::getPolicy require that the appId must be provide explicitly.
      *
      */
+    /**
+     * Called once an asynchronous send has been delivered to the Management Agent (true) or has been given up on
+     * (false). It may be called from the thread sending the messages, so it must not block.
+     */
+    using SendCompletion = std::function<void(bool delivered)>;
+
+    /**
+     * Snapshot of the outbound queue used by the asynchronous send methods.
+     */
+    struct OutboundQueueStats
+    {
+        size_t queuedEvents = 0;
+        size_t queuedStatuses = 0;
+        size_t maxQueuedEvents = 0;
+        uint64_t eventsSent = 0;
+        uint64_t eventBatchesSent = 0;
+        uint64_t eventsDropped = 0;
+        uint64_t statusesSent = 0;
+        uint64_t statusesCoalesced = 0;
+        uint64_t sendFailures = 0;
+    };
+
     class IBaseServiceApi
     {
     public:
@@ -97,6 +119,80 @@ namespace Common::PluginApi
          * https://sophos.atlassian.net/wiki/spaces/SophosCloud/pages/42132014794/EMP+status-health
          */
         virtual void sendThreatHealth(const std::string& healthJson) const = 0;
+
+        /**
+         * Queue an Event to be sent to Management Console via the Management Agent without waiting for it.
+         *
+         * Queued events are sent in order, with consecutive events for the same appId sent together in one
+         * message. If the queue is full the event is dropped and onComplete is called with false.
+         *
+         * The default implementation sends the event synchronously.
+         *
+         * @param appId The App name as required by Management Console.
+         * @param eventXml The content of the xml to be sent to Management Console.
+         * @param onComplete Optional, called once the event has been delivered or dropped.
+         */
+        virtual void sendEventAsync(
+            const std::string& appId,
+            const std::string& eventXml,
+            SendCompletion onComplete = {}) const
+        {
+            bool delivered = false;
+            try
+            {
+                sendEvent(appId, eventXml);
+                delivered = true;
+            }
+            catch (const std::exception&)
+            {
+            }
+            if (onComplete)
+            {
+                onComplete(delivered);
+            }
+        }
+
+        /**
+         * Queue an App Status to be sent to Management Console without waiting for it.
+         *
+         * Only the latest status for each appId is kept, so a status that is replaced before it is sent is never
+         * sent. Its onComplete is called with false.
+         *
+         * The default implementation sends the status synchronously.
+         *
+         * @see sendStatus
+         */
+        virtual void sendStatusAsync(
+            const std::string& appId,
+            const std::string& statusXml,
+            const std::string& statusWithoutTimestampsXml,
+            SendCompletion onComplete = {}) const
+        {
+            bool delivered = false;
+            try
+            {
+                sendStatus(appId, statusXml, statusWithoutTimestampsXml);
+                delivered = true;
+            }
+            catch (const std::exception&)
+            {
+            }
+            if (onComplete)
+            {
+                onComplete(delivered);
+            }
+        }
+
+        /**
+         * Wait until everything queued by the asynchronous send methods has been sent or given up on.
+         * @return false if the queue was not empty when the timeout expired.
+         */
+        virtual bool flush(std::chrono::milliseconds /*timeout*/) const { return true; }
+
+        /**
+         * @return the current depth of the asynchronous send queue and counts of what has been sent through it.
+         */
+        virtual OutboundQueueStats getOutboundQueueStats() const { return {}; }
     };
 
     // std::string getLibraryVersion();
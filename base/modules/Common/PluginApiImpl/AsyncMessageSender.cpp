@@ -0,0 +1,238 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "AsyncMessageSender.h"
+
+#include "Logger.h"
+
+#include <algorithm>
+
+namespace Common::PluginApiImpl
+{
+    AsyncMessageSender::AsyncMessageSender(
+        const std::string& pluginName,
+        SendFunction send,
+        size_t maxQueuedEvents,
+        size_t maxEventsPerBatch,
+        std::chrono::milliseconds shutdownFlushTimeout,
+        std::chrono::milliseconds queueFullTimeout) :
+        m_messageBuilder(pluginName),
+        m_send(std::move(send)),
+        m_maxQueuedEvents(std::max<size_t>(maxQueuedEvents, 1)),
+        m_maxEventsPerBatch(std::max<size_t>(maxEventsPerBatch, 1)),
+        m_shutdownFlushTimeout(shutdownFlushTimeout),
+        m_queueFullTimeout(queueFullTimeout),
+        m_thread(&AsyncMessageSender::run, this)
+    {
+    }
+
+    AsyncMessageSender::~AsyncMessageSender()
+    {
+        if (!flush(m_shutdownFlushTimeout))
+        {
+            LOGWARN("Timed out sending queued messages to Management Agent");
+        }
+
+        std::deque<QueuedEvent> events;
+        std::map<std::string, QueuedStatus> statuses;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            events.swap(m_events);
+            statuses.swap(m_statuses);
+        }
+        m_workAvailable.notify_all();
+        m_spaceAvailable.notify_all();
+        m_thread.join();
+
+        for (const auto& event : events)
+        {
+            complete(event.onComplete, false);
+        }
+        for (const auto& [appId, status] : statuses)
+        {
+            complete(status.onComplete, false);
+        }
+    }
+
+    void AsyncMessageSender::queueEvent(
+        const std::string& appId,
+        const std::string& eventXml,
+        Common::PluginApi::SendCompletion onComplete)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_events.size() >= m_maxQueuedEvents)
+            {
+                // Hold the caller back rather than lose the event while the Management Agent catches up
+                m_spaceAvailable.wait_for(
+                    lock, m_queueFullTimeout, [this]() { return m_stopping || m_events.size() < m_maxQueuedEvents; });
+            }
+            if (!m_stopping && m_events.size() < m_maxQueuedEvents)
+            {
+                m_events.push_back(QueuedEvent{ appId, eventXml, std::move(onComplete) });
+                m_stats.maxQueuedEvents = std::max(m_stats.maxQueuedEvents, m_events.size());
+                m_workAvailable.notify_one();
+                return;
+            }
+
+            ++m_stats.eventsDropped;
+            if (!m_warnedQueueFull)
+            {
+                LOGERROR(
+                    "Event queue to Management Agent is still full after " << m_queueFullTimeout.count()
+                                                                           << "ms, dropping events for AppId: "
+                                                                           << appId);
+                m_warnedQueueFull = true;
+            }
+        }
+        complete(onComplete, false);
+    }
+
+    void AsyncMessageSender::queueStatus(
+        const std::string& appId,
+        const std::string& statusXml,
+        const std::string& statusWithoutTimestampsXml,
+        Common::PluginApi::SendCompletion onComplete)
+    {
+        Common::PluginApi::SendCompletion superseded;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            QueuedStatus status{ statusXml, statusWithoutTimestampsXml, std::move(onComplete) };
+            auto found = m_statuses.find(appId);
+            if (found != m_statuses.end())
+            {
+                ++m_stats.statusesCoalesced;
+                superseded = std::move(found->second.onComplete);
+                found->second = std::move(status);
+            }
+            else
+            {
+                m_statuses.emplace(appId, std::move(status));
+            }
+            m_workAvailable.notify_one();
+        }
+        complete(superseded, false);
+    }
+
+    bool AsyncMessageSender::flush(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_idle.wait_for(
+            lock, timeout, [this]() { return m_events.empty() && m_statuses.empty() && !m_sending; });
+    }
+
+    Common::PluginApi::OutboundQueueStats AsyncMessageSender::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto stats = m_stats;
+        stats.queuedEvents = m_events.size();
+        stats.queuedStatuses = m_statuses.size();
+        return stats;
+    }
+
+    void AsyncMessageSender::run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_workAvailable.wait(lock, [this]() { return m_stopping || !m_events.empty() || !m_statuses.empty(); });
+            if (m_stopping)
+            {
+                return;
+            }
+            m_sending = true;
+
+            // Statuses go ahead of queued events, so the latest state isn't held back behind a backlog of events
+            if (!m_statuses.empty())
+            {
+                auto queued = m_statuses.extract(m_statuses.begin());
+                lock.unlock();
+
+                auto reply = send(m_messageBuilder.requestSendStatusMessage(
+                    queued.key(), queued.mapped().statusXml, queued.mapped().statusWithoutTimestampsXml));
+                bool delivered = reply.has_value();
+                complete(queued.mapped().onComplete, delivered);
+
+                lock.lock();
+                if (delivered)
+                {
+                    ++m_stats.statusesSent;
+                }
+            }
+            else
+            {
+                // Only consecutive events for one appId share a message, so events stay in the order they were queued
+                const size_t maxEventsPerBatch = m_eventBatchesAccepted ? m_maxEventsPerBatch : 1;
+                std::vector<QueuedEvent> batch;
+                std::string appId = m_events.front().appId;
+                while (!m_events.empty() && batch.size() < maxEventsPerBatch && m_events.front().appId == appId)
+                {
+                    batch.push_back(std::move(m_events.front()));
+                    m_events.pop_front();
+                }
+                m_warnedQueueFull = false;
+                m_spaceAvailable.notify_all();
+                lock.unlock();
+
+                std::vector<std::string> eventXmls;
+                eventXmls.reserve(batch.size());
+                for (auto& event : batch)
+                {
+                    eventXmls.push_back(std::move(event.eventXml));
+                }
+                LOGSUPPORT("Send " << eventXmls.size() << " Events for AppId: " << appId);
+                auto reply = send(m_messageBuilder.requestSendEventsMessage(appId, std::move(eventXmls)));
+                bool delivered = reply.has_value();
+                for (const auto& event : batch)
+                {
+                    complete(event.onComplete, delivered);
+                }
+
+                lock.lock();
+                if (delivered)
+                {
+                    m_eventBatchesAccepted = m_messageBuilder.acceptsEventBatches(*reply);
+                    m_stats.eventsSent += batch.size();
+                    ++m_stats.eventBatchesSent;
+                }
+            }
+
+            m_sending = false;
+            m_idle.notify_all();
+        }
+    }
+
+    std::optional<Common::PluginProtocol::DataMessage> AsyncMessageSender::send(
+        const Common::PluginProtocol::DataMessage& message)
+    {
+        try
+        {
+            return m_send(message);
+        }
+        catch (const std::exception& ex)
+        {
+            LOGWARN(
+                "Failed to send " << Common::PluginProtocol::ConvertCommandEnumToString(message.m_command)
+                                  << " for AppId: " << message.m_applicationId << ": " << ex.what());
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.sendFailures;
+        return std::nullopt;
+    }
+
+    void AsyncMessageSender::complete(const Common::PluginApi::SendCompletion& onComplete, bool delivered)
+    {
+        if (!onComplete)
+        {
+            return;
+        }
+        try
+        {
+            onComplete(delivered);
+        }
+        catch (const std::exception& ex)
+        {
+            LOGERROR("Send completion callback failed: " << ex.what());
+        }
+    }
+} // namespace Common::PluginApiImpl
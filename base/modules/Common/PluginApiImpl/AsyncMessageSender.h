@@ -0,0 +1,119 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "Common/PluginApi/IBaseServiceApi.h"
+#include "Common/PluginProtocol/MessageBuilder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace Common::PluginApiImpl
+{
+    /**
+     * Sends events and statuses to the Management Agent from a background thread so callers don't wait for the
+     * round trip.
+     *
+     * Events are kept in order in a bounded queue. When it is full, queueEvent waits up to the queue full timeout
+     * for the sending thread to make space before giving up on the event.
+     *
+     * Management Agents older than the batching support only read the first payload entry of a PLUGIN_SEND_EVENT,
+     * so events are sent one per message until the acknowledgement of an event says the Management Agent accepts
+     * batches. From then on up to maxEventsPerBatch consecutive events for the same appId share a message.
+     *
+     * Only the latest status for each appId is kept. A pending status is sent before any queued events, so a
+     * status can reach the Management Agent ahead of events that were queued before it.
+     */
+    class AsyncMessageSender
+    {
+    public:
+        /**
+         * Sends one message and returns the reply. Throws if the message was not acknowledged.
+         */
+        using SendFunction =
+            std::function<Common::PluginProtocol::DataMessage(const Common::PluginProtocol::DataMessage&)>;
+
+        static constexpr size_t DEFAULT_MAX_QUEUED_EVENTS = 1000;
+        static constexpr size_t DEFAULT_MAX_EVENTS_PER_BATCH = 50;
+        static constexpr std::chrono::milliseconds DEFAULT_SHUTDOWN_FLUSH_TIMEOUT{ 5000 };
+        static constexpr std::chrono::milliseconds DEFAULT_QUEUE_FULL_TIMEOUT{ 5000 };
+
+        AsyncMessageSender(
+            const std::string& pluginName,
+            SendFunction send,
+            size_t maxQueuedEvents = DEFAULT_MAX_QUEUED_EVENTS,
+            size_t maxEventsPerBatch = DEFAULT_MAX_EVENTS_PER_BATCH,
+            std::chrono::milliseconds shutdownFlushTimeout = DEFAULT_SHUTDOWN_FLUSH_TIMEOUT,
+            std::chrono::milliseconds queueFullTimeout = DEFAULT_QUEUE_FULL_TIMEOUT);
+
+        /**
+         * Waits up to the shutdown flush timeout for queued messages to be sent. Anything still queued after that
+         * is completed as not delivered.
+         */
+        ~AsyncMessageSender();
+
+        AsyncMessageSender(const AsyncMessageSender&) = delete;
+        AsyncMessageSender& operator=(const AsyncMessageSender&) = delete;
+
+        /**
+         * Blocks for up to the queue full timeout while the queue is full. If no space is made in that time the
+         * event is dropped and completed as not delivered.
+         */
+        void queueEvent(const std::string& appId, const std::string& eventXml, Common::PluginApi::SendCompletion);
+
+        void queueStatus(
+            const std::string& appId,
+            const std::string& statusXml,
+            const std::string& statusWithoutTimestampsXml,
+            Common::PluginApi::SendCompletion);
+
+        bool flush(std::chrono::milliseconds timeout);
+
+        Common::PluginApi::OutboundQueueStats stats() const;
+
+    private:
+        struct QueuedEvent
+        {
+            std::string appId;
+            std::string eventXml;
+            Common::PluginApi::SendCompletion onComplete;
+        };
+
+        struct QueuedStatus
+        {
+            std::string statusXml;
+            std::string statusWithoutTimestampsXml;
+            Common::PluginApi::SendCompletion onComplete;
+        };
+
+        void run();
+        std::optional<Common::PluginProtocol::DataMessage> send(const Common::PluginProtocol::DataMessage& message);
+        static void complete(const Common::PluginApi::SendCompletion& onComplete, bool delivered);
+
+        Common::PluginProtocol::MessageBuilder m_messageBuilder;
+        SendFunction m_send;
+        const size_t m_maxQueuedEvents;
+        const size_t m_maxEventsPerBatch;
+        const std::chrono::milliseconds m_shutdownFlushTimeout;
+        const std::chrono::milliseconds m_queueFullTimeout;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_idle;
+        std::condition_variable m_spaceAvailable;
+        std::deque<QueuedEvent> m_events;
+        std::map<std::string, QueuedStatus> m_statuses;
+        bool m_sending = false;
+        bool m_stopping = false;
+        bool m_warnedQueueFull = false;
+        bool m_eventBatchesAccepted = false;
+        Common::PluginApi::OutboundQueueStats m_stats;
+
+        // Last so everything it uses exists before it starts
+        std::thread m_thread;
+    };
+} // namespace Common::PluginApiImpl
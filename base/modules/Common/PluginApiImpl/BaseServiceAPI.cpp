@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "BaseServiceAPI.h"
 
@@ -34,6 +34,7 @@ void Common::PluginApiImpl::BaseServiceAPI::setPluginCallback(
 
 Common::PluginApiImpl::BaseServiceAPI::~BaseServiceAPI()
 {
+    m_asyncSender.reset();
     if (m_pluginCallbackHandler)
     {
         m_pluginCallbackHandler->stopAndJoin();
@@ -77,6 +78,59 @@ void Common::PluginApiImpl::BaseServiceAPI::sendStatus(
     }
 }
 
+void Common::PluginApiImpl::BaseServiceAPI::sendEventAsync(
+    const std::string& appId,
+    const std::string& eventXml,
+    Common::PluginApi::SendCompletion onComplete) const
+{
+    asyncSender().queueEvent(appId, eventXml, std::move(onComplete));
+}
+
+void Common::PluginApiImpl::BaseServiceAPI::sendStatusAsync(
+    const std::string& appId,
+    const std::string& statusXml,
+    const std::string& statusWithoutTimestampsXml,
+    Common::PluginApi::SendCompletion onComplete) const
+{
+    asyncSender().queueStatus(appId, statusXml, statusWithoutTimestampsXml, std::move(onComplete));
+}
+
+bool Common::PluginApiImpl::BaseServiceAPI::flush(std::chrono::milliseconds timeout) const
+{
+    std::lock_guard<std::mutex> lock(m_asyncSenderMutex);
+    return !m_asyncSender || m_asyncSender->flush(timeout);
+}
+
+Common::PluginApi::OutboundQueueStats Common::PluginApiImpl::BaseServiceAPI::getOutboundQueueStats() const
+{
+    std::lock_guard<std::mutex> lock(m_asyncSenderMutex);
+    return m_asyncSender ? m_asyncSender->stats() : Common::PluginApi::OutboundQueueStats{};
+}
+
+Common::PluginApiImpl::AsyncMessageSender& Common::PluginApiImpl::BaseServiceAPI::asyncSender() const
+{
+    std::lock_guard<std::mutex> lock(m_asyncSenderMutex);
+    if (!m_asyncSender)
+    {
+        m_asyncSender = std::make_unique<AsyncMessageSender>(
+            m_pluginName,
+            [this](const Common::PluginProtocol::DataMessage& request) { return sendAndCheckAck(request); });
+    }
+    return *m_asyncSender;
+}
+
+Common::PluginProtocol::DataMessage Common::PluginApiImpl::BaseServiceAPI::sendAndCheckAck(
+    const Common::PluginProtocol::DataMessage& request) const
+{
+    Common::PluginProtocol::DataMessage replyMessage = getReply(request);
+    if (!m_messageBuilder.hasAck(replyMessage))
+    {
+        throw Common::PluginApi::ApiException(
+            "Invalid reply for: " + Common::PluginProtocol::ConvertCommandEnumToString(request.m_command));
+    }
+    return replyMessage;
+}
+
 void Common::PluginApiImpl::BaseServiceAPI::registerWithManagementAgent() const
 {
     LOGSUPPORT("Registering '" << m_pluginName << "' with management agent");
@@ -1,10 +1,8 @@
-/******************************************************************************************************
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
 #pragma once
 
+#include "AsyncMessageSender.h"
 #include "PluginCallBackHandler.h"
 
 #include "Common/PluginApi/IBaseServiceApi.h"
@@ -39,13 +37,34 @@ namespace Common::PluginApiImpl
 
         void sendThreatHealth(const std::string& healthJson) const override;
 
+        void sendEventAsync(
+            const std::string& appId,
+            const std::string& eventXml,
+            Common::PluginApi::SendCompletion onComplete = {}) const override;
+
+        void sendStatusAsync(
+            const std::string& appId,
+            const std::string& statusXml,
+            const std::string& statusWithoutTimestampsXml,
+            Common::PluginApi::SendCompletion onComplete = {}) const override;
+
+        bool flush(std::chrono::milliseconds timeout) const override;
+
+        Common::PluginApi::OutboundQueueStats getOutboundQueueStats() const override;
+
     private:
         Common::PluginProtocol::DataMessage getReply(const Common::PluginProtocol::DataMessage& request) const;
+        Common::PluginProtocol::DataMessage sendAndCheckAck(const Common::PluginProtocol::DataMessage& request) const;
+        AsyncMessageSender& asyncSender() const;
 
         std::string m_pluginName;
         Common::ZeroMQWrapper::ISocketRequesterPtr m_socket;
 
         std::unique_ptr<PluginCallBackHandler> m_pluginCallbackHandler;
         Common::PluginProtocol::MessageBuilder m_messageBuilder;
+
+        // Only started when a plugin first sends asynchronously; stopped before the socket is destroyed
+        mutable std::mutex m_asyncSenderMutex;
+        mutable std::unique_ptr<AsyncMessageSender> m_asyncSender;
     };
 } // namespace Common::PluginApiImpl
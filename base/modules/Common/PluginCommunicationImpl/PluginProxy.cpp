@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "PluginProxy.h"
 
@@ -117,6 +117,7 @@ namespace Common::PluginCommunicationImpl
         Common::PluginProtocol::DataMessage reply;
         try
         {
+            std::lock_guard<std::mutex> lock(m_socketMutex);
             m_socket->write(protocol.serialize(request));
             reply = protocol.deserialize(m_socket->read());
         }
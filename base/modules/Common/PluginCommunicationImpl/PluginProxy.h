@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #pragma once
 
 #include "AppIdCollection.h"
@@ -9,6 +9,8 @@
 #include "Common/ZeroMQWrapper/ISocketRequester.h"
 #include "Common/ZeroMQWrapper/ISocketRequesterPtr.h"
 
+#include <mutex>
+
 namespace Common::PluginCommunicationImpl
 {
     class PluginProxy : virtual public PluginCommunication::IPluginProxy
@@ -52,6 +54,8 @@ namespace Common::PluginCommunicationImpl
     private:
         Common::PluginProtocol::DataMessage getReply(const Common::PluginProtocol::DataMessage& request) const;
         Common::ZeroMQWrapper::ISocketRequesterPtr m_socket;
+        // Requests on one plugin are serialised here so different plugins can be called concurrently
+        mutable std::mutex m_socketMutex;
         Common::PluginProtocol::MessageBuilder m_messageBuilder;
         AppIdCollection m_appIdCollection;
         std::string m_name;
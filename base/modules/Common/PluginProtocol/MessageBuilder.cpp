@@ -1,11 +1,9 @@
-/******************************************************************************************************
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
 #include "MessageBuilder.h"
 
 #include <cassert>
+#include <stdexcept>
 namespace Common::PluginProtocol
 {
     using namespace Common::PluginApi;
@@ -17,6 +15,15 @@ namespace Common::PluginProtocol
         return createDefaultDataMessage(Commands::PLUGIN_SEND_EVENT, appId, eventXml);
     }
 
+    DataMessage MessageBuilder::requestSendEventsMessage(const std::string& appId, std::vector<std::string> eventXmls)
+        const
+    {
+        assert(!eventXmls.empty());
+        DataMessage dataMessage = createDefaultDataMessage(Commands::PLUGIN_SEND_EVENT, appId, std::string());
+        dataMessage.m_payload = std::move(eventXmls);
+        return dataMessage;
+    }
+
     DataMessage MessageBuilder::requestSendStatusMessage(
         const std::string& appId,
         const std::string& statusXml,
@@ -74,6 +81,16 @@ namespace Common::PluginProtocol
         return dataMessage.m_payload.at(0);
     }
 
+    std::vector<std::string> MessageBuilder::requestExtractEvents(const DataMessage& dataMessage) const
+    {
+        assert(dataMessage.m_command == Commands::PLUGIN_SEND_EVENT);
+        if (dataMessage.m_payload.empty())
+        {
+            throw std::out_of_range("No events in message");
+        }
+        return dataMessage.m_payload;
+    }
+
     Common::PluginApi::StatusInfo MessageBuilder::requestExtractStatus(const DataMessage& dataMessage) const
     {
         assert(
@@ -102,6 +119,14 @@ namespace Common::PluginProtocol
         return reply;
     }
 
+    DataMessage MessageBuilder::replyAckEventsMessage(const DataMessage& dataMessage) const
+    {
+        assert(dataMessage.m_command == Commands::PLUGIN_SEND_EVENT);
+        DataMessage reply = replyAckMessage(dataMessage);
+        reply.m_payload.push_back(EVENT_BATCHES_ACCEPTED);
+        return reply;
+    }
+
     DataMessage MessageBuilder::replySetErrorIfEmpty(
         const DataMessage& dataMessage,
         const std::string& errorDescription) const
@@ -187,6 +212,12 @@ namespace Common::PluginProtocol
         return dataMessage.m_acknowledge;
     }
 
+    bool MessageBuilder::acceptsEventBatches(const DataMessage& dataMessage) const
+    {
+        return dataMessage.m_acknowledge && !dataMessage.m_payload.empty() &&
+               dataMessage.m_payload.at(0) == EVENT_BATCHES_ACCEPTED;
+    }
+
     DataMessage MessageBuilder::replyHealth(const DataMessage& dataMessage, const std::string& healthContent) const
     {
         assert(dataMessage.m_command == Commands::REQUEST_PLUGIN_HEALTH);
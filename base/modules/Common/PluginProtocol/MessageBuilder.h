@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -11,10 +11,15 @@ namespace Common::PluginProtocol
     class MessageBuilder
     {
     public:
+        /** Added to the acknowledgement of PLUGIN_SEND_EVENT by Management Agents that read every payload entry **/
+        inline static const std::string EVENT_BATCHES_ACCEPTED = "EventBatchesAccepted";
+
         explicit MessageBuilder(const std::string& pluginName);
 
         /** Create the requests as client **/
         DataMessage requestSendEventMessage(const std::string& appId, const std::string& eventXml) const;
+        /** Several events for one appId, one per payload entry **/
+        DataMessage requestSendEventsMessage(const std::string& appId, std::vector<std::string> eventXmls) const;
 
         DataMessage requestSendStatusMessage(
             const std::string& appId,
@@ -38,6 +43,7 @@ namespace Common::PluginProtocol
 
         /** Extracting information from requests as server **/
         std::string requestExtractEvent(const DataMessage&) const;
+        std::vector<std::string> requestExtractEvents(const DataMessage&) const;
         PluginApi::StatusInfo requestExtractStatus(const DataMessage&) const;
         std::string requestExtractPolicy(const DataMessage&) const;
         std::string requestExtractAction(const DataMessage&) const;
@@ -45,6 +51,7 @@ namespace Common::PluginProtocol
 
         /** Build replies as servers **/
         DataMessage replyAckMessage(const DataMessage&) const;
+        DataMessage replyAckEventsMessage(const DataMessage&) const;
         DataMessage replySetErrorIfEmpty(const DataMessage&, const std::string& errorDescription) const;
         DataMessage replyCurrentPolicy(const DataMessage&, const std::string& policyContent) const;
         DataMessage replyTelemetry(const DataMessage&, const std::string& telemetryContent) const;
@@ -57,6 +64,8 @@ namespace Common::PluginProtocol
         std::string replyExtractHealth(const DataMessage&) const;
 
         bool hasAck(const DataMessage& dataMessage) const;
+        /** Whether the acknowledgement of a PLUGIN_SEND_EVENT says several events can be sent in one message **/
+        bool acceptsEventBatches(const DataMessage& dataMessage) const;
 
     private:
         DataMessage createDefaultDataMessage(
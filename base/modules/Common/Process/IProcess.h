@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -131,6 +131,8 @@ namespace Common::Process
 
         /*
          * Set whether the buffer of the process should be flushed to the callback set by setOutputTrimmedCallback.
+         * Output is passed on as soon as it finishes a line, or when more output follows it. An unfinished last line
+         * is not passed on, and is returned by output() once the process has finished.
          * Default is disabled.
          * @param flushOnNewLine flush on new line or not.
          */
@@ -1,8 +1,8 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "ProcessImpl.h"
 
-#include "BoostProcessHolder.h"
+#include "SupervisedProcessHolder.h"
 #include "Logger.h"
 
 #include "Common/Process/IProcessException.h"
@@ -136,8 +136,8 @@ namespace Common::ProcessImpl
         {
             fullPeriod = Process::Milliseconds{ 1 };
         }
-        auto processOnBoost = safeAccess();
-        return processOnBoost->wait(fullPeriod);
+        auto processHolder = safeAccess();
+        return processHolder->wait(fullPeriod);
     }
 
     void ProcessImpl::exec(const std::string& path, const std::vector<std::string>& arguments)
@@ -160,11 +160,11 @@ namespace Common::ProcessImpl
         uid_t uid,
         gid_t gid)
     {
-        std::lock_guard<std::mutex> lock(m_protectImplOnBoost);
+        std::lock_guard<std::mutex> lock(m_protectImpl);
         m_pid = -1;
         try
         {
-            m_d = std::make_shared<BoostProcessHolder>(
+            m_d = std::make_shared<SupervisedProcessHolder>(
                 path,
                 arguments,
                 extraEnvironment,
@@ -197,32 +197,32 @@ namespace Common::ProcessImpl
     }
     int ProcessImpl::exitCode()
     {
-        auto processOnBoost = safeAccess();
-        return processOnBoost->exitCode();
+        auto processHolder = safeAccess();
+        return processHolder->exitCode();
     }
 
     int ProcessImpl::nativeExitCode()
     {
-        auto processOnBoost = safeAccess();
-        return processOnBoost->nativeExitCode();
+        auto processHolder = safeAccess();
+        return processHolder->nativeExitCode();
     }
 
     std::string ProcessImpl::output()
     {
-        auto processOnBoost = safeAccess();
-        return processOnBoost->output();
+        auto processHolder = safeAccess();
+        return processHolder->output();
     }
 
     std::string ProcessImpl::errorOutput()
     {
-        auto processOnBoost = safeAccess();
-        return processOnBoost->stderroutput();
+        auto processHolder = safeAccess();
+        return processHolder->stderroutput();
     }
 
     std::string ProcessImpl::standardOutput()
     {
-        auto processOnBoost = safeAccess();
-        return processOnBoost->stdoutput();
+        auto processHolder = safeAccess();
+        return processHolder->stdoutput();
     }
 
     bool ProcessImpl::kill()
@@ -234,19 +234,19 @@ namespace Common::ProcessImpl
     {
         int numOfDecSeconds = secondsBeforeSIGKILL * 10;
         bool requiredKill = false;
-        auto processOnBoost = safeAccess();
-        if (!processOnBoost->hasFinished())
+        auto processHolder = safeAccess();
+        if (!processHolder->hasFinished())
         {
-            processOnBoost->sendTerminateSignal();
+            processHolder->sendTerminateSignal();
             if (wait(Process::milli(numOfDecSeconds), 100) == Process::ProcessStatus::TIMEOUT)
             {
                 if (m_coreDumpEnabled)
                 {
-                    processOnBoost->sendAbortSignal();
+                    processHolder->sendAbortSignal();
                 }
                 else
                 {
-                    processOnBoost->kill();
+                    processHolder->kill();
                 }
 
                 requiredKill = true;
@@ -257,20 +257,20 @@ namespace Common::ProcessImpl
 
     void ProcessImpl::sendSIGUSR1()
     {
-        auto processOnBoost = safeAccess();
-        processOnBoost->sendUsr1Signal();
+        auto processHolder = safeAccess();
+        processHolder->sendUsr1Signal();
     }
 
     Process::ProcessStatus ProcessImpl::getStatus()
     {
-        auto processOnBoost = safeAccess();
-        if (!processOnBoost)
+        auto processHolder = safeAccess();
+        if (!processHolder)
         {
             LOGSUPPORT("getStatus can be called only after exec");
             return Process::ProcessStatus::NOTSTARTED;
         }
 
-        if (processOnBoost->hasFinished())
+        if (processHolder->hasFinished())
         {
             return Process::ProcessStatus::FINISHED;
         }
@@ -325,8 +325,8 @@ namespace Common::ProcessImpl
 
     void ProcessImpl::waitUntilProcessEnds()
     {
-        auto processOnBoost = safeAccess();
-        processOnBoost->wait();
+        auto processHolder = safeAccess();
+        processHolder->wait();
     }
 
     void ProcessImpl::setCoreDumpMode(const bool mode)
@@ -341,7 +341,7 @@ namespace Common::ProcessImpl
 
     std::shared_ptr<IProcessHolder> ProcessImpl::safeAccess()
     {
-        std::lock_guard<std::mutex> lock(m_protectImplOnBoost);
+        std::lock_guard<std::mutex> lock(m_protectImpl);
         std::shared_ptr<IProcessHolder> copy = m_d;
         return copy;
     }
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -55,7 +55,7 @@ namespace Common::ProcessImpl
         void setCoreDumpMode(const bool mode) override;
 
     private:
-        std::mutex m_protectImplOnBoost;
+        std::mutex m_protectImpl;
         std::atomic<int> m_pid;
         size_t m_outputLimit;
         bool m_flushOnNewLine;
@@ -0,0 +1,385 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "ProcessSupervisor.h"
+
+#include "Logger.h"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <system_error>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+// The same on every architecture, but missing from older headers
+#    define SYS_pidfd_open 434
+#endif
+
+namespace
+{
+    constexpr size_t READ_BUFFER_SIZE = 64 * 1024;
+    constexpr int MAX_EVENTS = 64;
+    // Reads from one pipe per wake up, so a child that writes constantly can't hold up the others
+    constexpr int MAX_READS_PER_EVENT = 16;
+
+    enum Kind : uint64_t
+    {
+        WAKE_UP = 0,
+        PIDFD = 1,
+        STDOUT_PIPE = 2,
+        STDERR_PIPE = 3
+    };
+
+    uint64_t makeKey(uint64_t id, Kind kind)
+    {
+        return (id << 2) | kind;
+    }
+
+    int pidfdOpen(pid_t pid)
+    {
+        return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+    }
+
+    void addToEpoll(int epollFd, int fd, uint64_t key)
+    {
+        struct epoll_event event
+        {
+        };
+        event.events = EPOLLIN;
+        event.data.u64 = key;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "Failed to watch child process");
+        }
+    }
+} // namespace
+
+namespace Common::ProcessImpl
+{
+    ProcessSupervisor& ProcessSupervisor::instance()
+    {
+        // Never destroyed, so processes held by other statics can still be stopped during exit
+        static auto* supervisor = new ProcessSupervisor();
+        return *supervisor;
+    }
+
+    ProcessSupervisor::ProcessSupervisor() :
+        m_epollFd(::epoll_create1(EPOLL_CLOEXEC)), m_buffer(READ_BUFFER_SIZE)
+    {
+        if (m_epollFd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "Failed to create process supervisor");
+        }
+        ::fcntl(m_wakeUp.readFd(), F_SETFD, FD_CLOEXEC);
+        ::fcntl(m_wakeUp.writeFd(), F_SETFD, FD_CLOEXEC);
+        addToEpoll(m_epollFd, m_wakeUp.readFd(), WAKE_UP);
+        m_thread = std::thread(&ProcessSupervisor::run, this);
+    }
+
+    ProcessSupervisor::~ProcessSupervisor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeUp.notify();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+        ::close(m_epollFd);
+    }
+
+    void ProcessSupervisor::supervise(pid_t pid, int stdoutFd, int stderrFd, std::shared_ptr<IChild> child)
+    {
+        Supervised supervised;
+        supervised.pid = pid;
+        supervised.pidFd = pidfdOpen(pid);
+        if (supervised.pidFd < 0)
+        {
+            LOGDEBUG("pidfd_open unavailable for " << pid << ", polling for exit instead: " << std::strerror(errno));
+        }
+        supervised.fds[0] = stdoutFd;
+        supervised.fds[1] = stderrFd;
+        supervised.child = std::move(child);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(supervised));
+            ++m_count;
+        }
+        m_wakeUp.notify();
+    }
+
+    size_t ProcessSupervisor::supervisedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count;
+    }
+
+    void ProcessSupervisor::run()
+    {
+        std::vector<struct epoll_event> events(MAX_EVENTS);
+        while (true)
+        {
+            int ready = ::epoll_wait(m_epollFd, events.data(), MAX_EVENTS, pollTimeoutMilliseconds());
+            if (ready < 0 && errno != EINTR)
+            {
+                LOGERROR("Process supervisor failed to wait for events: " << std::strerror(errno));
+                std::this_thread::sleep_for(CHILD_POLL_PERIOD);
+            }
+
+            std::vector<uint64_t> touched;
+            for (int i = 0; i < ready; ++i)
+            {
+                uint64_t key = events[i].data.u64;
+                if (key == WAKE_UP)
+                {
+                    while (m_wakeUp.notified())
+                    {
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_stopping)
+                        {
+                            return;
+                        }
+                    }
+                    addPending();
+                    continue;
+                }
+                handleEvent(key);
+                touched.push_back(key >> 2);
+            }
+
+            // Children without a pidfd, and children whose output outlives them, aren't woken for by epoll
+            auto now = std::chrono::steady_clock::now();
+            for (auto& [id, supervised] : m_supervised)
+            {
+                if (!supervised.exited && supervised.pidFd < 0)
+                {
+                    reap(supervised);
+                }
+                if (supervised.exited)
+                {
+                    touched.push_back(id);
+                }
+                if (supervised.exited && supervised.drainDeadline != std::chrono::steady_clock::time_point{} &&
+                    now >= supervised.drainDeadline)
+                {
+                    LOGDEBUG("Closing output of process " << supervised.pid << " which is still held open after exit");
+                    closeStream(supervised, Stream::STDOUT);
+                    closeStream(supervised, Stream::STDERR);
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+            touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+            for (auto id : touched)
+            {
+                checkFinished(id);
+            }
+        }
+    }
+
+    void ProcessSupervisor::addPending()
+    {
+        std::vector<Supervised> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pending.swap(m_pending);
+        }
+
+        for (auto& supervised : pending)
+        {
+            uint64_t id = m_nextId++;
+            try
+            {
+                if (supervised.pidFd >= 0)
+                {
+                    addToEpoll(m_epollFd, supervised.pidFd, makeKey(id, PIDFD));
+                }
+                addToEpoll(m_epollFd, supervised.fds[0], makeKey(id, STDOUT_PIPE));
+                addToEpoll(m_epollFd, supervised.fds[1], makeKey(id, STDERR_PIPE));
+            }
+            catch (const std::system_error& ex)
+            {
+                // The child is still polled for, it just loses its output
+                LOGERROR(ex.what() << ": " << supervised.pid);
+                if (supervised.pidFd >= 0)
+                {
+                    ::close(supervised.pidFd);
+                    supervised.pidFd = -1;
+                }
+                closeStream(supervised, Stream::STDOUT);
+                closeStream(supervised, Stream::STDERR);
+            }
+            m_supervised.emplace(id, std::move(supervised));
+        }
+    }
+
+    void ProcessSupervisor::handleEvent(uint64_t key)
+    {
+        auto found = m_supervised.find(key >> 2);
+        if (found == m_supervised.end())
+        {
+            return;
+        }
+        switch (key & 3)
+        {
+            case PIDFD:
+                reap(found->second);
+                break;
+            case STDOUT_PIPE:
+                readOutput(found->second, Stream::STDOUT);
+                break;
+            case STDERR_PIPE:
+                readOutput(found->second, Stream::STDERR);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void ProcessSupervisor::readOutput(Supervised& supervised, Stream stream)
+    {
+        int& fd = supervised.fds[stream == Stream::STDOUT ? 0 : 1];
+        for (int reads = 0; fd >= 0 && reads < MAX_READS_PER_EVENT; ++reads)
+        {
+            size_t wanted = std::min(m_buffer.size(), std::max<size_t>(supervised.child->readSize(stream), 1));
+            ssize_t bytes = ::read(fd, m_buffer.data(), wanted);
+            if (bytes > 0)
+            {
+                try
+                {
+                    supervised.child->onOutput(stream, m_buffer.data(), bytes);
+                }
+                catch (const std::exception& ex)
+                {
+                    LOGWARN("Exception handling output of process " << supervised.pid << ": " << ex.what());
+                }
+                continue;
+            }
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return;
+            }
+            if (bytes < 0)
+            {
+                LOGWARN("Failed to read output of process " << supervised.pid << ": " << std::strerror(errno));
+            }
+            closeStream(supervised, stream);
+        }
+    }
+
+    void ProcessSupervisor::closeStream(Supervised& supervised, Stream stream)
+    {
+        int& fd = supervised.fds[stream == Stream::STDOUT ? 0 : 1];
+        if (fd >= 0)
+        {
+            // Closing also removes it from the epoll set
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    void ProcessSupervisor::reap(Supervised& supervised)
+    {
+        if (supervised.exited)
+        {
+            return;
+        }
+        int status = 0;
+        pid_t reaped;
+        {
+            std::lock_guard<std::mutex> lock(supervised.child->reapMutex());
+            do
+            {
+                reaped = ::waitpid(supervised.pid, &status, WNOHANG);
+            } while (reaped < 0 && errno == EINTR);
+            if (reaped == 0)
+            {
+                return;
+            }
+            supervised.child->onReaped();
+        }
+        if (reaped < 0)
+        {
+            LOGWARN("Failed to get exit status of process " << supervised.pid << ": " << std::strerror(errno));
+            status = -1;
+        }
+
+        supervised.exited = true;
+        supervised.status = status;
+        if (supervised.pidFd >= 0)
+        {
+            ::close(supervised.pidFd);
+            supervised.pidFd = -1;
+        }
+
+        // Anything written before the exit is already in the pipes
+        readOutput(supervised, Stream::STDOUT);
+        readOutput(supervised, Stream::STDERR);
+        supervised.drainDeadline = std::chrono::steady_clock::now() + OUTPUT_DRAIN_TIMEOUT;
+    }
+
+    void ProcessSupervisor::checkFinished(uint64_t id)
+    {
+        auto found = m_supervised.find(id);
+        if (found == m_supervised.end())
+        {
+            return;
+        }
+        auto& supervised = found->second;
+        if (!supervised.exited || supervised.fds[0] >= 0 || supervised.fds[1] >= 0)
+        {
+            return;
+        }
+
+        auto child = std::move(supervised.child);
+        int status = supervised.status;
+        m_supervised.erase(found);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_count;
+        }
+
+        try
+        {
+            child->onExit(status);
+        }
+        catch (const std::exception& ex)
+        {
+            LOGWARN("Exception handling exit of process: " << ex.what());
+        }
+    }
+
+    int ProcessSupervisor::pollTimeoutMilliseconds() const
+    {
+        auto timeout = std::chrono::milliseconds::max();
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& [id, supervised] : m_supervised)
+        {
+            if (!supervised.exited && supervised.pidFd < 0)
+            {
+                timeout = std::min(timeout, std::chrono::milliseconds(CHILD_POLL_PERIOD));
+            }
+            else if (supervised.exited)
+            {
+                auto untilDeadline = std::chrono::ceil<std::chrono::milliseconds>(supervised.drainDeadline - now);
+                timeout = std::min(timeout, std::max(untilDeadline, std::chrono::milliseconds(0)));
+            }
+        }
+        return timeout == std::chrono::milliseconds::max() ? -1
+                                                            : static_cast<int>(std::min<long>(timeout.count(), INT_MAX));
+    }
+} // namespace Common::ProcessImpl
@@ -0,0 +1,124 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "Common/Threads/NotifyPipe.h"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common::ProcessImpl
+{
+    /**
+     * Watches every child process started by this process from one thread.
+     *
+     * Exits are noticed through a pidfd for each child, so they are seen as soon as they happen. On kernels without
+     * pidfd_open, children are instead checked with waitpid every CHILD_POLL_PERIOD. The read ends of each child's
+     * stdout and stderr pipes are read on the same thread into one shared buffer.
+     */
+    class ProcessSupervisor
+    {
+    public:
+        enum class Stream
+        {
+            STDOUT,
+            STDERR
+        };
+
+        /**
+         * Receives what happens to a child. All calls are made on the supervisor thread, so they must not block or
+         * wait for other supervised children.
+         */
+        class IChild
+        {
+        public:
+            virtual ~IChild() = default;
+
+            /**
+             * The most bytes to read from the stream next, so output limits are kept without splitting reads.
+             */
+            virtual size_t readSize(Stream stream) = 0;
+
+            virtual void onOutput(Stream stream, const char* data, size_t size) = 0;
+
+            /**
+             * Held while the child is reaped. Anything signalling the child holds it too, and checks for onReaped,
+             * so a signal can't reach another process that has reused the pid.
+             */
+            virtual std::mutex& reapMutex() = 0;
+
+            /**
+             * Called with reapMutex held as soon as the child has been reaped, before its remaining output is read.
+             */
+            virtual void onReaped() = 0;
+
+            /**
+             * Called once, after the child has been reaped and both pipes are closed.
+             * @param status from waitpid, or -1 if the child had already been reaped by something else
+             */
+            virtual void onExit(int status) = 0;
+        };
+
+        static constexpr std::chrono::milliseconds CHILD_POLL_PERIOD{ 50 };
+        // How long output is still read after a child exits, in case its own children keep the pipes open
+        static constexpr std::chrono::seconds OUTPUT_DRAIN_TIMEOUT{ 10 };
+
+        static ProcessSupervisor& instance();
+
+        ProcessSupervisor();
+        ~ProcessSupervisor();
+        ProcessSupervisor(const ProcessSupervisor&) = delete;
+        ProcessSupervisor& operator=(const ProcessSupervisor&) = delete;
+
+        /**
+         * Takes ownership of the read ends of the child's pipes. The child must not have been reaped yet.
+         */
+        void supervise(pid_t pid, int stdoutFd, int stderrFd, std::shared_ptr<IChild> child);
+
+        size_t supervisedCount() const;
+
+    private:
+        struct Supervised
+        {
+            pid_t pid = -1;
+            int pidFd = -1;
+            int fds[2] = { -1, -1 };
+            std::shared_ptr<IChild> child;
+            bool exited = false;
+            int status = -1;
+            std::chrono::steady_clock::time_point drainDeadline;
+        };
+
+        void run();
+        void addPending();
+        void handleEvent(uint64_t key);
+        void readOutput(Supervised& supervised, Stream stream);
+        void closeStream(Supervised& supervised, Stream stream);
+        void reap(Supervised& supervised);
+        void checkFinished(uint64_t id);
+        int pollTimeoutMilliseconds() const;
+
+        const int m_epollFd;
+        Common::Threads::NotifyPipe m_wakeUp;
+        std::vector<char> m_buffer;
+
+        mutable std::mutex m_mutex;
+        std::vector<Supervised> m_pending;
+        size_t m_count = 0;
+        bool m_stopping = false;
+
+        // Only used on the supervisor thread
+        uint64_t m_nextId = 1;
+        std::map<uint64_t, Supervised> m_supervised;
+
+        // Last so everything it uses exists before it starts
+        std::thread m_thread;
+    };
+} // namespace Common::ProcessImpl
@@ -0,0 +1,562 @@
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
+
+#include "SupervisedProcessHolder.h"
+
+#include "Logger.h"
+
+#include "Common/FileSystem/IFilePermissions.h"
+#include "Common/Process/IProcessException.h"
+
+#include <fcntl.h>
+#include <grp.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <system_error>
+#include <unistd.h>
+
+namespace
+{
+    std::vector<int> getFileDescriptorsToCloseAfterFork(const std::vector<int>& preserve)
+    {
+        std::vector<int> fds;
+        struct stat buf;
+#ifdef OPEN_MAX
+        for (int fd = 3; fd < OPEN_MAX; fd++)
+#else
+        for (int fd = 3; fd < 256; ++fd)
+#endif
+        {
+            if (::fstat(fd, &buf) != -1)
+            {
+                if (std::find(preserve.begin(), preserve.end(), fd) == preserve.end())
+                {
+                    fds.push_back(fd);
+                }
+            }
+        }
+        return fds;
+    }
+
+    class Pipe
+    {
+    public:
+        Pipe()
+        {
+            int fds[2];
+            if (::pipe2(fds, O_CLOEXEC) != 0)
+            {
+                throw std::system_error(errno, std::system_category(), "Failed to create pipe");
+            }
+            m_read = fds[0];
+            m_write = fds[1];
+        }
+
+        ~Pipe()
+        {
+            closeRead();
+            closeWrite();
+        }
+
+        Pipe(const Pipe&) = delete;
+        Pipe& operator=(const Pipe&) = delete;
+
+        int readFd() const { return m_read; }
+        int writeFd() const { return m_write; }
+
+        int releaseRead()
+        {
+            int fd = m_read;
+            m_read = -1;
+            return fd;
+        }
+
+        void closeRead()
+        {
+            if (m_read >= 0)
+            {
+                ::close(m_read);
+                m_read = -1;
+            }
+        }
+
+        void closeWrite()
+        {
+            if (m_write >= 0)
+            {
+                ::close(m_write);
+                m_write = -1;
+            }
+        }
+
+    private:
+        int m_read = -1;
+        int m_write = -1;
+    };
+
+    /**
+     * Strings for argv or envp, built before fork so the child doesn't need to allocate.
+     */
+    class CStringArray
+    {
+    public:
+        explicit CStringArray(std::vector<std::string> strings) : m_strings(std::move(strings))
+        {
+            for (auto& string : m_strings)
+            {
+                m_pointers.push_back(string.data());
+            }
+            m_pointers.push_back(nullptr);
+        }
+
+        char* const* get() const { return m_pointers.data(); }
+
+    private:
+        std::vector<std::string> m_strings;
+        std::vector<char*> m_pointers;
+    };
+
+    CStringArray buildEnvironment(const std::vector<Common::Process::EnvironmentPair>& extraEnvironment)
+    {
+        std::map<std::string, std::string> environment;
+        for (char** entry = ::environ; entry != nullptr && *entry != nullptr; ++entry)
+        {
+            std::string variable = *entry;
+            auto equals = variable.find('=');
+            if (equals != std::string::npos)
+            {
+                environment[variable.substr(0, equals)] = variable.substr(equals + 1);
+            }
+        }
+        for (const auto& [name, value] : extraEnvironment)
+        {
+            if (name.empty())
+            {
+                throw Common::Process::IProcessException("Environment name cannot be empty: '' = " + value);
+            }
+            environment[name] = value;
+        }
+
+        std::vector<std::string> variables;
+        variables.reserve(environment.size());
+        for (const auto& [name, value] : environment)
+        {
+            variables.push_back(name + "=" + value);
+        }
+        return CStringArray(std::move(variables));
+    }
+
+    // Reported by the child through a pipe if it fails before exec replaces it
+    struct ChildSetupError
+    {
+        enum Stage
+        {
+            INITGROUPS,
+            SETGID,
+            SETUID,
+            EXEC
+        };
+        int error;
+        Stage stage;
+    };
+
+    void redirect(int fd, int target)
+    {
+        if (fd == target)
+        {
+            // dup2 would leave close-on-exec set
+            ::fcntl(fd, F_SETFD, 0);
+        }
+        else
+        {
+            ::dup2(fd, target);
+        }
+    }
+
+    int evalExitStatus(int status)
+    {
+        if (WIFEXITED(status))
+        {
+            return WEXITSTATUS(status);
+        }
+        if (WIFSIGNALED(status))
+        {
+            return WTERMSIG(status);
+        }
+        return status;
+    }
+} // namespace
+
+namespace Common::ProcessImpl
+{
+    SupervisedProcessHolder::Child::Child(
+        std::string path,
+        Process::IProcess::functor callback,
+        std::function<void(std::string)> notifyTrimmed,
+        size_t outputLimit,
+        bool flushOnNewLine) :
+        m_path(std::move(path)),
+        m_callback(std::move(callback)),
+        m_notifyTrimmed(std::move(notifyTrimmed)),
+        m_outputLimit(outputLimit),
+        m_flushOnNewLine(flushOnNewLine)
+    {
+    }
+
+    SupervisedProcessHolder::Child::Output& SupervisedProcessHolder::Child::output(ProcessSupervisor::Stream stream)
+    {
+        return stream == ProcessSupervisor::Stream::STDOUT ? m_stdout : m_stderr;
+    }
+
+    size_t SupervisedProcessHolder::Child::readSize(ProcessSupervisor::Stream stream)
+    {
+        if (m_outputLimit == 0)
+        {
+            return SIZE_MAX;
+        }
+        if (m_flushOnNewLine)
+        {
+            return m_outputLimit;
+        }
+        return m_outputLimit - output(stream).pending.size();
+    }
+
+    void SupervisedProcessHolder::Child::onOutput(ProcessSupervisor::Stream stream, const char* data, size_t size)
+    {
+        if (m_outputLimit != 0 && m_flushOnNewLine)
+        {
+            // Each read is passed on once the next arrives, or straight away if it finishes a line, so callers see
+            // lines without waiting for the buffer to fill. An unfinished last line is left for output().
+            auto& out = output(stream);
+            if (!out.pending.empty())
+            {
+                notifyTrimmed(out.pending);
+            }
+            out.pending.assign(data, size);
+            if (out.pending.find('\n') != std::string::npos)
+            {
+                notifyTrimmed(out.pending);
+                out.pending.clear();
+            }
+            return;
+        }
+
+        auto& out = output(stream);
+        out.pending.append(data, size);
+        if (m_outputLimit == 0 || out.pending.size() < m_outputLimit)
+        {
+            return;
+        }
+
+        // Only the last two chunks are kept, anything older is handed to the trimmed output callback
+        if (!out.completed.empty())
+        {
+            LOGDEBUG("Notify trimmed output");
+            notifyTrimmed(out.completed);
+        }
+        out.completed = std::move(out.pending);
+        out.pending.clear();
+    }
+
+    void SupervisedProcessHolder::Child::notifyTrimmed(const std::string& output)
+    {
+        try
+        {
+            m_notifyTrimmed(output);
+        }
+        catch (std::exception& ex)
+        {
+            LOGWARN("Exception on notify output trimmed: " << ex.what());
+        }
+    }
+
+    std::mutex& SupervisedProcessHolder::Child::reapMutex()
+    {
+        return m_reapMutex;
+    }
+
+    void SupervisedProcessHolder::Child::onReaped()
+    {
+        m_reaped = true;
+    }
+
+    bool SupervisedProcessHolder::Child::signal(pid_t pid, int signal)
+    {
+        std::lock_guard<std::mutex> lock{ m_reapMutex };
+        // Once reaped the pid may belong to something else
+        if (m_reaped)
+        {
+            return false;
+        }
+        return ::kill(pid, signal) == 0;
+    }
+
+    void SupervisedProcessHolder::Child::onExit(int status)
+    {
+        LOGDEBUG(m_path << " Process finished with status " << status);
+        {
+            std::lock_guard<std::mutex> lock{ m_finishedMutex };
+            m_result.output = m_stdout.completed + m_stdout.pending;
+            m_result.errorlog = m_stderr.completed + m_stderr.pending;
+            m_result.nativeExitCode = status; // Separate signal and exit code
+            m_result.exitCode = evalExitStatus(status); // Signal overloaded with exit code
+        }
+
+        // Must return before the child is finished, as the callback's owner may be destroyed as soon as it is
+        try
+        {
+            m_callback();
+        }
+        catch (std::exception& ex)
+        {
+            LOGWARN("Exception on reporting process finished: " << ex.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ m_finishedMutex };
+            m_finished = true;
+        }
+        m_finishedCondition.notify_all();
+    }
+
+    void SupervisedProcessHolder::Child::waitUntilFinished()
+    {
+        std::unique_lock<std::mutex> lock{ m_finishedMutex };
+        m_finishedCondition.wait(lock, [this]() { return m_finished.load(); });
+    }
+
+    bool SupervisedProcessHolder::Child::waitUntilFinished(std::chrono::milliseconds timeToWait)
+    {
+        std::unique_lock<std::mutex> lock{ m_finishedMutex };
+        return m_finishedCondition.wait_for(lock, timeToWait, [this]() { return m_finished.load(); });
+    }
+
+    SupervisedProcessHolder::SupervisedProcessHolder(
+        const std::string& path,
+        const std::vector<std::string>& arguments,
+        const std::vector<Process::EnvironmentPair>& extraEnvironment,
+        uid_t uid,
+        gid_t gid,
+        Process::IProcess::functor callback,
+        std::function<void(std::string)> notifyTrimmed,
+        size_t outputLimit,
+        bool flushOnNewLine) :
+        m_child(std::make_shared<Child>(path, std::move(callback), std::move(notifyTrimmed), outputLimit, flushOnNewLine))
+    {
+        std::vector<std::string> argv{ path };
+        argv.insert(argv.end(), arguments.begin(), arguments.end());
+        CStringArray childArguments(std::move(argv));
+        CStringArray childEnvironment = buildEnvironment(extraEnvironment);
+        std::string username = Common::FileSystem::filePermissions()->getUserName(uid);
+        // Must set groups whilst still root
+        bool setGroups = ::getuid() == 0 && uid != 0;
+
+        Pipe out;
+        Pipe err;
+        Pipe setupErrors;
+        std::vector<int> fds = getFileDescriptorsToCloseAfterFork({ setupErrors.writeFd() });
+
+        {
+            // fork must be serialized, so no other thread's pipes are open while it happens
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock{ mutex };
+            m_pid = ::fork();
+        }
+        if (m_pid < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "Failed to fork");
+        }
+
+        if (m_pid == 0)
+        {
+            auto fail = [&setupErrors](ChildSetupError::Stage stage)
+            {
+                ChildSetupError setupError{ errno, stage };
+                [[maybe_unused]] auto written = ::write(setupErrors.writeFd(), &setupError, sizeof(setupError));
+                ::_exit(EXIT_FAILURE);
+            };
+
+            redirect(out.writeFd(), STDOUT_FILENO);
+            redirect(err.writeFd(), STDERR_FILENO);
+            if (setGroups && ::initgroups(username.c_str(), gid) != 0)
+            {
+                fail(ChildSetupError::INITGROUPS);
+            }
+            if (::setgid(gid) != 0)
+            {
+                fail(ChildSetupError::SETGID);
+            }
+            if (::setuid(uid) != 0)
+            {
+                fail(ChildSetupError::SETUID);
+            }
+            for (auto fd : fds)
+            {
+                ::close(fd);
+            }
+            ::execve(path.c_str(), childArguments.get(), childEnvironment.get());
+            fail(ChildSetupError::EXEC);
+        }
+
+        out.closeWrite();
+        err.closeWrite();
+        setupErrors.closeWrite();
+        ChildSetupError setupError{};
+        ssize_t bytes;
+        do
+        {
+            bytes = ::read(setupErrors.readFd(), &setupError, sizeof(setupError));
+        } while (bytes < 0 && errno == EINTR);
+        if (bytes == sizeof(setupError))
+        {
+            ::waitpid(m_pid, nullptr, 0);
+            switch (setupError.stage)
+            {
+                case ChildSetupError::INITGROUPS:
+                    throw std::system_error(
+                        setupError.error,
+                        std::system_category(),
+                        "initgroups failed for: " + username + " with errno " + std::to_string(setupError.error));
+                case ChildSetupError::SETGID:
+                    throw std::system_error(setupError.error, std::system_category(), "Failed to set group ids");
+                case ChildSetupError::SETUID:
+                    throw std::system_error(setupError.error, std::system_category(), "Failed to set user id");
+                case ChildSetupError::EXEC:
+                    throw std::system_error(setupError.error, std::system_category(), "execve failed");
+            }
+        }
+        LOGDEBUG("Child created");
+
+        ::fcntl(out.readFd(), F_SETFL, O_NONBLOCK);
+        ::fcntl(err.readFd(), F_SETFL, O_NONBLOCK);
+        try
+        {
+            ProcessSupervisor::instance().supervise(m_pid, out.releaseRead(), err.releaseRead(), m_child);
+        }
+        catch (const std::system_error&)
+        {
+            ::kill(m_pid, SIGKILL);
+            ::waitpid(m_pid, nullptr, 0);
+            throw;
+        }
+        LOGDEBUG("Process Running " << m_pid);
+    }
+
+    SupervisedProcessHolder::~SupervisedProcessHolder()
+    {
+        try
+        {
+            signal(SIGKILL);
+            m_child->waitUntilFinished();
+        }
+        catch (std::exception& ex)
+        {
+            LOGWARN("Exception in the destructor of process impl: " << ex.what());
+        }
+    }
+
+    int SupervisedProcessHolder::pid()
+    {
+        return m_pid;
+    }
+
+    void SupervisedProcessHolder::wait()
+    {
+        m_child->waitUntilFinished();
+    }
+
+    Process::ProcessStatus SupervisedProcessHolder::wait(std::chrono::milliseconds timeToWait)
+    {
+        return m_child->waitUntilFinished(timeToWait) ? Process::ProcessStatus::FINISHED
+                                                      : Process::ProcessStatus::TIMEOUT;
+    }
+
+    int SupervisedProcessHolder::exitCode()
+    {
+        wait();
+        return m_child->result().exitCode;
+    }
+
+    int SupervisedProcessHolder::nativeExitCode()
+    {
+        wait();
+        return m_child->result().nativeExitCode;
+    }
+
+    std::string SupervisedProcessHolder::output()
+    {
+        wait();
+        const auto& result = m_child->result();
+        if (!result.output.empty() && !result.errorlog.empty())
+        {
+            return result.output + "\n" + result.errorlog;
+        }
+        return result.output.empty() ? result.errorlog : result.output;
+    }
+
+    std::string SupervisedProcessHolder::stderroutput()
+    {
+        wait();
+        return m_child->result().errorlog;
+    }
+
+    std::string SupervisedProcessHolder::stdoutput()
+    {
+        wait();
+        return m_child->result().output;
+    }
+
+    bool SupervisedProcessHolder::hasFinished()
+    {
+        return m_child->finished();
+    }
+
+    void SupervisedProcessHolder::sendTerminateSignal()
+    {
+        if (hasFinished())
+        {
+            return;
+        }
+        LOGDEBUG("Terminating process " << m_pid);
+        signal(SIGTERM);
+    }
+
+    void SupervisedProcessHolder::sendAbortSignal()
+    {
+        if (hasFinished())
+        {
+            return;
+        }
+        LOGINFO("Killing process with abort signal " << m_pid);
+        signal(SIGABRT);
+    }
+
+    void SupervisedProcessHolder::sendUsr1Signal()
+    {
+        if (hasFinished())
+        {
+            return;
+        }
+        LOGINFO("Sending SIGUSR1 signal to process " << m_pid);
+        signal(SIGUSR1);
+    }
+
+    void SupervisedProcessHolder::kill()
+    {
+        if (hasFinished())
+        {
+            return;
+        }
+        LOGINFO("Killing process " << m_pid);
+        signal(SIGKILL);
+        wait();
+    }
+
+    void SupervisedProcessHolder::signal(int signal)
+    {
+        m_child->signal(m_pid, signal);
+    }
+} // namespace Common::ProcessImpl
@@ -0,0 +1,126 @@
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "IProcessHolder.h"
+#include "ProcessSupervisor.h"
+
+#include <condition_variable>
+
+namespace Common::ProcessImpl
+{
+    struct ProcessResult
+    {
+        int exitCode;
+        std::string output;
+        std::string errorlog;
+        std::string combinedoutput;
+        int nativeExitCode = 0;
+    };
+
+    /**
+     * A child process started with fork and exec, and watched by the ProcessSupervisor rather than by threads of its
+     * own.
+     */
+    class SupervisedProcessHolder : public IProcessHolder
+    {
+    public:
+        SupervisedProcessHolder(
+            const std::string& path,
+            const std::vector<std::string>& arguments,
+            const std::vector<Process::EnvironmentPair>& extraEnvironment,
+            uid_t uid,
+            gid_t gid,
+            Process::IProcess::functor callback,
+            std::function<void(std::string)> notifyTrimmed,
+            size_t outputLimit,
+            bool flushOnNewLine);
+        ~SupervisedProcessHolder() override;
+        int pid() override;
+
+        void wait() override;
+
+        Process::ProcessStatus wait(std::chrono::milliseconds timeToWait) override;
+
+        int exitCode() override;
+        int nativeExitCode() override;
+
+        std::string output() override;
+        std::string stderroutput() override;
+        std::string stdoutput() override;
+
+        bool hasFinished() override;
+
+        void sendTerminateSignal() override;
+
+        void sendAbortSignal() override;
+
+        void sendUsr1Signal() override;
+
+        void kill() override;
+
+    private:
+        /**
+         * Collects the child's output on the supervisor thread, and holds its result once it has exited.
+         */
+        class Child : public ProcessSupervisor::IChild
+        {
+        public:
+            Child(
+                std::string path,
+                Process::IProcess::functor callback,
+                std::function<void(std::string)> notifyTrimmed,
+                size_t outputLimit,
+                bool flushOnNewLine);
+
+            size_t readSize(ProcessSupervisor::Stream stream) override;
+            void onOutput(ProcessSupervisor::Stream stream, const char* data, size_t size) override;
+            std::mutex& reapMutex() override;
+            void onReaped() override;
+            void onExit(int status) override;
+
+            /**
+             * Sends the signal unless the child has been reaped, so it can't reach a process that reused the pid.
+             */
+            bool signal(pid_t pid, int signal);
+
+            void waitUntilFinished();
+            bool waitUntilFinished(std::chrono::milliseconds timeToWait);
+            bool finished() const { return m_finished; }
+            // Only valid once finished
+            const ProcessResult& result() const { return m_result; }
+
+        private:
+            struct Output
+            {
+                // The last whole chunk of outputLimit bytes, kept until the next one replaces it
+                std::string completed;
+                std::string pending;
+            };
+
+            Output& output(ProcessSupervisor::Stream stream);
+            void notifyTrimmed(const std::string& output);
+
+            const std::string m_path;
+            Process::IProcess::functor m_callback;
+            std::function<void(std::string)> m_notifyTrimmed;
+            const size_t m_outputLimit;
+            const bool m_flushOnNewLine;
+            Output m_stdout;
+            Output m_stderr;
+
+            std::mutex m_reapMutex;
+            bool m_reaped = false;
+
+            std::mutex m_finishedMutex;
+            std::condition_variable m_finishedCondition;
+            std::atomic<bool> m_finished = false;
+            ProcessResult m_result{};
+        };
+
+        void signal(int signal);
+
+        std::shared_ptr<Child> m_child;
+        pid_t m_pid = -1;
+    };
+} // namespace Common::ProcessImpl
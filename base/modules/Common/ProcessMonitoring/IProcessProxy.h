@@ -1,12 +1,13 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "Common/Process/IProcess.h"
 #include "Common/Process/IProcessInfo.h"
-#include "Common/Threads/NotifyPipe.h"
 
 #include <chrono>
+#include <functional>
+#include <memory>
 
 namespace Common::ProcessMonitoring
 {
@@ -45,13 +46,12 @@ namespace Common::ProcessMonitoring
         [[nodiscard]] virtual std::string name() const = 0;
         virtual void setCoreDumpMode(bool mode) = 0;
 
-        using NotifyPipeSharedPtr = std::shared_ptr<Common::Threads::NotifyPipe>;
         /**
-         * Set the pipe that should be notified when the process terminates.
-         * (When BoostProcessHolder callback to us)
-         * @param pipe
+         * Set the function to call when the process terminates.
+         * (When SupervisedProcessHolder calls back to us, so it is called on the process supervisor thread)
+         * @param callback
          */
-        virtual void setTerminationCallbackNotifyPipe(NotifyPipeSharedPtr pipe) = 0;
+        virtual void setTerminationCallback(std::function<void()> callback) = 0;
     };
     using IProcessProxyPtr = std::unique_ptr<IProcessProxy>;
     extern IProcessProxyPtr createProcessProxy(Common::Process::IProcessInfoPtr processInfoPtr);
@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "ProcessMonitor.h"
 
@@ -11,16 +11,23 @@
 #include "Common/ZeroMQWrapper/IPoller.h"
 #include "Common/ZeroMQWrapper/ISocketReplier.h"
 
+#include <algorithm>
 #include <cassert>
 #include <thread>
 
+namespace
+{
+    // Even when nothing is due, wake up occasionally in case a check was missed
+    constexpr std::chrono::hours MAXIMUM_WAIT{ 1 };
+} // namespace
+
 namespace Common::ProcessMonitoringImpl
 {
     ProcessMonitor::ProcessMonitor() : ProcessMonitor(Common::ZMQWrapperApi::createContext()) {}
 
     ProcessMonitor::ProcessMonitor(Common::ZMQWrapperApi::IContextSharedPtr context) : m_context(std::move(context))
     {
-        m_processTerminationCallbackPipe = std::make_shared<Common::Threads::NotifyPipe>();
+        m_exitedProxies = std::make_shared<ExitedProxies>();
     }
 
     ProcessMonitor::~ProcessMonitor()
@@ -40,9 +47,10 @@ namespace Common::ProcessMonitoringImpl
                 return 1;
             }
 
+            auto now = Clock::now();
             for (auto& proxy : m_processProxies)
             {
-                proxy->ensureStateMatchesOptions();
+                locked_checkProxy(*proxy, now);
             }
         }
 
@@ -55,22 +63,22 @@ namespace Common::ProcessMonitoringImpl
         Common::ZeroMQWrapper::IHasFDPtr terminationFD = poller->addEntry(
             signalHandler.terminationFileDescriptor(), Common::ZeroMQWrapper::IPoller::PollDirection::POLLIN);
         Common::ZeroMQWrapper::IHasFDPtr callbackFD = poller->addEntry(
-            m_processTerminationCallbackPipe->readFd(), Common::ZeroMQWrapper::IPoller::PollDirection::POLLIN);
+            m_exitedProxies->pipe.readFd(), Common::ZeroMQWrapper::IPoller::PollDirection::POLLIN);
 
         for (auto& socketHandleFunction : m_socketHandleFunctionList)
         {
             poller->addEntry(*socketHandleFunction.first, Common::ZeroMQWrapper::IPoller::PollDirection::POLLIN);
         }
 
-        std::chrono::seconds timeout(10);
-
         Common::UtilityImpl::FormattedTime time;
         while (keepRunning)
         {
-            LOGDEBUG("Calling poller at " << time.currentTime());
-            Common::ZeroMQWrapper::IPoller::poll_result_t active = poller->poll(std::chrono::milliseconds(timeout));
+            auto timeout = timeUntilNextCheck();
+            LOGDEBUG("Calling poller at " << time.currentTime() << " with timeout " << timeout.count() << "ms");
+            Common::ZeroMQWrapper::IPoller::poll_result_t active = poller->poll(timeout);
             LOGDEBUG("Returned from poller: " << active.size() << " at " << ::time(nullptr));
 
+            bool socketRequestHandled = false;
             for (auto& fd : active)
             {
                 if (fd == terminationFD.get())
@@ -88,12 +96,13 @@ namespace Common::ProcessMonitoringImpl
                 if (fd == callbackFD.get())
                 {
                     // Wake up to collect terminations, and restart processes
-                    while (m_processTerminationCallbackPipe->notified()) {}
+                    while (m_exitedProxies->pipe.notified()) {}
                 }
                 for (auto& socketHandleFunction : m_socketHandleFunctionList)
                 {
                     if (fd == socketHandleFunction.first)
                     {
+                        socketRequestHandled = true;
                         try
                         {
                             socketHandleFunction.second();
@@ -111,19 +120,45 @@ namespace Common::ProcessMonitoringImpl
                 }
             }
 
-            // Child may have exited, or socket request may have altered state.
-            timeout = std::chrono::hours(1); // Want a maximum of 1 hour wait
+            std::set<Common::ProcessMonitoring::IProcessProxy*> exited;
+            {
+                std::lock_guard<std::mutex> lock(m_exitedProxies->mutex);
+                exited.swap(m_exitedProxies->proxies);
+            }
+
+            std::lock_guard<std::mutex> lock(m_processProxiesMutex);
+            auto now = Clock::now();
+            if (socketRequestHandled)
             {
-                std::lock_guard<std::mutex> lock(m_processProxiesMutex);
+                // The request may have enabled, disabled, added or removed any of the processes
                 for (auto& proxy : m_processProxies)
                 {
-                    auto waitPeriod = proxy->checkForExit().first;
-                    waitPeriod = std::min(proxy->ensureStateMatchesOptions(), waitPeriod);
-                    timeout = std::min(waitPeriod, timeout);
+                    locked_checkProxy(*proxy, now);
                 }
+                continue;
+            }
+
+            std::vector<Common::ProcessMonitoring::IProcessProxy*> due;
+            for (auto* proxy : exited)
+            {
+                // Skip processes removed since they exited
+                if (m_proxyDeadlines.count(proxy) != 0)
+                {
+                    due.push_back(proxy);
+                }
+            }
+            for (auto deadline = m_deadlines.begin(); deadline != m_deadlines.end() && deadline->first <= now;
+                 ++deadline)
+            {
+                if (exited.count(deadline->second) == 0)
+                {
+                    due.push_back(deadline->second);
+                }
+            }
+            for (auto* proxy : due)
+            {
+                locked_checkProxy(*proxy, now);
             }
-            timeout = std::max(timeout, std::chrono::seconds(10)); // Ensure we wait at least 10 seconds
-            LOGDEBUG("timeout = " << timeout.count());
         }
 
         LOGINFO("Stopping processes");
@@ -137,6 +172,40 @@ namespace Common::ProcessMonitoringImpl
         return 0;
     }
 
+    void ProcessMonitor::locked_checkProxy(Common::ProcessMonitoring::IProcessProxy& proxy, Clock::time_point now)
+    {
+        auto waitPeriod = proxy.checkForExit().first;
+        waitPeriod = std::min(proxy.ensureStateMatchesOptions(), waitPeriod);
+        // A zero wait would have us spin on a process that isn't ready yet
+        waitPeriod = std::max(waitPeriod, std::chrono::seconds(1));
+
+        locked_unschedule(&proxy);
+        auto deadline = now + waitPeriod;
+        m_deadlines.emplace(deadline, &proxy);
+        m_proxyDeadlines.emplace(&proxy, deadline);
+    }
+
+    void ProcessMonitor::locked_unschedule(Common::ProcessMonitoring::IProcessProxy* proxy)
+    {
+        auto scheduled = m_proxyDeadlines.find(proxy);
+        if (scheduled != m_proxyDeadlines.end())
+        {
+            m_deadlines.erase({ scheduled->second, proxy });
+            m_proxyDeadlines.erase(scheduled);
+        }
+    }
+
+    std::chrono::milliseconds ProcessMonitor::timeUntilNextCheck()
+    {
+        std::lock_guard<std::mutex> lock(m_processProxiesMutex);
+        if (m_deadlines.empty())
+        {
+            return MAXIMUM_WAIT;
+        }
+        auto untilNext = std::chrono::ceil<std::chrono::milliseconds>(m_deadlines.begin()->first - Clock::now());
+        return std::clamp<std::chrono::milliseconds>(untilNext, std::chrono::milliseconds(0), MAXIMUM_WAIT);
+    }
+
     void ProcessMonitor::stopProcesses()
     {
         std::vector<std::thread> shutdownThreads;
@@ -158,7 +227,16 @@ namespace Common::ProcessMonitoringImpl
 
     void ProcessMonitor::addProcessToMonitor(Common::ProcessMonitoring::IProcessProxyPtr processProxyPtr)
     {
-        processProxyPtr->setTerminationCallbackNotifyPipe(m_processTerminationCallbackPipe);
+        // Holds the shared state rather than this, and the proxy is only looked at again if it is still scheduled
+        processProxyPtr->setTerminationCallback(
+            [exitedProxies = m_exitedProxies, proxy = processProxyPtr.get()]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(exitedProxies->mutex);
+                    exitedProxies->proxies.insert(proxy);
+                }
+                exitedProxies->pipe.notify();
+            });
 
         std::lock_guard<std::mutex> lock(m_processProxiesMutex);
         m_processProxies.push_back(std::move(processProxyPtr));
@@ -206,6 +284,7 @@ namespace Common::ProcessMonitoringImpl
             {
                 pluginProxy->stop();
                 it = m_processProxies.erase(it);
+                locked_unschedule(pluginProxy);
                 found = true;
             }
             else
@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -11,8 +11,11 @@
 #include "Common/ZeroMQWrapper/ISocketReplier.h"
 #include "Common/ZeroMQWrapper/ISocketReplierPtr.h"
 
+#include <chrono>
 #include <list>
+#include <map>
 #include <mutex>
+#include <set>
 
 namespace Common::ProcessMonitoringImpl
 {
@@ -36,10 +39,38 @@ namespace Common::ProcessMonitoringImpl
         void stopProcesses();
 
     private:
+        using Clock = std::chrono::steady_clock;
+        using Deadline = std::pair<Clock::time_point, Common::ProcessMonitoring::IProcessProxy*>;
+
+        /**
+         * Proxies whose process has exited since the main loop last looked. Shared with the termination callbacks,
+         * which are called on the process supervisor thread.
+         */
+        struct ExitedProxies
+        {
+            std::mutex mutex;
+            std::set<Common::ProcessMonitoring::IProcessProxy*> proxies;
+            Common::Threads::NotifyPipe pipe;
+        };
+
+        /**
+         * Checks for exit, brings the process in line with its options, and schedules when to check it next
+         */
+        void locked_checkProxy(Common::ProcessMonitoring::IProcessProxy& proxy, Clock::time_point now);
+        void locked_unschedule(Common::ProcessMonitoring::IProcessProxy* proxy);
+        std::chrono::milliseconds timeUntilNextCheck();
+
         std::mutex m_processProxiesMutex;
         ProxyList m_processProxies;
         SocketHandleFunctionList m_socketHandleFunctionList;
-        Common::ProcessMonitoring::IProcessProxy::NotifyPipeSharedPtr m_processTerminationCallbackPipe;
+        std::shared_ptr<ExitedProxies> m_exitedProxies;
+
+        /**
+         * When each proxy next needs to be checked, ordered by time, and by proxy so it can be rescheduled.
+         * Guarded by m_processProxiesMutex.
+         */
+        std::set<Deadline> m_deadlines;
+        std::map<Common::ProcessMonitoring::IProcessProxy*, Clock::time_point> m_proxyDeadlines;
 
 
     protected:
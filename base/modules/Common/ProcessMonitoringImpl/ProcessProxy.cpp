@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "ProcessProxy.h"
 
@@ -21,6 +21,7 @@ namespace Common::ProcessMonitoringImpl
         m_running(false),
         m_process(Common::Process::createProcess()),
         m_deathTime(0),
+        m_exitTime(),
         m_killIssuedTime(0)
     {
     }
@@ -43,7 +44,7 @@ namespace Common::ProcessMonitoringImpl
             {
                 LOGDEBUG("Notify process finished callback called");
                 m_termination_callback_called.store(true);
-                notifyProcessTerminationCallbackPipe(); // Will definitely happen after the store
+                notifyTerminationCallback(); // Will definitely happen after the store
             });
     }
 
@@ -233,6 +234,8 @@ namespace Common::ProcessMonitoringImpl
 
             m_sharedState.m_running = false;
             m_sharedState.m_deathTime = ::time(nullptr);
+            m_sharedState.m_exitTime =
+                m_sharedState.m_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
         }
         else if (!m_sharedState.m_enabled)
         {
@@ -269,6 +272,11 @@ namespace Common::ProcessMonitoringImpl
         {
             start();
             increaseBackoff();
+            if (m_sharedState.m_running && m_sharedState.m_exitTime != std::chrono::steady_clock::time_point{})
+            {
+                onRestart(std::chrono::steady_clock::now() - m_sharedState.m_exitTime);
+                m_sharedState.m_exitTime = {};
+            }
             return currentBackoff;
         }
         else
@@ -314,6 +322,7 @@ namespace Common::ProcessMonitoringImpl
         std::lock_guard<std::mutex> lock(m_sharedState.m_mutex);
         m_sharedState.m_enabled = enabled;
         m_sharedState.m_deathTime = 0; // If enabled we want to start as soon as possible
+        m_sharedState.m_exitTime = {};
     }
 
     bool ProcessProxy::isRunning()
@@ -338,11 +347,11 @@ namespace Common::ProcessMonitoringImpl
         std::lock_guard<std::mutex> lock(m_sharedState.m_mutex);
         return m_sharedState.m_enabled;
     }
-    void ProcessProxy::notifyProcessTerminationCallbackPipe()
+    void ProcessProxy::notifyTerminationCallback()
     {
-        if (m_processTerminationCallbackPipe)
+        if (m_terminationCallback)
         {
-            m_processTerminationCallbackPipe->notify();
+            m_terminationCallback();
         }
     }
 
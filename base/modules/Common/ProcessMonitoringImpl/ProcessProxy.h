@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -62,15 +62,21 @@ namespace Common::ProcessMonitoringImpl
 
         [[nodiscard]] std::string name() const override;
 
-        void setTerminationCallbackNotifyPipe(NotifyPipeSharedPtr pipe) override
+        void setTerminationCallback(std::function<void()> callback) override
         {
-            m_processTerminationCallbackPipe = std::move(pipe);
+            m_terminationCallback = std::move(callback);
         }
 
     protected:
         bool runningFlag();
         bool enabledFlag();
 
+        /**
+         * Called when the process is started again after exiting while enabled
+         * @param sinceExit time from the exit being seen to the process being started again, including back off
+         */
+        virtual void onRestart([[maybe_unused]] std::chrono::steady_clock::duration sinceExit) {}
+
         /**
          * Information object for the process
          */
@@ -120,17 +126,22 @@ namespace Common::ProcessMonitoringImpl
              */
             time_t m_deathTime;
 
+            /**
+             * When the exit was seen, if the process exited while enabled and hasn't been started again since.
+             */
+            std::chrono::steady_clock::time_point m_exitTime;
+
             time_t m_killIssuedTime;
 
             int m_lastExit = 0;
         };
 
-        void notifyProcessTerminationCallbackPipe();
+        void notifyTerminationCallback();
 
         /**
-         * Pipe that we notify when the process is terminating, during the callback from BoostProcessHolder
+         * Called when the process is terminating, during the callback from SupervisedProcessHolder
          */
-        NotifyPipeSharedPtr m_processTerminationCallbackPipe;
+        std::function<void()> m_terminationCallback;
         /**
          * Boolean to indicate we have come through the callback.
          * So we should wait for a result.
@@ -1,4 +1,4 @@
-// Copyright 2018-2022, Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Digest.h"
 
@@ -11,99 +11,65 @@ namespace Common::SslImpl
 {
     namespace
     {
-        // RAII EVP_MD_CTX wrapper
-        class MdContext
+        const EVP_MD* getDigestByName(Digest digestName)
         {
-        public:
-            MdContext() : mdctx_(EVP_MD_CTX_new())
+            const char* digestNameString;
+            switch (digestName)
             {
-                if (mdctx_ == nullptr)
-                {
-                    throw std::runtime_error("EVP_MD_CTX_new failed");
-                }
+                case Digest::md5:
+                    digestNameString = "md5";
+                    break;
+                case Digest::sha256:
+                    digestNameString = "sha256";
+                    break;
+                case Digest::sha1:
+                    digestNameString = "sha1";
+                    break;
             }
 
-            ~MdContext()
+            // TODO: replace with EVP_MD_fetch for OpenSSL 3.0
+            const EVP_MD* md = EVP_get_digestbyname(digestNameString);
+            if (md == nullptr)
             {
-                EVP_MD_CTX_free(mdctx_); // Safe to call with nullptr
-                mdctx_ = nullptr;
+                throw std::runtime_error(std::string("Unknown message digest ") + digestNameString);
             }
-
-            MdContext(const MdContext&) = delete;
-            MdContext& operator=(const MdContext& other) = delete;
-            MdContext(MdContext&& other) noexcept
-            {
-                mdctx_ = other.mdctx_;
-                other.mdctx_ = nullptr;
-            }
-            MdContext& operator=(MdContext&& other) noexcept
-            {
-                mdctx_ = other.mdctx_;
-                other.mdctx_ = nullptr;
-                return *this;
-            }
-
-            [[nodiscard]] EVP_MD_CTX* get() { return mdctx_; }
-
-        private:
-            EVP_MD_CTX* mdctx_;
-        };
+            return md;
+        }
     } // namespace
 
-    std::string calculateDigest(Digest digestName, std::istream& inStream)
+    StreamingDigest::StreamingDigest(Digest digestName) : mdctx_(EVP_MD_CTX_new())
     {
-        if (!inStream.good())
-        {
-            throw std::runtime_error("Provided istream is not in a good state for reading");
-        }
-
-        const char* digestNameString;
-        switch (digestName)
+        if (mdctx_ == nullptr)
         {
-            case Digest::md5:
-                digestNameString = "md5";
-                break;
-            case Digest::sha256:
-                digestNameString = "sha256";
-                break;
-            case Digest::sha1:
-                digestNameString = "sha1";
-                break;
+            throw std::runtime_error("EVP_MD_CTX_new failed");
         }
 
-        // TODO: replace with EVP_MD_fetch for OpenSSL 3.0
-        const EVP_MD* md = EVP_get_digestbyname(digestNameString);
-        if (md == nullptr)
-        {
-            throw std::runtime_error(std::string("Unknown message digest ") + digestNameString);
-        }
-
-        MdContext mdContext;
-
-        if (EVP_DigestInit_ex(mdContext.get(), md, nullptr) != 1)
+        if (EVP_DigestInit_ex(mdctx_, getDigestByName(digestName), nullptr) != 1)
         {
+            EVP_MD_CTX_free(mdctx_);
             throw std::runtime_error("EVP_DigestInit_ex failed");
         }
+    }
 
-        while (inStream.good())
-        {
-            char buffer[digestBufferSize];
-            inStream.read(buffer, digestBufferSize);
-            if (EVP_DigestUpdate(mdContext.get(), buffer, inStream.gcount()) != 1)
-            {
-                throw std::runtime_error("EVP_DigestUpdate failed");
-            }
-        }
+    StreamingDigest::~StreamingDigest()
+    {
+        EVP_MD_CTX_free(mdctx_);
+    }
 
-        if (inStream.bad())
+    void StreamingDigest::update(const void* data, size_t size)
+    {
+        if (EVP_DigestUpdate(mdctx_, data, size) != 1)
         {
-            throw std::runtime_error("Reading ended with a bad istream state");
+            throw std::runtime_error("EVP_DigestUpdate failed");
         }
+    }
 
+    std::string StreamingDigest::finalise()
+    {
         std::vector<unsigned char> digest(EVP_MAX_MD_SIZE);
         unsigned int len = 0;
 
-        if (EVP_DigestFinal_ex(mdContext.get(), digest.data(), &len) != 1)
+        if (EVP_DigestFinal_ex(mdctx_, digest.data(), &len) != 1)
         {
             throw std::runtime_error("EVP_DigestFinal_ex failed");
         }
@@ -120,6 +86,30 @@ namespace Common::SslImpl
         return stream.str();
     }
 
+    std::string calculateDigest(Digest digestName, std::istream& inStream)
+    {
+        if (!inStream.good())
+        {
+            throw std::runtime_error("Provided istream is not in a good state for reading");
+        }
+
+        StreamingDigest digest(digestName);
+
+        while (inStream.good())
+        {
+            char buffer[digestBufferSize];
+            inStream.read(buffer, digestBufferSize);
+            digest.update(buffer, inStream.gcount());
+        }
+
+        if (inStream.bad())
+        {
+            throw std::runtime_error("Reading ended with a bad istream state");
+        }
+
+        return digest.finalise();
+    }
+
     std::string calculateDigest(Digest digestName, const std::string& input)
     {
         std::istringstream istream(input);
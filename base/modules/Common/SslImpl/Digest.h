@@ -1,8 +1,12 @@
-// Copyright 2018-2022, Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include <istream>
+#include <memory>
+#include <string>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
 
 namespace Common::SslImpl
 {
@@ -29,5 +33,28 @@ namespace Common::SslImpl
      */
     [[nodiscard]] std::string calculateDigest(Digest digestName, const std::string& input);
 
+    /**
+     * Calculates a digest incrementally, for data that is produced in pieces rather than read from one stream.
+     */
+    class StreamingDigest
+    {
+    public:
+        explicit StreamingDigest(Digest digestName);
+        ~StreamingDigest();
+        StreamingDigest(const StreamingDigest&) = delete;
+        StreamingDigest& operator=(const StreamingDigest&) = delete;
+
+        void update(const void* data, size_t size);
+
+        /**
+         * Finishes the calculation. No more data can be added afterwards.
+         * @return Lowercase hexadecimal representation of the digest.
+         */
+        [[nodiscard]] std::string finalise();
+
+    private:
+        EVP_MD_CTX* mdctx_;
+    };
+
     constexpr int digestBufferSize = 1024;
 } // namespace Common::SslImpl
\ No newline at end of file
@@ -0,0 +1,294 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "StatAccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace
+{
+    constexpr double GROWTH = 1.01;
+    const double LOG_GROWTH = std::log(GROWTH);
+
+    const char* COUNT_KEY = "count";
+    const char* SUM_KEY = "sum";
+    const char* MEAN_KEY = "mean";
+    const char* SUM_SQUARED_DIFFERENCES_KEY = "m2";
+    const char* MIN_KEY = "min";
+    const char* MAX_KEY = "max";
+    const char* HISTOGRAM_KEY = "histogram";
+    const char* POSITIVE_KEY = "positive";
+    const char* NEGATIVE_KEY = "negative";
+    const char* ZEROS_KEY = "zeros";
+
+    int bucketIndex(double magnitude)
+    {
+        return static_cast<int>(std::ceil(std::log(magnitude) / LOG_GROWTH));
+    }
+
+    // Middle of the bucket, so the error is at most half a bucket either way
+    double bucketValue(int index)
+    {
+        return std::pow(GROWTH, index) * (1 + 1 / GROWTH) / 2;
+    }
+
+    void merge(std::map<int, unsigned long>& into, const std::map<int, unsigned long>& from)
+    {
+        for (const auto& [index, count] : from)
+        {
+            into[index] += count;
+        }
+    }
+
+    Common::Telemetry::TelemetryObject bucketsToTelemetryObject(const std::map<int, unsigned long>& buckets)
+    {
+        Common::Telemetry::TelemetryObject object;
+        for (const auto& [index, count] : buckets)
+        {
+            object.set(std::to_string(index), Common::Telemetry::TelemetryValue(count));
+        }
+        return object;
+    }
+
+    std::map<int, unsigned long> bucketsFromTelemetryObject(const Common::Telemetry::TelemetryObject& object)
+    {
+        std::map<int, unsigned long> buckets;
+        for (const auto& [index, count] : object.getChildObjects())
+        {
+            buckets[std::stoi(index)] = count.getValue().getUnsignedInteger();
+        }
+        return buckets;
+    }
+
+    const Common::Telemetry::TelemetryValue& valueAt(
+        const Common::Telemetry::TelemetryObject& object,
+        const std::string& key)
+    {
+        return object.getChildObjects().at(key).getValue();
+    }
+} // namespace
+
+namespace Common::Telemetry
+{
+    void StatHistogram::add(double value)
+    {
+        ++m_count;
+        if (value > 0)
+        {
+            ++m_positive[bucketIndex(value)];
+        }
+        else if (value < 0)
+        {
+            ++m_negative[bucketIndex(-value)];
+        }
+        else
+        {
+            ++m_zeros;
+        }
+    }
+
+    void StatHistogram::merge(const StatHistogram& other)
+    {
+        ::merge(m_positive, other.m_positive);
+        ::merge(m_negative, other.m_negative);
+        m_zeros += other.m_zeros;
+        m_count += other.m_count;
+    }
+
+    double StatHistogram::percentile(double percentile) const
+    {
+        if (m_count == 0)
+        {
+            return 0;
+        }
+
+        auto rank = static_cast<unsigned long>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * m_count));
+        rank = std::max<unsigned long>(rank, 1);
+
+        unsigned long seen = 0;
+        for (auto it = m_negative.rbegin(); it != m_negative.rend(); ++it)
+        {
+            seen += it->second;
+            if (seen >= rank)
+            {
+                return -bucketValue(it->first);
+            }
+        }
+        seen += m_zeros;
+        if (seen >= rank)
+        {
+            return 0;
+        }
+        for (const auto& [index, count] : m_positive)
+        {
+            seen += count;
+            if (seen >= rank)
+            {
+                return bucketValue(index);
+            }
+        }
+        return m_positive.empty() ? 0 : bucketValue(m_positive.rbegin()->first);
+    }
+
+    TelemetryObject StatHistogram::toTelemetryObject() const
+    {
+        TelemetryObject object;
+        object.set(POSITIVE_KEY, bucketsToTelemetryObject(m_positive));
+        object.set(NEGATIVE_KEY, bucketsToTelemetryObject(m_negative));
+        object.set(ZEROS_KEY, TelemetryValue(m_zeros));
+        return object;
+    }
+
+    StatHistogram StatHistogram::fromTelemetryObject(const TelemetryObject& object)
+    {
+        StatHistogram histogram;
+        histogram.m_positive = bucketsFromTelemetryObject(object.getChildObjects().at(POSITIVE_KEY));
+        histogram.m_negative = bucketsFromTelemetryObject(object.getChildObjects().at(NEGATIVE_KEY));
+        histogram.m_zeros = valueAt(object, ZEROS_KEY).getUnsignedInteger();
+        histogram.m_count = histogram.m_zeros;
+        for (const auto& buckets : { histogram.m_positive, histogram.m_negative })
+        {
+            for (const auto& [index, count] : buckets)
+            {
+                histogram.m_count += count;
+            }
+        }
+        return histogram;
+    }
+
+    void StatAccumulator::add(double value)
+    {
+        if (m_count == 0)
+        {
+            m_min = value;
+            m_max = value;
+        }
+        else
+        {
+            m_min = std::min(m_min, value);
+            m_max = std::max(m_max, value);
+        }
+
+        ++m_count;
+        m_sum += value;
+        double difference = value - m_runningMean;
+        m_runningMean += difference / m_count;
+        m_sumSquaredDifferences += difference * (value - m_runningMean);
+
+        if (m_histogram)
+        {
+            m_histogram->add(value);
+        }
+    }
+
+    void StatAccumulator::merge(const StatAccumulator& other)
+    {
+        if (m_count == 0)
+        {
+            m_count = other.m_count;
+            m_sum = other.m_sum;
+            m_runningMean = other.m_runningMean;
+            m_sumSquaredDifferences = other.m_sumSquaredDifferences;
+            m_min = other.m_min;
+            m_max = other.m_max;
+        }
+        else if (other.m_count != 0)
+        {
+            // Chan et al.'s method for combining the variance of two sets of samples
+            double count = static_cast<double>(m_count) + other.m_count;
+            double difference = other.m_runningMean - m_runningMean;
+            m_runningMean += difference * other.m_count / count;
+            m_sumSquaredDifferences +=
+                other.m_sumSquaredDifferences + difference * difference * m_count * other.m_count / count;
+            m_count += other.m_count;
+            m_sum += other.m_sum;
+            m_min = std::min(m_min, other.m_min);
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        if (other.m_histogram)
+        {
+            enableHistogram();
+            m_histogram->merge(*other.m_histogram);
+        }
+    }
+
+    double StatAccumulator::mean() const
+    {
+        return m_count == 0 ? 0 : m_sum / m_count;
+    }
+
+    double StatAccumulator::stdDeviation() const
+    {
+        return m_count == 0 ? 0 : std::sqrt(m_sumSquaredDifferences / m_count);
+    }
+
+    void StatAccumulator::enableHistogram()
+    {
+        if (!m_histogram)
+        {
+            m_histogram = StatHistogram{};
+        }
+    }
+
+    double StatAccumulator::percentile(double percentile) const
+    {
+        if (!m_histogram || m_count == 0)
+        {
+            return 0;
+        }
+        if (percentile <= 0)
+        {
+            return m_min;
+        }
+        if (percentile >= 100)
+        {
+            return m_max;
+        }
+        return std::clamp(m_histogram->percentile(percentile), m_min, m_max);
+    }
+
+    TelemetryObject StatAccumulator::toTelemetryObject() const
+    {
+        TelemetryObject object;
+        object.set(COUNT_KEY, TelemetryValue(m_count));
+        object.set(SUM_KEY, TelemetryValue(m_sum));
+        object.set(MEAN_KEY, TelemetryValue(m_runningMean));
+        object.set(SUM_SQUARED_DIFFERENCES_KEY, TelemetryValue(m_sumSquaredDifferences));
+        object.set(MIN_KEY, TelemetryValue(m_min));
+        object.set(MAX_KEY, TelemetryValue(m_max));
+        if (m_histogram)
+        {
+            object.set(HISTOGRAM_KEY, m_histogram->toTelemetryObject());
+        }
+        return object;
+    }
+
+    StatAccumulator StatAccumulator::fromTelemetryObject(const TelemetryObject& object)
+    {
+        if (object.getType() == TelemetryObject::Type::array)
+        {
+            // Saved before stats were accumulated, as the list of samples
+            StatAccumulator accumulator;
+            for (const auto& value : object.getArray())
+            {
+                accumulator.add(value.getValue().getDouble());
+            }
+            return accumulator;
+        }
+
+        StatAccumulator accumulator;
+        accumulator.m_count = valueAt(object, COUNT_KEY).getUnsignedInteger();
+        accumulator.m_sum = valueAt(object, SUM_KEY).getDouble();
+        accumulator.m_runningMean = valueAt(object, MEAN_KEY).getDouble();
+        accumulator.m_sumSquaredDifferences = valueAt(object, SUM_SQUARED_DIFFERENCES_KEY).getDouble();
+        accumulator.m_min = valueAt(object, MIN_KEY).getDouble();
+        accumulator.m_max = valueAt(object, MAX_KEY).getDouble();
+        if (object.keyExists(HISTOGRAM_KEY))
+        {
+            accumulator.m_histogram = StatHistogram::fromTelemetryObject(object.getChildObjects().at(HISTOGRAM_KEY));
+        }
+        return accumulator;
+    }
+} // namespace Common::Telemetry
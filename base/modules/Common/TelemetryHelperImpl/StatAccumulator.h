@@ -0,0 +1,81 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "TelemetryObject.h"
+
+#include <map>
+#include <optional>
+
+namespace Common::Telemetry
+{
+    /**
+     * Histogram of samples in buckets whose bounds grow by 1% each, so percentiles are accurate to about 1% of the
+     * value whatever its size. Only buckets that have been used take memory.
+     */
+    class StatHistogram
+    {
+    public:
+        void add(double value);
+        void merge(const StatHistogram& other);
+
+        /**
+         * @param percentile in the range [0, 100]
+         * @return a value from the bucket holding the percentile, or 0 if the histogram is empty
+         */
+        [[nodiscard]] double percentile(double percentile) const;
+
+        [[nodiscard]] TelemetryObject toTelemetryObject() const;
+        static StatHistogram fromTelemetryObject(const TelemetryObject& object);
+
+    private:
+        // Keyed on bucket index, so bucket k holds magnitudes in (GROWTH^(k-1), GROWTH^k]
+        std::map<int, unsigned long> m_positive;
+        std::map<int, unsigned long> m_negative;
+        unsigned long m_zeros = 0;
+        unsigned long m_count = 0;
+    };
+
+    /**
+     * Summary of a stream of samples that takes the same memory however many samples it has seen.
+     * Variance is kept with Welford's method so it stays accurate for long streams, and accumulators filled on
+     * different threads can be merged.
+     */
+    class StatAccumulator
+    {
+    public:
+        void add(double value);
+        void merge(const StatAccumulator& other);
+
+        [[nodiscard]] unsigned long count() const { return m_count; }
+        [[nodiscard]] double mean() const;
+        [[nodiscard]] double min() const { return m_min; }
+        [[nodiscard]] double max() const { return m_max; }
+        [[nodiscard]] double stdDeviation() const;
+
+        /**
+         * Keep a histogram of samples added from now on, so percentiles can be reported
+         */
+        void enableHistogram();
+        [[nodiscard]] bool hasHistogram() const { return m_histogram.has_value(); }
+
+        /**
+         * @return the percentile, limited to the range of samples seen, or 0 if there is no histogram.
+         * Percentiles 0 and 100 are exactly the min and max.
+         */
+        [[nodiscard]] double percentile(double percentile) const;
+
+        [[nodiscard]] TelemetryObject toTelemetryObject() const;
+        static StatAccumulator fromTelemetryObject(const TelemetryObject& object);
+
+    private:
+        unsigned long m_count = 0;
+        // The mean comes from the sum rather than Welford's running mean so it matches a plain average exactly
+        double m_sum = 0;
+        double m_runningMean = 0;
+        double m_sumSquaredDifferences = 0;
+        double m_min = 0;
+        double m_max = 0;
+        std::optional<StatHistogram> m_histogram;
+    };
+} // namespace Common::Telemetry
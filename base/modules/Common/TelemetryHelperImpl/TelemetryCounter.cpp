@@ -0,0 +1,34 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "TelemetryCounter.h"
+
+namespace
+{
+    size_t slotForThisThread()
+    {
+        static std::atomic<size_t> nextSlot{ 0 };
+        thread_local size_t slot = nextSlot++;
+        return slot;
+    }
+} // namespace
+
+namespace Common::Telemetry
+{
+    void TelemetryCounter::increment(long value) noexcept
+    {
+        if (m_slots)
+        {
+            m_slots->slots[slotForThisThread() % SLOT_COUNT].value.fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    long TelemetryCounter::Slots::take() noexcept
+    {
+        long total = 0;
+        for (auto& slot : slots)
+        {
+            total += slot.value.exchange(0, std::memory_order_relaxed);
+        }
+        return total;
+    }
+} // namespace Common::Telemetry
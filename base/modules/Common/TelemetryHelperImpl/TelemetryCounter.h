@@ -0,0 +1,51 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace Common::Telemetry
+{
+    /**
+     * Counter for hot paths, from TelemetryHelper::registerCounter.
+     * Incrementing it adds to an atomic slot picked by the calling thread, with no key lookup and no lock. The slots
+     * are added to the registered key when the TelemetryHelper is serialised or saved.
+     */
+    class TelemetryCounter
+    {
+    public:
+        /**
+         * Counter that isn't registered with a TelemetryHelper, so increments are discarded
+         */
+        TelemetryCounter() = default;
+
+        void increment(long value = 1) noexcept;
+
+    private:
+        friend class TelemetryHelper;
+
+        static constexpr size_t SLOT_COUNT = 8;
+
+        // Each slot on its own cache line so threads don't contend for it
+        struct alignas(64) Slot
+        {
+            std::atomic<long> value{ 0 };
+        };
+
+        struct Slots
+        {
+            std::array<Slot, SLOT_COUNT> slots;
+
+            /**
+             * @return the total of all the slots, which are set back to zero
+             */
+            long take() noexcept;
+        };
+
+        explicit TelemetryCounter(std::shared_ptr<Slots> slots) : m_slots(std::move(slots)) {}
+
+        std::shared_ptr<Slots> m_slots;
+    };
+} // namespace Common::Telemetry
@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "TelemetryHelper.h"
 
@@ -11,8 +11,28 @@
 #include "Common/FileSystemImpl/FileSystemImpl.h"
 #include "Common/UtilityImpl/StringUtils.h"
 
+#include <atomic>
 #include <cmath>
 #include <functional>
+#include <sstream>
+
+namespace
+{
+    // Each thread sticks to one stats shard, so threads appending stats rarely wait for each other
+    size_t statsShardForThisThread(size_t shardCount)
+    {
+        static std::atomic<size_t> nextShard{ 0 };
+        thread_local size_t shard = nextShard++;
+        return shard % shardCount;
+    }
+
+    std::string percentileKey(const std::string& statsKey, double percentile)
+    {
+        std::ostringstream key;
+        key << statsKey << "-p" << percentile;
+        return key.str();
+    }
+} // namespace
 
 namespace Common::Telemetry
 {
@@ -168,9 +188,34 @@ namespace Common::Telemetry
     std::string TelemetryHelper::serialise()
     {
         std::lock_guard<std::mutex> lock(m_dataLock);
+        noLockCollectCounters();
         return TelemetrySerialiser::serialise(m_root);
     }
 
+    TelemetryCounter TelemetryHelper::registerCounter(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(m_countersLock);
+        auto& slots = m_counters[key];
+        if (!slots)
+        {
+            slots = std::make_shared<TelemetryCounter::Slots>();
+        }
+        return TelemetryCounter(slots);
+    }
+
+    void TelemetryHelper::noLockCollectCounters(bool discard)
+    {
+        std::lock_guard<std::mutex> lock(m_countersLock);
+        for (const auto& [key, slots] : m_counters)
+        {
+            long total = slots->take();
+            if (total != 0 && !discard)
+            {
+                noLockIncrement(key, total);
+            }
+        }
+    }
+
     void TelemetryHelper::registerResetCallback(std::string cookie, std::function<void(TelemetryHelper&)> function)
     {
         std::lock_guard<std::mutex> lock(m_callbackLock);
@@ -194,7 +239,8 @@ namespace Common::Telemetry
     }
     void TelemetryHelper::locked_reset()
     {
-        m_statsCollection = {};
+        clearStats();
+        noLockCollectCounters(true);
         TelemetryHelper another;
         another.m_root = m_resetToThis;
         for (const auto& callback_entry : m_callbacks)
@@ -210,6 +256,7 @@ namespace Common::Telemetry
     void TelemetryHelper::clearData()
     {
         std::lock_guard<std::mutex> dataLock(m_dataLock);
+        noLockCollectCounters(true);
         m_root = m_resetToThis;
     }
 
@@ -225,6 +272,7 @@ namespace Common::Telemetry
         std::scoped_lock scopedLock(m_callbackLock, m_dataLock);
 
         // Serialise
+        noLockCollectCounters();
         std::string serialised = TelemetrySerialiser::serialise(m_root);
         locked_reset();
         return serialised;
@@ -245,96 +293,166 @@ namespace Common::Telemetry
 
     void TelemetryHelper::appendStat(const std::string& statsKey, double value)
     {
-        std::lock_guard<std::mutex> statsLock(m_dataLock);
-        noLockAppendStat(statsKey, value);
+        StatsShard& shard = m_statsShards[statsShardForThisThread(m_statsShards.size())];
+        std::lock_guard<std::mutex> shardLock(shard.lock);
+        noLockShardStat(shard, statsKey).add(value);
     }
 
-    void TelemetryHelper::noLockAppendStat(const std::string& statsKey, double value)
+    void TelemetryHelper::addStat(const std::string& statsKey, const StatAccumulator& stat)
     {
-        m_statsCollection[statsKey].push_back(value);
+        StatsShard& shard = m_statsShards[statsShardForThisThread(m_statsShards.size())];
+        std::lock_guard<std::mutex> shardLock(shard.lock);
+        noLockShardStat(shard, statsKey).merge(stat);
     }
 
-    double TelemetryHelper::getStatAverage(const std::string& statsKey)
+    StatAccumulator& TelemetryHelper::noLockShardStat(StatsShard& shard, const std::string& statsKey)
+    {
+        auto [stat, added] = shard.stats.try_emplace(statsKey);
+        if (added)
+        {
+            std::lock_guard<std::mutex> percentilesLock(m_statPercentilesLock);
+            if (m_statPercentiles.count(statsKey) != 0)
+            {
+                stat->second.enableHistogram();
+            }
+        }
+        return stat->second;
+    }
+
+    void TelemetryHelper::enableStatPercentiles(const std::string& statsKey, const std::vector<double>& percentiles)
+    {
+        {
+            std::lock_guard<std::mutex> percentilesLock(m_statPercentilesLock);
+            m_statPercentiles[statsKey] = percentiles;
+        }
+        for (auto& shard : m_statsShards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard.lock);
+            auto stat = shard.stats.find(statsKey);
+            if (stat != shard.stats.end())
+            {
+                stat->second.enableHistogram();
+            }
+        }
+    }
+
+    std::map<std::string, StatAccumulator> TelemetryHelper::mergeStats()
     {
-        if (m_statsCollection[statsKey].empty())
+        std::map<std::string, StatAccumulator> merged;
+        for (auto& shard : m_statsShards)
         {
-            return 0;
+            std::lock_guard<std::mutex> shardLock(shard.lock);
+            for (const auto& [statsKey, stat] : shard.stats)
+            {
+                merged[statsKey].merge(stat);
+            }
         }
+        return merged;
+    }
 
-        double sumation = 0;
-        for (auto& stat : m_statsCollection[statsKey])
+    StatAccumulator TelemetryHelper::mergeStat(const std::string& statsKey)
+    {
+        StatAccumulator merged;
+        for (auto& shard : m_statsShards)
         {
-            sumation += stat;
+            std::lock_guard<std::mutex> shardLock(shard.lock);
+            auto stat = shard.stats.find(statsKey);
+            if (stat != shard.stats.end())
+            {
+                merged.merge(stat->second);
+            }
         }
+        return merged;
+    }
 
-        return sumation / m_statsCollection[statsKey].size();
+    void TelemetryHelper::clearStats()
+    {
+        for (auto& shard : m_statsShards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard.lock);
+            shard.stats.clear();
+        }
+    }
+
+    double TelemetryHelper::getStatAverage(const std::string& statsKey)
+    {
+        return mergeStat(statsKey).mean();
     }
 
     double TelemetryHelper::getStatMin(const std::string& statsKey)
     {
-        return *std::min_element(m_statsCollection[statsKey].begin(), m_statsCollection[statsKey].end());
+        return mergeStat(statsKey).min();
     }
 
     double TelemetryHelper::getStatMax(const std::string& statsKey)
     {
-        return *std::max_element(m_statsCollection[statsKey].begin(), m_statsCollection[statsKey].end());
+        return mergeStat(statsKey).max();
     }
 
     double TelemetryHelper::getStatStdDeviation(const std::string& statsKey)
     {
-        double statMean = TelemetryHelper::getStatAverage(statsKey);
-        double sumation = 0;
-        for (auto& stat : m_statsCollection[statsKey])
-        {
-            double term = stat - statMean;
-            term = term * term;
-            sumation += term;
-        }
-        double statStdDeviationSquared = sumation / m_statsCollection[statsKey].size();
+        return mergeStat(statsKey).stdDeviation();
+    }
 
-        return sqrt(statStdDeviationSquared);
+    double TelemetryHelper::getStatPercentile(const std::string& statsKey, double percentile)
+    {
+        return mergeStat(statsKey).percentile(percentile);
     }
 
     void TelemetryHelper::updateTelemetryWithStats()
     {
-        updateTelemetryWithAllAverageStats();
-        updateTelemetryWithAllMinStats();
-        updateTelemetryWithAllMaxStats();
+        std::map<std::string, std::vector<double>> statPercentiles;
+        {
+            std::lock_guard<std::mutex> percentilesLock(m_statPercentilesLock);
+            statPercentiles = m_statPercentiles;
+        }
+
+        for (const auto& [statsKey, stat] : mergeStats())
+        {
+            set(statsKey + "-avg", stat.mean());
+            set(statsKey + "-min", stat.min());
+            set(statsKey + "-max", stat.max());
+
+            auto percentiles = statPercentiles.find(statsKey);
+            if (percentiles != statPercentiles.end() && stat.hasHistogram())
+            {
+                for (double percentile : percentiles->second)
+                {
+                    set(percentileKey(statsKey, percentile), stat.percentile(percentile));
+                }
+            }
+        }
     }
 
     void TelemetryHelper::updateTelemetryWithAllAverageStats()
     {
-        std::map<std::string, double> averages;
-        for (const auto& keyValuePair : m_statsCollection)
+        for (const auto& [statsKey, stat] : mergeStats())
         {
-            set(keyValuePair.first + "-avg", getStatAverage(keyValuePair.first));
+            set(statsKey + "-avg", stat.mean());
         }
     }
 
     void TelemetryHelper::updateTelemetryWithAllMinStats()
     {
-        std::map<std::string, double> minValues;
-        for (const auto& keyValuePair : m_statsCollection)
+        for (const auto& [statsKey, stat] : mergeStats())
         {
-            set(keyValuePair.first + "-min", getStatMin(keyValuePair.first));
+            set(statsKey + "-min", stat.min());
         }
     }
 
     void TelemetryHelper::updateTelemetryWithAllMaxStats()
     {
-        std::map<std::string, double> maxValues;
-        for (const auto& keyValuePair : m_statsCollection)
+        for (const auto& [statsKey, stat] : mergeStats())
         {
-            set(keyValuePair.first + "-max", getStatMax(keyValuePair.first));
+            set(statsKey + "-max", stat.max());
         }
     }
 
     void TelemetryHelper::updateTelemetryWithAllStdDeviationStats()
     {
-        std::map<std::string, double> maxValues;
-        for (const auto& keyValuePair : m_statsCollection)
+        for (const auto& [statsKey, stat] : mergeStats())
         {
-            set(keyValuePair.first + "-std-deviation", getStatStdDeviation(keyValuePair.first));
+            set(statsKey + "-std-deviation", stat.stdDeviation());
         }
     }
 
@@ -353,6 +471,7 @@ namespace Common::Telemetry
 
             if (m_fileSystem->isDirectory(Common::FileSystem::dirName(m_saveTelemetryPath)))
             {
+                noLockCollectCounters();
                 TelemetryObject restoreTelemetryObj;
                 restoreTelemetryObj.set(ROOTKEY, m_root);
                 restoreTelemetryObj.set(STATSKEY, noLockStatsCollectionToTelemetryObject());
@@ -415,29 +534,18 @@ namespace Common::Telemetry
     TelemetryObject TelemetryHelper::noLockStatsCollectionToTelemetryObject()
     {
         TelemetryObject statsTelemetryObj;
-        for (const auto& values : m_statsCollection)
+        for (const auto& [statsKey, stat] : mergeStats())
         {
-            std::list<TelemetryObject> valuesTelemetryObject;
-            for (const auto& value : values.second)
-            {
-                TelemetryObject valueTObj;
-                valueTObj.set(TelemetryValue(value));
-                valuesTelemetryObject.emplace_back(valueTObj);
-            }
-            statsTelemetryObj.set(values.first, valuesTelemetryObject);
+            statsTelemetryObj.set(statsKey, stat.toTelemetryObject());
         }
         return statsTelemetryObj;
     }
 
     void TelemetryHelper::noLockUpdateStatsCollection(const TelemetryObject& statsObject)
     {
-        auto statsCollection = statsObject.getChildObjects();
-        for (auto stat : statsCollection)
+        for (const auto& [statsKey, stat] : statsObject.getChildObjects())
         {
-            for (const auto& value : stat.second.getArray())
-            {
-                noLockAppendStat(stat.first, value.getValue().getDouble());
-            }
+            addStat(statsKey, StatAccumulator::fromTelemetryObject(stat));
         }
     }
 
@@ -1,11 +1,14 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include "StatAccumulator.h"
+#include "TelemetryCounter.h"
 #include "TelemetryObject.h"
 
 #include "Common/FileSystem/IFileSystem.h"
 
+#include <array>
 #include <functional>
 #include <mutex>
 #include <string>
@@ -42,6 +45,13 @@ namespace Common::Telemetry
         void increment(const std::string& key, long value);
         void increment(const std::string& key, unsigned long value);
 
+        /**
+         * Looks up the key once for code that increments it often. The counter's total is added to the key, as if
+         * by increment(key, total), whenever telemetry is serialised or saved. Counts not yet added are dropped by
+         * reset. Registering a key again returns a counter for the same total.
+         */
+        TelemetryCounter registerCounter(const std::string& key);
+
         void appendValue(const std::string& arrayKey, long value);
         void appendValue(const std::string& arrayKey, unsigned long value);
         void appendValue(const std::string& arrayKey, double value);
@@ -64,13 +74,29 @@ namespace Common::Telemetry
         void addValueToSet(const std::string& setKey, const char* value);
         void addValueToSet(const std::string& setKey, bool value);
 
+        /**
+         * Adds a sample to the stat. Samples are summarised as they arrive rather than stored, and threads add to
+         * separate summaries that are merged when the stats are read.
+         */
         void appendStat(const std::string& statsKey, double value);
+
+        /**
+         * Sets <statsKey>-avg, -min and -max, plus -p<percentile> for stats with percentiles enabled
+         */
         void updateTelemetryWithStats();
 
+        /**
+         * Keeps a histogram of the samples appended to the stat from now on so the percentiles can be reported.
+         * Survives reset.
+         * @param percentiles in the range [0, 100]
+         */
+        void enableStatPercentiles(const std::string& statsKey, const std::vector<double>& percentiles);
+
         double getStatAverage(const std::string& statsKey);
         double getStatMin(const std::string& statsKey);
         double getStatMax(const std::string& statsKey);
         double getStatStdDeviation(const std::string& statsKey);
+        double getStatPercentile(const std::string& statsKey, double percentile);
         void updateTelemetryWithAllAverageStats();
         void updateTelemetryWithAllMinStats();
         void updateTelemetryWithAllMaxStats();
@@ -101,7 +127,17 @@ namespace Common::Telemetry
         std::mutex m_dataLock;
         std::mutex m_callbackLock;
         std::map<std::string, std::function<void(TelemetryHelper&)>> m_callbacks;
-        std::map<std::string, std::vector<double>> m_statsCollection;
+        struct StatsShard
+        {
+            std::mutex lock;
+            std::map<std::string, StatAccumulator> stats;
+        };
+        static constexpr size_t STATS_SHARD_COUNT = 8;
+        std::array<StatsShard, STATS_SHARD_COUNT> m_statsShards;
+        std::mutex m_statPercentilesLock;
+        std::map<std::string, std::vector<double>> m_statPercentiles;
+        std::mutex m_countersLock;
+        std::map<std::string, std::shared_ptr<TelemetryCounter::Slots>> m_counters;
         std::string m_saveTelemetryPath;
         std::unique_ptr<Common::FileSystem::IFileSystem> m_fileSystem;
 
@@ -123,6 +159,12 @@ namespace Common::Telemetry
         void incrementInternal(const std::string& key, T value)
         {
             std::lock_guard<std::mutex> lock(m_dataLock);
+            noLockIncrement(key, value);
+        }
+
+        template<class T>
+        void noLockIncrement(const std::string& key, T value)
+        {
             TelemetryObject& telemetryObject = getTelemetryObjectByKey(key);
             TelemetryValue telemetryValue(0L);
 
@@ -212,11 +254,19 @@ namespace Common::Telemetry
             std::reference_wrapper<TelemetryObject> root);
         void clearData();
 
+        std::map<std::string, StatAccumulator> mergeStats();
+        StatAccumulator mergeStat(const std::string& statsKey);
+        void clearStats();
+        void addStat(const std::string& statsKey, const StatAccumulator& stat);
+
         // The following set of lockedXxx... methods do not lock the mutex before access.
         // the calling method must acquire the mutex before calling them
         TelemetryObject noLockStatsCollectionToTelemetryObject();
         void noLockUpdateStatsCollection(const TelemetryObject& statsObject);
         void noLockRestoreRoot(const TelemetryObject& savedTelemetryRoot);
-        void noLockAppendStat(const std::string& statsKey, double value);
+        // Adds counts from registered counters to m_root, or discards them
+        void noLockCollectCounters(bool discard = false);
+        // Must hold the shard's lock
+        StatAccumulator& noLockShardStat(StatsShard& shard, const std::string& statsKey);
     };
 } // namespace Common::Telemetry
@@ -0,0 +1,76 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Common::ZeroMQWrapper
+{
+    /**
+     * One part of a multi-part message, which owns its payload. Frames read from a socket hold the received ZMQ
+     * message, and writing one moves the payload to the socket instead of copying it.
+     */
+    class IFrame
+    {
+    public:
+        virtual ~IFrame() = default;
+
+        [[nodiscard]] virtual const char* data() const = 0;
+        [[nodiscard]] virtual std::size_t size() const = 0;
+
+        [[nodiscard]] std::string_view view() const { return { data(), size() }; }
+    };
+
+    using IFrameUniquePtr = std::unique_ptr<IFrame>;
+    using frames_t = std::vector<IFrameUniquePtr>;
+
+    class StringFrame : public IFrame
+    {
+    public:
+        explicit StringFrame(std::string payload) : m_payload(std::move(payload)) {}
+
+        [[nodiscard]] const char* data() const override { return m_payload.data(); }
+        [[nodiscard]] std::size_t size() const override { return m_payload.size(); }
+
+    private:
+        std::string m_payload;
+    };
+
+    /**
+     * Sends a buffer the caller owns, calling free once the socket has finished with it. ZMQ may call free from
+     * its own IO thread, and only after the message has been sent.
+     */
+    class BufferFrame : public IFrame
+    {
+    public:
+        using free_t = std::function<void(const char* data, std::size_t size)>;
+
+        BufferFrame(const char* data, std::size_t size, free_t free) :
+            m_data(data), m_size(size), m_free(std::move(free))
+        {
+        }
+        ~BufferFrame() override
+        {
+            if (m_free)
+            {
+                m_free(m_data, m_size);
+            }
+        }
+        BufferFrame(const BufferFrame&) = delete;
+        BufferFrame& operator=(const BufferFrame&) = delete;
+
+        [[nodiscard]] const char* data() const override { return m_data; }
+        [[nodiscard]] std::size_t size() const override { return m_size; }
+
+    private:
+        const char* m_data;
+        std::size_t m_size;
+        free_t m_free;
+    };
+} // namespace Common::ZeroMQWrapper
@@ -1,12 +1,9 @@
-/******************************************************************************************************
-
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "IDataType.h"
+#include "IFrame.h"
 #include "IHasFD.h"
 
 namespace Common::ZeroMQWrapper
@@ -17,5 +14,19 @@ namespace Common::ZeroMQWrapper
         using data_t = Common::ZeroMQWrapper::data_t;
 
         virtual data_t read() = 0;
+
+        /**
+         * Read a multi-part message without copying the payloads.
+         * ZMQ sockets override this, other readables copy the parts returned by read().
+         */
+        virtual frames_t readFrames()
+        {
+            frames_t frames;
+            for (auto& part : read())
+            {
+                frames.push_back(std::make_unique<StringFrame>(std::move(part)));
+            }
+            return frames;
+        }
     };
 } // namespace Common::ZeroMQWrapper
@@ -1,12 +1,9 @@
-/******************************************************************************************************
-
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "IDataType.h"
+#include "IFrame.h"
 #include "IHasFD.h"
 
 namespace Common::ZeroMQWrapper
@@ -19,5 +16,21 @@ namespace Common::ZeroMQWrapper
          * Write a multi-part message from data
          */
         virtual void write(const data_t& data) = 0;
+
+        /**
+         * Write a multi-part message, handing each frame's payload to the socket without copying it.
+         * Frames read from a socket are forwarded as they are.
+         * ZMQ sockets override this, other writables copy the frames and call write().
+         */
+        virtual void writeFrames(frames_t frames)
+        {
+            data_t data;
+            data.reserve(frames.size());
+            for (const auto& frame : frames)
+            {
+                data.emplace_back(frame->data(), frame->size());
+            }
+            write(data);
+        }
     };
 } // namespace Common::ZeroMQWrapper
@@ -1,8 +1,4 @@
-/******************************************************************************************************
-
-Copyright 2018-2019, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "SocketPublisherImpl.h"
 
@@ -39,3 +35,8 @@ void Common::ZeroMQWrapperImpl::SocketPublisherImpl::write(const std::vector<std
 {
     SocketUtil::write(m_socket, data);
 }
+
+void Common::ZeroMQWrapperImpl::SocketPublisherImpl::writeFrames(Common::ZeroMQWrapper::frames_t frames)
+{
+    SocketUtil::writeFrames(m_socket, std::move(frames));
+}
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -14,5 +14,7 @@ namespace Common::ZeroMQWrapperImpl
         explicit SocketPublisherImpl(ContextHolderSharedPtr context);
 
         void write(const std::vector<std::string>& data) override;
+
+        void writeFrames(Common::ZeroMQWrapper::frames_t frames) override;
     };
 } // namespace Common::ZeroMQWrapperImpl
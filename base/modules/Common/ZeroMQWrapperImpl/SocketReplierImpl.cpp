@@ -1,8 +1,4 @@
-/******************************************************************************************************
-
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #include "SocketReplierImpl.h"
 
 #include "SocketUtil.h"
@@ -24,3 +20,13 @@ void Common::ZeroMQWrapperImpl::SocketReplierImpl::write(const std::vector<std::
 {
     SocketUtil::write(m_socket, data);
 }
+
+Common::ZeroMQWrapper::frames_t Common::ZeroMQWrapperImpl::SocketReplierImpl::readFrames()
+{
+    return SocketUtil::readFrames(m_socket);
+}
+
+void Common::ZeroMQWrapperImpl::SocketReplierImpl::writeFrames(Common::ZeroMQWrapper::frames_t frames)
+{
+    SocketUtil::writeFrames(m_socket, std::move(frames));
+}
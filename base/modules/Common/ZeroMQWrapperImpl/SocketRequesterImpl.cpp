@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "SocketRequesterImpl.h"
 
@@ -37,3 +37,27 @@ void Common::ZeroMQWrapperImpl::SocketRequesterImpl::write(const std::vector<std
 {
     SocketUtil::write(m_socket, data);
 }
+
+Common::ZeroMQWrapper::frames_t Common::ZeroMQWrapperImpl::SocketRequesterImpl::readFrames()
+{
+    try
+    {
+        int timeout_ = timeout();
+        if (timeout_ != -1)
+        {
+            SocketUtil::checkIncomingData(m_socket, timeout_);
+        }
+        return SocketUtil::readFrames(m_socket);
+    }
+    catch (const std::exception&)
+    {
+        // As for read(), the socket can't make another request until it is refreshed
+        refresh();
+        throw;
+    }
+}
+
+void Common::ZeroMQWrapperImpl::SocketRequesterImpl::writeFrames(Common::ZeroMQWrapper::frames_t frames)
+{
+    SocketUtil::writeFrames(m_socket, std::move(frames));
+}
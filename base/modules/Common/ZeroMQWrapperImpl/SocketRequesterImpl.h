@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -16,5 +16,9 @@ namespace Common::ZeroMQWrapperImpl
         std::vector<std::string> read() override;
 
         void write(const std::vector<std::string>& data) override;
+
+        Common::ZeroMQWrapper::frames_t readFrames() override;
+
+        void writeFrames(Common::ZeroMQWrapper::frames_t frames) override;
     };
 } // namespace Common::ZeroMQWrapperImpl
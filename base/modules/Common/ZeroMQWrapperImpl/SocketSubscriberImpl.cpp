@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "SocketSubscriberImpl.h"
 
@@ -16,6 +16,11 @@ std::vector<std::string> SocketSubscriberImpl::read()
     return SocketUtil::read(m_socket);
 }
 
+Common::ZeroMQWrapper::frames_t SocketSubscriberImpl::readFrames()
+{
+    return SocketUtil::readFrames(m_socket);
+}
+
 void SocketSubscriberImpl::subscribeTo(const std::string& subject)
 {
     int rc = zmq_setsockopt(m_socket.skt(), ZMQ_SUBSCRIBE, subject.data(), subject.size());
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -19,6 +19,8 @@ namespace Common::ZeroMQWrapperImpl
          */
         std::vector<std::string> read() override;
 
+        Common::ZeroMQWrapper::frames_t readFrames() override;
+
         /**
          * Set the subscription for this socket.
          * @param subject
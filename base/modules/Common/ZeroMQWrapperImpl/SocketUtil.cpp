@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "SocketUtil.h"
 
@@ -7,9 +7,99 @@
 
 #include "Common/Exceptions/Print.h"
 
+#include <cstring>
 #include <sstream>
 #include <zmq.h>
 
+using Common::ZeroMQWrapper::frames_t;
+using Common::ZeroMQWrapper::IFrame;
+using Common::ZeroMQWrapper::IFrameUniquePtr;
+
+namespace Common::ZeroMQWrapperImpl
+{
+    namespace
+    {
+        // ZMQ keeps payloads this small inside the zmq_msg_t, so they are copied rather than handed over
+        constexpr size_t SMALL_FRAME_SIZE = 32;
+
+        class ReceivedFrame : public IFrame
+        {
+        public:
+            ReceivedFrame()
+            {
+                if (zmq_msg_init(&m_msg) != 0)
+                {
+                    throw ZeroMQWrapperException(LOCATION, "Failed to init msg while reading");
+                }
+            }
+            ~ReceivedFrame() override { zmq_msg_close(&m_msg); }
+            ReceivedFrame(const ReceivedFrame&) = delete;
+            ReceivedFrame& operator=(const ReceivedFrame&) = delete;
+
+            [[nodiscard]] const char* data() const override
+            {
+                return static_cast<const char*>(zmq_msg_data(const_cast<zmq_msg_t*>(&m_msg)));
+            }
+            [[nodiscard]] size_t size() const override { return zmq_msg_size(&m_msg); }
+
+            zmq_msg_t* msg() { return &m_msg; }
+
+        private:
+            zmq_msg_t m_msg;
+        };
+
+        void freeFrame(void*, void* hint)
+        {
+            delete static_cast<IFrame*>(hint);
+        }
+
+        /**
+         * Initialises msg with the payload of frame, taking ownership of the frame if ZMQ needs it to stay alive.
+         */
+        void initMessage(zmq_msg_t& msg, IFrameUniquePtr frame)
+        {
+            if (auto* received = dynamic_cast<ReceivedFrame*>(frame.get()))
+            {
+                zmq_msg_init(&msg);
+                zmq_msg_move(&msg, received->msg());
+                return;
+            }
+
+            if (frame->size() <= SMALL_FRAME_SIZE)
+            {
+                if (zmq_msg_init_size(&msg, frame->size()) != 0)
+                {
+                    throw ZeroMQWrapperException(LOCATION, "Failed to init msg while writing");
+                }
+                if (frame->size() > 0)
+                {
+                    std::memcpy(zmq_msg_data(&msg), frame->data(), frame->size());
+                }
+                return;
+            }
+
+            IFrame* owner = frame.get();
+            if (zmq_msg_init_data(&msg, const_cast<char*>(owner->data()), owner->size(), freeFrame, owner) != 0)
+            {
+                throw ZeroMQWrapperException(LOCATION, "Failed to init msg while writing");
+            }
+            // Now freed by ZMQ when it closes the message
+            frame.release();
+        }
+
+        [[noreturn]] void throwSendFailure(const std::string& what, int error)
+        {
+            std::ostringstream ost;
+            ost << what << ": errno=" << error << ": " << zmq_strerror(error);
+            if (error == EAGAIN)
+            {
+                throw ZeroMQTimeoutException(LOCATION, ost.str());
+            }
+            throw ZeroMQWrapperException(LOCATION, ost.str());
+        }
+    } // namespace
+} // namespace Common::ZeroMQWrapperImpl
+
 std::vector<std::string> Common::ZeroMQWrapperImpl::SocketUtil::read(
     Common::ZeroMQWrapperImpl::SocketHolder& socketHolder)
 {
@@ -92,6 +182,45 @@ void Common::ZeroMQWrapperImpl::SocketUtil::write(
     }
 }
 
+frames_t Common::ZeroMQWrapperImpl::SocketUtil::readFrames(Common::ZeroMQWrapperImpl::SocketHolder& socketHolder)
+{
+    void* socket = socketHolder.skt();
+    frames_t res;
+    bool more;
+    do
+    {
+        auto part = std::make_unique<ReceivedFrame>();
+        if (zmq_msg_recv(part->msg(), socket, 0) < 0)
+        {
+            throw ZeroMQWrapperException(LOCATION, "Failed to receive message component");
+        }
+        more = zmq_msg_more(part->msg()) != 0;
+        res.push_back(std::move(part));
+    } while (more);
+    return res;
+}
+
+void Common::ZeroMQWrapperImpl::SocketUtil::writeFrames(
+    Common::ZeroMQWrapperImpl::SocketHolder& socketHolder,
+    frames_t frames)
+{
+    void* socket = socketHolder.skt();
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        bool last = i + 1 == frames.size();
+        zmq_msg_t part;
+        initMessage(part, std::move(frames[i]));
+        errno = 0;
+        if (zmq_msg_send(&part, socket, last ? 0 : ZMQ_SNDMORE) < 0)
+        {
+            int error = errno;
+            // Still ours after a failed send, and closing it frees the frame
+            zmq_msg_close(&part);
+            throwSendFailure(last ? "Failed to send final data block" : "Failed to send data block", error);
+        }
+    }
+}
+
 void Common::ZeroMQWrapperImpl::SocketUtil::listen(
     Common::ZeroMQWrapperImpl::SocketHolder& socket,
     const std::string& address)
@@ -1,13 +1,11 @@
-/******************************************************************************************************
-
-Copyright 2018, Sophos Limited.  All rights reserved.
-
-******************************************************************************************************/
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "SocketHolder.h"
 
+#include "Common/ZeroMQWrapper/IFrame.h"
+
 #include <string>
 #include <vector>
 
@@ -35,6 +33,20 @@ namespace Common::ZeroMQWrapperImpl
          */
         static void write(SocketHolder&, const data_t& data);
 
+        /**
+         * Read a multi-part message from a socket, keeping each part in the ZMQ message it was received into.
+         * @return The frames of the message
+         */
+        static Common::ZeroMQWrapper::frames_t readFrames(SocketHolder&);
+
+        /**
+         * Send a multi-part message to a socket without copying the payloads.
+         * Frames read from a socket are moved to the socket. Other frames are owned by ZMQ until it has sent them,
+         * except for small ones, which ZMQ would copy into the message anyway.
+         * @param frames The multi-part message to send.
+         */
+        static void writeFrames(SocketHolder&, Common::ZeroMQWrapper::frames_t frames);
+
         /**
          * Do a bind from a socket to an address, to listen for connections.
          * @param address
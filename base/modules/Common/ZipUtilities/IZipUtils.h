@@ -1,11 +1,19 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 namespace Common::ZipUtilities
 {
+    struct ZipOutputInfo
+    {
+        uint64_t sizeBytes = 0;
+        // Empty if the zip file could not be read back to finish the digest
+        std::string sha256;
+        bool exceededMaxSize = false;
+    };
 
     class IZipUtils
     {
@@ -24,6 +32,19 @@ namespace Common::ZipUtilities
             bool ignoreFileError,
             bool passwordProtected,
             const std::string& password) const = 0;
+        /**
+         * Zips srcPath, calculating the sha256 of the zip file as it is written.
+         * Zipping stops as soon as the zip file would exceed maxSizeBytes, in which case non-zero is returned with
+         * info.exceededMaxSize set, and info.sizeBytes only counts what was written before stopping.
+         */
+        [[nodiscard]] virtual int zip(
+            const std::string& srcPath,
+            const std::string& destPath,
+            bool ignoreFileError,
+            bool passwordProtected,
+            const std::string& password,
+            uint64_t maxSizeBytes,
+            ZipOutputInfo& info) const = 0;
         [[nodiscard]] virtual int unzip(const std::string& srcPath, const std::string& destPath) const = 0;
         [[nodiscard]] virtual int unzip(
             const std::string& srcPath,
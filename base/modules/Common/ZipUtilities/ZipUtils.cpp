@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "ZipUtils.h"
 
@@ -6,18 +6,24 @@
 #include "UnzipFileWrapper.h"
 
 #include "Common/FileSystem/IFileSystem.h"
+#include "Common/SslImpl/Digest.h"
+#include "Common/UtilityImpl/StrError.h"
 #include "Common/UtilityImpl/StringUtils.h"
 
 #include <sys/stat.h>
 
+#include <fcntl.h>
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <stdio.h>
 #include <unistd.h>
 #include <utime.h>
 #include <zlib.h>
 
 #define WRITEBUFFERSIZE (8192)
+#define READBUFFERSIZE (65536)
 
 namespace
 {
@@ -46,7 +52,7 @@ namespace
         LOGDEBUG("Restoring mode to: " << f_mode);
     }
 
-    void getFileInfo(const std::string& filepath, zip_fileinfo* zfi, unsigned long crcFile)
+    void getFileInfo(const std::string& filepath, zip_fileinfo* zfi)
     {
         struct stat s;
         struct tm* filedate;
@@ -76,8 +82,7 @@ namespace
 
         char f_mode[20];
         sprintf(f_mode, "%3o", zfi->external_fa & 0777);
-        LOGDEBUG(
-            "Filename: " << filepath << ", crc: " << crcFile << ", timestamp: " << time_buf << ", mode: " << f_mode);
+        LOGDEBUG("Filename: " << filepath << ", timestamp: " << time_buf << ", mode: " << f_mode);
     }
 
     int extractCurrentfile(std::shared_ptr<Common::ZipUtilities::UnzipFileWrapper> uf, const char* password)
@@ -234,39 +239,233 @@ namespace
         }
         return err;
     }
-} // namespace
 
-namespace Common::ZipUtilities
-{
-    int ZipUtils::zip(const std::string& srcPath, const std::string& destPath, bool ignoreFileError) const
+    /*
+     * Output file for minizip that hashes the zip as it is written and stops writing it past a size limit.
+     * Entries are written with data descriptors so that minizip doesn't have to seek back to patch their local
+     * headers. Should it rewrite data that was already hashed anyway, the digest is restarted and whatever wasn't
+     * hashed as it was written is read back from the file by finishDigest.
+     * Once the size limit is exceeded writes are only counted, so the full size of the zip is still known.
+     */
+    struct ZipOutputFile
     {
-        return zip(srcPath, destPath, ignoreFileError, false, "");
+        ZipOutputFile(const std::string& path, uint64_t maxSize) :
+            path_(path), maxSize_(maxSize), digest_(std::in_place, Common::SslImpl::Digest::sha256)
+        {
+        }
+
+        /*
+         * Hashes the part of the file that wasn't hashed as it was written and returns the digest.
+         * Returns an empty string if the file can't be read back.
+         */
+        std::string finishDigest()
+        {
+            if (hashedTo_ < size_)
+            {
+                LOGDEBUG("Reading back " << (size_ - hashedTo_) << " bytes of " << path_ << " to hash them");
+                int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                {
+                    LOGWARN("Could not open " << path_ << " to hash it: " << Common::UtilityImpl::StrError(errno));
+                    return "";
+                }
+                std::vector<char> buffer(READBUFFERSIZE);
+                while (hashedTo_ < size_)
+                {
+                    ssize_t bytesRead = ::pread(
+                        fd, buffer.data(), std::min<uint64_t>(buffer.size(), size_ - hashedTo_), hashedTo_);
+                    if (bytesRead < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (bytesRead <= 0)
+                    {
+                        LOGWARN("Could not read " << path_ << " to hash it");
+                        ::close(fd);
+                        return "";
+                    }
+                    digest_->update(buffer.data(), bytesRead);
+                    hashedTo_ += bytesRead;
+                }
+                ::close(fd);
+            }
+            return digest_->finalise();
+        }
+
+        std::string path_;
+        uint64_t maxSize_;
+        std::optional<Common::SslImpl::StreamingDigest> digest_;
+        int fd_ = -1;
+        uint64_t position_ = 0;
+        uint64_t size_ = 0;
+        uint64_t hashedTo_ = 0;
+        bool exceededMaxSize_ = false;
+        int error_ = 0;
+    };
+
+    voidpf ZCALLBACK openZipOutput(voidpf opaque, const void* /*filename*/, int /*mode*/)
+    {
+        auto* output = static_cast<ZipOutputFile*>(opaque);
+        output->fd_ = ::open(output->path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (output->fd_ < 0)
+        {
+            output->error_ = errno;
+            return nullptr;
+        }
+        return output;
     }
 
-    int ZipUtils::zip(
-        const std::string& srcPath,
-        const std::string& destPath,
+    unsigned long ZCALLBACK readZipOutput(voidpf /*opaque*/, voidpf stream, void* buf, unsigned long size)
+    {
+        auto* output = static_cast<ZipOutputFile*>(stream);
+        ssize_t bytesRead = ::pread(output->fd_, buf, size, output->position_);
+        if (bytesRead < 0)
+        {
+            output->error_ = errno;
+            return 0;
+        }
+        output->position_ += bytesRead;
+        return bytesRead;
+    }
+
+    unsigned long ZCALLBACK writeZipOutput(voidpf /*opaque*/, voidpf stream, const void* buf, unsigned long size)
+    {
+        auto* output = static_cast<ZipOutputFile*>(stream);
+        if (output->exceededMaxSize_ || output->position_ + size > output->maxSize_)
+        {
+            // The short write fails the zip, so nothing more is compressed once the limit is crossed
+            output->exceededMaxSize_ = true;
+            return 0;
+        }
+
+        const char* data = static_cast<const char*>(buf);
+        unsigned long written = 0;
+        while (written < size)
+        {
+            ssize_t ret = ::pwrite(output->fd_, data + written, size - written, output->position_ + written);
+            if (ret < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                output->error_ = errno;
+                break;
+            }
+            written += ret;
+        }
+
+        if (output->position_ < output->hashedTo_)
+        {
+            // Data already hashed has changed, so it all has to be read back at the end
+            output->digest_.emplace(Common::SslImpl::Digest::sha256);
+            output->hashedTo_ = 0;
+        }
+        if (output->position_ == output->hashedTo_)
+        {
+            output->digest_->update(data, written);
+            output->hashedTo_ += written;
+        }
+        output->position_ += written;
+        output->size_ = std::max(output->size_, output->position_);
+        return written;
+    }
+
+    ZPOS64_T ZCALLBACK tellZipOutput(voidpf /*opaque*/, voidpf stream)
+    {
+        return static_cast<ZipOutputFile*>(stream)->position_;
+    }
+
+    long ZCALLBACK seekZipOutput(voidpf /*opaque*/, voidpf stream, ZPOS64_T offset, int origin)
+    {
+        auto* output = static_cast<ZipOutputFile*>(stream);
+        switch (origin)
+        {
+            case ZLIB_FILEFUNC_SEEK_SET:
+                output->position_ = offset;
+                break;
+            case ZLIB_FILEFUNC_SEEK_CUR:
+                output->position_ += offset;
+                break;
+            case ZLIB_FILEFUNC_SEEK_END:
+                output->position_ = output->size_ + offset;
+                break;
+            default:
+                return -1;
+        }
+        return 0;
+    }
+
+    int ZCALLBACK closeZipOutput(voidpf /*opaque*/, voidpf stream)
+    {
+        auto* output = static_cast<ZipOutputFile*>(stream);
+        int ret = ::close(output->fd_);
+        output->fd_ = -1;
+        return ret;
+    }
+
+    int ZCALLBACK errorZipOutput(voidpf /*opaque*/, voidpf stream)
+    {
+        return static_cast<ZipOutputFile*>(stream)->error_;
+    }
+
+    /*
+     * Reads a file to be zipped in fixed size pieces, so memory use doesn't depend on the size of the file.
+     * Returns false and logs if the file can't be read, or throws if read errors aren't being ignored.
+     */
+    bool forEachFileChunk(
+        const std::string& filePath,
         bool ignoreFileError,
-        bool passwordProtected) const
+        std::vector<char>& buffer,
+        const std::function<bool(const char*, size_t)>& onChunk)
     {
-        return zip(srcPath, destPath, ignoreFileError, passwordProtected, "");
+        try
+        {
+            auto stream = Common::FileSystem::fileSystem()->openFileForRead(filePath);
+            while (stream->good())
+            {
+                stream->read(buffer.data(), buffer.size());
+                if (stream->gcount() > 0 && !onChunk(buffer.data(), stream->gcount()))
+                {
+                    return false;
+                }
+            }
+            if (stream->bad())
+            {
+                throw std::runtime_error("read failed");
+            }
+            return true;
+        }
+        catch (const std::exception& exception)
+        {
+            std::stringstream errorMessage;
+            errorMessage << "Could not read contents of file: " << filePath << " with error: " << exception.what();
+            LOGWARN(errorMessage.str());
+            if (!ignoreFileError)
+            {
+                throw std::runtime_error(errorMessage.str());
+            }
+            return false;
+        }
     }
 
-    int ZipUtils::zip(
+    /*
+     * Adds srcPath to an open zip file and closes it.
+     * Entries are written with data descriptors when useDataDescriptors is set. If output is given, no more
+     * entries are added once it has gone over its size limit.
+     */
+    int addToZip(
+        zipFile zf,
         const std::string& srcPath,
         const std::string& destPath,
         bool ignoreFileError,
         bool passwordProtected,
-        const std::string& password) const
+        const std::string& password,
+        bool useDataDescriptors,
+        const ZipOutputFile* output = nullptr)
     {
+        auto exceededMaxSize = [output]() { return output != nullptr && output->exceededMaxSize_; };
         int ret = ZIP_OK;
-        zipFile zf = zipOpen(std::string(destPath.begin(), destPath.end()).c_str(), APPEND_STATUS_CREATE);
-        if (zf == nullptr)
-        {
-            LOGERROR("Error opening zip file: " << destPath);
-            return ENOENT;
-        }
-
         auto fs = Common::FileSystem::fileSystem();
         std::vector<Path> filesToZip;
         bool fileOnly = false;
@@ -282,59 +481,56 @@ namespace Common::ZipUtilities
         else
         {
             LOGWARN("No file or directory found at input path: " << srcPath);
+            std::ignore = zipClose(zf, nullptr);
             return ENOENT;
         }
 
-        for (auto& fullFilePath : filesToZip)
+        try
         {
-            if (!fs->isFile(fullFilePath))
-            {
-                continue;
-            }
-
-            std::string fileContents;
-            try
+            std::vector<char> buffer(READBUFFERSIZE);
+            for (auto& fullFilePath : filesToZip)
             {
-                // set maxsize of file we accept to 1GB
-                fileContents = fs->readFile(fullFilePath, 1024 * 1024 * 1024);
-            }
-            catch (const std::exception& exception)
-            {
-                std::stringstream errorMessage;
-                errorMessage << "Could not read contents of file: " << fullFilePath
-                             << " with error: " << exception.what();
-                LOGWARN(errorMessage.str());
-                if (!ignoreFileError)
+                if (!fs->isFile(fullFilePath))
                 {
-                    throw std::runtime_error(errorMessage.str());
+                    continue;
                 }
-            }
 
-            zip_fileinfo zfi;
-            std::string relativeFilePath;
-            if (fileOnly)
-            {
-                relativeFilePath = Common::FileSystem::basename(srcPath);
-            }
-            else
-            {
-                std::string temp = srcPath;
-                if (Common::UtilityImpl::StringUtils::endswith(srcPath, "/"))
+                zip_fileinfo zfi;
+                std::string relativeFilePath;
+                if (fileOnly)
                 {
-                    temp = temp.substr(0, temp.size() - 1);
+                    relativeFilePath = Common::FileSystem::basename(srcPath);
                 }
+                else
+                {
+                    std::string temp = srcPath;
+                    if (Common::UtilityImpl::StringUtils::endswith(srcPath, "/"))
+                    {
+                        temp = temp.substr(0, temp.size() - 1);
+                    }
 
-                relativeFilePath = fullFilePath.substr(temp.find_last_of("/") + 1, fullFilePath.size());
-            }
+                    relativeFilePath = fullFilePath.substr(temp.find_last_of("/") + 1, fullFilePath.size());
+                }
 
-            unsigned long crcFile = 0;
-            crcFile = crc32_z(crcFile, (unsigned char*)&fileContents[0], fileContents.size());
+                getFileInfo(fullFilePath, &zfi);
 
-            getFileInfo(fullFilePath, &zfi, crcFile);
+                // Traditional zip encryption needs the crc before any data is written
+                unsigned long crcFile = 0;
+                if (passwordProtected)
+                {
+                    forEachFileChunk(
+                        fullFilePath,
+                        ignoreFileError,
+                        buffer,
+                        [&crcFile](const char* data, size_t size)
+                        {
+                            crcFile = crc32_z(crcFile, reinterpret_cast<const unsigned char*>(data), size);
+                            return true;
+                        });
+                    LOGDEBUG("Filename: " << fullFilePath << ", crc: " << crcFile);
+                }
 
-            if (passwordProtected)
-            {
-                ret = zipOpenNewFileInZip3(
+                ret = zipOpenNewFileInZip4_64(
                     zf,
                     relativeFilePath.c_str(),
                     &zfi,
@@ -349,48 +545,143 @@ namespace Common::ZipUtilities
                     -MAX_WBITS,
                     DEF_MEM_LEVEL,
                     Z_DEFAULT_STRATEGY,
-                    password.c_str(),
-                    crcFile);
-            }
-            else
-            {
-                ret = zipOpenNewFileInZip(
-                    zf,
-                    relativeFilePath.c_str(),
-                    &zfi,
-                    nullptr,
-                    0,
-                    nullptr,
-                    0,
-                    nullptr,
-                    MZ_COMPRESS_METHOD_DEFLATE,
-                    MZ_COMPRESS_LEVEL_DEFAULT);
-            }
-
-            if (ret != ZIP_OK)
-            {
-                LOGWARN("Could not add file " << fullFilePath << " to zip file");
-                continue;
-            }
+                    passwordProtected ? password.c_str() : nullptr,
+                    crcFile,
+                    MZ_VERSION_MADEBY,
+                    useDataDescriptors ? MZ_ZIP_FLAG_DATA_DESCRIPTOR : 0,
+                    0);
+                if (exceededMaxSize())
+                {
+                    break;
+                }
+                if (ret != ZIP_OK)
+                {
+                    LOGWARN("Could not add file " << fullFilePath << " to zip file");
+                    continue;
+                }
 
-            ret = zipWriteInFileInZip(zf, &fileContents[0], fileContents.size());
-            if (ZIP_OK != ret)
-            {
-                LOGERROR("Error zipping up file: " << relativeFilePath);
-            }
+                forEachFileChunk(
+                    fullFilePath,
+                    ignoreFileError,
+                    buffer,
+                    [&](const char* data, size_t size)
+                    {
+                        ret = zipWriteInFileInZip(zf, data, size);
+                        return ret == ZIP_OK;
+                    });
+                if (exceededMaxSize())
+                {
+                    break;
+                }
+                if (ZIP_OK != ret)
+                {
+                    LOGERROR("Error zipping up file: " << relativeFilePath);
+                }
 
-            ret = zipCloseFileInZip(zf);
-            if (ZIP_OK != ret)
-            {
-                LOGERROR("Error closing zip file: " << relativeFilePath);
+                int closeRet = zipCloseFileInZip(zf);
+                if (ZIP_OK != closeRet)
+                {
+                    LOGERROR("Error closing zip file: " << relativeFilePath);
+                }
             }
         }
+        catch (const std::exception&)
+        {
+            std::ignore = zipClose(zf, nullptr);
+            throw;
+        }
 
-        ret = zipClose(zf, nullptr);
-        if (ZIP_OK != ret)
+        int closeRet = zipClose(zf, nullptr);
+        if (exceededMaxSize())
+        {
+            // zipClose can't write the rest of the zip either, the caller reports the limit instead
+            return ZIP_ERRNO;
+        }
+        if (ZIP_OK != closeRet)
         {
             LOGERROR("Error closing zip file: " << destPath);
         }
+        return closeRet;
+    }
+} // namespace
+
+namespace Common::ZipUtilities
+{
+    int ZipUtils::zip(const std::string& srcPath, const std::string& destPath, bool ignoreFileError) const
+    {
+        return zip(srcPath, destPath, ignoreFileError, false, "");
+    }
+
+    int ZipUtils::zip(
+        const std::string& srcPath,
+        const std::string& destPath,
+        bool ignoreFileError,
+        bool passwordProtected) const
+    {
+        return zip(srcPath, destPath, ignoreFileError, passwordProtected, "");
+    }
+
+    int ZipUtils::zip(
+        const std::string& srcPath,
+        const std::string& destPath,
+        bool ignoreFileError,
+        bool passwordProtected,
+        const std::string& password) const
+    {
+        zipFile zf = zipOpen(std::string(destPath.begin(), destPath.end()).c_str(), APPEND_STATUS_CREATE);
+        if (zf == nullptr)
+        {
+            LOGERROR("Error opening zip file: " << destPath);
+            return ENOENT;
+        }
+
+        return addToZip(zf, srcPath, destPath, ignoreFileError, passwordProtected, password, false);
+    }
+
+    int ZipUtils::zip(
+        const std::string& srcPath,
+        const std::string& destPath,
+        bool ignoreFileError,
+        bool passwordProtected,
+        const std::string& password,
+        uint64_t maxSizeBytes,
+        ZipOutputInfo& info) const
+    {
+        ZipOutputFile output(destPath, maxSizeBytes);
+        zlib_filefunc64_def fileFuncs{ openZipOutput, readZipOutput,  writeZipOutput, tellZipOutput,
+                                       seekZipOutput, closeZipOutput, errorZipOutput, &output };
+
+        int ret = ENOENT;
+        zipFile zf = zipOpen2_64(destPath.c_str(), APPEND_STATUS_CREATE, nullptr, &fileFuncs);
+        if (zf == nullptr)
+        {
+            LOGERROR("Error opening zip file: " << destPath);
+        }
+        else
+        {
+            ret = addToZip(
+                zf,
+                srcPath,
+                destPath,
+                ignoreFileError,
+                passwordProtected,
+                password,
+                true,
+                &output);
+        }
+
+        info.sizeBytes = output.size_;
+        info.exceededMaxSize = output.exceededMaxSize_;
+        info.sha256.clear();
+        if (output.exceededMaxSize_)
+        {
+            LOGWARN("Zip file of " << srcPath << " exceeded " << maxSizeBytes << " bytes, stopped zipping");
+            return ZIP_ERRNO;
+        }
+        if (ret == ZIP_OK)
+        {
+            info.sha256 = output.finishDigest();
+        }
         return ret;
     }
 
@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 #include "IZipUtils.h"
@@ -22,6 +22,14 @@ namespace Common::ZipUtilities
             bool ignoreFileError,
             bool passwordProtected,
             const std::string& password) const override;
+        [[nodiscard]] int zip(
+            const std::string& srcPath,
+            const std::string& destPath,
+            bool ignoreFileError,
+            bool passwordProtected,
+            const std::string& password,
+            uint64_t maxSizeBytes,
+            ZipOutputInfo& info) const override;
         [[nodiscard]] int unzip(const std::string& srcPath, const std::string& destPath) const override;
         [[nodiscard]] int unzip(
             const std::string& srcPath,
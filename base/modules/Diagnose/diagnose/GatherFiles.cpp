@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "GatherFiles.h"
 
@@ -122,6 +122,13 @@ namespace diagnose
         return m_tempDir->dirPath();
     }
 
+    void GatherFiles::setArchive(std::shared_ptr<TarArchive> archive, const std::string& archiveRoot)
+    {
+        m_archive = std::move(archive);
+        m_archiveRoot = archiveRoot;
+        m_archive->addDirectory(m_archiveRoot);
+    }
+
     Path GatherFiles::createBaseFilesDir(const Path& path)
     {
         return createDiagnoseFolder(path, BASE_FOLDER);
@@ -158,7 +165,7 @@ namespace diagnose
             }
         }
 
-        m_fileSystem->makedirs(outputDir);
+        makeDestinationDirs(outputDir);
         if (m_fileSystem->isDirectory(outputDir))
         {
             return outputDir;
@@ -178,19 +185,19 @@ namespace diagnose
         Path targetFilePath = Common::FileSystem::join(dirPath, filename);
 
         // Check to see if the file exists, if it does then append a ".#" on the end, e.g. ".1"
-        if (m_fileSystem->exists(targetFilePath))
+        if (destinationExists(targetFilePath))
         {
             int fileCounterSuffix = 1;
             Path targetFilePathStart = targetFilePath;
             targetFilePath = targetFilePathStart + "." + std::to_string(fileCounterSuffix);
-            while (m_fileSystem->exists(targetFilePath))
+            while (destinationExists(targetFilePath))
             {
                 fileCounterSuffix++;
                 targetFilePath = targetFilePathStart + "." + std::to_string(fileCounterSuffix);
             }
         }
 
-        m_fileSystem->copyFile(filePath, targetFilePath);
+        collectFile(filePath, targetFilePath);
         LOGINFO("Copied " << filePath << " to " << dirPath);
     }
 
@@ -201,10 +208,63 @@ namespace diagnose
             return;
         }
 
-        m_fileSystem->copyFile(filePath, destination);
+        collectFile(filePath, destination);
         LOGINFO("Copied " << filePath << " to " << destination);
     }
 
+    void GatherFiles::collectFile(const Path& filePath, const Path& destination)
+    {
+        auto inArchive = archivePath(destination);
+        if (!inArchive)
+        {
+            m_fileSystem->copyFile(filePath, destination);
+            return;
+        }
+        if (!m_archive->addFile(filePath, inArchive.value()))
+        {
+            LOGWARN("Unable to add " << filePath << " to the archive");
+        }
+    }
+
+    bool GatherFiles::destinationExists(const Path& destination)
+    {
+        auto inArchive = archivePath(destination);
+        if (inArchive && m_archive->contains(inArchive.value()))
+        {
+            return true;
+        }
+        return m_fileSystem->exists(destination);
+    }
+
+    void GatherFiles::makeDestinationDirs(const Path& path)
+    {
+        // Still made when archiving, as the staging directories are used to check what has been gathered
+        m_fileSystem->makedirs(path);
+        auto inArchive = archivePath(path);
+        if (inArchive)
+        {
+            m_archive->addDirectory(inArchive.value());
+        }
+    }
+
+    std::optional<std::string> GatherFiles::archivePath(const Path& destination)
+    {
+        if (!m_archive)
+        {
+            return std::nullopt;
+        }
+        Path root = Common::FileSystem::join(m_tempDir->dirPath(), DIAGNOSE_FOLDER);
+        if (destination == root)
+        {
+            return m_archiveRoot;
+        }
+        if (destination.compare(0, root.size() + 1, root + "/") != 0)
+        {
+            return std::nullopt;
+        }
+        return Common::FileSystem::join(m_archiveRoot, destination.substr(root.size() + 1));
+    }
+
     void GatherFiles::copyAllOfInterestFromDir(const Path& dirPath, const Path& destination)
     {
         if (m_fileSystem->isDirectory(dirPath))
@@ -322,7 +382,7 @@ namespace diagnose
                 std::string newDestinationPath =
                     Common::FileSystem::join(destination, pluginName, possibleSubDirectory);
 
-                m_fileSystem->makedirs(newDestinationPath);
+                makeDestinationDirs(newDestinationPath);
                 std::vector<Path> files = m_fileSystem->listFiles(absolutePath);
 
                 for (const auto& file : files)
@@ -353,7 +413,7 @@ namespace diagnose
             std::string pluginName = Common::FileSystem::basename(absolutePluginPath);
             Path pluginLogDir = Common::FileSystem::join(pluginsDir, pluginName, "log");
             Path pluginDestinationLogDir = Common::FileSystem::join(destination, pluginName);
-            m_fileSystem->makedirs(pluginDestinationLogDir);
+            makeDestinationDirs(pluginDestinationLogDir);
             if (m_fileSystem->isDirectory(pluginLogDir))
             {
                 copyAllOfInterestFromDir(pluginLogDir, pluginDestinationLogDir);
@@ -375,6 +435,13 @@ namespace diagnose
 
         Path fullDest = Common::FileSystem::join(destination, "BaseFiles/diagnose.log");
 
+        if (m_archive)
+        {
+            collectFile(diagnoseLogPath, fullDest);
+            std::cout << "Copied " << diagnoseLogPath << " to the archive" << std::endl;
+            return;
+        }
+
         if (!m_fileSystem->isFile(fullDest))
         {
             m_fileSystem->removeFile(fullDest);
@@ -410,14 +477,14 @@ namespace diagnose
 
             if (!m_fileSystem->isDirectory(destinationPath))
             {
-                m_fileSystem->makedirs(destinationPath);
+                makeDestinationDirs(destinationPath);
             }
 
             for (auto& sourceFilePath : files)
             {
                 Path destinationFilePath =
                     Common::FileSystem::join(destinationPath, Common::FileSystem::basename(sourceFilePath));
-                m_fileSystem->copyFile(sourceFilePath, destinationFilePath);
+                collectFile(sourceFilePath, destinationFilePath);
             }
         }
     }
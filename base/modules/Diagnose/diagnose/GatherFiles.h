@@ -1,8 +1,13 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
+
+#include "TarArchive.h"
 
 #include "Common/FileSystem/IFileSystem.h"
 #include "Common/FileSystem/ITempDir.h"
 
+#include <memory>
+#include <optional>
+
 #pragma once
 
 namespace diagnose
@@ -83,6 +88,12 @@ namespace diagnose
          */
         Path getRootLocation();
 
+        /*
+         * Streams gathered files into archive instead of copying them, stored under archiveRoot in place of the
+         * root diagnose output folder. Must be called after createRootDir.
+         */
+        void setArchive(std::shared_ptr<TarArchive> archive, const std::string& archiveRoot);
+
     protected:
         /*
          * Creates directories
@@ -102,9 +113,19 @@ namespace diagnose
             const std::string& pluginName,
             const Path& destination);
 
+        /*
+         * Copies a file to destination, or adds it to the archive if there is one.
+         */
+        void collectFile(const Path& filePath, const Path& destination);
+        bool destinationExists(const Path& destination);
+        void makeDestinationDirs(const Path& path);
+        std::optional<std::string> archivePath(const Path& destination);
+
         std::vector<std::string> m_logFilePaths;
         std::unique_ptr<Common::FileSystem::IFileSystem> m_fileSystem;
         std::string m_installDirectory;
         std::unique_ptr<Common::FileSystem::ITempDir> m_tempDir;
+        std::shared_ptr<TarArchive> m_archive;
+        std::string m_archiveRoot;
     };
 } // namespace diagnose
@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "SystemCommands.h"
 
@@ -19,36 +19,55 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace diagnose
 {
     using namespace Common::FileSystem;
 
+    std::string diagnoseArchivePrefix()
+    {
+        Common::UtilityImpl::FormattedTime formattedTime;
+        std::string timestamp = formattedTime.currentTime();
+        std::replace(timestamp.begin(), timestamp.end(), ' ', '_');
+        return "sspl-diagnose_" + timestamp;
+    }
+
     SystemCommands::SystemCommands(const std::string& destination) : m_destination(destination) {}
 
+    void SystemCommands::setArchive(std::shared_ptr<TarArchive> archive, const std::string& archiveDirectory)
+    {
+        m_archive = std::move(archive);
+        m_archiveDirectory = archiveDirectory;
+    }
+
     int SystemCommands::runCommand(
         const std::string& command,
         std::vector<std::string> arguments,
         const std::string& filename,
         const std::vector<u_int16_t>& exitcodes,
-        const int& retries) const
+        const int& retries,
+        size_t outputLimit) const
     {
-        Path filePath = Common::FileSystem::join(m_destination, filename);
+        Path filePath = Common::FileSystem::join(m_archive ? m_archiveDirectory : m_destination, filename);
         LOGINFO("Output file path: " << filePath);
 
         try
         {
             std::string exePath = Common::UtilityImpl::SystemExecutableUtils::getSystemExecutablePath(command);
-            auto output = runCommandOutputToString(exePath, arguments, exitcodes, retries);
-            fileSystem()->writeFile(filePath, output);
+            auto output = runCommandOutputToString(exePath, arguments, exitcodes, retries, outputLimit);
+            writeOutput(filename, output);
             return EXIT_SUCCESS;
         }
         catch (std::invalid_argument& e)
         {
             LOGINFO(command << " executable not found.");
-            fileSystem()->writeFile(filePath, e.what());
+            writeOutput(filename, e.what());
         }
         catch (SystemCommandsException& e)
         {
@@ -63,17 +82,86 @@ namespace diagnose
             std::stringstream message;
             message << e.output() << "***End Of Command Output***" << std::endl
                     << "Running command failed to complete with error: " << e.what();
-            fileSystem()->writeFile(filePath, message.str());
+            writeOutput(filename, message.str());
         }
 
         return EXIT_FAILURE;
     }
 
+    void SystemCommands::runCommands(const std::vector<DiagnoseCommand>& commands, size_t concurrency) const
+    {
+        std::atomic<size_t> next{ 0 };
+        std::mutex exceptionMutex;
+        std::exception_ptr firstException;
+
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < commands.size(); i = next++)
+            {
+                const auto& command = commands[i];
+                auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    int retries = static_cast<int>(std::max<int64_t>(
+                        1, command.timeout / std::chrono::milliseconds(GL_ProcTimeoutMilliSecs)));
+                    runCommand(
+                        command.command,
+                        command.arguments,
+                        command.filename,
+                        command.exitcodes,
+                        retries,
+                        command.outputLimit);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(exceptionMutex);
+                    if (!firstException)
+                    {
+                        firstException = std::current_exception();
+                    }
+                }
+                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start);
+                LOGINFO("Gathering " << command.filename << " took " << duration.count() << "ms");
+            }
+        };
+
+        std::vector<std::thread> workers;
+        size_t threads = std::min(std::max<size_t>(concurrency, 1), commands.size());
+        for (size_t i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers)
+        {
+            thread.join();
+        }
+
+        if (firstException)
+        {
+            std::rethrow_exception(firstException);
+        }
+    }
+
+    void SystemCommands::writeOutput(const std::string& filename, const std::string& content) const
+    {
+        if (m_archive)
+        {
+            m_archive->addData(Common::FileSystem::join(m_archiveDirectory, filename), content);
+        }
+        else
+        {
+            fileSystem()->writeFile(Common::FileSystem::join(m_destination, filename), content);
+        }
+    }
+
     std::string SystemCommands::runCommandOutputToString(
         const std::string& command,
         std::vector<std::string> args,
         const std::vector<u_int16_t>& exitcodes,
-        const int& retries) const
+        const int& retries,
+        size_t outputLimit) const
     {
         std::string commandAndArgs(command);
         std::for_each(
@@ -81,7 +169,7 @@ namespace diagnose
         LOGINFO("Running: " << commandAndArgs);
 
         auto processPtr = Common::Process::createProcess();
-        processPtr->setOutputLimit(GL_10mbSize);
+        processPtr->setOutputLimit(outputLimit);
 
         processPtr->exec(command, args);
         auto period = Common::Process::milli(GL_ProcTimeoutMilliSecs);
@@ -127,30 +215,16 @@ namespace diagnose
         return output;
     }
 
-    void SystemCommands::tarDiagnoseFolder(const std::string& srcPath, const std::string& destPath) const
+    void SystemCommands::finishTarArchive(
+        TarArchive& archive,
+        const std::string& archivePath,
+        const std::string& destPath) const
     {
-        Common::UtilityImpl::FormattedTime formattedTime;
-
-        std::cout << "Running tar on: " << srcPath << std::endl;
-
-        std::string timestamp = formattedTime.currentTime();
-        std::replace(timestamp.begin(), timestamp.end(), ' ', '_');
-        std::string prefix = "sspl-diagnose_" + timestamp;
-        std::string tarfileName = prefix + ".tar.gz";
+        archive.close();
 
+        std::string tarfileName = Common::FileSystem::basename(archivePath);
         std::string tarfile = Common::FileSystem::join(destPath, tarfileName);
-        std::string prefixpath = Common::FileSystem::join(srcPath, prefix);
-        std::string oldpath = Common::FileSystem::join(srcPath, DIAGNOSE_FOLDER);
-        auto fs = fileSystem();
-        fs->moveFile(oldpath, prefixpath);
-        // use -C to move the current working directory to the temp folder holding Diagnose output
-        std::string tarCommand = "tar -czf " + tarfile + " -C '" + srcPath + "' " + prefix;
-
-        int ret = system(tarCommand.c_str());
-        if (ret != 0)
-        {
-            throw std::invalid_argument("tar file command failed");
-        }
+        fileSystem()->moveFile(archivePath, tarfile);
 
         if (!fileSystem()->isFile(tarfile))
         {
@@ -161,10 +235,7 @@ namespace diagnose
 
     void SystemCommands::zipDiagnoseFolder(const std::string& srcPath, const std::string& destPath) const
     {
-        Common::UtilityImpl::FormattedTime formattedTime;
-        std::string timestamp = formattedTime.currentTime();
-        std::replace(timestamp.begin(), timestamp.end(), ' ', '_');
-        std::string prefix = "sspl-diagnose_" + timestamp;
+        std::string prefix = diagnoseArchivePrefix();
 
         std::string prefixpath = Common::FileSystem::join(Common::FileSystem::dirName(srcPath), prefix);
         auto fs = fileSystem();
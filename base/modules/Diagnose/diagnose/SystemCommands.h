@@ -1,16 +1,37 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include "TarArchive.h"
+
 #include "Common/FileSystem/IFileSystem.h"
 
+#include <chrono>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace diagnose
 {
     constexpr int GL_10mbSize = 10 * 1024 * 1024;
     const int GL_ProcTimeoutMilliSecs = 500;
     const int GL_ProcMaxRetries = 20;
+    constexpr size_t GL_DefaultCommandConcurrency = 4;
+
+    struct DiagnoseCommand
+    {
+        std::string command;
+        std::vector<std::string> arguments;
+        std::string filename;
+        std::vector<u_int16_t> exitcodes{};
+        std::chrono::milliseconds timeout{ GL_ProcTimeoutMilliSecs * GL_ProcMaxRetries };
+        size_t outputLimit = GL_10mbSize;
+    };
+
+    /*
+     * Returns the name diagnose archives are given, and the folder they unpack to.
+     */
+    std::string diagnoseArchivePrefix();
 
     class SystemCommands
     {
@@ -25,12 +46,25 @@ namespace diagnose
             std::vector<std::string> arguments,
             const std::string& filename,
             const std::vector<u_int16_t>& exitcodes = {},
-            const int& retries = GL_ProcMaxRetries) const;
+            const int& retries = GL_ProcMaxRetries,
+            size_t outputLimit = GL_10mbSize) const;
+
+        /*
+         * Runs the commands, up to concurrency at a time, logging how long each one took.
+         * The first exception thrown by any of them is rethrown once they have all finished.
+         */
+        void runCommands(const std::vector<DiagnoseCommand>& commands, size_t concurrency) const;
+
+        /*
+         * Writes command output into archiveDirectory in archive rather than the destination directory.
+         */
+        void setArchive(std::shared_ptr<TarArchive> archive, const std::string& archiveDirectory);
 
         /*
-         * Archive the diagnose output into a tar.gz ready for sending to Sophos.
+         * Completes the tar.gz at archivePath and moves it to destPath, ready for sending to Sophos.
          */
-        void tarDiagnoseFolder(const std::string& srcPath, const std::string& destPath) const;
+        void finishTarArchive(TarArchive& archive, const std::string& archivePath, const std::string& destPath)
+            const;
         /*
          * Archive the diagnose output into a zip ready for upload to Central location
          */
@@ -41,8 +75,13 @@ namespace diagnose
             const std::string& command,
             std::vector<std::string> args,
             const std::vector<u_int16_t>& exitcodes,
-            const int& retries) const;
+            const int& retries,
+            size_t outputLimit) const;
+
+        void writeOutput(const std::string& filename, const std::string& content) const;
 
         std::string m_destination;
+        std::shared_ptr<TarArchive> m_archive;
+        std::string m_archiveDirectory;
     };
 } // namespace diagnose
@@ -0,0 +1,270 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "TarArchive.h"
+
+#include "Logger.h"
+
+#include "Common/FileSystem/IFileSystemException.h"
+#include "Common/UtilityImpl/StrError.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 512;
+    constexpr size_t NAME_SIZE = 100;
+    constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+    constexpr unsigned GZIP_BUFFER_SIZE = 128 * 1024;
+    // The largest size the 11 octal digits of a header can hold
+    constexpr off_t MAX_ENTRY_SIZE = (off_t{ 1 } << 33) - 1;
+    const char LONG_NAME_ENTRY[] = "././@LongLink";
+    // Matches FileSystemImpl, as a full device is the usual reason
+    const std::string WRITE_FAILED = ", failed to complete writing to file, check space available on device: ";
+
+    void writeOctal(char* field, size_t fieldSize, unsigned long long value)
+    {
+        // Zero padded, leaving room for the terminator
+        snprintf(field, fieldSize, "%0*llo", static_cast<int>(fieldSize - 1), value);
+    }
+
+    class FileDescriptor
+    {
+    public:
+        explicit FileDescriptor(int fd) : m_fd(fd) {}
+        ~FileDescriptor()
+        {
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+            }
+        }
+        FileDescriptor(const FileDescriptor&) = delete;
+        FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+        [[nodiscard]] int get() const { return m_fd; }
+
+    private:
+        int m_fd;
+    };
+} // namespace
+
+namespace diagnose
+{
+    TarArchive::TarArchive(const Path& path) : m_path(path), m_file(gzopen(path.c_str(), "wb6"))
+    {
+        if (m_file == nullptr)
+        {
+            throw Common::FileSystem::IFileSystemException(
+                "Unable to create " + m_path + ": " + Common::UtilityImpl::StrError(errno));
+        }
+        gzbuffer(m_file, GZIP_BUFFER_SIZE);
+    }
+
+    TarArchive::~TarArchive()
+    {
+        if (m_file != nullptr)
+        {
+            // Left without an end of archive, so it can't be mistaken for a complete one
+            gzclose(m_file);
+        }
+    }
+
+    void TarArchive::addDirectory(const std::string& archivePath)
+    {
+        std::string name = archivePath;
+        if (name.empty() || name.back() != '/')
+        {
+            name += '/';
+        }
+
+        std::lock_guard lock(m_mutex);
+        checkOpen();
+        if (m_entries.count(name) == 0)
+        {
+            writeHeader(name, 0, 0750, std::time(nullptr), '5');
+        }
+    }
+
+    void TarArchive::addData(const std::string& archivePath, const std::string& content)
+    {
+        std::lock_guard lock(m_mutex);
+        checkOpen();
+        writeHeader(archivePath, static_cast<off_t>(content.size()), 0640, std::time(nullptr), '0');
+        writeBlocks(content.data(), content.size());
+    }
+
+    bool TarArchive::addFile(const Path& filePath, const std::string& archivePath)
+    {
+        FileDescriptor fd(::open(filePath.c_str(), O_RDONLY | O_CLOEXEC));
+        struct stat statBuf
+        {
+        };
+        if (fd.get() < 0 || ::fstat(fd.get(), &statBuf) != 0 || !S_ISREG(statBuf.st_mode))
+        {
+            return false;
+        }
+        if (statBuf.st_size > MAX_ENTRY_SIZE)
+        {
+            LOGWARN("Not archiving " << filePath << ", it is too large: " << statBuf.st_size << " bytes");
+            return false;
+        }
+
+        std::lock_guard lock(m_mutex);
+        checkOpen();
+        writeHeader(archivePath, statBuf.st_size, statBuf.st_mode & 07777, statBuf.st_mtime, '0');
+
+        std::vector<char> buffer(READ_CHUNK_SIZE);
+        off_t remaining = statBuf.st_size;
+        while (remaining > 0)
+        {
+            ssize_t bytesRead =
+                ::read(fd.get(), buffer.data(), std::min(buffer.size(), static_cast<size_t>(remaining)));
+            if (bytesRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytesRead <= 0)
+            {
+                break;
+            }
+            write(buffer.data(), bytesRead);
+            remaining -= bytesRead;
+        }
+
+        if (remaining > 0)
+        {
+            LOGWARN("Could not read all of " << filePath << ", " << remaining << " bytes have been replaced by zeros");
+            std::fill(buffer.begin(), buffer.end(), 0);
+            while (remaining > 0)
+            {
+                size_t size = std::min(buffer.size(), static_cast<size_t>(remaining));
+                write(buffer.data(), size);
+                remaining -= static_cast<off_t>(size);
+            }
+        }
+        writePadding(statBuf.st_size);
+        return true;
+    }
+
+    bool TarArchive::contains(const std::string& archivePath) const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_entries.count(archivePath) > 0;
+    }
+
+    void TarArchive::close()
+    {
+        std::lock_guard lock(m_mutex);
+        checkOpen();
+
+        // The end of an archive is two empty blocks
+        const char endOfArchive[BLOCK_SIZE * 2]{};
+        write(endOfArchive, sizeof(endOfArchive));
+
+        // Buffered data is only written here, so a full device may not be noticed until now
+        errno = 0;
+        int result = gzclose(m_file);
+        int error = errno;
+        m_file = nullptr;
+        if (result == Z_ERRNO)
+        {
+            throw Common::FileSystem::IFileSystemException(
+                "Unable to complete " + m_path + WRITE_FAILED + Common::UtilityImpl::StrError(error));
+        }
+        if (result != Z_OK)
+        {
+            throw Common::FileSystem::IFileSystemException(
+                "Unable to complete " + m_path + ": zlib status " + std::to_string(result));
+        }
+    }
+
+    void TarArchive::writeHeader(
+        const std::string& archivePath,
+        off_t size,
+        mode_t mode,
+        std::time_t mtime,
+        char type)
+    {
+        if (archivePath.size() > NAME_SIZE)
+        {
+            // The name goes in the data of an entry of its own, read as the name of the entry after it
+            writeHeader(LONG_NAME_ENTRY, static_cast<off_t>(archivePath.size() + 1), 0, 0, 'L');
+            writeBlocks(archivePath.c_str(), archivePath.size() + 1);
+        }
+
+        char header[BLOCK_SIZE]{};
+        memcpy(header, archivePath.data(), std::min(archivePath.size(), NAME_SIZE));
+        writeOctal(header + 100, 8, mode);
+        writeOctal(header + 108, 8, 0);
+        writeOctal(header + 116, 8, 0);
+        writeOctal(header + 124, 12, size);
+        writeOctal(header + 136, 12, std::max<std::time_t>(mtime, 0));
+        header[156] = type;
+        // GNU magic and version, as the long name entries are a GNU extension
+        memcpy(header + 257, "ustar  ", 8);
+
+        // The checksum is calculated with its own field filled with spaces
+        memset(header + 148, ' ', 8);
+        unsigned int checksum = 0;
+        for (unsigned char c : header)
+        {
+            checksum += c;
+        }
+        writeOctal(header + 148, 7, checksum);
+
+        write(header, sizeof(header));
+        if (type != 'L')
+        {
+            m_entries.insert(archivePath);
+        }
+    }
+
+    void TarArchive::writeBlocks(const char* data, size_t size)
+    {
+        write(data, size);
+        writePadding(static_cast<off_t>(size));
+    }
+
+    void TarArchive::writePadding(off_t size)
+    {
+        size_t partial = static_cast<size_t>(size) % BLOCK_SIZE;
+        if (partial != 0)
+        {
+            const char padding[BLOCK_SIZE]{};
+            write(padding, BLOCK_SIZE - partial);
+        }
+    }
+
+    void TarArchive::write(const char* data, size_t size)
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        if (gzwrite(m_file, data, static_cast<unsigned>(size)) == 0)
+        {
+            int zlibStatus = Z_OK;
+            const char* message = gzerror(m_file, &zlibStatus);
+            throw Common::FileSystem::IFileSystemException(
+                "Unable to write to " + m_path + (zlibStatus == Z_ERRNO ? WRITE_FAILED : std::string(": ")) +
+                (message ? message : "unknown"));
+        }
+    }
+
+    void TarArchive::checkOpen() const
+    {
+        if (m_file == nullptr)
+        {
+            throw std::runtime_error(m_path + " has already been closed");
+        }
+    }
+} // namespace diagnose
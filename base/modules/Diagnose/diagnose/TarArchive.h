@@ -0,0 +1,68 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "Common/FileSystem/IFileSystem.h"
+
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <string>
+#include <sys/types.h>
+
+struct gzFile_s;
+
+namespace diagnose
+{
+    /*
+     * Writes a gzip compressed tar archive as entries are added, so the gathered files don't have to be staged
+     * on disk first. Entries can be added from several threads, each one is written whole.
+     *
+     * Names longer than the 100 characters a tar header holds are written as GNU long name entries, which GNU tar,
+     * bsdtar and Python's tarfile all read.
+     */
+    class TarArchive
+    {
+    public:
+        /*
+         * Creates the archive at path, replacing any existing file.
+         * Throws IFileSystemException if it can't be created. Adding an entry or closing the archive also throws
+         * IFileSystemException if it can't be written, for example because the device is full.
+         */
+        explicit TarArchive(const Path& path);
+        ~TarArchive();
+        TarArchive(const TarArchive&) = delete;
+        TarArchive& operator=(const TarArchive&) = delete;
+
+        void addDirectory(const std::string& archivePath);
+
+        void addData(const std::string& archivePath, const std::string& content);
+
+        /*
+         * Streams a file into the archive. The entry has the size the file had when it was opened: a file that
+         * grows while being read is cut short and one that shrinks is padded with zeros.
+         * Returns false, without adding an entry, if the file can't be opened or isn't a regular file.
+         */
+        bool addFile(const Path& filePath, const std::string& archivePath);
+
+        [[nodiscard]] bool contains(const std::string& archivePath) const;
+
+        /*
+         * Writes the end of the archive and flushes it to disk. No entries can be added afterwards.
+         * Throws IFileSystemException if the archive couldn't be completed.
+         */
+        void close();
+
+    private:
+        void writeHeader(const std::string& archivePath, off_t size, mode_t mode, std::time_t mtime, char type);
+        void writeBlocks(const char* data, size_t size);
+        void writePadding(off_t size);
+        void write(const char* data, size_t size);
+        void checkOpen() const;
+
+        Path m_path;
+        gzFile_s* m_file;
+        mutable std::mutex m_mutex;
+        std::set<std::string> m_entries;
+    };
+} // namespace diagnose
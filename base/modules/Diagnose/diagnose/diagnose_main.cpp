@@ -1,11 +1,12 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "diagnose_main.h"
 
-#include "CheckForTar.h"
 #include "GatherFiles.h"
 #include "Logger.h"
+#include "Strings.h"
 #include "SystemCommands.h"
+#include "TarArchive.h"
 
 #include "Common/ApplicationConfiguration/IApplicationPathManager.h"
 #include "Common/FileSystem/IFileSystemException.h"
@@ -15,10 +16,28 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
+namespace
+{
+    // Commands that read the journal or walk the installation can take a while on a busy machine
+    constexpr std::chrono::seconds SLOW_COMMAND_TIMEOUT{ 60 };
+
+    template<typename Step>
+    void timedStep(const std::string& name, Step&& step)
+    {
+        auto start = std::chrono::steady_clock::now();
+        step();
+        auto duration =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        LOGINFO(name << " took " << duration.count() << "ms");
+    }
+} // namespace
+
 namespace diagnose
 {
     int diagnose_main::main(int argc, char* argv[])
@@ -47,18 +66,13 @@ namespace diagnose
             }
         }
 
-        if (!diagnose::CheckForTar::isTarAvailable())
-        {
-            std::cerr << "tar command not available: unable to generate diagnose output" << std::endl;
-            return 4;
-        }
-
         try
         {
             // Set the umask for the diagnose tool to remove other users' permissions
             umask(007);
 
             Common::Logging::ConsoleFileLoggingSetup logging("diagnose");
+            auto diagnoseStart = std::chrono::steady_clock::now();
 
             const std::string installDir = Common::ApplicationConfiguration::applicationPathManager().sophosInstall();
 
@@ -71,6 +85,17 @@ namespace diagnose
             // Create the top level directory in the output directory structure
             Path gatheredfilesFolder = gatherFiles.createRootDir(outputDir);
 
+            // Locally, files are streamed straight into the tar.gz. It's written in the temporary directory, so it's
+            // cleaned up if diagnose fails, and moved to the output directory once complete.
+            std::shared_ptr<TarArchive> archive;
+            const std::string archiveRoot = diagnoseArchivePrefix();
+            const Path archivePath = Common::FileSystem::join(gatherFiles.getRootLocation(), archiveRoot + ".tar.gz");
+            if (!remote)
+            {
+                archive = std::make_shared<TarArchive>(archivePath);
+                gatherFiles.setArchive(archive, archiveRoot);
+            }
+
             // Create the dir for all the base log files etc
             Path baseFilesDir = gatherFiles.createBaseFilesDir(gatheredfilesFolder);
 
@@ -81,16 +106,19 @@ namespace diagnose
             Path systemFilesDir = gatherFiles.createSystemFilesDir(gatheredfilesFolder);
 
             // Copy all files of interest from base.
-            gatherFiles.copyBaseFiles(baseFilesDir);
+            timedStep("Gathering base files", [&]() { gatherFiles.copyBaseFiles(baseFilesDir); });
 
             // Copy additional component generated files
-            gatherFiles.copyFilesInComponentDirectories(gatheredfilesFolder);
+            timedStep(
+                "Gathering component files",
+                [&]() { gatherFiles.copyFilesInComponentDirectories(gatheredfilesFolder); });
 
             // Copy all files of interest from all the plugins.
-            gatherFiles.copyPluginFiles(pluginFilesDir);
+            timedStep("Gathering plugin files", [&]() { gatherFiles.copyPluginFiles(pluginFilesDir); });
 
             // Copy all audit log files.
-            gatherFiles.gatherAuditLogs("/var/log/audit/", systemFilesDir);
+            timedStep(
+                "Gathering audit logs", [&]() { gatherFiles.gatherAuditLogs("/var/log/audit/", systemFilesDir); });
 
             // other formats of the timestamp in '-since=<timestamp>' result in parse errors as of journalctl version
             // 237
@@ -98,71 +126,109 @@ namespace diagnose
 
             // Run any system commands that we cant to capture the output from.
             SystemCommands systemCommands(systemFilesDir);
+            if (archive)
+            {
+                systemCommands.setArchive(archive, Common::FileSystem::join(archiveRoot, SYSTEM_FOLDER));
+            }
+
+            // Sampled before the other commands run, so that their load doesn't skew the samples. They only observe
+            // the system, so they can run alongside each other.
+            const std::vector<DiagnoseCommand> samplingCommands{
+                { "top", { "-bHn1" }, "top" },
+                { "dstat", { "-a", "-m", "1", "5" }, "dstat" },
+                { "iostat", { "1", "5" }, "iostat" },
+            };
+            timedStep(
+                "Sampling system activity",
+                [&]() { systemCommands.runCommands(samplingCommands, samplingCommands.size()); });
 
-            systemCommands.runCommand("df", { "-h" }, "df");
-            systemCommands.runCommand("top", { "-bHn1" }, "top");
-            systemCommands.runCommand("dstat", { "-a", "-m", "1", "5" }, "dstat");
-            systemCommands.runCommand("iostat", { "1", "5" }, "iostat");
-            systemCommands.runCommand("hostnamectl", std::vector<std::string>(), "hostnamectl");
-            systemCommands.runCommand("uname", { "-a" }, "uname");
-            systemCommands.runCommand("lscpu", std::vector<std::string>(), "lscpu");
-            systemCommands.runCommand("lshw", std::vector<std::string>(), "lshw"); // Doesn't work on Amazon
-            systemCommands.runCommand("ls", { "-l", "/lib/systemd/system" }, "systemd");
-            systemCommands.runCommand("ls", { "-l", "/usr/lib/systemd/system" }, "usr-systemd");
-            systemCommands.runCommand("ls", { "-l", "/etc/systemd/system/multi-user.target.wants" }, "etc-systemd");
-            systemCommands.runCommand("auditctl", { "-l" }, "auditctl-rules");
-            systemCommands.runCommand("auditctl", { "-s" }, "audit-subsystem-status");
-            systemCommands.runCommand("systemctl", { "status", "auditd" }, "systemctl-status-auditd");
-            systemCommands.runCommand("systemctl", { "list-unit-files" }, "list-unit-files");
-            systemCommands.runCommand("systemctl", { "status", "sophos-spl" }, "systemctl-status-sophos-spl");
-            systemCommands.runCommand(
-                "systemctl", { "status", "sophos-spl-update" }, "systemctl-status-sophos-spl-update", { 0, 3 });
-            systemCommands.runCommand("ls", { "/etc/audisp/plugins.d/" }, "plugins.d");
-            systemCommands.runCommand(
-                "journalctl", { logCollectionInterval, "-u", "sophos-spl" }, "journalctl-sophos-spl");
-            systemCommands.runCommand("journalctl", { logCollectionInterval, "-u", "auditd" }, "journalctl-auditd");
-            systemCommands.runCommand(
-                "journalctl", { logCollectionInterval, "_TRANSPORT=audit" }, "journalctl_TRANSPORT=audit");
-            systemCommands.runCommand("journalctl", { "--since=-10days" }, "journalctl-last10days");
-            systemCommands.runCommand("ps", { "-ef" }, "ps");
-            systemCommands.runCommand("getenforce", {}, "getenforce");
-            systemCommands.runCommand("ldd", { "--version" }, "ldd-version");
-            systemCommands.runCommand("route", { "-n" }, "route");
-            systemCommands.runCommand("ip", { "route" }, "ip-route");
-            systemCommands.runCommand("dmesg", {}, "dmesg");
-            systemCommands.runCommand("env", {}, "env");
-            systemCommands.runCommand("ss", { "-an" }, "ss");
-            systemCommands.runCommand("uptime", {}, "uptime");
-            systemCommands.runCommand("mount", std::vector<std::string>(), "mount");
-            systemCommands.runCommand("pstree", { "-ap" }, "pstree");
-            systemCommands.runCommand("lsmod", std::vector<std::string>(), "lsmod");
-            systemCommands.runCommand("lspci", std::vector<std::string>(), "lspci");
-            systemCommands.runCommand("ls", { "-alR", installDir }, "ListAllFilesInSSPLDir");
-            systemCommands.runCommand("du", { "-h", installDir, "--max-depth=2" }, "DiskSpaceOfSSPL");
-            systemCommands.runCommand("ifconfig", { "-a" }, "ifconfig");
-            systemCommands.runCommand("ip", { "addr" }, "ip-addr");
-            systemCommands.runCommand("sysctl", { "-a" }, "sysctl");
-            systemCommands.runCommand("rpm", { "-qa" }, "rpm-pkgs");
-            systemCommands.runCommand("dpkg", { "--get-selections" }, "dpkg-pkgs");
-            systemCommands.runCommand("yum", { "-y", "list", "installed" }, "yum-pkgs");
-            systemCommands.runCommand("apt", { "list", "--installed" }, "apt-pkgs");
-            systemCommands.runCommand("ldconfig", { "-p" }, "ldconfig");
-            systemCommands.runCommand(Common::FileSystem::join(installDir, "plugins/deviceisolation/bin/nft"), { "list", "ruleset" }, "nft-rules");
+            // The rest are independent of each other, so they're run concurrently
+            const std::vector<DiagnoseCommand> commands{
+                { "df", { "-h" }, "df" },
+                { "hostnamectl", {}, "hostnamectl" },
+                { "uname", { "-a" }, "uname" },
+                { "lscpu", {}, "lscpu" },
+                { "lshw", {}, "lshw" }, // Doesn't work on Amazon
+                { "ls", { "-l", "/lib/systemd/system" }, "systemd" },
+                { "ls", { "-l", "/usr/lib/systemd/system" }, "usr-systemd" },
+                { "ls", { "-l", "/etc/systemd/system/multi-user.target.wants" }, "etc-systemd" },
+                { "auditctl", { "-l" }, "auditctl-rules" },
+                { "auditctl", { "-s" }, "audit-subsystem-status" },
+                { "systemctl", { "status", "auditd" }, "systemctl-status-auditd" },
+                { "systemctl", { "list-unit-files" }, "list-unit-files" },
+                { "systemctl", { "status", "sophos-spl" }, "systemctl-status-sophos-spl" },
+                { "systemctl", { "status", "sophos-spl-update" }, "systemctl-status-sophos-spl-update", { 0, 3 } },
+                { "ls", { "/etc/audisp/plugins.d/" }, "plugins.d" },
+                { "journalctl",
+                  { logCollectionInterval, "-u", "sophos-spl" },
+                  "journalctl-sophos-spl",
+                  {},
+                  SLOW_COMMAND_TIMEOUT },
+                { "journalctl",
+                  { logCollectionInterval, "-u", "auditd" },
+                  "journalctl-auditd",
+                  {},
+                  SLOW_COMMAND_TIMEOUT },
+                { "journalctl",
+                  { logCollectionInterval, "_TRANSPORT=audit" },
+                  "journalctl_TRANSPORT=audit",
+                  {},
+                  SLOW_COMMAND_TIMEOUT },
+                { "journalctl", { logCollectionInterval }, "journalctl-last10days", {}, SLOW_COMMAND_TIMEOUT },
+                { "ps", { "-ef" }, "ps" },
+                { "getenforce", {}, "getenforce" },
+                { "ldd", { "--version" }, "ldd-version" },
+                { "route", { "-n" }, "route" },
+                { "ip", { "route" }, "ip-route" },
+                { "dmesg", {}, "dmesg" },
+                { "env", {}, "env" },
+                { "ss", { "-an" }, "ss" },
+                { "uptime", {}, "uptime" },
+                { "mount", {}, "mount" },
+                { "pstree", { "-ap" }, "pstree" },
+                { "lsmod", {}, "lsmod" },
+                { "lspci", {}, "lspci" },
+                { "ls", { "-alR", installDir }, "ListAllFilesInSSPLDir", {}, SLOW_COMMAND_TIMEOUT },
+                { "du", { "-h", installDir, "--max-depth=2" }, "DiskSpaceOfSSPL", {}, SLOW_COMMAND_TIMEOUT },
+                { "ifconfig", { "-a" }, "ifconfig" },
+                { "ip", { "addr" }, "ip-addr" },
+                { "sysctl", { "-a" }, "sysctl" },
+                { "rpm", { "-qa" }, "rpm-pkgs", {}, SLOW_COMMAND_TIMEOUT },
+                { "dpkg", { "--get-selections" }, "dpkg-pkgs" },
+                { "yum", { "-y", "list", "installed" }, "yum-pkgs", {}, SLOW_COMMAND_TIMEOUT },
+                { "apt", { "list", "--installed" }, "apt-pkgs", {}, SLOW_COMMAND_TIMEOUT },
+                { "ldconfig", { "-p" }, "ldconfig" },
+                { Common::FileSystem::join(installDir, "plugins/deviceisolation/bin/nft"),
+                  { "list", "ruleset" },
+                  "nft-rules" },
+            };
+            timedStep(
+                "Running system commands",
+                [&]() { systemCommands.runCommands(commands, GL_DefaultCommandConcurrency); });
 
             // Copy any files that contain useful info to the output dir.
-            gatherFiles.copyFile("/etc/os-release", Common::FileSystem::join(systemFilesDir, "os-release"));
-            gatherFiles.copyFile("/proc/cpuinfo", Common::FileSystem::join(systemFilesDir, "cpuinfo"));
-            gatherFiles.copyFile("/proc/meminfo", Common::FileSystem::join(systemFilesDir, "meminfo"));
-            gatherFiles.copyFile("/etc/selinux/config", Common::FileSystem::join(systemFilesDir, "selinux-config"));
-            gatherFiles.copyFile("/etc/fstab", Common::FileSystem::join(systemFilesDir, "fstab"));
-            gatherFiles.copyFile("/var/log/boot.log", Common::FileSystem::join(systemFilesDir, "boot.log"));
-            gatherFiles.copyFile("/etc/rsylog.conf", Common::FileSystem::join(systemFilesDir, "rsylog.conf"));
-            gatherFiles.copyFile("/etc/hosts", Common::FileSystem::join(systemFilesDir, "hosts"));
-            gatherFiles.copyFile("/etc/resolve.conf", Common::FileSystem::join(systemFilesDir, "resolve.conf"));
-            gatherFiles.copyFile(
-                "/etc/systemd/system.conf", Common::FileSystem::join(systemFilesDir, "systemd-system.conf"));
-
-            LOGINFO("Completed gathering files.");
+            timedStep(
+                "Gathering system files",
+                [&]()
+                {
+                    gatherFiles.copyFile("/etc/os-release", Common::FileSystem::join(systemFilesDir, "os-release"));
+                    gatherFiles.copyFile("/proc/cpuinfo", Common::FileSystem::join(systemFilesDir, "cpuinfo"));
+                    gatherFiles.copyFile("/proc/meminfo", Common::FileSystem::join(systemFilesDir, "meminfo"));
+                    gatherFiles.copyFile(
+                        "/etc/selinux/config", Common::FileSystem::join(systemFilesDir, "selinux-config"));
+                    gatherFiles.copyFile("/etc/fstab", Common::FileSystem::join(systemFilesDir, "fstab"));
+                    gatherFiles.copyFile("/var/log/boot.log", Common::FileSystem::join(systemFilesDir, "boot.log"));
+                    gatherFiles.copyFile("/etc/rsylog.conf", Common::FileSystem::join(systemFilesDir, "rsylog.conf"));
+                    gatherFiles.copyFile("/etc/hosts", Common::FileSystem::join(systemFilesDir, "hosts"));
+                    gatherFiles.copyFile(
+                        "/etc/resolve.conf", Common::FileSystem::join(systemFilesDir, "resolve.conf"));
+                    gatherFiles.copyFile(
+                        "/etc/systemd/system.conf", Common::FileSystem::join(systemFilesDir, "systemd-system.conf"));
+                });
+
+            auto gatheringDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - diagnoseStart);
+            LOGINFO("Completed gathering files in " << gatheringDuration.count() << "ms.");
 
             gatherFiles.copyDiagnoseLogFile(gatheredfilesFolder);
             if (remote)
@@ -171,7 +237,7 @@ namespace diagnose
             }
             else
             {
-                systemCommands.tarDiagnoseFolder(gatherFiles.getRootLocation(), outputDir);
+                systemCommands.finishTarArchive(*archive, archivePath, outputDir);
             }
         }
         catch (std::invalid_argument& e)
@@ -184,6 +250,11 @@ namespace diagnose
             std::cerr << "File system error: " << e.what() << std::endl;
             return 3;
         }
+        catch (std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 5;
+        }
 
         return 0;
     }
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "EventReceiverImpl.h"
 
@@ -11,7 +11,9 @@ using ManagementAgent::EventReceiverImpl::EventReceiverImpl;
 
 ManagementAgent::EventReceiverImpl::EventReceiverImpl::EventReceiverImpl(
     Common::TaskQueue::ITaskQueueSharedPtr taskQueue) :
-    m_taskQueue(std::move(taskQueue)), outbreakModeController_(std::make_shared<OutbreakModeController>())
+    m_taskQueue(std::move(taskQueue)),
+    outbreakModeController_(std::make_shared<OutbreakModeController>()),
+    eventSpool_(std::make_shared<EventSpool>())
 {
 }
 
@@ -25,8 +27,20 @@ void EventReceiverImpl::receivedSendEvent(const std::string& appId, const std::s
         return;
     }
 
-    Common::TaskQueue::ITaskPtr task(new EventTask({ appId, eventXml }));
-    m_taskQueue->queueTask(std::move(task));
+    if (appId == "ALC")
+    {
+        // mcsrouter keeps the latest ALC event file to resend, so ALC events stay in files of their own
+        Common::TaskQueue::ITaskPtr task(new EventTask({ appId, eventXml }));
+        m_taskQueue->queueTask(std::move(task));
+        return;
+    }
+
+    // Events that arrive before the spool task runs are written out with it
+    if (eventSpool_->add({ appId, eventXml }))
+    {
+        Common::TaskQueue::ITaskPtr task(new EventSpoolTask(eventSpool_));
+        m_taskQueue->queueTask(std::move(task));
+    }
 }
 
 void ManagementAgent::EventReceiverImpl::EventReceiverImpl::handleAction(const std::string& actionXml)
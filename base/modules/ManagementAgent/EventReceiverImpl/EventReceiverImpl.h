@@ -1,7 +1,8 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include "EventSpool.h"
 #include "IOutbreakModeController.h"
 
 #include "Common/TaskQueue/ITaskQueue.h"
@@ -23,5 +24,6 @@ namespace ManagementAgent::EventReceiverImpl
     private:
         Common::TaskQueue::ITaskQueueSharedPtr m_taskQueue;
         IOutbreakModeControllerPtr outbreakModeController_;
+        std::shared_ptr<EventSpool> eventSpool_;
     };
 } // namespace ManagementAgent::EventReceiverImpl
@@ -0,0 +1,105 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "EventSpool.h"
+
+#include "Common/ApplicationConfiguration/IApplicationPathManager.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
+#include "ManagementAgent/LoggerImpl/Logger.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace ManagementAgent::EventReceiverImpl;
+
+namespace
+{
+    Path createSpoolBasename(size_t fileIndex)
+    {
+        auto now = std::chrono::system_clock::now();
+        std::ostringstream ost;
+        ost << "events-" << std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+        if (fileIndex > 0)
+        {
+            ost << "-" << fileIndex;
+        }
+        ost << ".spool";
+        return ost.str();
+    }
+} // namespace
+
+EventSpool::EventSpool(size_t maxEventsPerFile) : maxEventsPerFile_(std::max<size_t>(maxEventsPerFile, 1)) {}
+
+bool EventSpool::add(Event event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(std::move(event));
+    return events_.size() == 1;
+}
+
+size_t EventSpool::flush()
+{
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events.swap(events_);
+    }
+    if (events.empty())
+    {
+        return 0;
+    }
+
+    Path eventDir = Common::ApplicationConfiguration::applicationPathManager().getMcsEventFilePath();
+    Path tmpDir = Common::ApplicationConfiguration::applicationPathManager().getTempPath();
+    auto fs = Common::FileSystem::fileSystem();
+
+    size_t written = 0;
+    size_t fileIndex = 0;
+    for (auto begin = events.begin(); begin != events.end(); ++fileIndex)
+    {
+        auto end = begin + std::min<size_t>(maxEventsPerFile_, events.end() - begin);
+        std::vector<Event> fileEvents(std::make_move_iterator(begin), std::make_move_iterator(end));
+        begin = end;
+
+        Path dest = Common::FileSystem::join(eventDir, createSpoolBasename(fileIndex));
+        try
+        {
+            if (fileEvents.size() == 1)
+            {
+                // Nothing to coalesce, so keep the usual one file per event
+                fileEvents.front().send();
+            }
+            else
+            {
+                fs->writeFileAtomically(dest, serialise(fileEvents), tmpDir, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+            }
+            written += fileEvents.size();
+        }
+        catch (const Common::FileSystem::IFileSystemException& ex)
+        {
+            LOGERROR("Failed to write " << fileEvents.size() << " events for mcsrouter: " << ex.what());
+        }
+    }
+    LOGDEBUG("Sent " << written << " events to mcsrouter in " << fileIndex << " files");
+    return written;
+}
+
+std::string EventSpool::serialise(const std::vector<Event>& events)
+{
+    size_t size = 0;
+    for (const auto& event : events)
+    {
+        size += event.appId_.size() + event.eventXml_.size() + 24;
+    }
+    std::string content;
+    content.reserve(size);
+    for (const auto& event : events)
+    {
+        content += event.appId_ + " " + std::to_string(event.eventXml_.size()) + "\n";
+        content += event.eventXml_;
+        content += "\n";
+    }
+    return content;
+}
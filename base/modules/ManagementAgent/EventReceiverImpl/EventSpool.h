@@ -0,0 +1,45 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "Event.h"
+
+#include <mutex>
+#include <vector>
+
+namespace ManagementAgent::EventReceiverImpl
+{
+    /**
+     * Collects events so that a burst of them is written to the mcsrouter event directory as a few spool files
+     * instead of one file per event.
+     *
+     * A spool file is named events-<timestamp>.spool and holds one record per event:
+     * "<appId> <length of eventXml in bytes>\n<eventXml>\n"
+     * An event that is on its own when the spool is flushed is written as a normal event file.
+     */
+    class EventSpool
+    {
+    public:
+        static constexpr size_t DEFAULT_MAX_EVENTS_PER_FILE = 500;
+
+        explicit EventSpool(size_t maxEventsPerFile = DEFAULT_MAX_EVENTS_PER_FILE);
+
+        /**
+         * @return true if the spool was empty, so a flush needs to be scheduled
+         */
+        bool add(Event event);
+
+        /**
+         * Writes everything spooled so far.
+         * @return the number of events written
+         */
+        size_t flush();
+
+        static std::string serialise(const std::vector<Event>& events);
+
+    private:
+        const size_t maxEventsPerFile_;
+        std::mutex mutex_;
+        std::vector<Event> events_;
+    };
+} // namespace ManagementAgent::EventReceiverImpl
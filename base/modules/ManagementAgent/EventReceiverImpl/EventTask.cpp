@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "EventTask.h"
 
@@ -13,4 +13,14 @@ ManagementAgent::EventReceiverImpl::EventTask::EventTask(
 void ManagementAgent::EventReceiverImpl::EventTask::run()
 {
     event_.send();
-}
\ No newline at end of file
+}
+
+ManagementAgent::EventReceiverImpl::EventSpoolTask::EventSpoolTask(std::shared_ptr<EventSpool> spool) :
+    spool_(std::move(spool))
+{
+}
+
+void ManagementAgent::EventReceiverImpl::EventSpoolTask::run()
+{
+    spool_->flush();
+}
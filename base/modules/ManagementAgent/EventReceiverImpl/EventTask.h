@@ -1,12 +1,14 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "Event.h"
+#include "EventSpool.h"
 #include "IOutbreakModeController.h"
 
 #include "Common/TaskQueue/ITask.h"
 
+#include <memory>
 #include <string>
 
 namespace ManagementAgent::EventReceiverImpl
@@ -20,4 +22,17 @@ namespace ManagementAgent::EventReceiverImpl
     private:
         Event event_;
     };
+
+    /**
+     * Writes out whatever has been added to the spool by the time it runs
+     */
+    class EventSpoolTask : public virtual Common::TaskQueue::ITask
+    {
+    public:
+        explicit EventSpoolTask(std::shared_ptr<EventSpool> spool);
+        void run() override;
+
+    private:
+        std::shared_ptr<EventSpool> spool_;
+    };
 } // namespace ManagementAgent::EventReceiverImpl
@@ -1,4 +1,4 @@
-// Copyright 2021-2023 Sophos Limited. All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #include "HealthTask.h"
 
@@ -25,6 +25,7 @@ namespace ManagementAgent::HealthStatusImpl
 
         healthStatus->resetPluginHealthLists();
 
+        std::map<std::string, bool> pluginsAndPrevHealthMissing;
         for (const auto& pluginName : m_pluginManager.getRegisteredPluginNames())
         {
             bool prevHealthMissing = false;
@@ -44,9 +45,17 @@ namespace ManagementAgent::HealthStatusImpl
             {
                 prevHealthMissing = true;
             }
+            pluginsAndPrevHealthMissing[pluginName] = prevHealthMissing;
+        }
 
-            ManagementAgent::PluginCommunication::PluginHealthStatus pluginHealthStatus =
-                m_pluginManager.getHealthStatusForPlugin(pluginName, prevHealthMissing);
+        // All plugins are asked at once so one slow plugin doesn't hold up the rest
+        std::map<std::string, PluginCommunication::PluginHealthStatus> pluginHealthStatuses;
+        if (!pluginsAndPrevHealthMissing.empty())
+        {
+            pluginHealthStatuses = m_pluginManager.getHealthStatusForPlugins(pluginsAndPrevHealthMissing);
+        }
+        for (const auto& [pluginName, pluginHealthStatus] : pluginHealthStatuses)
+        {
             if (pluginHealthStatus.healthValue == 2 && !m_pluginManager.checkIfSinglePluginInRegistry(pluginName))
             {
                 m_pluginManager.removePlugin(pluginName);
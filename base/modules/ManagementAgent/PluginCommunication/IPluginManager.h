@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -13,8 +13,10 @@
 #include "ManagementAgent/HealthStatusCommon/PluginHealthStatus.h"
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 using timepoint_t = std::chrono::steady_clock::time_point;
 
@@ -189,6 +191,18 @@ namespace ManagementAgent::PluginCommunication
             const std::string& pluginName,
             bool prevHealthMissing) = 0;
 
+        /**
+         * Get the health of several plugins at once, as getHealthStatusForPlugin does for one.
+         * The plugins are asked concurrently, so a slow plugin only delays its own reply.
+         *
+         * Plugins that have not replied within the plugin request timeout are reported with health missing.
+         *
+         * @param pluginsAndPrevHealthMissing plugin names, each with whether its previous health status was missing
+         * @return Health for each plugin that is still registered
+         */
+        virtual std::map<std::string, PluginHealthStatus> getHealthStatusForPlugins(
+            const std::map<std::string, bool>& pluginsAndPrevHealthMissing) = 0;
+
         /**
          * An accessor to expose the shared health object. Needed so that other parts of
          * Management Agent can interact with this Health object.
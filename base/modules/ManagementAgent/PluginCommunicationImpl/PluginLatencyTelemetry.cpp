@@ -0,0 +1,40 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "PluginLatencyTelemetry.h"
+
+#include "Common/TelemetryHelperImpl/TelemetryHelper.h"
+
+#include <algorithm>
+
+namespace ManagementAgent::PluginCommunicationImpl
+{
+    void PluginLatencyTelemetry::recordCall(const std::string& pluginName, std::chrono::steady_clock::duration latency)
+    {
+        double latencyMs = std::chrono::duration<double, std::milli>(latency).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats& stats = m_stats[pluginName];
+        ++stats.calls;
+        stats.totalMs += latencyMs;
+        stats.maxMs = std::max(stats.maxMs, latencyMs);
+        locked_publish(pluginName, stats);
+    }
+
+    void PluginLatencyTelemetry::recordMissedDeadline(const std::string& pluginName)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats& stats = m_stats[pluginName];
+        ++stats.missedDeadlines;
+        locked_publish(pluginName, stats);
+    }
+
+    void PluginLatencyTelemetry::locked_publish(const std::string& pluginName, const Stats& stats)
+    {
+        auto& telemetry = Common::Telemetry::TelemetryHelper::getInstance();
+        std::string prefix = "plugin-rpc-latency." + pluginName + ".";
+        telemetry.set(prefix + "calls", stats.calls);
+        telemetry.set(prefix + "missed-deadlines", stats.missedDeadlines);
+        telemetry.set(prefix + "avg-ms", stats.calls == 0 ? 0.0 : stats.totalMs / stats.calls);
+        telemetry.set(prefix + "max-ms", stats.maxMs);
+    }
+} // namespace ManagementAgent::PluginCommunicationImpl
@@ -0,0 +1,41 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ManagementAgent::PluginCommunicationImpl
+{
+    /**
+     * Keeps a running summary of how long each plugin takes to answer requests from Management Agent,
+     * and publishes it to telemetry under plugin-rpc-latency.<plugin name>
+     */
+    class PluginLatencyTelemetry
+    {
+    public:
+        void recordCall(const std::string& pluginName, std::chrono::steady_clock::duration latency);
+
+        /**
+         * Record that a plugin had not answered by the deadline of a fan-out request.
+         * The call itself is still recorded by recordCall when it finishes.
+         */
+        void recordMissedDeadline(const std::string& pluginName);
+
+    private:
+        struct Stats
+        {
+            unsigned long calls = 0;
+            unsigned long missedDeadlines = 0;
+            double totalMs = 0;
+            double maxMs = 0;
+        };
+
+        void locked_publish(const std::string& pluginName, const Stats& stats);
+
+        std::mutex m_mutex;
+        std::map<std::string, Stats> m_stats;
+    };
+} // namespace ManagementAgent::PluginCommunicationImpl
@@ -20,7 +20,12 @@
 #include <sys/stat.h>
 
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <set>
 #include <thread>
 
 namespace
@@ -40,16 +45,137 @@ namespace
         }
         return "";
     }
+
+    // Upper limit on the threads calling plugins at once; further calls wait for one of them
+    constexpr size_t MAX_CONCURRENT_PLUGIN_CALLS = 16;
+    // Allowance on top of the plugin request timeout, so a plugin that answers just inside it isn't missed
+    constexpr std::chrono::milliseconds PLUGIN_REPLY_GRACE{ 500 };
+
+    // Records how long a request to a plugin took, whether or not it succeeded
+    class LatencyRecorder
+    {
+    public:
+        LatencyRecorder(
+            ManagementAgent::PluginCommunicationImpl::PluginLatencyTelemetry& telemetry,
+            const std::string& pluginName) :
+            m_telemetry(telemetry), m_pluginName(pluginName), m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~LatencyRecorder()
+        {
+            try
+            {
+                m_telemetry.recordCall(m_pluginName, std::chrono::steady_clock::now() - m_start);
+            }
+            catch (const std::exception& ex)
+            {
+                LOGDEBUG("Failed to record latency for " << m_pluginName << ": " << ex.what());
+            }
+        }
+
+        LatencyRecorder(const LatencyRecorder&) = delete;
+        LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    private:
+        ManagementAgent::PluginCommunicationImpl::PluginLatencyTelemetry& m_telemetry;
+        const std::string& m_pluginName;
+        std::chrono::steady_clock::time_point m_start;
+    };
 } // namespace
 
 namespace ManagementAgent::PluginCommunicationImpl
 {
+    // Bounded pool of threads running fan-out calls. Threads are started as they are needed, up to maxThreads, and
+    // kept for later fan-outs. They are joined on destruction so that none can outlive the PluginManager and the
+    // ZMQ context its proxies use.
+    class PluginManager::BackgroundCalls
+    {
+    public:
+        explicit BackgroundCalls(size_t maxThreads) : m_maxThreads(maxThreads) {}
+
+        ~BackgroundCalls()
+        {
+            joinAll();
+        }
+
+        void start(std::function<void()> work)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_work.size() + 1 > m_idleThreads && m_threads.size() < m_maxThreads)
+            {
+                try
+                {
+                    m_threads.emplace_back([this]() { runWork(); });
+                }
+                catch (const std::system_error&)
+                {
+                    // The threads already running will get to the work
+                    if (m_threads.empty())
+                    {
+                        throw;
+                    }
+                }
+            }
+            m_work.push_back(std::move(work));
+            m_workAvailable.notify_one();
+        }
+
+        // Waits for the calls already running. Calls that haven't started are dropped.
+        void joinAll()
+        {
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+                m_work.clear();
+                threads.swap(m_threads);
+            }
+            m_workAvailable.notify_all();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        void runWork()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                ++m_idleThreads;
+                m_workAvailable.wait(lock, [this]() { return m_stopping || !m_work.empty(); });
+                --m_idleThreads;
+                if (m_stopping)
+                {
+                    return;
+                }
+                auto work = std::move(m_work.front());
+                m_work.pop_front();
+                lock.unlock();
+                work();
+                lock.lock();
+            }
+        }
+
+        const size_t m_maxThreads;
+        std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::deque<std::function<void()>> m_work;
+        std::vector<std::thread> m_threads;
+        size_t m_idleThreads = 0;
+        bool m_stopping = false;
+    };
+
     PluginManager::PluginManager(Common::ZMQWrapperApi::IContextSharedPtr context) :
         m_context(std::move(context)),
         m_healthStatus(std::make_shared<ManagementAgent::HealthStatusImpl::HealthStatus>()),
         m_serverCallbackHandler(),
         m_defaultTimeout(5000),
-        m_defaultConnectTimeout(5000)
+        m_defaultConnectTimeout(5000),
+        m_latencyTelemetry(std::make_shared<PluginLatencyTelemetry>()),
+        m_backgroundCalls(std::make_unique<BackgroundCalls>(MAX_CONCURRENT_PLUGIN_CALLS))
     {
         auto replier = m_context->getReplier();
         setTimeouts(*replier);
@@ -83,6 +209,8 @@ namespace ManagementAgent::PluginCommunicationImpl
             // Need to stop and join the reactor before we delete it
             m_serverCallbackHandler->stopAndJoin();
         }
+        // Background calls are bounded by the socket timeouts
+        m_backgroundCalls->joinAll();
     }
 
     void PluginManager::setServerCallback(
@@ -123,25 +251,34 @@ namespace ManagementAgent::PluginCommunicationImpl
             LOGDEBUG("PluginManager: apply new policy: " << appId << " to plugin: " << pluginName);
         }
 
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+        std::vector<std::pair<std::string, PluginProxyPtr>> plugins;
+        {
+            std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+            for (auto& [registeredPluginName, registeredProxy] : m_RegisteredPlugins)
+            {
+                if (registeredProxy->hasPolicyAppId(appId) &&
+                    (pluginName.empty() || registeredPluginName == pluginName))
+                {
+                    plugins.emplace_back(registeredPluginName, registeredProxy);
+                }
+            }
+        }
 
         // Keep a list of plugins we failed to communicate with
         std::vector<std::pair<std::string, std::string>> pluginNamesAndErrors;
 
         int pluginsNotified = 0;
-        for (auto& [registeredPluginName, registeredProxy] : m_RegisteredPlugins)
+        for (auto& [registeredPluginName, registeredProxy] : plugins)
         {
-            if (registeredProxy->hasPolicyAppId(appId) && (pluginName.empty() || registeredPluginName == pluginName))
+            try
             {
-                try
-                {
-                    registeredProxy->applyNewPolicy(appId, policyXml);
-                    ++pluginsNotified;
-                }
-                catch (std::exception& ex)
-                {
-                    pluginNamesAndErrors.emplace_back(registeredPluginName, ex.what());
-                }
+                LatencyRecorder latency(*m_latencyTelemetry, registeredPluginName);
+                registeredProxy->applyNewPolicy(appId, policyXml);
+                ++pluginsNotified;
+            }
+            catch (std::exception& ex)
+            {
+                pluginNamesAndErrors.emplace_back(registeredPluginName, ex.what());
             }
         }
         // If we failed to communicate with plugins, check they are still installed. If not, remove them from
@@ -156,25 +293,33 @@ namespace ManagementAgent::PluginCommunicationImpl
         const std::string& correlationId)
     {
         LOGDEBUG("PluginManager: Queue action " << appId);
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+        std::vector<std::pair<std::string, PluginProxyPtr>> plugins;
+        {
+            std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+            for (auto& proxy : m_RegisteredPlugins)
+            {
+                if (proxy.second->hasActionAppId(appId))
+                {
+                    plugins.emplace_back(proxy);
+                }
+            }
+        }
 
         // Keep a list of plugins we failed to communicate with
         std::vector<std::pair<std::string, std::string>> pluginNamesAndErrors;
 
         int pluginsNotified = 0;
-        for (auto& proxy : m_RegisteredPlugins)
+        for (auto& proxy : plugins)
         {
-            if (proxy.second->hasActionAppId(appId))
+            try
             {
-                try
-                {
-                    proxy.second->queueAction(appId, actionXml, correlationId);
-                    ++pluginsNotified;
-                }
-                catch (std::exception& ex)
-                {
-                    pluginNamesAndErrors.emplace_back(proxy.first, ex.what());
-                }
+                LatencyRecorder latency(*m_latencyTelemetry, proxy.first);
+                proxy.second->queueAction(appId, actionXml, correlationId);
+                ++pluginsNotified;
+            }
+            catch (std::exception& ex)
+            {
+                pluginNamesAndErrors.emplace_back(proxy.first, ex.what());
             }
         }
 
@@ -215,6 +360,7 @@ namespace ManagementAgent::PluginCommunicationImpl
             else
             {
                 // Plugin is no longer installed, remove it from memory
+                std::lock_guard<std::mutex> lock(m_pluginMapMutex);
                 m_RegisteredPlugins.erase(plugin.first);
                 LOGINFO(plugin.first << " has been uninstalled.");
             }
@@ -232,22 +378,98 @@ namespace ManagementAgent::PluginCommunicationImpl
     std::vector<Common::PluginApi::StatusInfo> PluginManager::getStatus(const std::string& pluginName)
     {
         LOGDEBUG("PluginManager: get status " << pluginName);
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
-        return getPlugin(pluginName)->getStatus();
+        auto plugin = getPlugin(pluginName);
+        LatencyRecorder latency(*m_latencyTelemetry, pluginName);
+        return plugin->getStatus();
     }
 
     std::string PluginManager::getTelemetry(const std::string& pluginName)
     {
         LOGDEBUG("PluginManager: get telemetry " << pluginName);
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
-        return getPlugin(pluginName)->getTelemetry();
+        auto plugin = getPlugin(pluginName);
+        LatencyRecorder latency(*m_latencyTelemetry, pluginName);
+        return plugin->getTelemetry();
     }
 
     std::string PluginManager::getHealth(const std::string& pluginName)
     {
         LOGDEBUG("PluginManager: get health " << pluginName);
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
-        return getPlugin(pluginName)->getHealth();
+        auto plugin = getPlugin(pluginName);
+        LatencyRecorder latency(*m_latencyTelemetry, pluginName);
+        return plugin->getHealth();
+    }
+
+    template<typename Result>
+    std::map<std::string, Result> PluginManager::callPluginsConcurrently(
+        const std::vector<std::pair<std::string, PluginProxyPtr>>& plugins,
+        std::chrono::milliseconds timeout,
+        std::function<Result(const std::string&, Common::PluginCommunication::IPluginProxy&)> call)
+    {
+        struct Replies
+        {
+            std::mutex mutex;
+            std::condition_variable replied;
+            std::map<std::string, Result> results;
+            std::set<std::string> answered;
+            size_t remaining = 0;
+        };
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        auto replies = std::make_shared<Replies>();
+        replies->remaining = plugins.size();
+
+        for (const auto& [pluginName, plugin] : plugins)
+        {
+            // Only shared state is captured, as the call may outlive this function
+            auto work = [replies,
+                         call,
+                         pluginName = pluginName,
+                         plugin = plugin,
+                         latencyTelemetry = m_latencyTelemetry]()
+            {
+                std::optional<Result> result;
+                try
+                {
+                    LatencyRecorder latency(*latencyTelemetry, pluginName);
+                    result = call(pluginName, *plugin);
+                }
+                catch (const std::exception& ex)
+                {
+                    LOGDEBUG("Request to " << pluginName << " failed: " << ex.what());
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(replies->mutex);
+                    if (result)
+                    {
+                        replies->results.emplace(pluginName, std::move(*result));
+                    }
+                    replies->answered.insert(pluginName);
+                    --replies->remaining;
+                    replies->replied.notify_all();
+                }
+            };
+
+            try
+            {
+                m_backgroundCalls->start(work);
+            }
+            catch (const std::system_error& ex)
+            {
+                LOGWARN("Failed to start thread for " << pluginName << ", calling it directly: " << ex.what());
+                work();
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(replies->mutex);
+        replies->replied.wait_until(lock, deadline, [&replies]() { return replies->remaining == 0; });
+        for (const auto& plugin : plugins)
+        {
+            if (replies->answered.count(plugin.first) == 0)
+            {
+                m_latencyTelemetry->recordMissedDeadline(plugin.first);
+            }
+        }
+        return replies->results;
     }
 
     bool PluginManager::isThreatResetTask(const std::string& xml)
@@ -316,18 +538,19 @@ namespace ManagementAgent::PluginCommunicationImpl
         auto requester = m_context->getRequester();
         Common::PluginApiImpl::PluginResourceManagement::setupRequester(
             *requester, pluginName, m_defaultTimeout, m_defaultConnectTimeout);
-        std::unique_ptr<Common::PluginCommunication::IPluginProxy> proxyPlugin =
-            std::make_unique<Common::PluginCommunicationImpl::PluginProxy>(std::move(requester), pluginName);
+        PluginProxyPtr proxyPlugin =
+            std::make_shared<Common::PluginCommunicationImpl::PluginProxy>(std::move(requester), pluginName);
         m_RegisteredPlugins[pluginName] = std::move(proxyPlugin);
         return m_RegisteredPlugins[pluginName].get();
     }
 
-    Common::PluginCommunication::IPluginProxy* PluginManager::getPlugin(const std::string& pluginName)
+    PluginManager::PluginProxyPtr PluginManager::getPlugin(const std::string& pluginName)
     {
+        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
         auto found = m_RegisteredPlugins.find(pluginName);
         if (found != m_RegisteredPlugins.end())
         {
-            return found->second.get();
+            return found->second;
         }
         throw Common::PluginCommunication::IPluginCommunicationException("Tried to access non-registered plugin");
     }
@@ -402,12 +625,86 @@ namespace ManagementAgent::PluginCommunicationImpl
         const std::string& pluginName,
         bool prevHealthMissing)
     {
-        std::lock_guard<std::mutex> lock(m_pluginMapMutex);
-        auto plugin = getPlugin(pluginName);
+        PluginProxyPtr plugin;
+        ManagementAgent::PluginCommunication::PluginHealthStatus pluginHealthStatus;
+        {
+            // Plugin details are updated under the map lock
+            std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+            auto found = m_RegisteredPlugins.find(pluginName);
+            if (found == m_RegisteredPlugins.end())
+            {
+                throw Common::PluginCommunication::IPluginCommunicationException(
+                    "Tried to access non-registered plugin");
+            }
+            plugin = found->second;
+            pluginHealthStatus = getHealthTypeForPlugin(*plugin);
+        }
+        if (pluginHealthStatus.healthType == ManagementAgent::PluginCommunication::HealthType::NONE)
+        {
+            return pluginHealthStatus;
+        }
+
+        LatencyRecorder latency(*m_latencyTelemetry, pluginName);
+        return queryPluginHealth(*plugin, pluginName, pluginHealthStatus, prevHealthMissing);
+    }
+
+    std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus> PluginManager::
+        getHealthStatusForPlugins(const std::map<std::string, bool>& pluginsAndPrevHealthMissing)
+    {
+        std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus> healthStatuses;
+        std::vector<std::pair<std::string, PluginProxyPtr>> pluginsToQuery;
+        {
+            std::lock_guard<std::mutex> lock(m_pluginMapMutex);
+            for (const auto& [pluginName, prevHealthMissing] : pluginsAndPrevHealthMissing)
+            {
+                auto found = m_RegisteredPlugins.find(pluginName);
+                if (found == m_RegisteredPlugins.end())
+                {
+                    continue;
+                }
+                healthStatuses[pluginName] = getHealthTypeForPlugin(*found->second);
+                if (healthStatuses[pluginName].healthType != ManagementAgent::PluginCommunication::HealthType::NONE)
+                {
+                    pluginsToQuery.emplace_back(*found);
+                }
+            }
+        }
+
+        auto replies = callPluginsConcurrently<ManagementAgent::PluginCommunication::PluginHealthStatus>(
+            pluginsToQuery,
+            // Any plugin that can still answer within its request timeout is waited for
+            std::chrono::milliseconds(m_defaultTimeout) + PLUGIN_REPLY_GRACE,
+            [pluginsAndPrevHealthMissing, healthTypes = healthStatuses](
+                const std::string& pluginName, Common::PluginCommunication::IPluginProxy& plugin)
+            {
+                return queryPluginHealth(
+                    plugin, pluginName, healthTypes.at(pluginName), pluginsAndPrevHealthMissing.at(pluginName));
+            });
 
-        bool serviceHealth = plugin->getServiceHealth();
-        bool threatServiceHealth = plugin->getThreatServiceHealth();
-        std::string displayName = plugin->getDisplayPluginName();
+        for (const auto& [pluginName, plugin] : pluginsToQuery)
+        {
+            auto reply = replies.find(pluginName);
+            if (reply != replies.end())
+            {
+                healthStatuses[pluginName] = reply->second;
+            }
+            else
+            {
+                if (!pluginsAndPrevHealthMissing.at(pluginName))
+                {
+                    LOGWARN("Timed out getting health for service " << plugin->getDisplayPluginName());
+                }
+                healthStatuses[pluginName].healthValue = 2;
+            }
+        }
+        return healthStatuses;
+    }
+
+    ManagementAgent::PluginCommunication::PluginHealthStatus PluginManager::getHealthTypeForPlugin(
+        Common::PluginCommunication::IPluginProxy& plugin)
+    {
+        bool serviceHealth = plugin.getServiceHealth();
+        bool threatServiceHealth = plugin.getThreatServiceHealth();
 
         ManagementAgent::PluginCommunication::PluginHealthStatus pluginHealthStatus;
         if (serviceHealth && threatServiceHealth)
@@ -426,22 +723,31 @@ namespace ManagementAgent::PluginCommunicationImpl
         {
             return pluginHealthStatus;
         }
-        pluginHealthStatus.displayName = displayName;
+        pluginHealthStatus.displayName = plugin.getDisplayPluginName();
+        return pluginHealthStatus;
+    }
+
+    ManagementAgent::PluginCommunication::PluginHealthStatus PluginManager::queryPluginHealth(
+        Common::PluginCommunication::IPluginProxy& plugin,
+        const std::string& pluginName,
+        ManagementAgent::PluginCommunication::PluginHealthStatus pluginHealthStatus,
+        bool prevHealthMissing)
+    {
         std::string health;
 
         try
         {
-            health = plugin->getHealth();
+            health = plugin.getHealth();
             if (prevHealthMissing)
             {
-                LOGINFO("Health restored for service " << plugin->getDisplayPluginName());
+                LOGINFO("Health restored for service " << plugin.getDisplayPluginName());
             }
         }
         catch (const Common::PluginCommunication::IPluginCommunicationException&)
         {
             if (!prevHealthMissing)
             {
-                LOGWARN("Could not get health for service " << plugin->getDisplayPluginName());
+                LOGWARN("Could not get health for service " << plugin.getDisplayPluginName());
             }
 
             pluginHealthStatus.healthValue = 2;
@@ -1,7 +1,8 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
+#include "PluginLatencyTelemetry.h"
 #include "PluginServerCallbackHandler.h"
 
 #include "Common/PluginCommunication/IPluginProxy.h"
@@ -13,9 +14,12 @@
 #include "ManagementAgent/PluginCommunication/IPluginManager.h"
 #include "ManagementAgent/PluginCommunication/IPluginServerCallback.h"
 
+#include <chrono>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace ManagementAgent::PluginCommunicationImpl
 {
@@ -60,6 +64,8 @@ namespace ManagementAgent::PluginCommunicationImpl
         ManagementAgent::PluginCommunication::PluginHealthStatus getHealthStatusForPlugin(
             const std::string& pluginName,
             bool prevHealthMissing) override;
+        std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus> getHealthStatusForPlugins(
+            const std::map<std::string, bool>& pluginsAndPrevHealthMissing) override;
 
         std::shared_ptr<ManagementAgent::HealthStatusImpl::HealthStatus> getSharedHealthStatusObj() override;
 
@@ -78,19 +84,39 @@ namespace ManagementAgent::PluginCommunicationImpl
         bool updateOngoingWithGracePeriod(unsigned int gracePeriodSeconds, timepoint_t now) override;
 
     private:
-        Common::PluginCommunication::IPluginProxy* getPlugin(const std::string& pluginName);
+        using PluginProxyPtr = std::shared_ptr<Common::PluginCommunication::IPluginProxy>;
+        class BackgroundCalls;
+
+        /**
+         * Finds a registered plugin. The proxy can be used after m_pluginMapMutex is released,
+         * so a request to one plugin doesn't block requests to the others.
+         */
+        PluginProxyPtr getPlugin(const std::string& pluginName);
+
+        /**
+         * Calls the plugins on a bounded pool of threads and waits up to timeout for the replies.
+         * Calls still running at the deadline are left to finish in the background, and are waited for when the
+         * PluginManager is destroyed.
+         */
+        template<typename Result>
+        std::map<std::string, Result> callPluginsConcurrently(
+            const std::vector<std::pair<std::string, PluginProxyPtr>>& plugins,
+            std::chrono::milliseconds timeout,
+            std::function<Result(const std::string&, Common::PluginCommunication::IPluginProxy&)> call);
 
         void setTimeouts(Common::ZeroMQWrapper::ISocketSetup& socket);
 
         Common::ZMQWrapperApi::IContextSharedPtr m_context;
         Common::ZeroMQWrapper::IProxyPtr m_proxy;
-        std::map<std::string, std::unique_ptr<Common::PluginCommunication::IPluginProxy>> m_RegisteredPlugins;
+        std::map<std::string, PluginProxyPtr> m_RegisteredPlugins;
         std::shared_ptr<ManagementAgent::HealthStatusImpl::HealthStatus> m_healthStatus;
         std::unique_ptr<PluginServerCallbackHandler> m_serverCallbackHandler;
         PluginCommunication::IEventReceiverPtr eventReceiver_;
         int m_defaultTimeout;
         int m_defaultConnectTimeout;
         std::mutex m_pluginMapMutex;
+        std::shared_ptr<PluginLatencyTelemetry> m_latencyTelemetry;
+        std::unique_ptr<BackgroundCalls> m_backgroundCalls;
 
         /**
          * Create a plugin, always re-creating it
@@ -145,5 +171,21 @@ namespace ManagementAgent::PluginCommunicationImpl
         static bool isThreatResetTask(const std::string& filePath);
 
         bool updateOngoing();
+
+        /**
+         * Gets the health of a plugin that reports health, as described by status, which must come from
+         * getHealthTypeForPlugin.
+         */
+        static ManagementAgent::PluginCommunication::PluginHealthStatus queryPluginHealth(
+            Common::PluginCommunication::IPluginProxy& plugin,
+            const std::string& pluginName,
+            ManagementAgent::PluginCommunication::PluginHealthStatus status,
+            bool prevHealthMissing);
+
+        /**
+         * Which health the plugin reports, without contacting it
+         */
+        static ManagementAgent::PluginCommunication::PluginHealthStatus getHealthTypeForPlugin(
+            Common::PluginCommunication::IPluginProxy& plugin);
     };
 } // namespace ManagementAgent::PluginCommunicationImpl
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "PluginServerCallbackHandler.h"
 
@@ -30,9 +30,13 @@ namespace ManagementAgent::PluginCommunicationImpl
             switch (request.m_command)
             {
                 case Commands::PLUGIN_SEND_EVENT:
-                    m_serverCallback->receivedSendEvent(
-                        request.m_applicationId, m_messageBuilder.requestExtractEvent(request));
-                    return m_messageBuilder.replyAckMessage(request);
+                    // Plugins may send a batch of events for one appId in a single message, once the
+                    // acknowledgement has told them it is supported
+                    for (const auto& eventXml : m_messageBuilder.requestExtractEvents(request))
+                    {
+                        m_serverCallback->receivedSendEvent(request.m_applicationId, eventXml);
+                    }
+                    return m_messageBuilder.replyAckEventsMessage(request);
                 case Commands::PLUGIN_SEND_STATUS:
                     m_serverCallback->receivedChangeStatus(
                         request.m_applicationId, m_messageBuilder.requestExtractStatus(request));
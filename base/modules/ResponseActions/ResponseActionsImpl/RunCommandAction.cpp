@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "RunCommandAction.h"
 
@@ -197,7 +197,7 @@ SingleCommandResult RunCommandAction::runCommand(const std::string& command)
         // RA plugin gives action runner 30 - 2 seconds to complete during shutdown so -4 here to give plugin some time
         // to cleanup whilst letting this process finish its own cleanup
         // If secondsBeforeSIGKILL was 30 - 3 then RA would end up killing action runner (this process' parent) whilst
-        // this process' execution was at around cacheResult() in BoostProcessHolder.cpp
+        // this process' execution was waiting for the child's result in SupervisedProcessHolder.cpp
         int secondsBeforeSIGKILL = 30 - 4;
         if (process->kill(secondsBeforeSIGKILL))
         {
@@ -84,60 +84,61 @@ namespace ResponseActionsImpl
         std::string zipName = Common::FileSystem::subdirNameFromPath(info.targetPath) + ".zip";
         m_pathToUpload = Common::FileSystem::join(tmpdir, zipName);
         int ret;
+        // The zip is hashed as it is written and abandoned as soon as it passes the size limit,
+        // rather than compressing the whole folder and then reading the zip back to check and hash it
+        Common::ZipUtilities::ZipOutputInfo zipInfo;
         try
         {
-            if (info.password.empty())
-            {
-                ret = Common::ZipUtilities::zipUtils().zip(info.targetPath, m_pathToUpload, false);
-            }
-            else
-            {
-                ret = Common::ZipUtilities::zipUtils().zip(info.targetPath, m_pathToUpload, false, true, info.password);
-            }
+            ret = Common::ZipUtilities::zipUtils().zip(
+                info.targetPath, m_pathToUpload, false, !info.password.empty(), info.password, info.maxSize, zipInfo);
         }
         catch (const std::runtime_error&)
         {
             // logging is done in the zip util
             ret = 1;
         }
-        if (ret != 0)
+        if (zipInfo.exceededMaxSize)
         {
             std::stringstream error;
-            error << "Error zipping " << info.targetPath;
+            error << "Folder at path " << info.targetPath << " after being compressed is above the size limit "
+                  << info.maxSize << " bytes";
             LOGWARN(error.str());
-            ActionsUtils::setErrorInfo(response, 3, error.str());
+            ActionsUtils::setErrorInfo(response, 1, error.str(), "exceed_size_limit");
             return;
         }
-
-        response["sizeBytes"] = fs->fileSize(m_pathToUpload);
-        if (response["sizeBytes"] > info.maxSize)
+        if (ret != 0)
         {
             std::stringstream error;
-            error << "Folder at path " << info.targetPath + " after being compressed is size " << response["sizeBytes"]
-                  << " bytes which is above the size limit " << info.maxSize << " bytes";
+            error << "Error zipping " << info.targetPath;
             LOGWARN(error.str());
-            ActionsUtils::setErrorInfo(response, 1, error.str(), "exceed_size_limit");
+            ActionsUtils::setErrorInfo(response, 3, error.str());
             return;
         }
 
-        std::string sha256;
-
-        try
+        response["sizeBytes"] = zipInfo.sizeBytes;
+        if (!zipInfo.sha256.empty())
         {
-            response["sha256"] = fs->calculateDigest(Common::SslImpl::Digest::sha256, m_pathToUpload);
+            response["sha256"] = zipInfo.sha256;
         }
-        catch (const Common::FileSystem::IFileSystemException&)
-        {
-            std::string error = "Zip file to be uploaded cannot be accessed";
-            ActionsUtils::setErrorInfo(response, 1, error, "access_denied");
-            return;
-        }
-        catch (const std::exception& exception)
+        else
         {
-            std::stringstream error;
-            error << "Unknown error when calculating digest of zip file :" << exception.what();
-            ActionsUtils::setErrorInfo(response, 1, error.str());
-            return;
+            try
+            {
+                response["sha256"] = fs->calculateDigest(Common::SslImpl::Digest::sha256, m_pathToUpload);
+            }
+            catch (const Common::FileSystem::IFileSystemException&)
+            {
+                std::string error = "Zip file to be uploaded cannot be accessed";
+                ActionsUtils::setErrorInfo(response, 1, error, "access_denied");
+                return;
+            }
+            catch (const std::exception& exception)
+            {
+                std::stringstream error;
+                error << "Unknown error when calculating digest of zip file :" << exception.what();
+                ActionsUtils::setErrorInfo(response, 1, error.str());
+                return;
+            }
         }
 
         Common::HttpRequests::Headers requestHeaders{ { "Content-Type", "application/zip" } };
@@ -0,0 +1,265 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "NativeSystemTelemetry.h"
+
+#include "Common/UtilityImpl/StringUtils.h"
+
+#include <sys/sysinfo.h>
+#include <sys/utsname.h>
+
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+    // Files in /proc and /sys report a size of zero, so read them as streams
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("Failed to read " + path);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    struct utsname getUtsname()
+    {
+        struct utsname name
+        {
+        };
+        if (::uname(&name) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "uname failed");
+        }
+        return name;
+    }
+
+    std::string stripQuotes(const std::string& value)
+    {
+        if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front())
+        {
+            return value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+
+    // The same test df uses to leave out network file systems for --local
+    bool isRemote(const std::string& source, const std::string& type)
+    {
+        static const std::set<std::string> remoteTypes{ "afs",   "auristorfs", "ceph",      "cifs",   "coda",
+                                                        "fuse.glusterfs", "fuse.sshfs", "glusterfs", "gpfs",
+                                                        "lustre", "ncpfs",     "nfs",       "nfs4",   "smb3",
+                                                        "smbfs", "sshfs",      "9p" };
+        return remoteTypes.count(type) != 0 ||
+               (source.find(':') != std::string::npos && source.front() != '/') ||
+               (source.rfind("//", 0) == 0 && (type == "smbfs" || type == "smb3" || type == "cifs"));
+    }
+
+    // Mount points in mountinfo have space, tab, newline and backslash as octal escapes
+    std::string unescapeMountPoint(const std::string& escaped)
+    {
+        std::string unescaped;
+        for (size_t i = 0; i < escaped.size(); ++i)
+        {
+            if (escaped[i] == '\\' && i + 3 < escaped.size())
+            {
+                const std::string octal = escaped.substr(i + 1, 3);
+                if (octal.find_first_not_of("01234567") == std::string::npos)
+                {
+                    unescaped += static_cast<char>(std::stoi(octal, nullptr, 8));
+                    i += 3;
+                    continue;
+                }
+            }
+            unescaped += escaped[i];
+        }
+        return unescaped;
+    }
+
+    std::optional<struct statvfs> statFileSystem(const std::string& mountPoint)
+    {
+        struct statvfs stats
+        {
+        };
+        if (::statvfs(mountPoint.c_str(), &stats) != 0)
+        {
+            return std::nullopt;
+        }
+        return stats;
+    }
+} // namespace
+
+namespace Telemetry
+{
+    NativeTelemetrySources systemTelemetryNativeSources()
+    {
+        return NativeTelemetrySources{
+            { "kernel", [] { return NativeSystemTelemetry::kernel(); } },
+            { "cpu-cores", [] { return NativeSystemTelemetry::cpuCores(); } },
+            { "memory-total", [] { return NativeSystemTelemetry::memoryTotal(); } },
+            { "locale", [] { return NativeSystemTelemetry::locale(); } },
+            { "uptime", [] { return NativeSystemTelemetry::uptime(); } },
+            { "timezone", [] { return NativeSystemTelemetry::timezone(); } },
+            { "selinux", [] { return NativeSystemTelemetry::selinux(); } },
+            { "architecture", [] { return NativeSystemTelemetry::architecture(); } },
+            { "disks", [] { return NativeSystemTelemetry::disks(); } },
+        };
+    }
+
+    namespace NativeSystemTelemetry
+    {
+        std::string kernel()
+        {
+            auto name = getUtsname();
+            return std::string("Kernel: ") + name.sysname + " " + name.release + "\n";
+        }
+
+        std::string cpuCores(const std::string& cpuInfoPath)
+        {
+            std::istringstream cpuInfo(readFile(cpuInfoPath));
+            int processors = 0;
+            for (std::string line; std::getline(cpuInfo, line);)
+            {
+                if (line.rfind("processor", 0) == 0 && line.find(':') != std::string::npos)
+                {
+                    ++processors;
+                }
+            }
+            if (processors == 0)
+            {
+                throw std::runtime_error("No processors in " + cpuInfoPath);
+            }
+            return "CPU(s): " + std::to_string(processors) + "\n";
+        }
+
+        std::string memoryTotal()
+        {
+            struct sysinfo info
+            {
+            };
+            if (::sysinfo(&info) != 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "sysinfo failed");
+            }
+            unsigned long long totalBytes =
+                (static_cast<unsigned long long>(info.totalram) + info.totalswap) * info.mem_unit;
+            return "Total: " + std::to_string(totalBytes / 1024) + "\n";
+        }
+
+        std::string locale(const std::vector<std::string>& localeConfigPaths)
+        {
+            for (const auto& path : localeConfigPaths)
+            {
+                std::string contents;
+                try
+                {
+                    contents = readFile(path);
+                }
+                catch (const std::runtime_error&)
+                {
+                    continue;
+                }
+
+                std::istringstream lines(contents);
+                for (std::string line; std::getline(lines, line);)
+                {
+                    line = Common::UtilityImpl::StringUtils::trim(line);
+                    if (line.rfind("LANG=", 0) == 0)
+                    {
+                        return "System Locale: LANG=" + stripQuotes(line.substr(5)) + "\n";
+                    }
+                }
+            }
+            throw std::runtime_error("No LANG in system locale config");
+        }
+
+        std::string uptime(const std::string& uptimePath)
+        {
+            return readFile(uptimePath);
+        }
+
+        std::string timezone()
+        {
+            ::tzset();
+            std::time_t now = std::time(nullptr);
+            struct tm local
+            {
+            };
+            if (::localtime_r(&now, &local) == nullptr)
+            {
+                throw std::runtime_error("localtime failed");
+            }
+            char zone[64];
+            if (std::strftime(zone, sizeof(zone), "%Z", &local) == 0)
+            {
+                throw std::runtime_error("No time zone name");
+            }
+            return std::string(zone) + "\n";
+        }
+
+        std::string selinux(const std::string& selinuxFsPath)
+        {
+            // Without selinuxfs, leave it to getenforce, which isn't installed on most systems without SELinux
+            std::string enforce = Common::UtilityImpl::StringUtils::trim(readFile(selinuxFsPath + "/enforce"));
+            return enforce == "1" ? "Enforcing\n" : "Permissive\n";
+        }
+
+        std::string architecture()
+        {
+            return std::string(getUtsname().machine) + "\n";
+        }
+
+        std::string disks(const std::string& mountInfoPath, const StatFileSystem& statFileSystemOverride)
+        {
+            const StatFileSystem& stat = statFileSystemOverride ? statFileSystemOverride : statFileSystem;
+            std::ostringstream output;
+            output << "Filesystem Type 1K-blocks Used Available Use% Mounted on\n";
+
+            std::istringstream mountInfo(readFile(mountInfoPath));
+            std::set<std::string> devices;
+            for (std::string line; std::getline(mountInfo, line);)
+            {
+                // <id> <parent> <major:minor> <root> <mount point> <options> [<optional fields>...] - <type> <source>
+                std::istringstream fields(line);
+                std::string id, parent, device, root, mountPoint, field, type, source;
+                fields >> id >> parent >> device >> root >> mountPoint;
+                while (fields >> field && field != "-")
+                {
+                }
+                if (!(fields >> type >> source) || isRemote(source, type) || devices.count(device) != 0)
+                {
+                    continue;
+                }
+
+                mountPoint = unescapeMountPoint(mountPoint);
+                auto stats = stat(mountPoint);
+                if (!stats || stats->f_blocks == 0)
+                {
+                    continue;
+                }
+                devices.insert(device);
+
+                auto toKiB = [&stats](unsigned long long blocks) { return blocks * stats->f_frsize / 1024; };
+                unsigned long long total = toKiB(stats->f_blocks);
+                unsigned long long used = toKiB(stats->f_blocks - stats->f_bfree);
+                unsigned long long available = toKiB(stats->f_bavail);
+                unsigned long long usedPercent =
+                    used + available == 0 ? 0
+                                          : static_cast<unsigned long long>(
+                                                std::ceil(100.0 * static_cast<double>(used) / (used + available)));
+
+                output << source << " " << type << " " << total << " " << used << " " << available << " "
+                       << usedPercent << "% " << mountPoint << "\n";
+            }
+            return output.str();
+        }
+    } // namespace NativeSystemTelemetry
+} // namespace Telemetry
@@ -0,0 +1,62 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include <sys/statvfs.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Telemetry
+{
+    /**
+     * Produces the same output as the command configured for a system telemetry item, at least the lines that the
+     * item's regex matches, without running the command. Throws if the information isn't available, in which case
+     * the command is run instead.
+     */
+    using NativeTelemetrySource = std::function<std::string()>;
+
+    /**
+     * Type representing telemetry item name and how to get the item's command output in-process.
+     */
+    using NativeTelemetrySources = std::map<std::string, NativeTelemetrySource>;
+
+    /**
+     * Sources for the items in systemTelemetryObjectsConfig and systemTelemetryArraysConfig that don't need a
+     * command. Items read from systemd unit state (apparmor, auditd) have none and still run systemctl.
+     */
+    NativeTelemetrySources systemTelemetryNativeSources();
+
+    namespace NativeSystemTelemetry
+    {
+        using StatFileSystem = std::function<std::optional<struct statvfs>(const std::string& mountPoint)>;
+
+        // As hostnamectl: "Kernel: <sysname> <release>"
+        std::string kernel();
+        // As lscpu: "CPU(s): <processors in cpuinfo>"
+        std::string cpuCores(const std::string& cpuInfoPath = "/proc/cpuinfo");
+        // As free -t: "Total: <RAM plus swap in KiB>"
+        std::string memoryTotal();
+        // As localectl: "System Locale: LANG=<LANG from the system locale config>"
+        std::string locale(const std::vector<std::string>& localeConfigPaths = { "/etc/locale.conf",
+                                                                                 "/etc/default/locale" });
+        std::string uptime(const std::string& uptimePath = "/proc/uptime");
+        // As date +%Z
+        std::string timezone();
+        // As getenforce, for systems with selinuxfs mounted
+        std::string selinux(const std::string& selinuxFsPath = "/sys/fs/selinux");
+        // As uname -m
+        std::string architecture();
+
+        /**
+         * As df -T --local: a header line then "<source> <type> <KiB> <KiB used> <KiB available> <use%> <mount>"
+         * for each local file system with blocks, reporting each device once.
+         */
+        std::string disks(
+            const std::string& mountInfoPath = "/proc/self/mountinfo",
+            const StatFileSystem& statFileSystem = {});
+    } // namespace NativeSystemTelemetry
+} // namespace Telemetry
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #include "SystemTelemetryCollectorImpl.h"
 
 #include "Common/FileSystem/IFileSystem.h"
@@ -21,9 +21,11 @@ namespace Telemetry
         Telemetry::SystemTelemetryConfig objectsConfig,
         Telemetry::SystemTelemetryConfig arraysConfig,
         unsigned waitTimeMilliSeconds,
-        unsigned waitMaxRetries) :
+        unsigned waitMaxRetries,
+        Telemetry::NativeTelemetrySources nativeSources) :
         m_objectsConfig(std::move(objectsConfig)),
         m_arraysConfig(std::move(arraysConfig)),
+        m_nativeSources(std::move(nativeSources)),
         m_waitTimeMilliSeconds(waitTimeMilliSeconds),
         m_waitMaxRetries(waitMaxRetries)
     {
@@ -37,6 +39,19 @@ namespace Telemetry
         for (auto const& [name, item] : config)
         {
             auto const& [command, commandArgs, regexp, properties] = item;
+            T values;
+            auto nativeOutput = getNativeTelemetryItem(name);
+            if (nativeOutput)
+            {
+                if (getTelemetryValuesFromCommandOutput(values, nativeOutput.value(), regexp, properties))
+                {
+                    telemetry[name] = values;
+                    continue;
+                }
+                LOGDEBUG("Failed to find telemetry item: " << name << " in-process, running command: " << command);
+                values = T{};
+            }
+
             std::string commandOutput;
 
             try
@@ -58,8 +73,6 @@ namespace Telemetry
                                                      << ", exception: " << exception.what());
             }
 
-            T values;
-
             if (getTelemetryValuesFromCommandOutput(
                     values, commandOutput, regexp, properties)) // getTelemetryValuesFromCommandOutput used depends on T
             {
@@ -83,6 +96,25 @@ namespace Telemetry
         return collect<std::vector<TelemetryItem>>(m_arraysConfig);
     }
 
+    std::optional<std::string> SystemTelemetryCollectorImpl::getNativeTelemetryItem(const std::string& name) const
+    {
+        auto source = m_nativeSources.find(name);
+        if (source == m_nativeSources.end())
+        {
+            return std::nullopt;
+        }
+
+        try
+        {
+            return source->second();
+        }
+        catch (const std::exception& exception)
+        {
+            LOGDEBUG("Failed to get telemetry item: " << name << " in-process: " << exception.what());
+        }
+        return std::nullopt;
+    }
+
     std::string SystemTelemetryCollectorImpl::getTelemetryItem(
         const std::string& command,
         std::vector<std::string> args) const
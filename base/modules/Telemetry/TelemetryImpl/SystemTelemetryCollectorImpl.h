@@ -1,13 +1,15 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
 #include "ISystemTelemetryCollector.h"
+#include "NativeSystemTelemetry.h"
 #include "SystemTelemetryConfig.h"
 
 #include "Common/Process/IProcess.h"
 
 #include <map>
+#include <optional>
 #include <regex>
 #include <string>
 #include <variant>
@@ -16,6 +18,7 @@ namespace Telemetry
 {
     /**
      * Class for collecting system telemetry into an internal data structure.
+     * Items with a native source are read in-process, and only run their command if the native source fails.
      */
     class SystemTelemetryCollectorImpl : public ISystemTelemetryCollector
     {
@@ -24,7 +27,8 @@ namespace Telemetry
             Telemetry::SystemTelemetryConfig objectsConfig,
             Telemetry::SystemTelemetryConfig arraysConfig,
             unsigned waitTimeMilliSeconds = 100,
-            unsigned waitMaxRetries = 10);
+            unsigned waitMaxRetries = 10,
+            Telemetry::NativeTelemetrySources nativeSources = {});
 
         std::map<std::string, TelemetryItem> collectObjects() const override;
 
@@ -48,10 +52,12 @@ namespace Telemetry
         std::map<std::string, T> collect(const SystemTelemetryConfig& config) const;
 
         std::string getTelemetryItem(const std::string& command, std::vector<std::string> args) const;
+        std::optional<std::string> getNativeTelemetryItem(const std::string& name) const;
         std::vector<std::string> matchSingleLine(std::istringstream& stream, const std::regex& re) const;
 
         Telemetry::SystemTelemetryConfig m_objectsConfig;
         Telemetry::SystemTelemetryConfig m_arraysConfig;
+        Telemetry::NativeTelemetrySources m_nativeSources;
         unsigned m_waitTimeMilliSeconds;
         unsigned m_waitMaxRetries;
         mutable std::map<std::string, std::string> m_commandOutputCache;
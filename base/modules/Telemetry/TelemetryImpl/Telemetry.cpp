@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "Telemetry.h"
 
@@ -65,8 +65,7 @@ namespace Telemetry
                 requester->connect(pluginSocketAddress);
 
                 telemetryProvider = std::make_shared<PluginTelemetryReporter>(
-                    std::make_unique<Common::PluginCommunicationImpl::PluginProxy>(
-                        Common::PluginCommunicationImpl::PluginProxy{ std::move(requester), pluginName }));
+                    std::make_unique<Common::PluginCommunicationImpl::PluginProxy>(std::move(requester), pluginName));
             }
             else
             {
@@ -90,7 +89,8 @@ namespace Telemetry
                 systemTelemetryObjectsConfig(),
                 systemTelemetryArraysConfig(),
                 telemetryConfig->getExternalProcessWaitTime(),
-                telemetryConfig->getExternalProcessWaitRetries()));
+                telemetryConfig->getExternalProcessWaitRetries(),
+                systemTelemetryNativeSources()));
 
         telemetryProviders.emplace_back(systemTelemetryReporter);
 
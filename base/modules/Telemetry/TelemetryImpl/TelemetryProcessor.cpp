@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "TelemetryProcessor.h"
 #include "Common/TelemetryConfigImpl/TelemetryStatus.h"
@@ -15,6 +15,7 @@
 
 #include <sys/stat.h>
 
+#include <future>
 #include <utility>
 
 using namespace Telemetry;
@@ -75,13 +76,23 @@ void TelemetryProcessor::gatherTelemetry()
 {
     LOGINFO("Gathering telemetry");
 
+    // Each plugin can take up to its socket timeout to reply, so all the providers are asked at once. If a thread
+    // can't be started the provider is asked when its reply is collected. Replies are merged in provider order.
+    std::vector<std::future<std::string>> replies;
+    replies.reserve(m_telemetryProviders.size());
     for (auto& provider : m_telemetryProviders)
     {
-        std::string name = provider->getName();
+        replies.push_back(std::async(
+            std::launch::async | std::launch::deferred, [provider]() { return provider->getTelemetry(); }));
+    }
+
+    for (size_t i = 0; i < m_telemetryProviders.size(); ++i)
+    {
+        std::string name = m_telemetryProviders[i]->getName();
 
         try
         {
-            std::string telemetry = provider->getTelemetry();
+            std::string telemetry = replies[i].get();
             LOGINFO("Gathered telemetry for " << name);
             LOGDEBUG("Telemetry data gathered: " << telemetry);
             addTelemetry(name, telemetry);
@@ -91,7 +102,6 @@ void TelemetryProcessor::gatherTelemetry()
             LOGWARN("Could not get telemetry for " << name << ". Exception: " << ex.what());
             addTelemetry(name, "{\"health\":1}");
         }
-        provider.reset();
     }
     m_telemetryProviders.clear();
 }
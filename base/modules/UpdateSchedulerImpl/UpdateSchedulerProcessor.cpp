@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "UpdateSchedulerProcessor.h"
 
@@ -100,6 +100,7 @@ namespace UpdateSchedulerImpl
         m_configfilePath(Common::ApplicationConfiguration::applicationPathManager().getSulDownloaderConfigFilePath()),
         m_previousConfigFilePath(
             Common::ApplicationConfiguration::applicationPathManager().getSulDownloaderPreviousConfigFilePath()),
+        m_reportsIndex(Common::ApplicationConfiguration::applicationPathManager().getSulDownloaderReportIndexFilePath()),
         m_formattedTime(),
         m_policyReceived(false),
         m_pendingUpdate(false),
@@ -632,7 +633,7 @@ namespace UpdateSchedulerImpl
             Common::FileSystem::join(Common::FileSystem::dirName(m_configfilePath), "supplement_only.marker");
 
         // Check if we should do a supplement-only update or not
-        time_t lastProductUpdateCheck = configModule::DownloadReportsAnalyser::getLastProductUpdateCheck();
+        time_t lastProductUpdateCheck = configModule::DownloadReportsAnalyser::getLastProductUpdateCheck(m_reportsIndex);
         UpdateSupplementDecider decider(weeklySchedule_);
         updateProducts = decider.updateProducts(lastProductUpdateCheck, UpdateNow);
 
@@ -702,7 +703,7 @@ namespace UpdateSchedulerImpl
         }
 
         LOGSUPPORT("Process reports to get events and status.");
-        ReportAndFiles reportAndFiles = configModule::DownloadReportsAnalyser::processReports();
+        ReportAndFiles reportAndFiles = configModule::DownloadReportsAnalyser::processReports(m_reportsIndex);
 
         if (reportAndFiles.sortedFilePaths.empty())
         {
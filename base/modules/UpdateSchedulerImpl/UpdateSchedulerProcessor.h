@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -15,6 +15,7 @@
 #include "UpdateScheduler/IAsyncSulDownloaderRunner.h"
 #include "UpdateScheduler/ICronSchedulerThread.h"
 #include "UpdateScheduler/SchedulerTaskQueue.h"
+#include "configModule/DownloadReportsIndex.h"
 #include "configModule/UpdatePolicyTranslator.h"
 
 namespace UpdateSchedulerImpl
@@ -91,6 +92,7 @@ namespace UpdateSchedulerImpl
         std::string m_reportfilePath;
         std::string m_configfilePath;
         std::string m_previousConfigFilePath;
+        configModule::DownloadReportsIndex m_reportsIndex;
         std::string m_machineID;
         Common::UtilityImpl::FormattedTime m_formattedTime;
         bool m_policyReceived;
@@ -1,11 +1,11 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #include "DownloadReportsAnalyser.h"
 
 #include "UpdateStatus.h"
 
 #include "Common/ApplicationConfiguration/IApplicationPathManager.h"
+#include "Common/TelemetryHelperImpl/TelemetryHelper.h"
 #include "Common/FileSystem/IFileSystem.h"
-#include "Common/UpdateUtilities/DownloadReports.h"
 #include "Common/UtilityImpl/StringUtils.h"
 #include "UpdateSchedulerImpl/common/Logger.h"
 
@@ -17,6 +17,9 @@ using namespace Common::DownloadReport;
 
 namespace
 {
+    const char* const reportAnalysisDurationTelemetryKey = "report-analysis-duration-ms";
+    const char* const reportsParsedTelemetryKey = "reports-parsed";
+
     using MessageInsert = UpdateSchedulerImpl::configModule::MessageInsert;
     using UpdateEvent = UpdateSchedulerImpl::configModule::UpdateEvent;
     using EventMessageNumber = UpdateSchedulerImpl::EventMessageNumber;
@@ -206,50 +209,43 @@ namespace UpdateSchedulerImpl::configModule
         return collectionResult;
     }
 
-    DownloadReportsAnalyser::FileAndDownloadReportVector DownloadReportsAnalyser::readSortedReports()
+    DownloadReportsAnalyser::FileAndDownloadReportVector DownloadReportsAnalyser::readSortedReports(
+        DownloadReportsIndex& reportsIndex)
     {
-        auto listOfReportFiles = Common::UpdateUtilities::listOfAllPreviousReports(
-            Common::ApplicationConfiguration::applicationPathManager().getSulDownloaderReportPath());
+        auto entries = refreshReportsIndex(reportsIndex, true);
 
         std::vector<FileAndDownloadReport> reportCollection;
-        reportCollection.reserve(listOfReportFiles.size());
-
-        const std::string processedReportPath =
-            Common::ApplicationConfiguration::applicationPathManager().getSulDownloaderProcessedReportPath();
-
-        for (const auto& filepath : listOfReportFiles)
+        reportCollection.reserve(entries.size());
+        for (auto& entry : entries)
         {
-            try
-            {
-                std::string content = Common::FileSystem::fileSystem()->readFile(filepath);
-                DownloadReport fileReport = DownloadReport::toReport(content);
-
-                // check to see if report has been processed
-                if (Common::FileSystem::fileSystem()->isFile(
-                        Common::FileSystem::join(processedReportPath, Common::FileSystem::basename(filepath))))
-                {
-                    fileReport.setProcessedReport(true);
-                }
-
-                reportCollection.push_back(FileAndDownloadReport{ filepath, fileReport, fileReport.getStartTime() });
-            }
-            catch (const std::exception& ex)
-            {
-                LOGERROR("Failed to process file: " << filepath << ": " << ex.what());
-            }
+            reportCollection.push_back(
+                FileAndDownloadReport{ entry.filepath, std::move(*entry.report), entry.summary.startTime });
         }
-        std::sort(
-            reportCollection.begin(),
-            reportCollection.end(),
-            [](const FileAndDownloadReport& lhs, const FileAndDownloadReport& rhs)
-            { return lhs.sortKey < rhs.sortKey; });
-
         return reportCollection;
     }
 
-    ReportAndFiles DownloadReportsAnalyser::processReports()
+    std::vector<DownloadReportsIndex::Entry> DownloadReportsAnalyser::refreshReportsIndex(
+        DownloadReportsIndex& reportsIndex,
+        bool needReports)
+    {
+        const auto& pathManager = Common::ApplicationConfiguration::applicationPathManager();
+
+        auto entries = reportsIndex.refresh(
+            pathManager.getSulDownloaderReportPath(), pathManager.getSulDownloaderProcessedReportPath(), needReports);
+
+        const auto& stats = reportsIndex.lastRefreshStats();
+        LOGSUPPORT(
+            "Read " << stats.parsed << " new or changed suldownloader reports and " << stats.cached
+                    << " cached reports in " << stats.duration.count() << "ms");
+        auto& telemetry = Common::Telemetry::TelemetryHelper::getInstance();
+        telemetry.appendStat(reportAnalysisDurationTelemetryKey, static_cast<double>(stats.duration.count()));
+        telemetry.increment(reportsParsedTelemetryKey, static_cast<unsigned long>(stats.parsed));
+        return entries;
+    }
+
+    ReportAndFiles DownloadReportsAnalyser::processReports(DownloadReportsIndex& reportsIndex)
     {
-        auto reportCollection = readSortedReports();
+        auto reportCollection = readSortedReports(reportsIndex);
 
         LOGSUPPORT("Process " << reportCollection.size() << " suldownloader reports");
         for (auto& entry : reportCollection)
@@ -502,25 +498,20 @@ namespace UpdateSchedulerImpl::configModule
         }
         return false;
     }
-    time_t DownloadReportsAnalyser::getLastProductUpdateCheck()
+    time_t DownloadReportsAnalyser::getLastProductUpdateCheck(DownloadReportsIndex& reportsIndex)
     {
-        auto reportCollection = readSortedReports();
-
-        if (reportCollection.empty())
-        {
-            return 0;
-        }
-        std::reverse(reportCollection.begin(), reportCollection.end());
+        // Only needs the summaries, so doesn't parse reports that are already in the index
+        auto entries = refreshReportsIndex(reportsIndex, false);
 
-        for (const auto& reportHolder : reportCollection)
+        for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry)
         {
             /*
              * Only consider successful update-checks
              * If updates are failing, then try product-update-check every time.
              */
-            if (reportHolder.report.isSuccesfulProductUpdateCheck())
+            if (entry->summary.successfulProductUpdateCheck)
             {
-                return convertStringTimeToTimet(reportHolder.report.getStartTime());
+                return convertStringTimeToTimet(entry->summary.startTime);
             }
         }
 
@@ -1,6 +1,7 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #pragma once
 
+#include "DownloadReportsIndex.h"
 #include "UpdateEvent.h"
 #include "UpdateStatus.h"
 
@@ -54,17 +55,20 @@ namespace UpdateSchedulerImpl::configModule
          *
          * It loads the SulDownloads from the directory path getSulDownloaderReportPath. Load the files into
          * DownloadReport, sort them in chronological order before passing them to the overloaded method that
-         * handles vector of DownloadReport.
+         * handles vector of DownloadReport. Only reports that are new or have changed since reportsIndex was last
+         * refreshed are parsed.
          *
+         * @param reportsIndex Index of the reports, kept by the caller between calls
          * @return ReportAndFiles
          */
-        static ReportAndFiles processReports();
+        static ReportAndFiles processReports(DownloadReportsIndex& reportsIndex);
 
         /**
          * Get the time of the last product update check, by looking at saved reports
+         * @param reportsIndex Index of the reports, kept by the caller between calls
          * @return
          */
-        static time_t getLastProductUpdateCheck();
+        static time_t getLastProductUpdateCheck(DownloadReportsIndex& reportsIndex);
 
     private:
         struct FileAndDownloadReport
@@ -74,7 +78,11 @@ namespace UpdateSchedulerImpl::configModule
             std::string sortKey;
         };
         using FileAndDownloadReportVector = std::vector<FileAndDownloadReport>;
-        static FileAndDownloadReportVector readSortedReports();
+        static FileAndDownloadReportVector readSortedReports(DownloadReportsIndex& reportsIndex);
+
+        static std::vector<DownloadReportsIndex::Entry> refreshReportsIndex(
+            DownloadReportsIndex& reportsIndex,
+            bool needReports);
 
         static ReportCollectionResult handleSuccessReports(const DownloadReportVector& reportCollection);
 
@@ -0,0 +1,202 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+#include "DownloadReportsIndex.h"
+
+#include "Common/ApplicationConfiguration/IApplicationPathManager.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/UpdateUtilities/DownloadReports.h"
+#include "UpdateSchedulerImpl/common/Logger.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <set>
+
+using Common::DownloadReport::DownloadReport;
+
+namespace UpdateSchedulerImpl::configModule
+{
+    namespace
+    {
+        constexpr int INDEX_VERSION = 1;
+
+        DownloadReportsIndex::Summary summarise(const DownloadReport& report)
+        {
+            DownloadReportsIndex::Summary summary;
+            summary.startTime = report.getStartTime();
+            summary.status = report.getStatus();
+            summary.successfulProductUpdateCheck = report.isSuccesfulProductUpdateCheck();
+            for (const auto& product : report.getProducts())
+            {
+                summary.products.push_back(product.rigidName);
+            }
+            return summary;
+        }
+    } // namespace
+
+    DownloadReportsIndex::DownloadReportsIndex(std::string indexPath) : m_indexPath(std::move(indexPath)) {}
+
+    std::vector<DownloadReportsIndex::Entry> DownloadReportsIndex::refresh(
+        const std::string& reportDirectory,
+        const std::string& processedReportDirectory,
+        bool needReports)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto* fileSystem = Common::FileSystem::fileSystem();
+        m_stats = RefreshStats{};
+
+        auto reportFiles = Common::UpdateUtilities::listOfAllPreviousReports(reportDirectory);
+        bool changed = false;
+        if (reportFiles.empty())
+        {
+            // Stale entries left in the index file are dropped by the next refresh that finds reports
+            m_reports.clear();
+        }
+        else if (!fileSystem->isFile(m_indexPath))
+        {
+            // Nothing in memory can be trusted if the index has been removed
+            m_reports.clear();
+            changed = true;
+        }
+        else if (m_reports.empty())
+        {
+            load();
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(reportFiles.size());
+        std::set<std::string> listed;
+        for (const auto& filepath : reportFiles)
+        {
+            std::string filename = Common::FileSystem::basename(filepath);
+            listed.insert(filename);
+            try
+            {
+                std::time_t modifiedTime = fileSystem->lastModifiedTime(filepath);
+                off_t size = fileSystem->fileSize(filepath);
+
+                auto cached = m_reports.find(filename);
+                if (cached != m_reports.end() && cached->second.modifiedTime == modifiedTime &&
+                    cached->second.size == size && (!needReports || cached->second.report))
+                {
+                    m_stats.cached++;
+                }
+                else
+                {
+                    // Not cached if it fails to parse, so it's reported again by the next refresh
+                    m_reports.erase(filename);
+                    DownloadReport report = DownloadReport::toReport(fileSystem->readFile(filepath));
+                    cached = m_reports.emplace(filename, CachedReport{ modifiedTime, size, summarise(report), report })
+                                 .first;
+                    m_stats.parsed++;
+                    changed = true;
+                }
+
+                CachedReport& cachedReport = cached->second;
+                bool processed = fileSystem->isFile(Common::FileSystem::join(processedReportDirectory, filename));
+                if (cachedReport.summary.processed != processed)
+                {
+                    cachedReport.summary.processed = processed;
+                    changed = true;
+                }
+
+                Entry entry{ filepath, cachedReport.summary, std::nullopt };
+                if (needReports)
+                {
+                    entry.report = cachedReport.report;
+                    entry.report->setProcessedReport(processed);
+                }
+                entries.push_back(std::move(entry));
+            }
+            catch (const std::exception& ex)
+            {
+                LOGERROR("Failed to process file: " << filepath << ": " << ex.what());
+            }
+        }
+
+        for (auto it = m_reports.begin(); it != m_reports.end();)
+        {
+            if (listed.count(it->first) == 0)
+            {
+                it = m_reports.erase(it);
+                changed = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (changed)
+        {
+            save();
+        }
+
+        std::sort(
+            entries.begin(),
+            entries.end(),
+            [](const Entry& lhs, const Entry& rhs) { return lhs.summary.startTime < rhs.summary.startTime; });
+
+        m_stats.duration =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        return entries;
+    }
+
+    void DownloadReportsIndex::load()
+    {
+        try
+        {
+            auto index = nlohmann::json::parse(Common::FileSystem::fileSystem()->readFile(m_indexPath));
+            if (index.value("version", 0) != INDEX_VERSION)
+            {
+                LOGDEBUG("Ignoring report index with a different version: " << m_indexPath);
+                return;
+            }
+            for (const auto& [filename, item] : index.at("reports").items())
+            {
+                CachedReport cached;
+                cached.modifiedTime = item.at("modifiedTime").get<std::time_t>();
+                cached.size = item.at("size").get<off_t>();
+                cached.summary.startTime = item.at("startTime").get<std::string>();
+                cached.summary.status = item.at("status").get<Common::DownloadReport::RepositoryStatus>();
+                cached.summary.successfulProductUpdateCheck = item.at("successfulProductUpdateCheck").get<bool>();
+                cached.summary.products = item.at("products").get<std::vector<std::string>>();
+                cached.summary.processed = item.at("processed").get<bool>();
+                m_reports.emplace(filename, std::move(cached));
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            LOGWARN("Failed to load report index " << m_indexPath << ", all reports will be read: " << ex.what());
+            m_reports.clear();
+        }
+    }
+
+    void DownloadReportsIndex::save() const
+    {
+        nlohmann::json reports = nlohmann::json::object();
+        for (const auto& [filename, cached] : m_reports)
+        {
+            reports[filename] = { { "modifiedTime", cached.modifiedTime },
+                                  { "size", cached.size },
+                                  { "startTime", cached.summary.startTime },
+                                  { "status", cached.summary.status },
+                                  { "successfulProductUpdateCheck", cached.summary.successfulProductUpdateCheck },
+                                  { "products", cached.summary.products },
+                                  { "processed", cached.summary.processed } };
+        }
+        nlohmann::json index = { { "version", INDEX_VERSION }, { "reports", reports } };
+
+        try
+        {
+            Common::FileSystem::fileSystem()->writeFileAtomically(
+                m_indexPath,
+                index.dump(),
+                Common::ApplicationConfiguration::applicationPathManager().getTempPath());
+        }
+        catch (const std::exception& ex)
+        {
+            // Only a cache, the reports will be read again next time
+            LOGWARN("Failed to save report index " << m_indexPath << ": " << ex.what());
+        }
+    }
+} // namespace UpdateSchedulerImpl::configModule
@@ -0,0 +1,83 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+#pragma once
+
+#include "Common/DownloadReport/DownloadReport.h"
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace UpdateSchedulerImpl::configModule
+{
+    /**
+     * Caches the SulDownloader reports so that only new or changed reports are read and parsed.
+     *
+     * A summary of each report is persisted, keyed by file name and checked against the file's modification time and
+     * size, which is enough to sort the reports and find the last product update check without parsing them. The
+     * parsed reports are also kept in memory for the life of the process, for the full analysis.
+     *
+     * The processed flag is checked on every refresh, as the processed reports directory is rewritten after each
+     * analysis.
+     */
+    class DownloadReportsIndex
+    {
+    public:
+        struct Summary
+        {
+            std::string startTime;
+            Common::DownloadReport::RepositoryStatus status = Common::DownloadReport::RepositoryStatus::UNSPECIFIED;
+            bool successfulProductUpdateCheck = false;
+            std::vector<std::string> products;
+            bool processed = false;
+        };
+
+        struct Entry
+        {
+            std::string filepath;
+            Summary summary;
+            // Only set if the refresh needed reports
+            std::optional<Common::DownloadReport::DownloadReport> report;
+        };
+
+        struct RefreshStats
+        {
+            size_t parsed = 0;
+            size_t cached = 0;
+            std::chrono::milliseconds duration{ 0 };
+        };
+
+        explicit DownloadReportsIndex(std::string indexPath);
+
+        /**
+         * Lists the reports in reportDirectory in chronological order, updating the index for new, changed and removed
+         * reports. Reports that can't be read are logged and left out.
+         * @param needReports Whether every entry must hold its parsed report, or only its summary
+         */
+        std::vector<Entry> refresh(
+            const std::string& reportDirectory,
+            const std::string& processedReportDirectory,
+            bool needReports);
+
+        [[nodiscard]] const RefreshStats& lastRefreshStats() const { return m_stats; }
+
+    private:
+        struct CachedReport
+        {
+            std::time_t modifiedTime = 0;
+            off_t size = 0;
+            Summary summary;
+            std::optional<Common::DownloadReport::DownloadReport> report;
+        };
+
+        void load();
+        void save() const;
+
+        std::string m_indexPath;
+        std::map<std::string, CachedReport> m_reports;
+        RefreshStats m_stats;
+    };
+} // namespace UpdateSchedulerImpl::configModule
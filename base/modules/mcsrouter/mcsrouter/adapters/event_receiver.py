@@ -1,5 +1,5 @@
 #!/usr/bin/env python3
-# Copyright 2019 Sophos Plc, Oxford, England.
+# Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 """
 event_receiver Module
@@ -18,6 +18,50 @@ import mcsrouter.utils.xml_helper as xml_helper
 LOGGER = logging.getLogger(__name__)
 
 
+def read_spool(file_path):
+    """
+    Split a spool file written by Management Agent into (app_id, body) pairs.
+    Each record is "<app_id> <body length in bytes>\n<body>\n".
+    Raises ValueError if the file is truncated or malformed.
+    """
+    with open(file_path, "rb") as spool_file:
+        contents = spool_file.read()
+
+    events = []
+    offset = 0
+    while offset < len(contents):
+        header_end = contents.index(b"\n", offset)
+        app_id, length = contents[offset:header_end].decode("utf-8").split(" ")
+        body_start = header_end + 1
+        body_end = body_start + int(length)
+        if body_end >= len(contents) or contents[body_end:body_end + 1] != b"\n":
+            raise ValueError("Truncated event in spool")
+        events.append((app_id, contents[body_start:body_end].decode("utf-8", errors="replace")))
+        offset = body_end + 1
+    return events
+
+
+def receive_spool(file_path):
+    """
+    Remove a spool file and yield each event that was in it
+    """
+    try:
+        time = os.path.getmtime(file_path)
+        events = read_spool(file_path)
+    except (OSError, ValueError) as ex:
+        LOGGER.error("Failed to read event spool {}: {}".format(file_path, str(ex)))
+        events = []
+    safe_remove_file(file_path)
+
+    for app_id, body in events:
+        try:
+            xml_helper.check_xml_has_no_script_tags(body)
+        except xml_helper.XMLException as ex:
+            LOGGER.error("Failed verification of XML as it contains script tags. Error: {}".format(str(ex)))
+            continue
+        yield (app_id, time, body)
+
+
 def receive():
     """
     Async receive call
@@ -27,7 +71,9 @@ def receive():
     for event_file in os.listdir(event_dir):
         match_object = re.match(r"([A-Z]*)_event-(.*).xml", event_file)
         file_path = os.path.join(event_dir, event_file)
-        if match_object:
+        if re.match(r"events-.*\.spool$", event_file):
+            yield from receive_spool(file_path)
+        elif match_object:
             app_id = match_object.group(1)
             time = os.path.getmtime(file_path)
             body = xml_helper.get_escaped_non_ascii_content(
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "PluginProxy.h"
 
@@ -41,6 +41,14 @@ PluginProxy::exit_status_t PluginProxy::checkForExit()
     return processProxyPair;
 }
 
+void PluginProxy::onRestart(std::chrono::steady_clock::duration sinceExit)
+{
+    auto latency = std::chrono::duration<double, std::milli>(sinceExit).count();
+    LOGDEBUG("Restarted " << name() << " " << latency << "ms after it exited");
+    Common::Telemetry::TelemetryHelper::getInstance().appendStat(
+        watchdog::watchdogimpl::createRestartLatencyTelemetryKeyFromPluginName(name()), latency);
+}
+
 std::string PluginProxy::name() const
 {
     return getPluginInfo().getPluginName();
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -32,6 +32,12 @@ namespace watchdog::watchdogimpl
          */
         bool updatePluginInfo(const Common::PluginRegistryImpl::PluginInfo& info);
 
+    protected:
+        /**
+         * Records how long the plugin was down for in the restart latency telemetry stat
+         */
+        void onRestart(std::chrono::steady_clock::duration sinceExit) override;
+
     private:
         /**
          * Returns a reference to the plugin info used in the plugin proxy
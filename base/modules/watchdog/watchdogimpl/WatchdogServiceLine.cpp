@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #include "WatchdogServiceLine.h"
 
 #include "Logger.h"
@@ -116,6 +116,7 @@ namespace
                     watchdog::watchdogimpl::createUnexpectedRestartTelemetryKeyFromPluginName(pluginName), 0UL);
             }
             Common::Telemetry::TelemetryHelper::getInstance().set("health", 0UL);
+            Common::Telemetry::TelemetryHelper::getInstance().updateTelemetryWithStats();
 
             try
             {
@@ -237,4 +238,11 @@ namespace watchdog::watchdogimpl
         telemetryMessage << pluginName << "-unexpected-restarts-" << code;
         return telemetryMessage.str();
     }
+
+    std::string createRestartLatencyTelemetryKeyFromPluginName(const std::string& pluginName)
+    {
+        std::stringstream telemetryMessage;
+        telemetryMessage << pluginName << "-restart-latency-ms";
+        return telemetryMessage.str();
+    }
 } // namespace watchdog::watchdogimpl
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #pragma once
 
 #include "Common/PluginApiImpl/PluginCallBackHandler.h"
@@ -23,4 +23,5 @@ namespace watchdog::watchdogimpl
 
     std::string createUnexpectedRestartTelemetryKeyFromPluginName(const std::string& pluginName);
     std::string createUnexpectedRestartTelemetryKeyFromPluginNameAndCode(const std::string& pluginName, int code);
+    std::string createRestartLatencyTelemetryKeyFromPluginName(const std::string& pluginName);
 } // namespace watchdog::watchdogimpl
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -63,6 +63,7 @@ public:
 
     MOCK_METHOD(std::string, getUpdateCertificatesPath, (), (const, override));
     MOCK_METHOD(std::string, getSulDownloaderProcessedReportPath, (), (const, override));
+    MOCK_METHOD(std::string, getSulDownloaderReportIndexFilePath, (), (const, override));
     MOCK_METHOD(std::string, getSulDownloaderPath, (), (const, override));
     MOCK_METHOD(std::string, getBaseExecutablesDir, (), (const, override));
     MOCK_METHOD(std::string, getUpdateCacheCertificateFilePath, (), (const, override));
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Common/FileSystem/IFileNotFoundException.h"
 #include "Common/FileSystem/IFilePermissions.h"
@@ -443,6 +443,42 @@ namespace
         EXPECT_THROW(m_fileSystem->openFileForRead(tempDir.absPath("Root")), IFileSystemException);
     }
 
+    TEST_F( FileSystemImplTest, openFileForWriteTruncatesAndWritesFile)
+    {
+        Tests::TempDir tempDir;
+        tempDir.makeDirs("Root/");
+        tempDir.createFile("Root/file","previous content");
+        {
+            auto file = m_fileSystem->openFileForWrite(tempDir.absPath("Root/file"));
+            *file << "hello\n" << "world";
+        }
+        EXPECT_EQ(m_fileSystem->readFile(tempDir.absPath("Root/file")), "hello\nworld");
+    }
+
+    TEST_F( FileSystemImplTest, openFileForWriteThrowsWhenDirectoryDoesNotExist)
+    {
+        Tests::TempDir tempDir;
+        EXPECT_THROW(m_fileSystem->openFileForWrite(tempDir.absPath("NotThere/file")), IFileSystemException);
+    }
+
+    TEST_F( FileSystemImplTest, openFileForAppendKeepsExistingContent)
+    {
+        Tests::TempDir tempDir;
+        tempDir.makeDirs("Root/");
+        tempDir.createFile("Root/file","previous content");
+        {
+            auto file = m_fileSystem->openFileForAppend(tempDir.absPath("Root/file"));
+            *file << ",hello" << ",world";
+        }
+        EXPECT_EQ(m_fileSystem->readFile(tempDir.absPath("Root/file")), "previous content,hello,world");
+    }
+
+    TEST_F( FileSystemImplTest, openFileForAppendThrowsWhenDirectoryDoesNotExist)
+    {
+        Tests::TempDir tempDir;
+        EXPECT_THROW(m_fileSystem->openFileForAppend(tempDir.absPath("NotThere/file")), IFileSystemException);
+    }
+
     TEST_F(FileSystemImplTest, atomicWriteStoresExpectedContentForFile)
     {
         std::string filePath = Common::FileSystem::join(m_fileSystem->currentWorkingDirectory(), "AtomicWrite.txt");
@@ -1147,6 +1183,84 @@ namespace
         EXPECT_EQ(::close(fd), 0);
     }
 
+    TEST_F(FileSystemImplTest, calculateDigestWithFdDoesNotChangeTheFileOffset)
+    {
+        const Tests::TempDir tempDir;
+        const std::string filename = "file";
+        tempDir.createFile(filename, "foo_bar_baz");
+
+        const int fd{ ::open(tempDir.absPath(filename).c_str(), O_RDONLY) };
+        ::lseek(fd, 4, SEEK_SET);
+
+        EXPECT_NO_THROW(std::ignore = m_fileSystem->calculateDigest(Common::SslImpl::Digest::md5, fd));
+        EXPECT_EQ(::lseek(fd, 0, SEEK_CUR), 4);
+
+        EXPECT_EQ(::close(fd), 0);
+    }
+
+    TEST_F(FileSystemImplTest, calculateDigestOfFileLargerThanReadBuffer)
+    {
+        const Tests::TempDir tempDir;
+        const std::string filename = "file";
+        std::string content(3 * 1024 * 1024 + 17, 'a');
+        content.back() = 'b';
+        tempDir.createFile(filename, content);
+
+        std::string digest;
+        EXPECT_NO_THROW(
+            digest = m_fileSystem->calculateDigest(Common::SslImpl::Digest::sha256, tempDir.absPath(filename)));
+        EXPECT_EQ(digest, Common::SslImpl::calculateDigest(Common::SslImpl::Digest::sha256, content));
+    }
+
+    TEST_F(FileSystemImplTest, calculateDigestFromPipe)
+    {
+        int pipeFds[2];
+        ASSERT_EQ(::pipe(pipeFds), 0);
+        const std::string content = "foo";
+        ASSERT_EQ(::write(pipeFds[1], content.data(), content.size()), static_cast<ssize_t>(content.size()));
+        EXPECT_EQ(::close(pipeFds[1]), 0);
+
+        std::string digest;
+        EXPECT_NO_THROW(digest = m_fileSystem->calculateDigest(Common::SslImpl::Digest::md5, pipeFds[0]));
+        EXPECT_EQ(digest, Common::SslImpl::calculateDigest(Common::SslImpl::Digest::md5, content));
+
+        EXPECT_EQ(::close(pipeFds[0]), 0);
+    }
+
+    TEST_F(FileSystemImplTest, calculateDigestsCalculatesEachDigestInOrder)
+    {
+        const Tests::TempDir tempDir;
+        const std::string filename = "file";
+        const std::string content = "foo_bar_baz";
+        tempDir.createFile(filename, content);
+        const std::vector<Common::SslImpl::Digest> digestNames{ Common::SslImpl::Digest::sha1,
+                                                                Common::SslImpl::Digest::sha256,
+                                                                Common::SslImpl::Digest::md5 };
+
+        std::vector<std::string> fromPath;
+        EXPECT_NO_THROW(fromPath = m_fileSystem->calculateDigests(digestNames, tempDir.absPath(filename)));
+        const int fd{ ::open(tempDir.absPath(filename).c_str(), O_RDONLY) };
+        std::vector<std::string> fromFd;
+        EXPECT_NO_THROW(fromFd = m_fileSystem->calculateDigests(digestNames, fd));
+        EXPECT_EQ(::close(fd), 0);
+
+        ASSERT_EQ(fromPath.size(), digestNames.size());
+        for (size_t i = 0; i < digestNames.size(); ++i)
+        {
+            EXPECT_EQ(fromPath[i], Common::SslImpl::calculateDigest(digestNames[i], content));
+        }
+        EXPECT_EQ(fromFd, fromPath);
+    }
+
+    TEST_F(FileSystemImplTest, calculateDigestsThrowsOnNonExistentPath)
+    {
+        const Tests::TempDir tempDir{};
+        EXPECT_THROW(
+            std::ignore = m_fileSystem->calculateDigests(
+                { Common::SslImpl::Digest::sha1, Common::SslImpl::Digest::sha256 }, tempDir.absPath("non-existent")),
+            IFileSystemException);
+    }
+
     class mockFileSystemForMoveFileTryCopy : public FileSystemImpl
     {
     public:
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -42,6 +42,8 @@ public:
     MOCK_METHOD((std::vector<std::string>), readLines, (const Path& path), (const, override));
     MOCK_METHOD((std::vector<std::string>), readLines, (const Path& path, unsigned long maxSize), (const, override));
     MOCK_METHOD(std::unique_ptr<std::istream>, openFileForRead, (const Path& path), (const, override));
+    MOCK_METHOD(std::unique_ptr<std::ostream>, openFileForWrite, (const Path& path), (const, override));
+    MOCK_METHOD(std::unique_ptr<std::ostream>, openFileForAppend, (const Path& path), (const, override));
     MOCK_METHOD(void, appendFile, (const Path& path, const std::string& content), (const, override));
     MOCK_METHOD(void, writeFile, (const Path& path, const std::string& content), (const, override));
     MOCK_METHOD(void, writeFileAtomically, (const Path& path, const std::string& content, const Path& tempDir), (const, override));
@@ -73,6 +75,8 @@ public:
     MOCK_METHOD(void, recursivelyDeleteContentsOfDirectory, (const Path& path), (const, override));
     MOCK_METHOD(std::string, calculateDigest, (Common::SslImpl::Digest digestName, const Path& path), (const, override));
     MOCK_METHOD(std::string, calculateDigest, (Common::SslImpl::Digest digestName, int fd), (const, override));
+    MOCK_METHOD(std::vector<std::string>, calculateDigests, (const std::vector<Common::SslImpl::Digest>& digestNames, const Path& path), (const, override));
+    MOCK_METHOD(std::vector<std::string>, calculateDigests, (const std::vector<Common::SslImpl::Digest>& digestNames, int fd), (const, override));
     MOCK_METHOD(std::filesystem::space_info, getDiskSpaceInfo, (const Path& path), (const, override));
     MOCK_METHOD(std::filesystem::space_info, getDiskSpaceInfo, (const Path& path, std::error_code& ec), (const, override));
     MOCK_METHOD(std::string, getSystemCommandExecutablePath, (const std::string& path), (const, override));
@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -31,6 +31,17 @@ public:
          bool passwordProtected,
          const std::string& password),
         (const, override));
+    MOCK_METHOD(
+        int,
+        zip,
+        (const std::string& srcPath,
+         const std::string& destPath,
+         bool ignoreFileError,
+         bool passwordProtected,
+         const std::string& password,
+         uint64_t maxSizeBytes,
+         Common::ZipUtilities::ZipOutputInfo& info),
+        (const, override));
 
     MOCK_METHOD(int, unzip, (const std::string& srcPath, const std::string& destPath), (const, override));
     MOCK_METHOD(
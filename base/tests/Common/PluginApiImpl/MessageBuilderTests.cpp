@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "TestCompare.h"
 
@@ -51,6 +51,18 @@ TEST_F(MessageBuilderTests, requestSendEventMessageReturnsExpectedMessage)
     EXPECT_PRED_FORMAT2(dataMessageSimilar, expectedMessage, actualMessage);
 }
 
+TEST_F(MessageBuilderTests, requestSendEventsMessageReturnsOnePayloadPerEvent)
+{
+    DataMessage expectedMessage = createDataMessage();
+    expectedMessage.m_command = Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT;
+    expectedMessage.m_payload = { "EventXml1", "EventXml2" };
+
+    DataMessage actualMessage = m_messageBuilder->requestSendEventsMessage(defaultAppId, { "EventXml1", "EventXml2" });
+
+    EXPECT_PRED_FORMAT2(dataMessageSimilar, expectedMessage, actualMessage);
+    EXPECT_EQ(m_messageBuilder->requestExtractEvents(actualMessage), expectedMessage.m_payload);
+}
+
 TEST_F(MessageBuilderTests, requestSendStatusMessageReturnsExpectedMessage)
 {
     DataMessage expectedMessage = createDataMessage();
@@ -144,6 +156,28 @@ TEST_F(MessageBuilderTests, replyAckMessageReturnsExpectedMessage)
     EXPECT_PRED_FORMAT2(dataMessageSimilar, expectedMessage, actualMessage);
 }
 
+TEST_F(MessageBuilderTests, replyAckEventsMessageSaysEventBatchesAreAccepted)
+{
+    DataMessage expectedMessage = createDataMessage();
+    expectedMessage.m_command = Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT;
+
+    DataMessage actualMessage = m_messageBuilder->replyAckEventsMessage(expectedMessage);
+
+    expectedMessage.m_acknowledge = true;
+    expectedMessage.m_payload = { MessageBuilder::EVENT_BATCHES_ACCEPTED };
+
+    EXPECT_PRED_FORMAT2(dataMessageSimilar, expectedMessage, actualMessage);
+    EXPECT_TRUE(m_messageBuilder->acceptsEventBatches(actualMessage));
+}
+
+TEST_F(MessageBuilderTests, acceptsEventBatchesIsFalseForAPlainAck)
+{
+    DataMessage message = createDataMessage();
+    message.m_command = Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT;
+
+    EXPECT_FALSE(m_messageBuilder->acceptsEventBatches(m_messageBuilder->replyAckMessage(message)));
+}
+
 TEST_F(MessageBuilderTests, replySetErrorIfEmptyReturnsExpectedMessageWhenErrorIsEmpty)
 {
     DataMessage expectedMessage = createDataMessage();
@@ -0,0 +1,312 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "Common/Logging/ConsoleLoggingSetup.h"
+#include "Common/PluginApi/ApiException.h"
+#include "Common/PluginApiImpl/AsyncMessageSender.h"
+#include "Common/PluginProtocol/MessageBuilder.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+using Common::PluginApiImpl::AsyncMessageSender;
+using Common::PluginProtocol::Commands;
+using Common::PluginProtocol::DataMessage;
+
+namespace
+{
+    // Records messages, optionally holding the sending thread until released
+    class FakeManagementAgent
+    {
+    public:
+        DataMessage send(const DataMessage& message)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_blocked.wait(lock, [this]() { return !m_blocking; });
+            m_messages.push_back(message);
+            if (m_fail)
+            {
+                throw Common::PluginApi::ApiException("Failed");
+            }
+            Common::PluginProtocol::MessageBuilder messageBuilder(message.m_pluginName);
+            if (m_acceptBatches && message.m_command == Commands::PLUGIN_SEND_EVENT)
+            {
+                return messageBuilder.replyAckEventsMessage(message);
+            }
+            return messageBuilder.replyAckMessage(message);
+        }
+
+        void block()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_blocking = true;
+        }
+
+        void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_blocking = false;
+            }
+            m_blocked.notify_all();
+        }
+
+        void fail() { m_fail = true; }
+
+        void acceptBatches() { m_acceptBatches = true; }
+
+        std::vector<DataMessage> messages()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_messages;
+        }
+
+        AsyncMessageSender::SendFunction sendFunction()
+        {
+            return [this](const DataMessage& message) { return send(message); };
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_blocked;
+        bool m_blocking = false;
+        std::atomic<bool> m_fail = false;
+        std::atomic<bool> m_acceptBatches = false;
+        std::vector<DataMessage> m_messages;
+    };
+
+    class TestAsyncMessageSender : public ::testing::Test
+    {
+    public:
+        // Waits until the sending thread has taken everything queued so far
+        static void waitForSendingThread(const AsyncMessageSender& sender)
+        {
+            while (sender.stats().queuedEvents != 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        Common::Logging::ConsoleLoggingSetup m_loggingSetup;
+        FakeManagementAgent m_agent;
+    };
+} // namespace
+
+TEST_F(TestAsyncMessageSender, eventIsSentAndCompleted)
+{
+    AsyncMessageSender sender("plugin", m_agent.sendFunction());
+    std::promise<bool> delivered;
+
+    sender.queueEvent("APP", "event", [&delivered](bool result) { delivered.set_value(result); });
+
+    EXPECT_TRUE(delivered.get_future().get());
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    auto messages = m_agent.messages();
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0].m_command, Commands::PLUGIN_SEND_EVENT);
+    EXPECT_EQ(messages[0].m_applicationId, "APP");
+    EXPECT_EQ(messages[0].m_pluginName, "plugin");
+    EXPECT_EQ(messages[0].m_payload, std::vector<std::string>{ "event" });
+}
+
+TEST_F(TestAsyncMessageSender, consecutiveEventsForOneAppIdAreBatchedInOrderOnceTheManagementAgentAcceptsBatches)
+{
+    m_agent.acceptBatches();
+    AsyncMessageSender sender("plugin", m_agent.sendFunction(), 100, 3);
+    m_agent.block();
+    sender.queueEvent("APP", "event0", {});
+    waitForSendingThread(sender);
+    for (int i = 1; i <= 4; ++i)
+    {
+        sender.queueEvent("APP", "event" + std::to_string(i), {});
+    }
+    sender.queueEvent("OTHER", "other", {});
+    sender.queueEvent("APP", "event5", {});
+    m_agent.release();
+
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    std::vector<std::pair<std::string, std::vector<std::string>>> sent;
+    for (const auto& message : m_agent.messages())
+    {
+        sent.emplace_back(message.m_applicationId, message.m_payload);
+    }
+    ASSERT_EQ(sent.size(), 5);
+    std::vector<std::string> appEvents;
+    for (const auto& [appId, payload] : sent)
+    {
+        EXPECT_LE(payload.size(), 3);
+        if (appId == "APP")
+        {
+            appEvents.insert(appEvents.end(), payload.begin(), payload.end());
+        }
+    }
+    EXPECT_EQ(
+        appEvents,
+        (std::vector<std::string>{ "event0", "event1", "event2", "event3", "event4", "event5" }));
+    EXPECT_EQ(sent[0], (std::pair<std::string, std::vector<std::string>>{ "APP", { "event0" } }));
+    EXPECT_EQ(sent[sent.size() - 2].first, "OTHER");
+    EXPECT_EQ(sent.back(), (std::pair<std::string, std::vector<std::string>>{ "APP", { "event5" } }));
+    EXPECT_EQ(sender.stats().eventsSent, 7);
+}
+
+TEST_F(TestAsyncMessageSender, supersededStatusIsNotSent)
+{
+    AsyncMessageSender sender("plugin", m_agent.sendFunction());
+    m_agent.block();
+    sender.queueEvent("APP", "event", {});
+    waitForSendingThread(sender);
+    std::vector<bool> results;
+    std::mutex resultsMutex;
+    auto record = [&](bool delivered)
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        results.push_back(delivered);
+    };
+    sender.queueStatus("APP", "status1", "status1", record);
+    sender.queueStatus("APP", "status2", "status2", record);
+    m_agent.release();
+
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    auto messages = m_agent.messages();
+    ASSERT_EQ(messages.size(), 2);
+    EXPECT_EQ(messages[1].m_command, Commands::PLUGIN_SEND_STATUS);
+    EXPECT_EQ(messages[1].m_payload, (std::vector<std::string>{ "status2", "status2" }));
+    EXPECT_EQ(results, (std::vector<bool>{ false, true }));
+    EXPECT_EQ(sender.stats().statusesCoalesced, 1);
+    EXPECT_EQ(sender.stats().statusesSent, 1);
+}
+
+TEST_F(TestAsyncMessageSender, eventsAreSentOnePerMessageWhenTheManagementAgentDoesNotAcceptBatches)
+{
+    AsyncMessageSender sender("plugin", m_agent.sendFunction());
+    m_agent.block();
+    sender.queueEvent("APP", "event0", {});
+    waitForSendingThread(sender);
+    sender.queueEvent("APP", "event1", {});
+    sender.queueEvent("APP", "event2", {});
+    m_agent.release();
+
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    auto messages = m_agent.messages();
+    ASSERT_EQ(messages.size(), 3);
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        EXPECT_EQ(messages[i].m_payload, std::vector<std::string>{ "event" + std::to_string(i) });
+    }
+}
+
+TEST_F(TestAsyncMessageSender, pendingStatusIsSentBeforeEventsQueuedEarlier)
+{
+    AsyncMessageSender sender("plugin", m_agent.sendFunction());
+    m_agent.block();
+    sender.queueEvent("APP", "event0", {});
+    waitForSendingThread(sender);
+    sender.queueEvent("APP", "event1", {});
+    sender.queueStatus("APP", "status", "status", {});
+    m_agent.release();
+
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    auto messages = m_agent.messages();
+    ASSERT_EQ(messages.size(), 3);
+    EXPECT_EQ(messages[0].m_payload, std::vector<std::string>{ "event0" });
+    EXPECT_EQ(messages[1].m_command, Commands::PLUGIN_SEND_STATUS);
+    EXPECT_EQ(messages[2].m_payload, std::vector<std::string>{ "event1" });
+}
+
+TEST_F(TestAsyncMessageSender, fullQueueWaitsForSpace)
+{
+    AsyncMessageSender sender("plugin", m_agent.sendFunction(), 1);
+    m_agent.block();
+    sender.queueEvent("APP", "event0", {});
+    waitForSendingThread(sender);
+    sender.queueEvent("APP", "event1", {});
+
+    std::promise<bool> delivered;
+    auto queued = std::async(
+        std::launch::async,
+        [&sender, &delivered]()
+        { sender.queueEvent("APP", "event2", [&delivered](bool result) { delivered.set_value(result); }); });
+    EXPECT_EQ(queued.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    m_agent.release();
+
+    EXPECT_EQ(queued.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(delivered.get_future().get());
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(sender.stats().eventsDropped, 0);
+    EXPECT_EQ(sender.stats().eventsSent, 3);
+}
+
+TEST_F(TestAsyncMessageSender, eventsAreDroppedWhenQueueStaysFull)
+{
+    AsyncMessageSender sender(
+        "plugin", m_agent.sendFunction(), 2, 1, std::chrono::seconds(5), std::chrono::milliseconds(10));
+    m_agent.block();
+    std::atomic<int> dropped = 0;
+    auto onComplete = [&dropped](bool delivered)
+    {
+        if (!delivered)
+        {
+            ++dropped;
+        }
+    };
+    sender.queueEvent("APP", "event0", onComplete);
+    waitForSendingThread(sender);
+    for (int i = 1; i <= 4; ++i)
+    {
+        sender.queueEvent("APP", "event" + std::to_string(i), onComplete);
+    }
+
+    auto stats = sender.stats();
+    EXPECT_EQ(stats.queuedEvents, 2);
+    EXPECT_EQ(stats.maxQueuedEvents, 2);
+    EXPECT_EQ(stats.eventsDropped, 2);
+    EXPECT_EQ(dropped, 2);
+    m_agent.release();
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(sender.stats().eventsSent, 3);
+}
+
+TEST_F(TestAsyncMessageSender, failedSendIsCompletedAsNotDelivered)
+{
+    m_agent.fail();
+    AsyncMessageSender sender("plugin", m_agent.sendFunction());
+    std::promise<bool> delivered;
+
+    sender.queueEvent("APP", "event", [&delivered](bool result) { delivered.set_value(result); });
+
+    EXPECT_FALSE(delivered.get_future().get());
+    ASSERT_TRUE(sender.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(sender.stats().sendFailures, 1);
+    EXPECT_EQ(sender.stats().eventsSent, 0);
+}
+
+TEST_F(TestAsyncMessageSender, unsentMessagesAreCompletedAsNotDeliveredOnShutdown)
+{
+    std::atomic<int> notDelivered = 0;
+    auto onComplete = [&notDelivered](bool delivered)
+    {
+        if (!delivered)
+        {
+            ++notDelivered;
+        }
+    };
+    m_agent.block();
+    std::thread releaser;
+    {
+        AsyncMessageSender sender("plugin", m_agent.sendFunction(), 10, 10, std::chrono::milliseconds(10));
+        sender.queueEvent("APP", "event0", {});
+        waitForSendingThread(sender);
+        sender.queueEvent("APP", "event1", onComplete);
+        sender.queueStatus("APP", "status", "status", onComplete);
+        // The sender can only stop once the message being sent has gone
+        releaser = std::thread(
+            [this]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                m_agent.release();
+            });
+    }
+    releaser.join();
+    EXPECT_EQ(notDelivered, 2);
+}
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Common/FileSystem/IFileSystem.h"
 #include "tests/Common/Helpers/LogInitializedTests.h"
@@ -11,6 +11,7 @@
 #include "tests/Common/Helpers/TempDir.h"
 #include "tests/Common/Helpers/TestExecutionSynchronizer.h"
 
+#include <atomic>
 #include <fstream>
 #include <thread>
 
@@ -154,6 +155,24 @@ namespace
         ASSERT_EQ(process->output(), "");
     }
 
+    TEST_F(ProcessImpl, ProcessIsNotFinishedUntilTheNotifyCallbackHasReturned)
+    {
+        std::atomic<bool> callbackReturned = false;
+        {
+            auto process = createProcess();
+            process->setNotifyProcessFinishedCallBack(
+                [&callbackReturned]()
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                    callbackReturned = true;
+                });
+            process->exec("/bin/true", {});
+            ASSERT_EQ(process->wait(std::chrono::milliseconds(10), 500), Common::Process::ProcessStatus::FINISHED);
+            EXPECT_TRUE(callbackReturned);
+        }
+        EXPECT_TRUE(callbackReturned);
+    }
+
     TEST_F(ProcessImpl, WaitFromDifferentThreadsDoesNotDeadLock)
     {
         auto process = createProcess();
@@ -380,7 +399,8 @@ sleep 10000
                 out1 = out;
                 return;
             }
-                out2 = out;
+            // bash may write the second echo in more than one go
+            out2 += out;
         });
         process->setOutputLimit(100);
         process->setFlushBufferOnNewLine(true);
@@ -390,7 +410,8 @@ sleep 10000
         std::string output = process->output();
 
         ASSERT_EQ(out1, "first");
-        ASSERT_EQ(out2, "abc\ndef");
+        // An unfinished last line that arrives on its own is left for output()
+        ASSERT_EQ(out2 + output, "abc\ndef");
     }
 
     TEST_F(ProcessImpl, OutputCannotBeCalledBeforeExec)
@@ -0,0 +1,252 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "Common/Process/IProcess.h"
+#include "Common/ProcessImpl/ProcessSupervisor.h"
+#include "tests/Common/Helpers/LogInitializedTests.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include <condition_variable>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+using Common::ProcessImpl::ProcessSupervisor;
+
+namespace
+{
+    class RecordingChild : public ProcessSupervisor::IChild
+    {
+    public:
+        explicit RecordingChild(size_t readSize = SIZE_MAX) : m_readSize(readSize) {}
+
+        size_t readSize(ProcessSupervisor::Stream) override { return m_readSize; }
+
+        void onOutput(ProcessSupervisor::Stream stream, const char* data, size_t size) override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            (stream == ProcessSupervisor::Stream::STDOUT ? m_stdout : m_stderr).append(data, size);
+            m_largestRead = std::max(m_largestRead, size);
+        }
+
+        std::mutex& reapMutex() override { return m_reapMutex; }
+
+        void onReaped() override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_reaped = true;
+        }
+
+        void onExit(int status) override
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_status = status;
+                ++m_exits;
+            }
+            m_exited.notify_all();
+        }
+
+        bool waitForExit(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_exited.wait_for(lock, timeout, [this]() { return m_exits > 0; });
+        }
+
+        const size_t m_readSize;
+        std::mutex m_reapMutex;
+        std::mutex m_mutex;
+        std::condition_variable m_exited;
+        std::string m_stdout;
+        std::string m_stderr;
+        size_t m_largestRead = 0;
+        bool m_reaped = false;
+        int m_status = 0;
+        int m_exits = 0;
+    };
+
+    // Forks a child which exits straight away, leaving a grandchild holding its stdout open for holdFor
+    pid_t startChildWithGrandchild(std::chrono::milliseconds holdFor, int& outFd, int& errFd)
+    {
+        int outPipe[2];
+        int errPipe[2];
+        if (::pipe2(outPipe, O_CLOEXEC) != 0 || ::pipe2(errPipe, O_CLOEXEC) != 0)
+        {
+            return -1;
+        }
+        pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            if (::fork() == 0)
+            {
+                ::usleep(std::chrono::duration_cast<std::chrono::microseconds>(holdFor).count());
+            }
+            ::_exit(0);
+        }
+        ::close(outPipe[1]);
+        ::close(errPipe[1]);
+        ::fcntl(outPipe[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(errPipe[0], F_SETFL, O_NONBLOCK);
+        outFd = outPipe[0];
+        errFd = errPipe[0];
+        return pid;
+    }
+
+    // Forks a child which writes the given output then exits with exitCode
+    pid_t startChild(const std::string& out, const std::string& err, int exitCode, int& outFd, int& errFd)
+    {
+        int outPipe[2];
+        int errPipe[2];
+        if (::pipe2(outPipe, O_CLOEXEC) != 0 || ::pipe2(errPipe, O_CLOEXEC) != 0)
+        {
+            return -1;
+        }
+        pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            [[maybe_unused]] auto written = ::write(outPipe[1], out.data(), out.size());
+            written = ::write(errPipe[1], err.data(), err.size());
+            ::_exit(exitCode);
+        }
+        ::close(outPipe[1]);
+        ::close(errPipe[1]);
+        ::fcntl(outPipe[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(errPipe[0], F_SETFL, O_NONBLOCK);
+        outFd = outPipe[0];
+        errFd = errPipe[0];
+        return pid;
+    }
+
+    size_t threadCount()
+    {
+        auto tasks = std::filesystem::directory_iterator("/proc/self/task");
+        return std::distance(std::filesystem::begin(tasks), std::filesystem::end(tasks));
+    }
+
+    class TestProcessSupervisor : public LogOffInitializedTests
+    {
+    };
+} // namespace
+
+TEST_F(TestProcessSupervisor, outputAndExitStatusAreReported)
+{
+    ProcessSupervisor supervisor;
+    auto child = std::make_shared<RecordingChild>();
+    int outFd;
+    int errFd;
+    pid_t pid = startChild("out", "err", 3, outFd, errFd);
+    ASSERT_GT(pid, 0);
+
+    supervisor.supervise(pid, outFd, errFd, child);
+
+    ASSERT_TRUE(child->waitForExit(std::chrono::seconds(5)));
+    std::lock_guard<std::mutex> lock(child->m_mutex);
+    EXPECT_EQ(child->m_stdout, "out");
+    EXPECT_EQ(child->m_stderr, "err");
+    EXPECT_TRUE(WIFEXITED(child->m_status));
+    EXPECT_EQ(WEXITSTATUS(child->m_status), 3);
+    EXPECT_EQ(child->m_exits, 1);
+    EXPECT_EQ(supervisor.supervisedCount(), 0);
+}
+
+TEST_F(TestProcessSupervisor, reapIsReportedBeforeOutputHeldOpenByAGrandchildCloses)
+{
+    ProcessSupervisor supervisor;
+    auto child = std::make_shared<RecordingChild>();
+    int outFd;
+    int errFd;
+    pid_t pid = startChildWithGrandchild(std::chrono::milliseconds(1000), outFd, errFd);
+    ASSERT_GT(pid, 0);
+
+    supervisor.supervise(pid, outFd, errFd, child);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    bool reaped = false;
+    while (!reaped && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock(child->m_mutex);
+        reaped = child->m_reaped;
+    }
+    // Signals must stop as soon as the pid can be reused, not once the output is finished with
+    EXPECT_TRUE(reaped);
+    {
+        std::lock_guard<std::mutex> lock(child->m_mutex);
+        EXPECT_EQ(child->m_exits, 0);
+    }
+    ASSERT_TRUE(child->waitForExit(std::chrono::seconds(5)));
+}
+
+TEST_F(TestProcessSupervisor, readsAreNoLargerThanTheChildAsksFor)
+{
+    ProcessSupervisor supervisor;
+    auto child = std::make_shared<RecordingChild>(10);
+    std::string output(1000, 'x');
+    int outFd;
+    int errFd;
+    pid_t pid = startChild(output, "", 0, outFd, errFd);
+    ASSERT_GT(pid, 0);
+
+    supervisor.supervise(pid, outFd, errFd, child);
+
+    ASSERT_TRUE(child->waitForExit(std::chrono::seconds(5)));
+    std::lock_guard<std::mutex> lock(child->m_mutex);
+    EXPECT_EQ(child->m_stdout, output);
+    EXPECT_LE(child->m_largestRead, 10);
+}
+
+TEST_F(TestProcessSupervisor, manyChildrenAreSupervisedByOneThread)
+{
+    ProcessSupervisor supervisor;
+    std::vector<std::shared_ptr<RecordingChild>> children;
+    size_t threadsBefore = threadCount();
+
+    for (int i = 0; i < 20; ++i)
+    {
+        auto child = std::make_shared<RecordingChild>();
+        int outFd;
+        int errFd;
+        pid_t pid = startChild(std::to_string(i), "", i, outFd, errFd);
+        ASSERT_GT(pid, 0);
+        supervisor.supervise(pid, outFd, errFd, child);
+        children.push_back(child);
+    }
+    EXPECT_EQ(threadCount(), threadsBefore);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        ASSERT_TRUE(children[i]->waitForExit(std::chrono::seconds(5)));
+        std::lock_guard<std::mutex> lock(children[i]->m_mutex);
+        EXPECT_EQ(children[i]->m_stdout, std::to_string(i));
+        EXPECT_EQ(WEXITSTATUS(children[i]->m_status), i);
+    }
+}
+
+TEST_F(TestProcessSupervisor, processesDoNotStartThreadsOfTheirOwn)
+{
+    // Make sure the shared supervisor is running before counting
+    auto first = Common::Process::createProcess();
+    first->exec("/bin/true", {});
+    first->waitUntilProcessEnds();
+    size_t threadsBefore = threadCount();
+
+    std::vector<std::unique_ptr<Common::Process::IProcess>> processes;
+    for (int i = 0; i < 10; ++i)
+    {
+        processes.push_back(Common::Process::createProcess());
+        processes.back()->exec("/bin/sleep", { "0.5" });
+    }
+    EXPECT_EQ(threadCount(), threadsBefore);
+
+    auto started = std::chrono::steady_clock::now();
+    for (auto& process : processes)
+    {
+        process->waitUntilProcessEnds();
+        EXPECT_EQ(process->exitCode(), 0);
+    }
+    // Exits are noticed as they happen rather than on a poll
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+}
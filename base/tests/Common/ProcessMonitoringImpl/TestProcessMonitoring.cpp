@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "Common/Logging/ConsoleLoggingSetup.h"
 #include "Common/ProcessMonitoring/IProcessMonitor.h"
@@ -8,6 +8,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <future>
 #include <signal.h>
 #include <thread>
@@ -50,6 +51,47 @@ namespace
         Common::ProcessMonitoring::IProcessMonitorPtr m_processMonitorPtr;
         pthread_t m_thread_id;
     };
+
+    class FakeProcessProxy : public Common::ProcessMonitoring::IProcessProxy
+    {
+    public:
+        explicit FakeProcessProxy(std::chrono::seconds checkPeriod) : m_checkPeriod(checkPeriod) {}
+
+        void stop() override {}
+        exit_status_t checkForExit() override
+        {
+            ++m_checks;
+            return { m_checkPeriod, Common::Process::ProcessStatus::RUNNING };
+        }
+        std::chrono::seconds ensureStateMatchesOptions() override { return m_checkPeriod; }
+        void shutDownProcessCheckForExit() override {}
+        void setEnabled(bool) override {}
+        bool isRunning() override { return true; }
+        [[nodiscard]] std::string name() const override { return ""; }
+        void setCoreDumpMode(bool) override {}
+        void setTerminationCallback(std::function<void()> callback) override
+        {
+            m_terminationCallback = std::move(callback);
+        }
+
+        bool waitForChecks(int count, std::chrono::milliseconds timeout)
+        {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (m_checks < count)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return true;
+        }
+
+        const std::chrono::seconds m_checkPeriod;
+        std::atomic<int> m_checks = 0;
+        std::function<void()> m_terminationCallback;
+    };
 } // namespace
 
 class ProcessMonitoring : public ::testing::Test
@@ -221,3 +263,41 @@ TEST_F(ProcessMonitoring, createProcessMonitorAndCheckSIGCHLDSignalIsHandled)
     EXPECT_THAT(logMessage, ::testing::Not(::testing::HasSubstr("ERROR")));
     EXPECT_THAT(logMessage, ::testing::HasSubstr("Stopping processes"));
 }
+
+TEST_F(ProcessMonitoring, exitNotificationChecksOnlyTheProcessThatExited)
+{
+    auto processMonitorPtr = Common::ProcessMonitoring::createProcessMonitor();
+    auto exitingProxy = std::make_unique<FakeProcessProxy>(std::chrono::hours(1));
+    auto otherProxy = std::make_unique<FakeProcessProxy>(std::chrono::hours(1));
+    auto* exiting = exitingProxy.get();
+    auto* other = otherProxy.get();
+    processMonitorPtr->addProcessToMonitor(std::move(exitingProxy));
+    processMonitorPtr->addProcessToMonitor(std::move(otherProxy));
+    ProcessMonitorThread processMonitorThread(std::move(processMonitorPtr));
+
+    processMonitorThread.start();
+    ASSERT_TRUE(exiting->waitForChecks(1, std::chrono::seconds(5)));
+    ASSERT_TRUE(other->waitForChecks(1, std::chrono::seconds(5)));
+
+    ASSERT_TRUE(exiting->m_terminationCallback);
+    exiting->m_terminationCallback();
+    EXPECT_TRUE(exiting->waitForChecks(2, std::chrono::seconds(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(other->m_checks, 1);
+
+    EXPECT_EQ(processMonitorThread.stop(), 0);
+}
+
+TEST_F(ProcessMonitoring, processesAreCheckedWhenDueWithoutAMinimumWait)
+{
+    auto processMonitorPtr = Common::ProcessMonitoring::createProcessMonitor();
+    auto proxy = std::make_unique<FakeProcessProxy>(std::chrono::seconds(1));
+    auto* fake = proxy.get();
+    processMonitorPtr->addProcessToMonitor(std::move(proxy));
+    ProcessMonitorThread processMonitorThread(std::move(processMonitorPtr));
+
+    processMonitorThread.start();
+    EXPECT_TRUE(fake->waitForChecks(3, std::chrono::seconds(5)));
+
+    EXPECT_EQ(processMonitorThread.stop(), 0);
+}
@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #define TEST_PUBLIC public
 
@@ -30,6 +30,19 @@ namespace
     private:
         Common::Logging::ConsoleLoggingSetup m_loggingSetup;
     };
+
+    class RestartRecordingProcessProxy : public Common::ProcessMonitoringImpl::ProcessProxy
+    {
+    public:
+        using ProcessProxy::ProcessProxy;
+
+        void onRestart(std::chrono::steady_clock::duration sinceExit) override
+        {
+            m_restarts.push_back(sinceExit);
+        }
+
+        std::vector<std::chrono::steady_clock::duration> m_restarts;
+    };
 } // namespace
 
 TEST_F(TestProcessProxy, createProcessProxyDoesntThrow)
@@ -440,4 +453,40 @@ TEST_F(TestProcessProxy, checkBackoffCanBeResetCorrectly)
         delay = proxy.ensureStateMatchesOptions();
         EXPECT_EQ(delay.count(), proxy.m_maximumBackoff.count());
     }
-}
\ No newline at end of file
+}
+
+TEST_F(TestProcessProxy, restartAfterExitIsReportedWithItsLatency)
+{
+    const std::string INST = Common::ApplicationConfiguration::applicationPathManager().sophosInstall();
+    const std::string execPath = "./foobar";
+    const std::string absolutePath = INST + "/foobar";
+    Common::ProcessImpl::ProcessFactory::instance().replaceCreator([absolutePath]() {
+        std::vector<std::string> args;
+        auto mockProcess = new StrictMock<MockProcess>();
+        EXPECT_CALL(*mockProcess, exec(absolutePath, args, _, _, _)).Times(2);
+        EXPECT_CALL(*mockProcess, setOutputLimit(_)).Times(1);
+        EXPECT_CALL(*mockProcess, getStatus()).WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+        EXPECT_CALL(*mockProcess, exitCode())
+            .WillOnce(Return(Common::ProcessMonitoringImpl::ProcessProxy::RESTART_EXIT_CODE));
+        EXPECT_CALL(*mockProcess, output()).WillOnce(Return(""));
+        return std::unique_ptr<Common::Process::IProcess>(mockProcess);
+    });
+
+    auto filesystemMock = std::make_unique<StrictMock<MockFileSystem>>();
+    EXPECT_CALL(*filesystemMock, isFile(_)).WillRepeatedly(Return(true));
+    auto scopedReplaceFileSystem = Tests::ScopedReplaceFileSystem(std::move(filesystemMock));
+
+    auto info = Common::Process::createEmptyProcessInfo();
+    info->setExecutableUserAndGroup("root:root");
+    info->setExecutableFullPath(execPath);
+
+    RestartRecordingProcessProxy proxy(std::move(info));
+    proxy.ensureStateMatchesOptions();
+    // The first start isn't a restart
+    EXPECT_TRUE(proxy.m_restarts.empty());
+
+    EXPECT_NO_THROW(proxy.checkForExit());
+    proxy.ensureStateMatchesOptions();
+    ASSERT_EQ(proxy.m_restarts.size(), 1);
+    EXPECT_LT(proxy.m_restarts[0], std::chrono::seconds(1));
+}
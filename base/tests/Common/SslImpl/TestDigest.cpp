@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Common/SslImpl/Digest.h"
 #include <gtest/gtest.h>
@@ -41,4 +41,18 @@ TEST(TestDigest, calculateDigestBadStreamThrows)
     std::istringstream stream{ "foo" };
     stream.setstate(std::istringstream::badbit);
     EXPECT_THROW(std::ignore = calculateDigest(Digest::md5, stream), std::runtime_error);
-}
\ No newline at end of file
+}
+TEST(TestDigest, streamingDigestMatchesWholeInput)
+{
+    StreamingDigest digest{ Digest::sha256 };
+    digest.update("hello ", 6);
+    digest.update("", 0);
+    digest.update("world!", 6);
+    EXPECT_EQ(digest.finalise(), calculateDigest(Digest::sha256, "hello world!"));
+}
+
+TEST(TestDigest, streamingDigestOfNothing)
+{
+    StreamingDigest digest{ Digest::md5 };
+    EXPECT_EQ(digest.finalise(), "d41d8cd98f00b204e9800998ecf8427e");
+}
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -10,5 +10,6 @@ namespace
     {
     public:
         bool empty() { return m_tasks.empty(); }
+        size_t size() { return m_tasks.size(); }
     };
 } // namespace
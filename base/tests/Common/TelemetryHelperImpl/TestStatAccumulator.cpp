@@ -0,0 +1,161 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "Common/TelemetryHelperImpl/StatAccumulator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using Common::Telemetry::StatAccumulator;
+using Common::Telemetry::StatHistogram;
+using Common::Telemetry::TelemetryObject;
+
+namespace
+{
+    double naiveStdDeviation(const std::vector<double>& values)
+    {
+        double mean = 0;
+        for (double value : values)
+        {
+            mean += value;
+        }
+        mean /= values.size();
+        double sum = 0;
+        for (double value : values)
+        {
+            sum += (value - mean) * (value - mean);
+        }
+        return std::sqrt(sum / values.size());
+    }
+} // namespace
+
+TEST(TestStatAccumulator, emptyAccumulatorReportsZeros)
+{
+    StatAccumulator stat;
+    EXPECT_EQ(stat.count(), 0);
+    EXPECT_EQ(stat.mean(), 0);
+    EXPECT_EQ(stat.min(), 0);
+    EXPECT_EQ(stat.max(), 0);
+    EXPECT_EQ(stat.stdDeviation(), 0);
+    EXPECT_EQ(stat.percentile(50), 0);
+}
+
+TEST(TestStatAccumulator, summariesMatchAveragingTheSamples)
+{
+    StatAccumulator stat;
+    for (double value : { 1.0, 6.0, 10.0 })
+    {
+        stat.add(value);
+    }
+    EXPECT_EQ(stat.count(), 3);
+    EXPECT_EQ(stat.mean(), (1.0 + 6.0 + 10.0) / 3);
+    EXPECT_EQ(stat.min(), 1);
+    EXPECT_EQ(stat.max(), 10);
+    EXPECT_NEAR(stat.stdDeviation(), naiveStdDeviation({ 1, 6, 10 }), 1e-12);
+}
+
+TEST(TestStatAccumulator, varianceStaysAccurateForLargeOffset)
+{
+    // Summing squares would lose all precision here
+    StatAccumulator stat;
+    for (int i = 0; i < 1000; ++i)
+    {
+        stat.add(1e9 + (i % 2));
+    }
+    EXPECT_NEAR(stat.stdDeviation(), 0.5, 1e-6);
+}
+
+TEST(TestStatAccumulator, mergedAccumulatorsMatchOneAccumulatorOfAllSamples)
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<double> distribution(100, 15);
+    StatAccumulator all;
+    std::vector<StatAccumulator> parts(4);
+    for (int i = 0; i < 10000; ++i)
+    {
+        double value = distribution(generator);
+        all.add(value);
+        parts[i % 3].add(value);
+    }
+
+    StatAccumulator merged;
+    for (const auto& part : parts)
+    {
+        merged.merge(part);
+    }
+    EXPECT_EQ(merged.count(), all.count());
+    EXPECT_NEAR(merged.mean(), all.mean(), 1e-9);
+    EXPECT_EQ(merged.min(), all.min());
+    EXPECT_EQ(merged.max(), all.max());
+    EXPECT_NEAR(merged.stdDeviation(), all.stdDeviation(), 1e-9);
+}
+
+TEST(TestStatAccumulator, percentilesAreWithinOnePercent)
+{
+    StatAccumulator stat;
+    stat.enableHistogram();
+    for (int i = 1; i <= 10000; ++i)
+    {
+        stat.add(i);
+    }
+    for (double percentile : { 1.0, 50.0, 90.0, 99.0, 99.9 })
+    {
+        double expected = percentile * 100;
+        EXPECT_NEAR(stat.percentile(percentile), expected, expected * 0.01) << percentile;
+    }
+    EXPECT_EQ(stat.percentile(0), 1);
+    EXPECT_EQ(stat.percentile(100), 10000);
+}
+
+TEST(TestStatAccumulator, percentilesHandleZeroAndNegativeSamples)
+{
+    StatHistogram histogram;
+    for (double value : { -100.0, -1.0, 0.0, 0.0, 5.0 })
+    {
+        histogram.add(value);
+    }
+    EXPECT_NEAR(histogram.percentile(20), -100, 1);
+    EXPECT_NEAR(histogram.percentile(40), -1, 0.01);
+    EXPECT_EQ(histogram.percentile(60), 0);
+    EXPECT_EQ(histogram.percentile(80), 0);
+    EXPECT_NEAR(histogram.percentile(100), 5, 0.05);
+}
+
+TEST(TestStatAccumulator, roundTripsThroughTelemetryObject)
+{
+    StatAccumulator stat;
+    stat.enableHistogram();
+    for (double value : { -3.0, 0.0, 1.5, 6.0, 10.0 })
+    {
+        stat.add(value);
+    }
+
+    auto restored = StatAccumulator::fromTelemetryObject(stat.toTelemetryObject());
+
+    EXPECT_EQ(restored.count(), stat.count());
+    EXPECT_EQ(restored.mean(), stat.mean());
+    EXPECT_EQ(restored.min(), stat.min());
+    EXPECT_EQ(restored.max(), stat.max());
+    EXPECT_EQ(restored.stdDeviation(), stat.stdDeviation());
+    ASSERT_TRUE(restored.hasHistogram());
+    EXPECT_EQ(restored.percentile(50), stat.percentile(50));
+}
+
+TEST(TestStatAccumulator, restoresFromListOfSamples)
+{
+    std::list<TelemetryObject> samples;
+    for (double value : { 1.0, 6.0, 10.0 })
+    {
+        TelemetryObject sample;
+        sample.set(Common::Telemetry::TelemetryValue(value));
+        samples.push_back(sample);
+    }
+    TelemetryObject object;
+    object.set(samples);
+
+    auto restored = StatAccumulator::fromTelemetryObject(object);
+
+    EXPECT_EQ(restored.count(), 3);
+    EXPECT_EQ(restored.max(), 10);
+}
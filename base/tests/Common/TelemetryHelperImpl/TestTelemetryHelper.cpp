@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "Common/FileSystemImpl/FileSystemImpl.h"
 #include "Common/Logging/ConsoleLoggingSetup.h"
@@ -584,10 +584,10 @@ TEST_F(TestTelemetryHelper, telemtryStatStdDeviationSerialisedCorrectly)
 
 TEST_F(TestTelemetryHelper, TelemetryAndStatsAreSavedCorrectly)
 {
+    std::string saved;
     MockFileSystem* mockFileSystemPtr  = new StrictMock<MockFileSystem>;
     EXPECT_CALL(*mockFileSystemPtr, isDirectory(HasSubstr("/opt/sophos-spl/base/telemetry/cache"))).WillOnce(Return(true));
-    EXPECT_CALL(*mockFileSystemPtr, writeFileAtomically(HasSubstr("helper"),
-            R"({"rootkey":{"a":"b"},"statskey":{"statName":[1.0,6.0,10.0]}})", _));
+    EXPECT_CALL(*mockFileSystemPtr, writeFileAtomically(HasSubstr("helper"), _, _)).WillOnce(SaveArg<1>(&saved));
 
     TelemetryHelper& helper = TelemetryHelper::getInstance();
     ScopeInsertFSMock s(mockFileSystemPtr, helper);
@@ -599,6 +599,44 @@ TEST_F(TestTelemetryHelper, TelemetryAndStatsAreSavedCorrectly)
     helper.set("a", "b");
 
     helper.save("helper");
+
+    auto savedJson = nlohmann::json::parse(saved);
+    EXPECT_EQ(savedJson["rootkey"], nlohmann::json::parse(R"({"a":"b"})"));
+    const auto& savedStat = savedJson["statskey"]["statName"];
+    EXPECT_EQ(savedStat["count"], 3);
+    EXPECT_EQ(savedStat["sum"], 17.0);
+    EXPECT_EQ(savedStat["min"], 1.0);
+    EXPECT_EQ(savedStat["max"], 10.0);
+}
+
+TEST_F(TestTelemetryHelper, savedStatsAreRestoredWithoutChange)
+{
+    std::string saved;
+    TelemetryHelper helper;
+    MockFileSystem* mockFileSystemPtr  = new StrictMock<MockFileSystem>;
+    ScopeInsertFSMock s(mockFileSystemPtr, helper);
+    EXPECT_CALL(*mockFileSystemPtr, isDirectory(_)).WillOnce(Return(true));
+    EXPECT_CALL(*mockFileSystemPtr, writeFileAtomically(_, _, _)).WillOnce(SaveArg<1>(&saved));
+    helper.enableStatPercentiles("statName", { 50 });
+    for (int i = 1; i <= 100; ++i)
+    {
+        helper.appendStat("statName", i);
+    }
+    helper.save("helper");
+    helper.updateTelemetryWithStats();
+    std::string expected = helper.serialise();
+
+    TelemetryHelper restoredHelper;
+    MockFileSystem* restoreFileSystemPtr  = new StrictMock<MockFileSystem>;
+    ScopeInsertFSMock restoreScope(restoreFileSystemPtr, restoredHelper);
+    EXPECT_CALL(*restoreFileSystemPtr, isFile(_)).WillOnce(Return(true));
+    EXPECT_CALL(*restoreFileSystemPtr, readFile(_, _)).WillOnce(Return(saved));
+    EXPECT_CALL(*restoreFileSystemPtr, removeFile(_));
+    restoredHelper.enableStatPercentiles("statName", { 50 });
+    restoredHelper.restore("helper");
+    restoredHelper.updateTelemetryWithStats();
+
+    EXPECT_EQ(restoredHelper.serialise(), expected);
 }
 
 TEST_F(TestTelemetryHelper, updateStatsCollectionFromSavedTelemetry)
@@ -647,6 +685,132 @@ TEST_F(TestTelemetryHelper, updateStatsFromSavedTelemetryInvalidJson)
     ASSERT_EQ(R"({})", helper.serialise());
 }
 
+TEST_F(TestTelemetryHelper, statPercentilesAreAddedForEnabledStats)
+{
+    TelemetryHelper helper;
+    helper.enableStatPercentiles("latency", { 50, 99.9 });
+    for (int i = 1; i <= 1000; ++i)
+    {
+        helper.appendStat("latency", i);
+        helper.appendStat("other", i);
+    }
+    helper.updateTelemetryWithStats();
+
+    auto json = nlohmann::json::parse(helper.serialise());
+    EXPECT_NEAR(json["latency-p50"].get<double>(), 500, 5);
+    EXPECT_NEAR(json["latency-p99.9"].get<double>(), 999, 10);
+    EXPECT_EQ(json["latency-max"], 1000.0);
+    EXPECT_FALSE(json.contains("other-p50"));
+}
+
+TEST_F(TestTelemetryHelper, statPercentilesSurviveReset)
+{
+    TelemetryHelper helper;
+    helper.enableStatPercentiles("latency", { 50 });
+    helper.appendStat("latency", 1);
+    helper.reset();
+    helper.appendStat("latency", 2);
+    helper.updateTelemetryWithStats();
+
+    EXPECT_EQ(R"({"latency-avg":2.0,"latency-max":2.0,"latency-min":2.0,"latency-p50":2.0})", helper.serialise());
+}
+
+TEST_F(TestTelemetryHelper, statsAppendedFromManyThreadsAreAllCounted)
+{
+    TelemetryHelper helper;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 16; ++thread)
+    {
+        threads.emplace_back(
+            [&helper]()
+            {
+                for (int i = 1; i <= 1000; ++i)
+                {
+                    helper.appendStat("statName", i);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_DOUBLE_EQ(helper.getStatAverage("statName"), 500.5);
+    EXPECT_EQ(helper.getStatMin("statName"), 1);
+    EXPECT_EQ(helper.getStatMax("statName"), 1000);
+    EXPECT_NEAR(helper.getStatStdDeviation("statName"), 288.67499, 1e-4);
+}
+
+TEST_F(TestTelemetryHelper, registeredCounterIsAddedToKeyWhenSerialised)
+{
+    TelemetryHelper helper;
+    helper.increment("counters.events", 2L);
+    auto counter = helper.registerCounter("counters.events");
+    counter.increment();
+    counter.increment(4);
+
+    EXPECT_EQ(R"({"counters":{"events":7}})", helper.serialise());
+    EXPECT_EQ(R"({"counters":{"events":7}})", helper.serialise());
+}
+
+TEST_F(TestTelemetryHelper, registeringKeyAgainSharesTheCount)
+{
+    TelemetryHelper helper;
+    auto counter1 = helper.registerCounter("events");
+    auto counter2 = helper.registerCounter("events");
+    counter1.increment();
+    counter2.increment();
+
+    EXPECT_EQ(R"({"events":2})", helper.serialiseAndReset());
+    EXPECT_EQ(R"({})", helper.serialise());
+}
+
+TEST_F(TestTelemetryHelper, resetDropsCountsNotYetSerialised)
+{
+    TelemetryHelper helper;
+    auto counter = helper.registerCounter("events");
+    counter.increment();
+    helper.reset();
+    counter.increment();
+
+    EXPECT_EQ(R"({"events":1})", helper.serialise());
+}
+
+TEST_F(TestTelemetryHelper, unregisteredCounterDiscardsIncrements)
+{
+    TelemetryCounter counter;
+    EXPECT_NO_THROW(counter.increment());
+}
+
+TEST_F(TestTelemetryHelper, counterIncrementedFromManyThreadsCountsEveryIncrement)
+{
+    TelemetryHelper helper;
+    auto counter = helper.registerCounter("events");
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 16; ++thread)
+    {
+        threads.emplace_back(
+            [&helper, counter]() mutable
+            {
+                for (int i = 0; i < 10000; ++i)
+                {
+                    counter.increment();
+                    helper.increment("events", 1L);
+                }
+            });
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        helper.serialise();
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(R"({"events":320000})", helper.serialise());
+}
+
 TEST_F(TestTelemetryHelper, addValueToSet)
 {
     TelemetryHelper& helper = TelemetryHelper::getInstance();
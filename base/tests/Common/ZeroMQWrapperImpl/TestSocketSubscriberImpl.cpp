@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Common/Exceptions/Print.h"
 #include "Common/ZMQWrapperApi/IContext.h"
@@ -7,6 +7,7 @@
 #include "Common/ZeroMQWrapper/ISocketSubscriber.h"
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <thread>
 
 using Common::ZeroMQWrapper::ISocketSubscriberPtr;
@@ -102,4 +103,52 @@ namespace
         EXPECT_EQ(data.at(1), "DATA");
     }
 
+    TEST(TestSocketSubscriberImpl, framesAreSentFromCallerBuffersAndFreedOnceSent)
+    {
+        auto context = Common::ZMQWrapperApi::createContext();
+        ISocketSubscriberPtr socket = context->getSubscriber();
+        socket->setTimeout(100);
+        socket->listen("inproc://framesTest");
+        socket->subscribeTo("FOOBAR");
+        auto sender = context->getPublisher();
+        sender->connect("inproc://framesTest");
+
+        const std::string payload(4096, 'x');
+        std::atomic<int> buffersSent{ 0 };
+        std::atomic<int> buffersFreed{ 0 };
+        Common::ZeroMQWrapper::frames_t received;
+        // Messages are dropped until the subscription has propagated
+        for (int attempt = 0; attempt < 50 && received.empty(); ++attempt)
+        {
+            Common::ZeroMQWrapper::frames_t frames;
+            frames.push_back(std::make_unique<Common::ZeroMQWrapper::StringFrame>("FOOBAR"));
+            frames.push_back(std::make_unique<Common::ZeroMQWrapper::BufferFrame>(
+                payload.data(),
+                payload.size(),
+                [&buffersFreed](const char*, size_t) { buffersFreed++; }));
+            sender->writeFrames(std::move(frames));
+            buffersSent++;
+            try
+            {
+                received = socket->readFrames();
+            }
+            catch (const Common::ZeroMQWrapper::IIPCException&)
+            {
+            }
+        }
+
+        ASSERT_EQ(received.size(), 2);
+        EXPECT_EQ(received.at(0)->view(), "FOOBAR");
+        EXPECT_EQ(received.at(1)->view(), payload);
+        // inproc hands the message itself to the subscriber
+        EXPECT_EQ(received.at(1)->data(), payload.data());
+
+        // Buffers are freed once every frame referring to them has gone, including any still queued
+        received.clear();
+        socket.reset();
+        sender.reset();
+        context.reset();
+        EXPECT_EQ(buffersFreed, buffersSent);
+    }
+
 } // namespace
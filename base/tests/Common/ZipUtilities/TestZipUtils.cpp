@@ -1,12 +1,15 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "Common/FileSystem/IFileSystem.h"
 #include "Common/ZipUtilities/ZipUtils.h"
 
 #include "tests/Common/Helpers/LogInitializedTests.h"
+#include "tests/Common/Helpers/TempDir.h"
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 namespace
 {
     class TestZipUtils : public LogInitializedTests
@@ -31,4 +34,72 @@ namespace
         EXPECT_NE(Common::ZipUtilities::zipUtils().unzip(testDir, "/tmp"), 0);
         fs->removeFileOrDirectory(testDir);
     }
-}
\ No newline at end of file
+
+    TEST_F(TestZipUtils, zip_reportsSizeAndDigestOfZipFile)
+    {
+        Tests::TempDir tempDir;
+        tempDir.createFile("src/a.txt", std::string(100000, 'a'));
+        tempDir.createFile("src/sub/b.txt", "some content");
+        std::string zipFile = tempDir.absPath("out.zip");
+
+        Common::ZipUtilities::ZipOutputInfo info;
+        ASSERT_EQ(
+            Common::ZipUtilities::zipUtils().zip(tempDir.absPath("src"), zipFile, false, false, "", 1024 * 1024, info),
+            0);
+
+        auto fs = Common::FileSystem::fileSystem();
+        EXPECT_FALSE(info.exceededMaxSize);
+        EXPECT_EQ(info.sizeBytes, fs->fileSize(zipFile));
+        EXPECT_EQ(info.sha256, fs->calculateDigest(Common::SslImpl::Digest::sha256, zipFile));
+
+        // The zip written with data descriptors can still be extracted. unzip changes the working directory.
+        std::string workingDir = fs->currentWorkingDirectory();
+        Tests::TempDir extractDir;
+        EXPECT_EQ(Common::ZipUtilities::zipUtils().unzip(zipFile, extractDir.dirPath()), 0);
+        ASSERT_EQ(::chdir(workingDir.c_str()), 0);
+        EXPECT_EQ(fs->readFile(extractDir.absPath("src/sub/b.txt")), "some content");
+    }
+
+    TEST_F(TestZipUtils, zip_reportsDigestOfPasswordProtectedZipFile)
+    {
+        Tests::TempDir tempDir;
+        tempDir.createFile("src/a.txt", std::string(100000, 'a'));
+        std::string zipFile = tempDir.absPath("out.zip");
+
+        Common::ZipUtilities::ZipOutputInfo info;
+        ASSERT_EQ(
+            Common::ZipUtilities::zipUtils().zip(
+                tempDir.absPath("src"), zipFile, false, true, "password", 1024 * 1024, info),
+            0);
+
+        EXPECT_EQ(
+            info.sha256,
+            Common::FileSystem::fileSystem()->calculateDigest(Common::SslImpl::Digest::sha256, zipFile));
+    }
+
+    TEST_F(TestZipUtils, zip_stopsOnceMaxSizeIsExceeded)
+    {
+        Tests::TempDir tempDir;
+        // Random-ish content so it doesn't compress below the limit
+        std::string content;
+        unsigned int value = 1;
+        for (int i = 0; i < 100000; ++i)
+        {
+            value = value * 1103515245 + 12345;
+            content += static_cast<char>(value >> 16);
+        }
+        tempDir.createFile("src/a.bin", content);
+        tempDir.createFile("src/b.bin", content);
+        std::string zipFile = tempDir.absPath("out.zip");
+
+        Common::ZipUtilities::ZipOutputInfo info;
+        EXPECT_NE(
+            Common::ZipUtilities::zipUtils().zip(tempDir.absPath("src"), zipFile, false, false, "", 50000, info), 0);
+
+        EXPECT_TRUE(info.exceededMaxSize);
+        EXPECT_TRUE(info.sha256.empty());
+        // Only what was written before the limit is counted
+        EXPECT_LE(info.sizeBytes, 50000);
+        EXPECT_LE(Common::FileSystem::fileSystem()->fileSize(zipFile), 50000);
+    }
+}
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #include "Common/Logging/ConsoleLoggingSetup.h"
 #include "ManagementAgent/EventReceiverImpl/EventReceiverImpl.h"
@@ -34,6 +34,25 @@ TEST_F(TestEventReceiverImpl, ReceivingEventCausesATaskToBeQueued)
     EXPECT_FALSE(queue->empty());
 }
 
+TEST_F(TestEventReceiverImpl, EventsReceivedBeforeTheSpoolIsFlushedShareOneTask)
+{
+    auto queue = std::make_shared<FakeQueue>();
+    ManagementAgent::EventReceiverImpl::EventReceiverImpl foo(queue);
+    foo.receivedSendEvent("APPID", "EventXML1");
+    foo.receivedSendEvent("APPID", "EventXML2");
+    foo.receivedSendEvent("OTHER", "EventXML3");
+    EXPECT_EQ(queue->size(), 1);
+}
+
+TEST_F(TestEventReceiverImpl, AlcEventsGetATaskEach)
+{
+    auto queue = std::make_shared<FakeQueue>();
+    ManagementAgent::EventReceiverImpl::EventReceiverImpl foo(queue);
+    foo.receivedSendEvent("ALC", "EventXML1");
+    foo.receivedSendEvent("ALC", "EventXML2");
+    EXPECT_EQ(queue->size(), 2);
+}
+
 TEST_F(TestEventReceiverImpl, ReceivingActionDoesNotThrow)
 {
     auto queue = std::make_shared<FakeQueue>();
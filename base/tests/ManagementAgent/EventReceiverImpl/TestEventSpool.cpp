@@ -0,0 +1,127 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Class under test
+#include "ManagementAgent/EventReceiverImpl/EventSpool.h"
+// Product
+#include "Common/ApplicationConfiguration/IApplicationPathManager.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
+// Test helpers
+#include "tests/Common/Helpers/FileSystemReplaceAndRestore.h"
+#include "tests/Common/Helpers/LogInitializedTests.h"
+#include "tests/Common/Helpers/MockFileSystem.h"
+// 3rd parties
+#include <gtest/gtest.h>
+
+using ManagementAgent::EventReceiverImpl::Event;
+using ManagementAgent::EventReceiverImpl::EventSpool;
+
+namespace
+{
+    constexpr mode_t EVENT_FILE_MODE = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+
+    class TestEventSpool : public LogInitializedTests
+    {
+    public:
+        TestEventSpool()
+        {
+            auto filesystemMock = std::make_unique<StrictMock<MockFileSystem>>();
+            filesystemMock_ = filesystemMock.get();
+            replacer_.replace(std::move(filesystemMock));
+        }
+
+        std::string tempDir_ = Common::ApplicationConfiguration::applicationPathManager().getTempPath();
+        StrictMock<MockFileSystem>* filesystemMock_;
+        Tests::ScopedReplaceFileSystem replacer_;
+    };
+} // namespace
+
+TEST_F(TestEventSpool, SerialiseWritesLengthPrefixedRecords)
+{
+    EXPECT_EQ(EventSpool::serialise({ { "CORE", "<a>\n</a>" }, { "SAV", "" } }), "CORE 8\n<a>\n</a>\nSAV 0\n\n");
+}
+
+TEST_F(TestEventSpool, AddReportsWhenTheSpoolWasEmpty)
+{
+    EventSpool spool;
+    EXPECT_TRUE(spool.add({ "APPID", "XML1" }));
+    EXPECT_FALSE(spool.add({ "APPID", "XML2" }));
+}
+
+TEST_F(TestEventSpool, FlushingEmptySpoolWritesNothing)
+{
+    EventSpool spool;
+    EXPECT_EQ(spool.flush(), 0);
+}
+
+TEST_F(TestEventSpool, SingleEventIsWrittenAsAnEventFile)
+{
+    EXPECT_CALL(
+        *filesystemMock_,
+        writeFileAtomically(
+            MatchesRegex("/opt/sophos-spl/base/mcs/event/APPID_event-.*\\.xml"), "XML", tempDir_, EVENT_FILE_MODE))
+        .WillOnce(Return());
+
+    EventSpool spool;
+    spool.add({ "APPID", "XML" });
+    EXPECT_EQ(spool.flush(), 1);
+}
+
+TEST_F(TestEventSpool, SeveralEventsAreWrittenToOneSpoolFile)
+{
+    std::vector<Event> events{ { "APPID", "XML1" }, { "OTHER", "XML2" }, { "APPID", "XML3" } };
+    EXPECT_CALL(
+        *filesystemMock_,
+        writeFileAtomically(
+            MatchesRegex("/opt/sophos-spl/base/mcs/event/events-[0-9]+\\.spool"),
+            EventSpool::serialise(events),
+            tempDir_,
+            EVENT_FILE_MODE))
+        .WillOnce(Return());
+
+    EventSpool spool;
+    for (const auto& event : events)
+    {
+        spool.add(event);
+    }
+    EXPECT_EQ(spool.flush(), 3);
+    EXPECT_EQ(spool.flush(), 0);
+}
+
+TEST_F(TestEventSpool, SpoolFilesAreLimitedInSize)
+{
+    EXPECT_CALL(
+        *filesystemMock_,
+        writeFileAtomically(
+            MatchesRegex("/opt/sophos-spl/base/mcs/event/events-[0-9]+\\.spool"),
+            EventSpool::serialise({ { "APPID", "XML1" }, { "APPID", "XML2" } }),
+            tempDir_,
+            EVENT_FILE_MODE))
+        .WillOnce(Return());
+    EXPECT_CALL(
+        *filesystemMock_,
+        writeFileAtomically(
+            MatchesRegex("/opt/sophos-spl/base/mcs/event/events-[0-9]+-1\\.spool"),
+            EventSpool::serialise({ { "APPID", "XML3" }, { "APPID", "XML4" } }),
+            tempDir_,
+            EVENT_FILE_MODE))
+        .WillOnce(Return());
+
+    EventSpool spool(2);
+    for (int i = 1; i <= 4; ++i)
+    {
+        spool.add({ "APPID", "XML" + std::to_string(i) });
+    }
+    EXPECT_EQ(spool.flush(), 4);
+}
+
+TEST_F(TestEventSpool, FailedWriteIsNotCounted)
+{
+    EXPECT_CALL(*filesystemMock_, writeFileAtomically(_, _, _, _))
+        .WillOnce(Throw(Common::FileSystem::IFileSystemException("TEST")));
+
+    EventSpool spool;
+    spool.add({ "APPID", "XML1" });
+    spool.add({ "APPID", "XML2" });
+    EXPECT_EQ(spool.flush(), 0);
+}
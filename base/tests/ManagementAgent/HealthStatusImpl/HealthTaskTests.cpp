@@ -14,6 +14,9 @@
 
 namespace
 {
+    using PluginsAndPrevHealthMissing = std::map<std::string, bool>;
+    using HealthStatuses = std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus>;
+
     class HealthTaskTests : public testing::Test
     {
     protected:
@@ -118,8 +121,8 @@ TEST_F(HealthTaskTests, run_healthStatusMessageIsUpdatedWhenStatusFileFailsToWri
         isFile(Common::ApplicationConfiguration::applicationPathManager().getThreatHealthJsonFilePath()))
         .WillOnce(Return(false));
     EXPECT_CALL(m_mockPluginManager, getRegisteredPluginNames()).Times(3).WillRepeatedly(Return(std::vector<std::string>{"pluginone"}));
-    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugin("pluginone", false)).Times(2).WillRepeatedly(Return(pluginHealthBad));
-    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugin("pluginone", false)).WillOnce(Return(pluginHealthGood)).RetiresOnSaturation();
+    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugins(PluginsAndPrevHealthMissing{ { "pluginone", false } })).Times(2).WillRepeatedly(Return(HealthStatuses{ { "pluginone", pluginHealthBad } }));
+    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugins(PluginsAndPrevHealthMissing{ { "pluginone", false } })).WillOnce(Return(HealthStatuses{ { "pluginone", pluginHealthGood } })).RetiresOnSaturation();
     auto healthStatus = std::make_shared<ManagementAgent::HealthStatusImpl::HealthStatus>();
     EXPECT_CALL(m_mockPluginManager, getSharedHealthStatusObj()).WillRepeatedly(Return(healthStatus));
 
@@ -169,8 +172,8 @@ TEST_F(HealthTaskTests, run_healthStatusMessageIsUpdatedWithCorrectUtmInformatio
             isFile(Common::ApplicationConfiguration::applicationPathManager().getThreatHealthJsonFilePath()))
             .WillOnce(Return(false));
     EXPECT_CALL(m_mockPluginManager, getRegisteredPluginNames()).Times(3).WillRepeatedly(Return(std::vector<std::string>{"pluginone"}));
-    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugin("pluginone", false)).Times(2).WillRepeatedly(Return(pluginHealthBad));
-    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugin("pluginone", false)).WillOnce(Return(pluginHealthGood)).RetiresOnSaturation();
+    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugins(PluginsAndPrevHealthMissing{ { "pluginone", false } })).Times(2).WillRepeatedly(Return(HealthStatuses{ { "pluginone", pluginHealthBad } }));
+    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugins(PluginsAndPrevHealthMissing{ { "pluginone", false } })).WillOnce(Return(HealthStatuses{ { "pluginone", pluginHealthGood } })).RetiresOnSaturation();
     auto healthStatus = std::make_shared<ManagementAgent::HealthStatusImpl::HealthStatus>();
     EXPECT_CALL(m_mockPluginManager, getSharedHealthStatusObj()).WillRepeatedly(Return(healthStatus));
 
@@ -216,7 +219,7 @@ TEST_F(HealthTaskTests, run_healthRemovesMissingPluginsIfNotFoundInRegistry)
         .WillOnce(Return(false));
 
     EXPECT_CALL(m_mockPluginManager, getRegisteredPluginNames()).WillOnce(Return(std::vector<std::string>{ "plugin" }));
-    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugin("plugin", false)).WillOnce(Return(pluginHealthMissing));
+    EXPECT_CALL(m_mockPluginManager, getHealthStatusForPlugins(PluginsAndPrevHealthMissing{ { "plugin", false } })).WillOnce(Return(HealthStatuses{ { "plugin", pluginHealthMissing } }));
     auto healthStatus = std::make_shared<ManagementAgent::HealthStatusImpl::HealthStatus>();
     EXPECT_CALL(m_mockPluginManager, checkIfSinglePluginInRegistry("plugin")).WillOnce(Return(false));
     EXPECT_CALL(m_mockPluginManager, removePlugin("plugin"));
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -36,6 +36,9 @@ public:
         (std::shared_ptr<ManagementAgent::PluginCommunication::IThreatHealthReceiver>& receiver));
     MOCK_METHOD(ManagementAgent::PluginCommunication::PluginHealthStatus, getHealthStatusForPlugin,
         (const std::string& pluginName, bool prevHealthMissing));
+    MOCK_METHOD((std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus>),
+        getHealthStatusForPlugins,
+        ((const std::map<std::string, bool>& pluginsAndPrevHealthMissing)));
     MOCK_METHOD(std::shared_ptr<ManagementAgent::HealthStatusImpl::HealthStatus>, getSharedHealthStatusObj, ());
     MOCK_METHOD(bool, updateOngoingWithGracePeriod, (unsigned int gracePeriodSeconds, timepoint_t now));
 };
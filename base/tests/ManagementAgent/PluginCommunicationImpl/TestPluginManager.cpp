@@ -467,6 +467,65 @@ TEST_F(TestPluginManager, TestGetHealthOnRemovedPluginThrows)
         Common::PluginCommunication::IPluginCommunicationException);
 }
 
+TEST_F(TestPluginManager, TestGetHealthStatusForPluginsWithoutHealthDoesNotCallPlugin)
+{
+    EXPECT_CALL(*m_mockedPluginApiCallback, getHealth()).Times(0);
+    auto healthStatuses = m_pluginManagerPtr->getHealthStatusForPlugins(
+        { { m_pluginOneName, false }, { "plugin_not_registered", false } });
+    ASSERT_EQ(healthStatuses.size(), 1);
+    EXPECT_EQ(
+        healthStatuses[m_pluginOneName].healthType, ManagementAgent::PluginCommunication::HealthType::NONE);
+}
+
+TEST_F(TestPluginManager, TestGetHealthStatusForPluginsReturnsPluginHealth)
+{
+    Common::PluginRegistryImpl::PluginInfo pluginInfo;
+    pluginInfo.setHasServiceHealth(true);
+    pluginInfo.setDisplayPluginName("Plugin One");
+    m_pluginManagerPtr->registerAndConfigure(m_pluginOneName, pluginInfo);
+
+    nlohmann::json healthJson;
+    healthJson["Health"] = 1;
+    EXPECT_CALL(*m_mockedPluginApiCallback, getHealth()).Times(1).WillOnce(Return(healthJson.dump()));
+    std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus> healthStatuses;
+    std::thread getHealth([this, &healthStatuses]() {
+      healthStatuses = m_pluginManagerPtr->getHealthStatusForPlugins({ { m_pluginOneName, false } });
+    });
+    getHealth.join();
+
+    ASSERT_EQ(healthStatuses.count(m_pluginOneName), 1);
+    EXPECT_EQ(
+        healthStatuses[m_pluginOneName].healthType, ManagementAgent::PluginCommunication::HealthType::SERVICE);
+    EXPECT_EQ(healthStatuses[m_pluginOneName].healthValue, 1);
+    EXPECT_EQ(healthStatuses[m_pluginOneName].displayName, "Plugin One");
+}
+
+TEST_F(TestPluginManager, TestGetHealthStatusForPluginsWaitsForAPluginThatAnswersWithinTheRequestTimeout)
+{
+    Common::PluginRegistryImpl::PluginInfo pluginInfo;
+    pluginInfo.setHasServiceHealth(true);
+    m_pluginManagerPtr->registerAndConfigure(m_pluginOneName, pluginInfo);
+
+    nlohmann::json healthJson;
+    healthJson["Health"] = 1;
+    // Slow, but inside the 5 second plugin request timeout
+    EXPECT_CALL(*m_mockedPluginApiCallback, getHealth())
+        .WillOnce(Invoke(
+            [&healthJson]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(4500));
+                return healthJson.dump();
+            }));
+    std::map<std::string, ManagementAgent::PluginCommunication::PluginHealthStatus> healthStatuses;
+    std::thread getHealth([this, &healthStatuses]() {
+      healthStatuses = m_pluginManagerPtr->getHealthStatusForPlugins({ { m_pluginOneName, false } });
+    });
+    getHealth.join();
+
+    ASSERT_EQ(healthStatuses.count(m_pluginOneName), 1);
+    EXPECT_EQ(healthStatuses[m_pluginOneName].healthValue, 1);
+}
+
 TEST_F(TestPluginManager, TestRegistrationOfASeccondPluginWithTheSameName)
 {
     auto& fileSystemMock = setupFileSystemAndGetMock();
@@ -103,6 +103,24 @@ TEST_F(TestPluginServerCallbackHandler, TestServerCallbackHandlerReturnsAcknowle
         .WillOnce(Return());
     Common::PluginProtocol::DataMessage ackMessage =
         createAcknowledgementMessage(Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT);
+    ackMessage.m_payload = { Common::PluginProtocol::MessageBuilder::EVENT_BATCHES_ACCEPTED };
+    auto replyMessage = sendReceive(eventMessage);
+    EXPECT_PRED_FORMAT2(dataMessageSimilar, ackMessage, replyMessage);
+}
+
+TEST_F(TestPluginServerCallbackHandler, TestServerCallbackHandlerPassesOnEachEventInABatch)
+{
+    Common::PluginProtocol::DataMessage eventMessage =
+        createDefaultMessage(Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT, std::string("Event1"));
+    eventMessage.m_payload.emplace_back("Event2");
+    {
+        InSequence seq;
+        EXPECT_CALL(*m_mockServerCallback, receivedSendEvent(eventMessage.m_applicationId, "Event1"));
+        EXPECT_CALL(*m_mockServerCallback, receivedSendEvent(eventMessage.m_applicationId, "Event2"));
+    }
+    Common::PluginProtocol::DataMessage ackMessage =
+        createAcknowledgementMessage(Common::PluginProtocol::Commands::PLUGIN_SEND_EVENT);
+    ackMessage.m_payload = { Common::PluginProtocol::MessageBuilder::EVENT_BATCHES_ACCEPTED };
     auto replyMessage = sendReceive(eventMessage);
     EXPECT_PRED_FORMAT2(dataMessageSimilar, ackMessage, replyMessage);
 }
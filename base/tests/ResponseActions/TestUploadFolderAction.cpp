@@ -73,10 +73,13 @@ public:
         EXPECT_CALL(*m_mockHttpRequester, put(_)).WillOnce(Return(httpresponse));
     }
 
-    void setupMockZipUtils(const int& returnVal = UNZ_OK)
+    void setupMockZipUtils(
+        const int& returnVal = UNZ_OK,
+        const Common::ZipUtilities::ZipOutputInfo& info = { 100, "sha256string", false })
     {
         auto mockZip = std::make_unique<NiceMock<MockZipUtils>>();
-        EXPECT_CALL(*mockZip, zip(_, _, _)).WillOnce(Return(returnVal));
+        EXPECT_CALL(*mockZip, zip(_, _, false, false, "", _, _))
+            .WillOnce(DoAll(SetArgReferee<6>(info), Return(returnVal)));
         Common::ZipUtilities::replaceZipUtils(std::move(mockZip));
     }
 
@@ -106,22 +109,22 @@ TEST_F(UploadFolderTests, SuccessCaseWithPassword)
     replaceApplicationPathManager(std::move(mockAppManager));
 
     auto mockZip = std::make_unique<NiceMock<MockZipUtils>>();
-    EXPECT_CALL(*mockZip, zip(_, _, _, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(*mockZip, zip(folderPath, zipFile, false, true, "password", 1000, _))
+        .WillOnce(DoAll(SetArgReferee<6>(Common::ZipUtilities::ZipOutputInfo{ 8, "sha256string", false }), Return(0)));
     Common::ZipUtilities::replaceZipUtils(std::move(mockZip));
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory(folderPath)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(zipFile)).Times(1);
     EXPECT_CALL(*m_mockFileSystem, isFile(zipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, isFile("")).WillOnce(Return(false));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(zipFile)).WillOnce(Return(8));
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, zipFile))
-        .WillOnce(Return("sha256string"));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
     nlohmann::json response = uploadFolderAction.run(action.dump());
 
     EXPECT_EQ(response["result"], ResponseResult::SUCCESS);
     EXPECT_EQ(response["httpStatus"], 200);
+    EXPECT_EQ(response["sizeBytes"], 8);
+    EXPECT_EQ(response["sha256"], "sha256string");
 }
 
 TEST_F(UploadFolderTests, SuccessCase)
@@ -133,11 +136,8 @@ TEST_F(UploadFolderTests, SuccessCase)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -145,6 +145,30 @@ TEST_F(UploadFolderTests, SuccessCase)
 
     EXPECT_EQ(response["result"], ResponseResult::SUCCESS);
     EXPECT_EQ(response["httpStatus"], 200);
+    EXPECT_EQ(response["sizeBytes"], 100);
+    EXPECT_EQ(response["sha256"], "sha256string");
+}
+
+TEST_F(UploadFolderTests, DigestReadFromZipFileWhenNotCalculatedWhileZipping)
+{
+    addResponseToMockRequester(HTTP_STATUS_OK, ResponseErrorCode::OK);
+    setupMockZipUtils(UNZ_OK, { 100, "", false });
+
+    ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
+    nlohmann::json action = getDefaultUploadObject();
+
+    EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
+    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
+        .WillOnce(Return("digestFromFile"));
+    EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
+    Tests::replaceFileSystem(std::move(m_mockFileSystem));
+
+    nlohmann::json response = uploadFolderAction.run(action.dump());
+
+    EXPECT_EQ(response["result"], ResponseResult::SUCCESS);
+    EXPECT_EQ(response["sha256"], "digestFromFile");
 }
 
 TEST_F(UploadFolderTests, successHugeURL)
@@ -162,11 +186,8 @@ TEST_F(UploadFolderTests, successHugeURL)
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -204,10 +225,7 @@ TEST_F(UploadFolderTests, successHugePath)
     EXPECT_CALL(*m_mockFileSystem, isDirectory(largeTargetPath)).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     EXPECT_CALL(*m_mockFileSystem, isFile(zipfile)).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(zipfile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, removeFile(zipfile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, zipfile))
-        .WillOnce(Return("sha256string"));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
     nlohmann::json action = getDefaultUploadObject();
@@ -231,18 +249,15 @@ TEST_F(UploadFolderTests, successEmptyPassword)
     addResponseToMockRequester(HTTP_STATUS_OK, ResponseErrorCode::OK);
 
     auto mockZip = std::make_unique<NiceMock<MockZipUtils>>();
-    EXPECT_CALL(*mockZip, zip(_, _, _)).WillOnce(Return(UNZ_OK));
-    EXPECT_CALL(*mockZip, zip(_, _, _, _, _)).Times(0);
+    EXPECT_CALL(*mockZip, zip(_, _, false, false, "", _, _))
+        .WillOnce(DoAll(SetArgReferee<6>(Common::ZipUtilities::ZipOutputInfo{ 100, "sha256string", false }), Return(UNZ_OK)));
     Common::ZipUtilities::replaceZipUtils(std::move(mockZip));
 
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -271,18 +286,15 @@ TEST_F(UploadFolderTests, successHugePassword)
     addResponseToMockRequester(HTTP_STATUS_OK, ResponseErrorCode::OK);
 
     auto mockZip = std::make_unique<NiceMock<MockZipUtils>>();
-    EXPECT_CALL(*mockZip, zip(_, _, _)).Times(0);
-    EXPECT_CALL(*mockZip, zip(_, _, _, _, _)).WillOnce(Return(UNZ_OK));
+    EXPECT_CALL(*mockZip, zip(_, _, false, true, largePassword, _, _))
+        .WillOnce(DoAll(SetArgReferee<6>(Common::ZipUtilities::ZipOutputInfo{ 100, "sha256string", false }), Return(UNZ_OK)));
     Common::ZipUtilities::replaceZipUtils(std::move(mockZip));
 
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -312,11 +324,8 @@ TEST_F(UploadFolderTests, SuccessCaseWithProxy)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(true));
     std::string obfuscatedCreds =
         "CCD4E57ZjW+t5XPiMSJH1TurG3MfWCN3DpjJRINMwqNaWl+3zzlVIdyVmifCHUwcmaX6+YTSyyBM8SslIIGV5rUw";
@@ -346,11 +355,8 @@ TEST_F(UploadFolderTests, ProxyFallsBackToDirect)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(true));
     std::string obfuscatedCreds =
         "CCD4E57ZjW+t5XPiMSJH1TurG3MfWCN3DpjJRINMwqNaWl+3zzlVIdyVmifCHUwcmaX6+YTSyyBM8SslIIGV5rUw";
@@ -497,13 +503,12 @@ TEST_F(UploadFolderTests, emptyPath)
 
 TEST_F(UploadFolderTests, ZippedFolderOverSizeLimit)
 {
-    setupMockZipUtils();
+    setupMockZipUtils(UNZ_ERRNO, { 1000, "", true });
 
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(10000));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
@@ -514,19 +519,18 @@ TEST_F(UploadFolderTests, ZippedFolderOverSizeLimit)
     EXPECT_EQ(response["errorType"], "exceed_size_limit");
     EXPECT_EQ(
         response["errorMessage"],
-        "Folder at path /tmp/path after being compressed is size 10000 bytes which is above the size limit 1000 bytes");
+        "Folder at path /tmp/path after being compressed is above the size limit 1000 bytes");
 }
 
 TEST_F(UploadFolderTests, ZippedFolderOverSizeLimitNotSet)
 {
-    setupMockZipUtils();
+    setupMockZipUtils(UNZ_ERRNO, { 0, "", true });
 
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
     nlohmann::json action = getDefaultUploadObject();
     action.at("maxUploadSizeBytes") = 0;
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(1));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
@@ -537,7 +541,7 @@ TEST_F(UploadFolderTests, ZippedFolderOverSizeLimitNotSet)
     EXPECT_EQ(response["errorType"], "exceed_size_limit");
     EXPECT_EQ(
         response["errorMessage"],
-        "Folder at path /tmp/path after being compressed is size 1 bytes which is above the size limit 0 bytes");
+        "Folder at path /tmp/path after being compressed is above the size limit 0 bytes");
 }
 
 TEST_F(UploadFolderTests, ZipFails)
@@ -569,7 +573,7 @@ TEST_F(UploadFolderTests, ZipFailsDueToLargeFile)
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
     auto mockZip = std::make_unique<NiceMock<MockZipUtils>>();
-    ON_CALL(*mockZip, zip(_, _, _)).WillByDefault(Throw(std::runtime_error("")));
+    ON_CALL(*mockZip, zip(_, _, _, _, _, _, _)).WillByDefault(Throw(std::runtime_error("")));
     Common::ZipUtilities::replaceZipUtils(std::move(mockZip));
 
     nlohmann::json response = uploadFolderAction.run(action.dump());
@@ -580,13 +584,12 @@ TEST_F(UploadFolderTests, ZipFailsDueToLargeFile)
 
 TEST_F(UploadFolderTests, FileBeingWrittenToAndOverSizeLimit)
 {
-    setupMockZipUtils();
+    setupMockZipUtils(UNZ_OK, { 100, "", false });
 
     ResponseActionsImpl::UploadFolderAction uploadFolderAction(m_mockHttpRequester,m_mockSignalHandler, m_mockSysCallWrapper);
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
     EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
@@ -609,11 +612,8 @@ TEST_F(UploadFolderTests, FailureDueToTimeout)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -635,9 +635,6 @@ TEST_F(UploadFolderTests, FailureDueToNetworkError)
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -658,11 +655,8 @@ TEST_F(UploadFolderTests, FailureDueToServerError)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -682,11 +676,8 @@ TEST_F(UploadFolderTests, FailureDueToServerCertError)
     setupMockZipUtils();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).WillOnce(Return());
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-        .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -710,11 +701,8 @@ TEST_F(UploadFolderTests, terminateSignal)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-            .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -736,11 +724,8 @@ TEST_F(UploadFolderTests, timeoutSignal)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-            .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
@@ -764,11 +749,8 @@ TEST_F(UploadFolderTests, PpollErrorContinueWhenEINTR)
     nlohmann::json action = getDefaultUploadObject();
 
     EXPECT_CALL(*m_mockFileSystem, isDirectory("/tmp/path")).WillOnce(Return(true));
-    EXPECT_CALL(*m_mockFileSystem, fileSize(m_defaultZipFile)).WillOnce(Return(100));
     EXPECT_CALL(*m_mockFileSystem, isFile(m_defaultZipFile)).Times(1).WillOnce(Return(true));
     EXPECT_CALL(*m_mockFileSystem, removeFile(m_defaultZipFile)).Times(1);
-    EXPECT_CALL(*m_mockFileSystem, calculateDigest(Common::SslImpl::Digest::sha256, m_defaultZipFile))
-            .WillOnce(Return("sha256string"));
     EXPECT_CALL(*m_mockFileSystem, isFile("/opt/sophos-spl/base/etc/sophosspl/current_proxy")).WillOnce(Return(false));
     Tests::replaceFileSystem(std::move(m_mockFileSystem));
 
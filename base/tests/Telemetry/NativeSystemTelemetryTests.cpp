@@ -0,0 +1,158 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "Telemetry/TelemetryImpl/NativeSystemTelemetry.h"
+#include "Telemetry/TelemetryImpl/SystemTelemetryConfig.h"
+#include "tests/Common/Helpers/TempDir.h"
+
+#include <gtest/gtest.h>
+
+#include <regex>
+#include <sys/utsname.h>
+
+using namespace Telemetry;
+
+namespace
+{
+    // The first capture group of the configured regex in the first line it matches, as the collector finds it
+    std::string matchConfigRegex(const std::string& item, const std::string& output)
+    {
+        const auto& config = item == "disks" ? systemTelemetryArraysConfig() : systemTelemetryObjectsConfig();
+        std::regex re(std::get<2>(config.at(item)));
+        std::istringstream lines(output);
+        for (std::string line; std::getline(lines, line);)
+        {
+            std::smatch match;
+            if (std::regex_search(line, match, re) && match.size() > 1)
+            {
+                return match[1];
+            }
+        }
+        return "";
+    }
+
+    struct statvfs fileSystemStats(unsigned long blocks, unsigned long free, unsigned long available)
+    {
+        struct statvfs stats
+        {
+        };
+        stats.f_frsize = 4096;
+        stats.f_blocks = blocks;
+        stats.f_bfree = free;
+        stats.f_bavail = available;
+        return stats;
+    }
+} // namespace
+
+TEST(NativeSystemTelemetryTests, kernelMatchesConfigRegex)
+{
+    struct utsname name
+    {
+    };
+    ASSERT_EQ(uname(&name), 0);
+    EXPECT_EQ(matchConfigRegex("kernel", NativeSystemTelemetry::kernel()), std::string(name.sysname) + " " + name.release);
+}
+
+TEST(NativeSystemTelemetryTests, architectureMatchesConfigRegex)
+{
+    struct utsname name
+    {
+    };
+    ASSERT_EQ(uname(&name), 0);
+    EXPECT_EQ(matchConfigRegex("architecture", NativeSystemTelemetry::architecture()), name.machine);
+}
+
+TEST(NativeSystemTelemetryTests, cpuCoresCountsProcessors)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile(
+        "cpuinfo",
+        "processor\t: 0\nmodel name\t: CPU\n\nprocessor\t: 1\nmodel name\t: CPU\n\nprocessor\t: 2\n");
+
+    EXPECT_EQ(matchConfigRegex("cpu-cores", NativeSystemTelemetry::cpuCores(tempDir.absPath("cpuinfo"))), "3");
+}
+
+TEST(NativeSystemTelemetryTests, cpuCoresThrowsWithoutProcessors)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile("cpuinfo", "");
+
+    EXPECT_THROW(NativeSystemTelemetry::cpuCores(tempDir.absPath("cpuinfo")), std::runtime_error);
+}
+
+TEST(NativeSystemTelemetryTests, memoryTotalMatchesConfigRegex)
+{
+    EXPECT_FALSE(matchConfigRegex("memory-total", NativeSystemTelemetry::memoryTotal()).empty());
+}
+
+TEST(NativeSystemTelemetryTests, localeIsReadFromFirstConfigWithLang)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile("default-locale", "# comment\nLANG=\"en_GB.UTF-8\"\nLANGUAGE=en_GB:en\n");
+
+    auto output = NativeSystemTelemetry::locale({ tempDir.absPath("locale.conf"), tempDir.absPath("default-locale") });
+
+    EXPECT_EQ(matchConfigRegex("locale", output), "en_GB.UTF-8");
+}
+
+TEST(NativeSystemTelemetryTests, localeThrowsWithoutLang)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile("locale.conf", "LC_TIME=C\n");
+
+    EXPECT_THROW(NativeSystemTelemetry::locale({ tempDir.absPath("locale.conf") }), std::runtime_error);
+}
+
+TEST(NativeSystemTelemetryTests, uptimeMatchesConfigRegex)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile("uptime", "350735.47 234388.90\n");
+
+    EXPECT_EQ(matchConfigRegex("uptime", NativeSystemTelemetry::uptime(tempDir.absPath("uptime"))), "350735");
+}
+
+TEST(NativeSystemTelemetryTests, selinuxReportsEnforcement)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile("selinux/enforce", "1");
+    EXPECT_EQ(matchConfigRegex("selinux", NativeSystemTelemetry::selinux(tempDir.absPath("selinux"))), "Enforcing");
+
+    tempDir.createFile("selinux/enforce", "0");
+    EXPECT_EQ(matchConfigRegex("selinux", NativeSystemTelemetry::selinux(tempDir.absPath("selinux"))), "Permissive");
+}
+
+TEST(NativeSystemTelemetryTests, selinuxThrowsWithoutSelinuxFs)
+{
+    Tests::TempDir tempDir;
+    EXPECT_THROW(NativeSystemTelemetry::selinux(tempDir.absPath("selinux")), std::runtime_error);
+}
+
+TEST(NativeSystemTelemetryTests, disksReportsEachLocalDeviceOnce)
+{
+    Tests::TempDir tempDir;
+    tempDir.createFile(
+        "mountinfo",
+        "22 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+        "23 22 0:5 / /proc rw,nosuid - proc proc rw\n"
+        "24 22 0:24 / /run rw,nosuid shared:5 - tmpfs tmpfs rw,size=814448k\n"
+        "25 22 8:1 /var/lib /srv/bind rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+        "26 22 0:50 / /mnt/nfs rw,relatime - nfs4 server:/export rw\n"
+        "27 22 8:2 / /mnt/my\\040disk rw,relatime - xfs /dev/sda2 rw\n");
+    std::map<std::string, struct statvfs> stats{ { "/", fileSystemStats(10255160, 1705983, 1182625) },
+                                                 { "/proc", fileSystemStats(0, 0, 0) },
+                                                 { "/run", fileSystemStats(203612, 203226, 203226) },
+                                                 { "/srv/bind", fileSystemStats(10255160, 1705983, 1182625) },
+                                                 { "/mnt/nfs", fileSystemStats(1000, 500, 500) },
+                                                 { "/mnt/my disk", fileSystemStats(1000, 250, 250) } };
+
+    auto output = NativeSystemTelemetry::disks(
+        tempDir.absPath("mountinfo"),
+        [&stats](const std::string& mountPoint) -> std::optional<struct statvfs> { return stats.at(mountPoint); });
+
+    EXPECT_EQ(
+        output,
+        "Filesystem Type 1K-blocks Used Available Use% Mounted on\n"
+        "/dev/sda1 ext4 41020640 34196708 4730500 88% /\n"
+        "tmpfs tmpfs 814448 1544 812904 1% /run\n"
+        "/dev/sda2 xfs 4000 3000 1000 75% /mnt/my disk\n");
+    EXPECT_EQ(matchConfigRegex("disks", output), "ext4");
+}
@@ -451,3 +451,70 @@ TEST_F(SystemTelemetryCollectorImplTests, CollectObjectsSelinuxOk)
     ASSERT_NE(selinuxStatus, stringValue.cend());
     ASSERT_EQ(std::get<std::string>(selinuxStatus->second[0].second), enforcementLevel);
 }
+
+TEST_F(SystemTelemetryCollectorImplTests, NativeSourceIsUsedWithoutRunningCommand)
+{
+    bool processCreated = false;
+    Common::ProcessImpl::ProcessFactory::instance().replaceCreator(
+        [&processCreated]() -> std::unique_ptr<Common::Process::IProcess>
+        {
+            processCreated = true;
+            return nullptr;
+        });
+    Telemetry::NativeTelemetrySources nativeSources{ { "cpu-cores", []() { return L_lscpulines; } },
+                                                     { "disks", []() { return L_dfTLocalLines; } } };
+
+    Telemetry::SystemTelemetryCollectorImpl systemTelemetryCollectorImpl(
+        lscpuTelemetryConfig(), Telemetry::systemTelemetryArraysConfig(), 100, 10, nativeSources);
+
+    auto objects = systemTelemetryCollectorImpl.collectObjects();
+    auto arrays = systemTelemetryCollectorImpl.collectArraysOfObjects();
+
+    EXPECT_FALSE(processCreated);
+    ASSERT_EQ(objects.count("cpu-cores"), 1);
+    EXPECT_EQ(std::get<int>(objects["cpu-cores"][0].second), 2);
+    ASSERT_EQ(arrays.count("disks"), 1);
+    ASSERT_EQ(arrays["disks"].size(), 4);
+    EXPECT_EQ(std::get<std::string>(arrays["disks"][2][0].second), "ext4");
+    EXPECT_EQ(std::get<int>(arrays["disks"][2][1].second), 4730500);
+}
+
+TEST_F(SystemTelemetryCollectorImplTests, CommandIsRunWhenNativeSourceFails)
+{
+    setupMockProcesses(lscpuTelemetryConfig().size());
+    auto& mockProcess_ = mockProcesses_[0];
+    Telemetry::NativeTelemetrySources nativeSources{
+        { "cpu-cores", []() -> std::string { throw std::runtime_error("No cpuinfo"); } }
+    };
+
+    Telemetry::SystemTelemetryCollectorImpl systemTelemetryCollectorImpl(lscpuTelemetryConfig(), {}, 100, 10, nativeSources);
+
+    EXPECT_CALL(*mockProcess_, exec(_, _));
+    EXPECT_CALL(*mockProcess_, setOutputLimit(_));
+    EXPECT_CALL(*mockProcess_, wait(_, _)).WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+    EXPECT_CALL(*mockProcess_, output()).WillOnce(Return(L_lscpulines));
+    EXPECT_CALL(*mockProcess_, exitCode()).WillRepeatedly(Return(EXIT_SUCCESS));
+
+    auto intValue = systemTelemetryCollectorImpl.collectObjects();
+    ASSERT_EQ(intValue.count("cpu-cores"), 1);
+    EXPECT_EQ(std::get<int>(intValue["cpu-cores"][0].second), 2);
+}
+
+TEST_F(SystemTelemetryCollectorImplTests, CommandIsRunWhenNativeOutputDoesNotMatch)
+{
+    setupMockProcesses(archTelemetryConfig().size());
+    auto& mockProcess_ = mockProcesses_[0];
+    Telemetry::NativeTelemetrySources nativeSources{ { "architecture", []() { return std::string("?\n"); } } };
+
+    Telemetry::SystemTelemetryCollectorImpl systemTelemetryCollectorImpl(archTelemetryConfig(), {}, 100, 10, nativeSources);
+
+    EXPECT_CALL(*mockProcess_, exec(_, _));
+    EXPECT_CALL(*mockProcess_, setOutputLimit(_));
+    EXPECT_CALL(*mockProcess_, wait(_, _)).WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+    EXPECT_CALL(*mockProcess_, output()).WillOnce(Return("x86_64\n"));
+    EXPECT_CALL(*mockProcess_, exitCode()).WillRepeatedly(Return(EXIT_SUCCESS));
+
+    auto values = systemTelemetryCollectorImpl.collectObjects();
+    ASSERT_EQ(values.count("architecture"), 1);
+    EXPECT_EQ(std::get<std::string>(values["architecture"][0].second), "x86_64");
+}
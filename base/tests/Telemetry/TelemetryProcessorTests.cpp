@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 /**
  * Component tests for Telemetry Executable
@@ -19,6 +19,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <future>
+
 using ::testing::StrictMock;
 
 class TelemetryProcessorTest : public LogInitializedTests
@@ -125,6 +127,47 @@ TEST_F(TelemetryProcessorTest, telemetryProcessorThreeProvidersOneThrows)
     ASSERT_EQ(R"({"Mock1":{"key":1},"Mock2":{"health":1},"Mock3":{"key":3}})", json);
 }
 
+TEST_F(TelemetryProcessorTest, telemetryProcessorAsksProvidersConcurrently)
+{
+    auto mockTelemetryProvider1 = std::make_shared<MockTelemetryProvider>();
+    auto mockTelemetryProvider2 = std::make_shared<MockTelemetryProvider>();
+
+    // Each provider only replies once the other one has been asked
+    std::promise<void> provider1Asked;
+    std::promise<void> provider2Asked;
+    auto provider2AskedFuture = provider2Asked.get_future();
+    auto provider1AskedFuture = provider1Asked.get_future();
+    EXPECT_CALL(*mockTelemetryProvider1, getName()).WillOnce(Return("Mock1"));
+    EXPECT_CALL(*mockTelemetryProvider1, getTelemetry())
+        .WillOnce(Invoke(
+            [&]()
+            {
+                provider1Asked.set_value();
+                return provider2AskedFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready
+                           ? std::string(R"({"key":1})")
+                           : std::string(R"({"key":"timeout"})");
+            }));
+    EXPECT_CALL(*mockTelemetryProvider2, getName()).WillOnce(Return("Mock2"));
+    EXPECT_CALL(*mockTelemetryProvider2, getTelemetry())
+        .WillOnce(Invoke(
+            [&]()
+            {
+                provider2Asked.set_value();
+                return provider1AskedFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready
+                           ? std::string(R"({"key":2})")
+                           : std::string(R"({"key":"timeout"})");
+            }));
+
+    std::vector<std::shared_ptr<Telemetry::ITelemetryProvider>> telemetryProviders;
+    telemetryProviders.emplace_back(mockTelemetryProvider1);
+    telemetryProviders.emplace_back(mockTelemetryProvider2);
+
+    DerivedTelemetryProcessor telemetryProcessor(m_config, std::move(m_httpRequester), telemetryProviders);
+    telemetryProcessor.gatherTelemetry();
+    std::string json = telemetryProcessor.getSerialisedTelemetry();
+    ASSERT_EQ(R"({"Mock1":{"key":1},"Mock2":{"key":2}})", json);
+}
+
 TEST_F(TelemetryProcessorTest, telemetryProcessorWritesJsonToFile)
 {
     auto mockTelemetryProvider = std::make_shared<MockTelemetryProvider>();
@@ -1,4 +1,4 @@
-// Copyright 2018-2023 Sophos Limited. All rights reserved.
+// Copyright 2018-2024 Sophos Limited. All rights reserved.
 #include "DownloadReportTestBuilder.h"
 
 #include "Common/FileSystemImpl/FileSystemImpl.h"
@@ -19,6 +19,23 @@ using Common::DownloadReport::RepositoryStatus;
 class TestDownloadReportAnalyser : public ::testing::Test
 {
 public:
+    static constexpr const char* INDEX_PATH = "/opt/sophos-spl/base/update/var/updatescheduler/report_index.json";
+
+    // Each test starts with an empty index, and no index file on disk
+    static void expectReportsIndexUpdated(MockFileSystem& mockFileSystem, const std::vector<std::string>& reportFiles)
+    {
+        const std::string indexPath = INDEX_PATH;
+        EXPECT_CALL(mockFileSystem, isFile(indexPath)).WillOnce(Return(false));
+        for (const auto& reportFile : reportFiles)
+        {
+            EXPECT_CALL(mockFileSystem, lastModifiedTime(reportFile)).WillOnce(Return(1000));
+            EXPECT_CALL(mockFileSystem, fileSize(reportFile)).WillOnce(Return(100));
+        }
+        EXPECT_CALL(mockFileSystem, writeFileAtomically(indexPath, _, _)).WillOnce(Return());
+    }
+
+    DownloadReportsIndex m_reportsIndex{ INDEX_PATH };
+
     ::testing::AssertionResult insertMessagesAreEquivalent(
         const char* m_expr,
         const char* n_expr,
@@ -389,6 +406,7 @@ TEST_F(TestDownloadReportAnalyser, SuccessFollowedBy2FailuresUsingFiles)
     EXPECT_CALL(*mockFileSystem, readFile("update_report_1.json")).WillOnce(Return(file1));
     EXPECT_CALL(*mockFileSystem, readFile("update_report_2.json")).WillOnce(Return(file2));
     EXPECT_CALL(*mockFileSystem, readFile("update_report_3.json")).WillOnce(Return(file3));
+    expectReportsIndexUpdated(*mockFileSystem, { "update_report_1.json", "update_report_2.json", "update_report_3.json" });
 
     EXPECT_CALL(*mockFileSystem, isFile("/opt/sophos-spl/base/update/var/updatescheduler/processedReports/update_report_1.json"))
         .WillOnce(Return(true));
@@ -400,7 +418,7 @@ TEST_F(TestDownloadReportAnalyser, SuccessFollowedBy2FailuresUsingFiles)
     std::unique_ptr<MockFileSystem> mockIFileSystemPtr = std::unique_ptr<MockFileSystem>(mockFileSystem);
     Tests::ScopedReplaceFileSystem scopedReplaceFileSystem(std::move(mockIFileSystemPtr));
 
-    ReportAndFiles reportAndFiles = DownloadReportsAnalyser::processReports();
+    ReportAndFiles reportAndFiles = DownloadReportsAnalyser::processReports(m_reportsIndex);
     ReportCollectionResult collectionResult = reportAndFiles.reportCollectionResult;
 
     std::vector<std::string> sortedOrder{ "update_report_1.json", "update_report_2.json", "update_report_3.json" };
@@ -441,11 +459,12 @@ TEST_F(TestDownloadReportAnalyser, ReportFileWithUnReadableDataLogsErrorAndFilte
     EXPECT_CALL(*mockFileSystem, readFile("update_report_2.json")).WillOnce(Return(goodFile));
     EXPECT_CALL(*mockFileSystem, isFile("/opt/sophos-spl/base/update/var/updatescheduler/processedReports/update_report_2.json"))
         .WillOnce(Return(false));
+    expectReportsIndexUpdated(*mockFileSystem, { "update_report_1.json", "update_report_2.json" });
 
     std::unique_ptr<MockFileSystem> mockIFileSystemPtr = std::unique_ptr<MockFileSystem>(mockFileSystem);
     Tests::ScopedReplaceFileSystem scopedReplaceFileSystem(std::move(mockIFileSystemPtr));
 
-    ReportAndFiles reportAndFiles = DownloadReportsAnalyser::processReports();
+    ReportAndFiles reportAndFiles = DownloadReportsAnalyser::processReports(m_reportsIndex);
     ReportCollectionResult collectionResult = reportAndFiles.reportCollectionResult;
 
     std::vector<std::string> sortedOrder{ "update_report_2.json" };
@@ -466,6 +485,30 @@ TEST_F(TestDownloadReportAnalyser, ReportFileWithUnReadableDataLogsErrorAndFilte
     EXPECT_THAT(logMessage, ::testing::HasSubstr("Failed to process file: update_report_1.json"));
 }
 
+TEST_F(TestDownloadReportAnalyser, ReportsCachedByOneIndexAreReadAgainByAnother)
+{
+    std::string file = DownloadReportTestBuilder::goodReportString(DownloadReportTestBuilder::UseTime::Previous);
+    std::vector<std::string> files{ "update_report_1.json" };
+    auto mockFileSystem = new StrictMock<MockFileSystem>();
+    EXPECT_CALL(*mockFileSystem, listFiles(_)).Times(2).WillRepeatedly(Return(files));
+    EXPECT_CALL(*mockFileSystem, readFile("update_report_1.json")).Times(2).WillRepeatedly(Return(file));
+    EXPECT_CALL(*mockFileSystem, isFile("/opt/sophos-spl/base/update/var/updatescheduler/processedReports/update_report_1.json"))
+        .Times(2)
+        .WillRepeatedly(Return(false));
+    EXPECT_CALL(*mockFileSystem, isFile(std::string(INDEX_PATH))).Times(2).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mockFileSystem, lastModifiedTime("update_report_1.json")).Times(2).WillRepeatedly(Return(1000));
+    EXPECT_CALL(*mockFileSystem, fileSize("update_report_1.json")).Times(2).WillRepeatedly(Return(100));
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(std::string(INDEX_PATH), _, _)).Times(2);
+
+    std::unique_ptr<MockFileSystem> mockIFileSystemPtr = std::unique_ptr<MockFileSystem>(mockFileSystem);
+    Tests::ScopedReplaceFileSystem scopedReplaceFileSystem(std::move(mockIFileSystemPtr));
+
+    EXPECT_EQ(DownloadReportsAnalyser::processReports(m_reportsIndex).sortedFilePaths, files);
+
+    DownloadReportsIndex otherIndex{ INDEX_PATH };
+    EXPECT_EQ(DownloadReportsAnalyser::processReports(otherIndex).sortedFilePaths, files);
+}
+
 TEST_F(TestDownloadReportAnalyser, ProductsAreListedIfPossibleEvenOnConnectionError)
 {
     DownloadReportsAnalyser::DownloadReportVector twoReports{ DownloadReportTestBuilder::goodReport(
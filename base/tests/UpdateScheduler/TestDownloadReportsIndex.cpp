@@ -0,0 +1,155 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+#include "DownloadReportTestBuilder.h"
+
+#include "Common/Logging/ConsoleLoggingSetup.h"
+#include "UpdateSchedulerImpl/configModule/DownloadReportsIndex.h"
+#include "tests/Common/Helpers/FileSystemReplaceAndRestore.h"
+#include "tests/Common/Helpers/MockFileSystem.h"
+
+#include <gtest/gtest.h>
+
+using namespace UpdateSchedulerImpl::configModule;
+using namespace ::testing;
+
+namespace
+{
+    const std::string REPORT_DIR = "/reports";
+    const std::string PROCESSED_DIR = "/reports/processedReports";
+    const std::string INDEX_PATH = "/reports/report_index.json";
+    const std::string REPORT_1 = "/reports/update_report_1.json";
+    const std::string REPORT_2 = "/reports/update_report_2.json";
+
+    class TestDownloadReportsIndex : public ::testing::Test
+    {
+    public:
+        TestDownloadReportsIndex()
+        {
+            m_mockFileSystem = new StrictMock<MockFileSystem>();
+            m_replacer.replace(std::unique_ptr<Common::FileSystem::IFileSystem>(m_mockFileSystem));
+            EXPECT_CALL(*m_mockFileSystem, isFile(HasSubstr(PROCESSED_DIR))).WillRepeatedly(Return(false));
+            m_report1 = DownloadReportTestBuilder::goodReportString(DownloadReportTestBuilder::UseTime::Previous);
+            m_report2 = DownloadReportTestBuilder::getPluginFailedToInstallReportString(
+                DownloadReportTestBuilder::UseTime::Later);
+        }
+
+        void expectReport(const std::string& path, std::time_t modifiedTime, off_t size)
+        {
+            EXPECT_CALL(*m_mockFileSystem, lastModifiedTime(path)).WillRepeatedly(Return(modifiedTime));
+            EXPECT_CALL(*m_mockFileSystem, fileSize(path)).WillRepeatedly(Return(size));
+        }
+
+        StrictMock<MockFileSystem>* m_mockFileSystem;
+        Tests::ScopedReplaceFileSystem m_replacer;
+        std::string m_report1;
+        std::string m_report2;
+
+    private:
+        Common::Logging::ConsoleLoggingSetup m_loggingSetup;
+    };
+} // namespace
+
+TEST_F(TestDownloadReportsIndex, unchangedReportsAreNotParsedAgain)
+{
+    EXPECT_CALL(*m_mockFileSystem, listFiles(REPORT_DIR))
+        .WillRepeatedly(Return(std::vector<std::string>{ REPORT_2, REPORT_1 }));
+    expectReport(REPORT_1, 1000, 100);
+    expectReport(REPORT_2, 2000, 200);
+    EXPECT_CALL(*m_mockFileSystem, isFile(INDEX_PATH)).WillOnce(Return(false)).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_1)).WillOnce(Return(m_report1));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_2)).WillOnce(Return(m_report2));
+    EXPECT_CALL(*m_mockFileSystem, writeFileAtomically(INDEX_PATH, _, _)).WillOnce(Return());
+
+    DownloadReportsIndex index(INDEX_PATH);
+    auto first = index.refresh(REPORT_DIR, PROCESSED_DIR, true);
+    EXPECT_EQ(index.lastRefreshStats().parsed, 2);
+
+    auto second = index.refresh(REPORT_DIR, PROCESSED_DIR, true);
+    EXPECT_EQ(index.lastRefreshStats().parsed, 0);
+    EXPECT_EQ(index.lastRefreshStats().cached, 2);
+
+    ASSERT_EQ(second.size(), 2);
+    EXPECT_EQ(second[0].filepath, REPORT_1);
+    EXPECT_EQ(second[1].filepath, REPORT_2);
+    ASSERT_TRUE(second[1].report.has_value());
+    EXPECT_EQ(second[1].report->getStatus(), first[1].report->getStatus());
+}
+
+TEST_F(TestDownloadReportsIndex, changedReportIsParsedAgain)
+{
+    EXPECT_CALL(*m_mockFileSystem, listFiles(REPORT_DIR)).WillRepeatedly(Return(std::vector<std::string>{ REPORT_1 }));
+    EXPECT_CALL(*m_mockFileSystem, lastModifiedTime(REPORT_1)).WillOnce(Return(1000)).WillOnce(Return(1001));
+    EXPECT_CALL(*m_mockFileSystem, fileSize(REPORT_1)).WillRepeatedly(Return(100));
+    EXPECT_CALL(*m_mockFileSystem, isFile(INDEX_PATH)).WillOnce(Return(false)).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_1)).WillOnce(Return(m_report1)).WillOnce(Return(m_report2));
+    EXPECT_CALL(*m_mockFileSystem, writeFileAtomically(INDEX_PATH, _, _)).Times(2);
+
+    DownloadReportsIndex index(INDEX_PATH);
+    auto first = index.refresh(REPORT_DIR, PROCESSED_DIR, false);
+    auto second = index.refresh(REPORT_DIR, PROCESSED_DIR, false);
+
+    EXPECT_EQ(index.lastRefreshStats().parsed, 1);
+    ASSERT_EQ(second.size(), 1);
+    EXPECT_TRUE(first[0].summary.successfulProductUpdateCheck);
+    EXPECT_FALSE(second[0].summary.successfulProductUpdateCheck);
+}
+
+TEST_F(TestDownloadReportsIndex, summariesAreLoadedFromTheSavedIndexWithoutParsingReports)
+{
+    EXPECT_CALL(*m_mockFileSystem, listFiles(REPORT_DIR))
+        .WillRepeatedly(Return(std::vector<std::string>{ REPORT_1, REPORT_2 }));
+    expectReport(REPORT_1, 1000, 100);
+    expectReport(REPORT_2, 2000, 200);
+    std::string savedIndex;
+    EXPECT_CALL(*m_mockFileSystem, isFile(INDEX_PATH)).WillOnce(Return(false)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_1)).WillOnce(Return(m_report1));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_2)).WillOnce(Return(m_report2));
+    EXPECT_CALL(*m_mockFileSystem, writeFileAtomically(INDEX_PATH, _, _)).WillOnce(SaveArg<1>(&savedIndex));
+
+    std::vector<DownloadReportsIndex::Entry> parsed;
+    {
+        DownloadReportsIndex index(INDEX_PATH);
+        parsed = index.refresh(REPORT_DIR, PROCESSED_DIR, false);
+    }
+
+    // As if the process had restarted
+    EXPECT_CALL(*m_mockFileSystem, readFile(INDEX_PATH)).WillOnce(Return(savedIndex));
+    DownloadReportsIndex index(INDEX_PATH);
+    auto loaded = index.refresh(REPORT_DIR, PROCESSED_DIR, false);
+
+    EXPECT_EQ(index.lastRefreshStats().parsed, 0);
+    ASSERT_EQ(loaded.size(), 2);
+    for (size_t i = 0; i < loaded.size(); i++)
+    {
+        EXPECT_EQ(loaded[i].filepath, parsed[i].filepath);
+        EXPECT_EQ(loaded[i].summary.startTime, parsed[i].summary.startTime);
+        EXPECT_EQ(loaded[i].summary.status, parsed[i].summary.status);
+        EXPECT_EQ(loaded[i].summary.successfulProductUpdateCheck, parsed[i].summary.successfulProductUpdateCheck);
+        EXPECT_EQ(loaded[i].summary.products, parsed[i].summary.products);
+        EXPECT_FALSE(loaded[i].report.has_value());
+    }
+}
+
+TEST_F(TestDownloadReportsIndex, removedReportsAreDroppedFromTheIndex)
+{
+    EXPECT_CALL(*m_mockFileSystem, listFiles(REPORT_DIR))
+        .WillOnce(Return(std::vector<std::string>{ REPORT_1, REPORT_2 }))
+        .WillOnce(Return(std::vector<std::string>{ REPORT_2 }));
+    expectReport(REPORT_1, 1000, 100);
+    expectReport(REPORT_2, 2000, 200);
+    EXPECT_CALL(*m_mockFileSystem, isFile(INDEX_PATH)).WillOnce(Return(false)).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_1)).WillOnce(Return(m_report1));
+    EXPECT_CALL(*m_mockFileSystem, readFile(REPORT_2)).WillOnce(Return(m_report2));
+    std::string savedIndex;
+    EXPECT_CALL(*m_mockFileSystem, writeFileAtomically(INDEX_PATH, _, _))
+        .WillOnce(Return())
+        .WillOnce(SaveArg<1>(&savedIndex));
+
+    DownloadReportsIndex index(INDEX_PATH);
+    index.refresh(REPORT_DIR, PROCESSED_DIR, true);
+    auto entries = index.refresh(REPORT_DIR, PROCESSED_DIR, true);
+
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[0].filepath, REPORT_2);
+    EXPECT_EQ(savedIndex.find("update_report_1.json"), std::string::npos);
+    EXPECT_NE(savedIndex.find("update_report_2.json"), std::string::npos);
+}
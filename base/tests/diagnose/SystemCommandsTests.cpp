@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "Common/Logging/ConsoleLoggingSetup.h"
 #include "Common/ProcessImpl/ProcessImpl.h"
@@ -163,4 +163,31 @@ TEST_F(DiagnoseSystemCommandsTests, RunCommandMultipleTimesWithTimeout)
 
     auto retCodeSuccess = systemCommands.runCommand("df", { "-h" }, "df");
     ASSERT_EQ(retCodeSuccess, EXIT_SUCCESS);
-}
\ No newline at end of file
+}
+
+TEST_F(DiagnoseSystemCommandsTests, RunCommandsAppliesEachCommandsTimeoutAndOutputLimit)
+{
+    setupMocks(2);
+    std::string systemDirPath("/Never/Createdir/");
+    diagnose::SystemCommands systemCommands(systemDirPath);
+    EXPECT_CALL(*m_mockFileSystem, isExecutable(_)).WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*m_mockProcesses[0], setOutputLimit(diagnose::GL_10mbSize));
+    EXPECT_CALL(*m_mockProcesses[0], exec(_, _));
+    EXPECT_CALL(*m_mockProcesses[0], wait(_, diagnose::GL_ProcMaxRetries))
+        .WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+    EXPECT_CALL(*m_mockProcesses[0], output()).WillOnce(Return(L_dfTLocalLines));
+    EXPECT_CALL(*m_mockProcesses[0], exitCode()).WillRepeatedly(Return(EXIT_SUCCESS));
+    EXPECT_CALL(*m_mockFileSystem, writeFile(systemDirPath + "df", L_dfTLocalLines));
+
+    EXPECT_CALL(*m_mockProcesses[1], setOutputLimit(1024));
+    EXPECT_CALL(*m_mockProcesses[1], exec(_, _));
+    EXPECT_CALL(*m_mockProcesses[1], wait(_, 120)).WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+    EXPECT_CALL(*m_mockProcesses[1], output()).WillOnce(Return("journal"));
+    EXPECT_CALL(*m_mockProcesses[1], exitCode()).WillRepeatedly(Return(EXIT_SUCCESS));
+    EXPECT_CALL(*m_mockFileSystem, writeFile(systemDirPath + "journalctl", "journal"));
+
+    // Only one at a time, as the mock process creator isn't thread safe
+    systemCommands.runCommands(
+        { { "df", { "-h" }, "df" }, { "journalctl", {}, "journalctl", {}, std::chrono::seconds(60), 1024 } }, 1);
+}
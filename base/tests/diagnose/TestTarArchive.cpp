@@ -0,0 +1,175 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "Diagnose/diagnose/TarArchive.h"
+
+#include "Common/FileSystem/IFileSystemException.h"
+#include "Common/Logging/ConsoleLoggingSetup.h"
+#include "tests/Common/Helpers/TempDir.h"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <cstring>
+#include <map>
+#include <thread>
+
+namespace
+{
+    struct Entry
+    {
+        char type;
+        std::string content;
+    };
+
+    // Reads back what the archive wrote, enough to check the entries without relying on a tar binary
+    std::map<std::string, Entry> readArchive(const std::string& path)
+    {
+        gzFile file = gzopen(path.c_str(), "rb");
+        EXPECT_NE(file, nullptr);
+        std::string data;
+        char buffer[4096];
+        int bytesRead;
+        while ((bytesRead = gzread(file, buffer, sizeof(buffer))) > 0)
+        {
+            data.append(buffer, bytesRead);
+        }
+        gzclose(file);
+
+        std::map<std::string, Entry> entries;
+        std::string longName;
+        size_t offset = 0;
+        while (offset + 512 <= data.size() && data[offset] != '\0')
+        {
+            const char* header = data.data() + offset;
+            size_t size = std::stoul(std::string(header + 124, 11), nullptr, 8);
+            char type = header[156];
+            std::string content = data.substr(offset + 512, size);
+            offset += 512 + (size + 511) / 512 * 512;
+
+            if (type == 'L')
+            {
+                longName = content.c_str();
+                continue;
+            }
+            std::string name = longName.empty() ? std::string(header, strnlen(header, 100)) : longName;
+            longName.clear();
+            entries[name] = Entry{ type, content };
+        }
+        // Two empty blocks end the archive
+        EXPECT_EQ(data.size() - offset, 1024);
+        return entries;
+    }
+
+    class TestTarArchive : public ::testing::Test
+    {
+    public:
+        TestTarArchive() : m_tempDir("/tmp", "TestTarArchive") {}
+
+        Tests::TempDir m_tempDir;
+
+    private:
+        Common::Logging::ConsoleLoggingSetup m_loggingSetup;
+    };
+} // namespace
+
+TEST_F(TestTarArchive, entriesAreWrittenWithTheirContent)
+{
+    std::string fileContent(2000, 'f');
+    m_tempDir.createFile("source.log", fileContent);
+    std::string archivePath = m_tempDir.absPath("out.tar.gz");
+
+    diagnose::TarArchive archive(archivePath);
+    archive.addDirectory("root/BaseFiles");
+    archive.addData("root/SystemFiles/df", "df output");
+    EXPECT_TRUE(archive.addFile(m_tempDir.absPath("source.log"), "root/BaseFiles/source.log"));
+    archive.close();
+
+    auto entries = readArchive(archivePath);
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_EQ(entries["root/BaseFiles/"].type, '5');
+    EXPECT_EQ(entries["root/SystemFiles/df"].content, "df output");
+    EXPECT_EQ(entries["root/BaseFiles/source.log"].type, '0');
+    EXPECT_EQ(entries["root/BaseFiles/source.log"].content, fileContent);
+}
+
+TEST_F(TestTarArchive, longNamesAreKept)
+{
+    std::string archivePath = m_tempDir.absPath("out.tar.gz");
+    std::string longName = "root/" + std::string(150, 'd') + "/file.log";
+
+    diagnose::TarArchive archive(archivePath);
+    archive.addData(longName, "content");
+    archive.close();
+
+    auto entries = readArchive(archivePath);
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[longName].content, "content");
+}
+
+TEST_F(TestTarArchive, missingFileIsNotAdded)
+{
+    diagnose::TarArchive archive(m_tempDir.absPath("out.tar.gz"));
+
+    EXPECT_FALSE(archive.addFile(m_tempDir.absPath("missing.log"), "root/missing.log"));
+    EXPECT_FALSE(archive.addFile(m_tempDir.dirPath(), "root/directory"));
+    EXPECT_FALSE(archive.contains("root/missing.log"));
+    archive.close();
+}
+
+TEST_F(TestTarArchive, entriesAddedConcurrentlyAreAllWrittenWhole)
+{
+    std::string archivePath = m_tempDir.absPath("out.tar.gz");
+    diagnose::TarArchive archive(archivePath);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back(
+            [&archive, i]()
+            {
+                for (int j = 0; j < 20; ++j)
+                {
+                    std::string name = std::to_string(i) + "-" + std::to_string(j);
+                    archive.addData(name, std::string(1000 + j, static_cast<char>('a' + i)));
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    archive.close();
+
+    auto entries = readArchive(archivePath);
+    ASSERT_EQ(entries.size(), 160);
+    EXPECT_EQ(entries["7-19"].content, std::string(1019, 'h'));
+}
+
+TEST_F(TestTarArchive, entriesCannotBeAddedOnceClosed)
+{
+    diagnose::TarArchive archive(m_tempDir.absPath("out.tar.gz"));
+    archive.close();
+
+    EXPECT_THROW(archive.addData("root/late", "content"), std::runtime_error);
+}
+
+TEST_F(TestTarArchive, writingToAFullDeviceThrowsFileSystemException)
+{
+    // Compressed output is buffered, so the failure may only be seen when the archive is closed
+    auto writeArchive = []()
+    {
+        diagnose::TarArchive archive("/dev/full");
+        archive.addData("root/data", std::string(1024 * 1024, 'd'));
+        archive.close();
+    };
+
+    try
+    {
+        writeArchive();
+        FAIL() << "Expected IFileSystemException";
+    }
+    catch (const Common::FileSystem::IFileSystemException& ex)
+    {
+        EXPECT_NE(std::string(ex.what()).find("check space available on device"), std::string::npos);
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Compares writing events for mcsrouter one file per event against writing them through the event spool
+
+#include "Common/ApplicationConfiguration/IApplicationConfiguration.h"
+#include "Common/ApplicationConfiguration/IApplicationPathManager.h"
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/Logging/ConsoleLoggingSetup.h"
+#include "ManagementAgent/EventReceiverImpl/Event.h"
+#include "ManagementAgent/EventReceiverImpl/EventSpool.h"
+
+#include <chrono>
+#include <iostream>
+
+using ManagementAgent::EventReceiverImpl::Event;
+using ManagementAgent::EventReceiverImpl::EventSpool;
+
+namespace
+{
+    const std::string EVENT_XML = R"sophos(<?xml version="1.0" encoding="utf-8"?>
+<event type="sophos.core.detection" ts="1970-01-01T00:02:03.000Z">
+  <user userId="username"/>
+  <alert id="fedcba98-7654-3210-fedc-ba9876543210" name="EICAR-AV-Test" threatType="1" origin="1" remote="true">
+    <sha256>131f95c51cc819465fa1797f6ccacf9d494aaaff46fa3eac73ae63ffbdfd8267</sha256>
+    <path>/path/to/eicar.txt</path>
+  </alert>
+</event>)sophos";
+
+    void clearEventDir()
+    {
+        auto fs = Common::FileSystem::fileSystem();
+        for (const auto& file :
+             fs->listFiles(Common::ApplicationConfiguration::applicationPathManager().getMcsEventFilePath()))
+        {
+            fs->removeFile(file);
+        }
+    }
+
+    void report(const std::string& name, int events, std::chrono::steady_clock::duration elapsed)
+    {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << name << ": " << events << " events in " << seconds << "s, " << events / seconds
+                  << " events/s" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <empty directory to use as install root> [events]" << std::endl;
+        return EINVAL;
+    }
+    int events = argc == 3 ? std::stoi(argv[2]) : 10000;
+
+    Common::Logging::ConsoleLoggingSetup loggingSetup;
+    Common::ApplicationConfiguration::applicationConfiguration().setData(
+        Common::ApplicationConfiguration::SOPHOS_INSTALL, argv[1]);
+    auto fs = Common::FileSystem::fileSystem();
+    fs->makedirs(Common::ApplicationConfiguration::applicationPathManager().getMcsEventFilePath());
+    fs->makedirs(Common::ApplicationConfiguration::applicationPathManager().getTempPath());
+    clearEventDir();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < events; ++i)
+    {
+        Event{ "CORE", EVENT_XML }.send();
+    }
+    report("Event file per event", events, std::chrono::steady_clock::now() - start);
+    clearEventDir();
+
+    // Worst case for the spool: every event is flushed before the next one arrives
+    EventSpool spool;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < events; ++i)
+    {
+        spool.add({ "CORE", EVENT_XML });
+        spool.flush();
+    }
+    report("Spool flushed per event", events, std::chrono::steady_clock::now() - start);
+    clearEventDir();
+
+    for (size_t backlog : { 10, 100, 1000 })
+    {
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < events; ++i)
+        {
+            spool.add({ "CORE", EVENT_XML });
+            if ((i + 1) % backlog == 0)
+            {
+                spool.flush();
+            }
+        }
+        spool.flush();
+        report("Spool flushed every " + std::to_string(backlog) + " events", events,
+               std::chrono::steady_clock::now() - start);
+        clearEventDir();
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Compares hashing a large file through an istream against FileSystemImpl's pread based digests.
+// Usage: FileDigestBenchmark <file to create> [size in MiB]
+
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/SslImpl/Digest.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+using Common::SslImpl::Digest;
+
+namespace
+{
+    void report(const std::string& name, size_t bytes, std::chrono::steady_clock::duration elapsed)
+    {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << name << ": " << seconds << "s, " << bytes / seconds / (1024 * 1024) << " MiB/s" << std::endl;
+    }
+
+    void createFile(const std::string& path, size_t bytes)
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string block(1024 * 1024, '\0');
+        for (size_t i = 0; i < block.size(); ++i)
+        {
+            block[i] = static_cast<char>(i * 31);
+        }
+        for (size_t written = 0; written < bytes; written += block.size())
+        {
+            out.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), bytes - written)));
+        }
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <file to create> [size in MiB]" << std::endl;
+        return EINVAL;
+    }
+    const std::string path = argv[1];
+    const size_t bytes = (argc == 3 ? std::stoul(argv[2]) : 1024) * 1024 * 1024;
+    createFile(path, bytes);
+    auto fs = Common::FileSystem::fileSystem();
+
+    // The first run pulls the file into the page cache, so the later runs compare hashing not disk reads
+    {
+        std::ifstream in(path, std::ios::binary);
+        auto start = std::chrono::steady_clock::now();
+        std::ignore = Common::SslImpl::calculateDigest(Digest::sha256, in);
+        report("istream SHA-256 (first run)", bytes, std::chrono::steady_clock::now() - start);
+    }
+    for (auto digest : { Digest::sha1, Digest::sha256 })
+    {
+        std::ifstream in(path, std::ios::binary);
+        auto start = std::chrono::steady_clock::now();
+        std::ignore = Common::SslImpl::calculateDigest(digest, in);
+        report(std::string("istream ") + (digest == Digest::sha1 ? "SHA-1" : "SHA-256"), bytes,
+               std::chrono::steady_clock::now() - start);
+    }
+
+    for (auto digest : { Digest::sha1, Digest::sha256 })
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::ignore = fs->calculateDigest(digest, path);
+        report(std::string("calculateDigest ") + (digest == Digest::sha1 ? "SHA-1" : "SHA-256"), bytes,
+               std::chrono::steady_clock::now() - start);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::ignore = fs->calculateDigests({ Digest::sha1, Digest::sha256 }, path);
+    report("calculateDigests SHA-1 and SHA-256 in one pass", bytes, std::chrono::steady_clock::now() - start);
+
+    fs->removeFile(path);
+    return 0;
+}
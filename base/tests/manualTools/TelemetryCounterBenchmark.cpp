@@ -0,0 +1,63 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Compares incrementing telemetry by key with incrementing a registered counter, from several threads at once
+
+#include "Common/TelemetryHelperImpl/TelemetryHelper.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    template<typename Increment>
+    void run(const std::string& name, int threadCount, int incrementsPerThread, Increment increment)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (int j = 0; j < incrementsPerThread; ++j)
+                    {
+                        increment();
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long increments = static_cast<long>(threadCount) * incrementsPerThread;
+        std::cout << name << " with " << threadCount << " threads: " << increments / seconds / 1e6
+                  << " million increments/s" << std::endl;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int incrementsPerThread = argc == 2 ? std::stoi(argv[1]) : 1000000;
+    const std::string key = "journaler.attempted-journal-writes";
+
+    for (int threadCount : { 1, 2, 4, 8, 16 })
+    {
+        Common::Telemetry::TelemetryHelper byKeyHelper;
+        run("increment(key)", threadCount, incrementsPerThread, [&]() { byKeyHelper.increment(key, 1L); });
+
+        Common::Telemetry::TelemetryHelper counterHelper;
+        auto counter = counterHelper.registerCounter(key);
+        run("TelemetryCounter", threadCount, incrementsPerThread, [&]() { counter.increment(); });
+
+        if (byKeyHelper.serialise() != counterHelper.serialise())
+        {
+            std::cerr << "Totals differ: " << byKeyHelper.serialise() << " " << counterHelper.serialise()
+                      << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Compares pub/sub throughput of the copying read/write API against readFrames/writeFrames.
+// Usage: ZmqPubSubBenchmark [message size in KiB] [message count] [address]
+// The address defaults to inproc, use an ipc:// address to include the socket transport.
+
+#include "Common/ZMQWrapperApi/IContext.h"
+#include "Common/ZeroMQWrapper/IIPCException.h"
+#include "Common/ZeroMQWrapper/ISocketPublisher.h"
+#include "Common/ZeroMQWrapper/ISocketSubscriber.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using Common::ZeroMQWrapper::BufferFrame;
+using Common::ZeroMQWrapper::frames_t;
+using Common::ZeroMQWrapper::StringFrame;
+
+namespace
+{
+    const std::string WARMUP = "warmup";
+    const std::string TOPIC = "bench";
+
+    struct Received
+    {
+        size_t messages = 0;
+        size_t bytes = 0;
+        std::chrono::steady_clock::duration elapsed{ 0 };
+    };
+
+    void report(const std::string& name, size_t sent, const Received& received)
+    {
+        double seconds = std::chrono::duration<double>(received.elapsed).count();
+        std::cout << name << ": " << received.messages << "/" << sent << " messages in " << seconds << "s, "
+                  << received.messages / seconds << " msg/s, " << received.bytes / seconds / (1024 * 1024) << " MiB/s"
+                  << std::endl;
+    }
+
+    // PUB drops messages a slow subscriber can't queue, so the subscriber reads until the publisher goes quiet
+    Received run(const std::string& address, size_t count, bool useFrames, const std::string& payload)
+    {
+        auto context = Common::ZMQWrapperApi::createContext();
+        auto subscriber = context->getSubscriber();
+        subscriber->setTimeout(1000);
+        subscriber->listen(address);
+        subscriber->subscribeTo("");
+        auto publisher = context->getPublisher();
+        publisher->connect(address);
+
+        std::atomic<bool> subscribed{ false };
+        Received received;
+        std::thread reader(
+            [&]()
+            {
+                std::chrono::steady_clock::time_point start;
+                std::chrono::steady_clock::time_point last;
+                try
+                {
+                    while (true)
+                    {
+                        std::string topic;
+                        size_t bytes = 0;
+                        if (useFrames)
+                        {
+                            auto frames = subscriber->readFrames();
+                            topic = frames.at(0)->view();
+                            bytes = frames.at(1)->size();
+                        }
+                        else
+                        {
+                            auto data = subscriber->read();
+                            topic = data.at(0);
+                            bytes = data.at(1).size();
+                        }
+                        if (topic == WARMUP)
+                        {
+                            subscribed = true;
+                            continue;
+                        }
+                        last = std::chrono::steady_clock::now();
+                        if (received.messages++ == 0)
+                        {
+                            start = last;
+                        }
+                        received.bytes += bytes;
+                    }
+                }
+                catch (const Common::ZeroMQWrapper::IIPCException&)
+                {
+                }
+                received.elapsed = last - start;
+            });
+
+        while (!subscribed)
+        {
+            publisher->write({ WARMUP, "" });
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (useFrames)
+            {
+                frames_t frames;
+                frames.push_back(std::make_unique<StringFrame>(TOPIC));
+                // The payload outlives the context, so there is nothing to free
+                frames.push_back(std::make_unique<BufferFrame>(payload.data(), payload.size(), nullptr));
+                publisher->writeFrames(std::move(frames));
+            }
+            else
+            {
+                publisher->write({ TOPIC, payload });
+            }
+        }
+        reader.join();
+        return received;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " [message size in KiB] [message count] [address]" << std::endl;
+        return EINVAL;
+    }
+    const size_t size = (argc > 1 ? std::stoul(argv[1]) : 64) * 1024;
+    const size_t count = argc > 2 ? std::stoul(argv[2]) : 100000;
+    const std::string address = argc > 3 ? argv[3] : "inproc://ZmqPubSubBenchmark";
+    const std::string payload(size, 'x');
+
+    report("read/write", count, run(address, count, false, payload));
+    report("readFrames/writeFrames", count, run(address, count, true, payload));
+    return 0;
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Copyright 2024 Sophos Limited. All rights reserved.
+
+import os
+import shutil
+import tempfile
+import unittest
+from unittest import mock
+
+import logging
+logger = logging.getLogger("TestEventReceiver")
+
+import PathManager
+
+import mcsrouter.adapters.event_receiver as event_receiver
+
+EVENT_XML = '<?xml version="1.0" encoding="utf-8"?><event type="sophos.core.detection"><path>/tmp/é</path></event>'
+
+
+def spool_record(app_id, body):
+    encoded = body.encode("utf-8")
+    return app_id.encode("utf-8") + b" " + str(len(encoded)).encode("utf-8") + b"\n" + encoded + b"\n"
+
+
+class TestEventReceiver(unittest.TestCase):
+    def setUp(self):
+        self.event_dir = tempfile.mkdtemp()
+        patcher = mock.patch('mcsrouter.utils.path_manager.event_dir', return_value=self.event_dir)
+        patcher.start()
+        self.addCleanup(patcher.stop)
+
+    def tearDown(self):
+        shutil.rmtree(self.event_dir)
+
+    def write(self, name, contents):
+        with open(os.path.join(self.event_dir, name), "wb") as f:
+            f.write(contents)
+
+    def test_receive_reads_event_file(self):
+        self.write("CORE_event-123.xml", EVENT_XML.encode("utf-8"))
+        events = list(event_receiver.receive())
+        self.assertEqual([(app_id, body) for app_id, _, body in events], [("CORE", EVENT_XML)])
+        self.assertEqual(os.listdir(self.event_dir), [])
+
+    def test_receive_reads_every_event_in_spool_in_order(self):
+        body_with_newlines = EVENT_XML.replace("><", ">\n<")
+        self.write("events-123.spool",
+                   spool_record("CORE", EVENT_XML) + spool_record("SAV", body_with_newlines) + spool_record("CORE", ""))
+        events = list(event_receiver.receive())
+        self.assertEqual([(app_id, body) for app_id, _, body in events],
+                         [("CORE", EVENT_XML), ("SAV", body_with_newlines), ("CORE", "")])
+        self.assertEqual(os.listdir(self.event_dir), [])
+
+    def test_receive_skips_spooled_event_with_script_tags(self):
+        self.write("events-123.spool",
+                   spool_record("CORE", "<event><script>bad</script></event>") + spool_record("CORE", EVENT_XML))
+        events = list(event_receiver.receive())
+        self.assertEqual([body for _, _, body in events], [EVENT_XML])
+
+    @mock.patch("logging.Logger.error")
+    def test_receive_removes_truncated_spool(self, *mockargs):
+        self.write("events-123.spool", spool_record("CORE", EVENT_XML)[:-10])
+        self.assertEqual(list(event_receiver.receive()), [])
+        self.assertEqual(os.listdir(self.event_dir), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
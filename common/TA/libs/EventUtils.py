@@ -5,10 +5,47 @@ import os
 from robot.api import logger
 
 
-def check_at_least_one_event_has_substr(event_dir, expected_contents):
-    for f in os.listdir(event_dir):
+def read_events(event_dir):
+    """
+    Returns (path, event xml) for every event waiting for mcsrouter, including each event in a spool file
+    written by Management Agent
+    """
+    events = []
+    for f in sorted(os.listdir(event_dir)):
         path = os.path.join(event_dir, f)
-        contents = open(path).read()
+        if not f.endswith(".spool"):
+            with open(path) as event_file:
+                events.append((path, event_file.read()))
+            continue
+
+        with open(path, "rb") as spool_file:
+            spool = spool_file.read()
+        offset = 0
+        while offset < len(spool):
+            header_end = spool.index(b"\n", offset)
+            app_id, length = spool[offset:header_end].split(b" ")
+            body_start = header_end + 1
+            body_end = body_start + int(length)
+            events.append((path, spool[body_start:body_end].decode("utf-8")))
+            offset = body_end + 1
+    return events
+
+
+def count_mcs_events(event_dir):
+    return len(read_events(event_dir))
+
+
+def check_event_received(event_dir, expected_contents):
+    for path, contents in read_events(event_dir):
+        if contents == expected_contents:
+            logger.info("Found event in %s" % path)
+            return
+
+    raise AssertionError("Failed to find event %s in %s" % (expected_contents, event_dir))
+
+
+def check_at_least_one_event_has_substr(event_dir, expected_contents):
+    for path, contents in read_events(event_dir):
         if expected_contents in contents:
             logger.info("Found %s in %s" % (expected_contents, path))
             return
@@ -1,4 +1,4 @@
-// Copyright 2003-2023 Sophos Limited. All rights reserved.
+// Copyright 2003-2024 Sophos Limited. All rights reserved.
 
 // digest_body.cpp: implementation of the digest_file_body class.
 //
@@ -9,10 +9,9 @@
 #include "iostr_utils.h"
 #include "print.h"
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
-#include <regex>
-#include <vector>
 
 namespace VerificationTool
 {
@@ -48,7 +47,30 @@ namespace VerificationTool
     //	<hex>	   = [0-9,a-f]
     //
 
-    static std::regex shaXXX_regex("#(sha256|sha384) ([a-f0-9]{64,})");
+    // Longest comment line accepted; longer lines fail the parse
+    static const size_t MAX_COMMENT_LINE = 65535;
+
+    // Matches "#sha256 <hex>" or "#sha384 <hex>" with at least 64 hex digits, and nothing else on the line
+    static bool parse_sha_comment(const string& comment, string& algorithm, string& digest)
+    {
+        static const string prefixes[] = { "#sha256 ", "#sha384 " };
+        for (const auto& prefix : prefixes)
+        {
+            if (comment.compare(0, prefix.size(), prefix) != 0)
+            {
+                continue;
+            }
+            auto hex_begin = comment.begin() + static_cast<string::difference_type>(prefix.size());
+            if (comment.size() - prefix.size() < 64 || !all_of(hex_begin, comment.end(), char_class_hex))
+            {
+                return false;
+            }
+            algorithm = prefix.substr(1, prefix.size() - 2);
+            digest.assign(hex_begin, comment.end());
+            return true;
+        }
+        return false;
+    }
 
     // Parse comment lines. Comment lines may contain a keyword followed by arguments,
     // or they contain regular comments, which are ignored. Unknown keywords are ignored
@@ -56,25 +78,29 @@ namespace VerificationTool
     static void parse_comment_line(istream& in, list<file_info>& files)
     {
         using namespace std;
-        vector<char> buffer(65536);
-
-        in.getline(&buffer[0], static_cast<streamsize>(buffer.size()));
+        string comment;
+        getline(in, comment);
+        if (comment.size() > MAX_COMMENT_LINE)
+        {
+            in.setstate(ios::failbit);
+            return;
+        }
 
         // Comment lines apply to the last file_info; if there isn't one, ignore this line.
         if (files.empty())
             return;
 
         file_info& last_file = files.back();
-        string comment(&buffer[0]);
-        smatch match;
+        string algorithm;
+        string digest;
 
         // Look for SHAXXX attribute and save it
-        if (regex_match(comment, match, shaXXX_regex) && match.size() == 3)
+        if (parse_sha_comment(comment, algorithm, digest))
         {
-            if (match[1] == "sha256")
-                last_file.sha256(match[2]);
-            else if (match[1] == "sha384")
-                last_file.sha384(match[2]);
+            if (algorithm == "sha256")
+                last_file.sha256(digest);
+            else if (algorithm == "sha384")
+                last_file.sha384(digest);
         }
     }
 
@@ -1,4 +1,4 @@
-// Copyright 2003-2023 Sophos Limited. All rights reserved.
+// Copyright 2003-2024 Sophos Limited. All rights reserved.
 
 // digest_body_checker.cpp: implementation of the digest_body_checker class.
 //
@@ -7,19 +7,83 @@
 #include "crypto_utils.h"
 
 #include "file_info.h"
+#include "hash.h"
 
 #include "print.h"
 
+#include <fcntl.h>
+
 #include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
+#include <memory>
+#include <unistd.h>
 
 namespace manifest
 {
     using namespace std;
 
+    namespace
+    {
+        constexpr size_t READ_BUFFER_SIZE = 256 * 1024;
+        constexpr size_t READ_BUFFER_ALIGNMENT = 4096;
+
+        // One buffer per verifying thread, page aligned so the kernel can copy into it efficiently
+        char* read_buffer()
+        {
+            thread_local std::unique_ptr<char, decltype(&free)> buffer(
+                static_cast<char*>(aligned_alloc(READ_BUFFER_ALIGNMENT, READ_BUFFER_SIZE)), &free);
+            if (!buffer)
+            {
+                throw std::bad_alloc();
+            }
+            return buffer.get();
+        }
+
+        // Feeds the whole file to every digest in one pass. Returns false if the file can't be read.
+        bool hash_file(int fd, const crypto::hash& digests)
+        {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            char* buffer = read_buffer();
+            while (true)
+            {
+                ssize_t bytes = ::read(fd, buffer, READ_BUFFER_SIZE);
+                if (bytes > 0)
+                {
+                    digests.add_data(buffer, static_cast<size_t>(bytes));
+                    continue;
+                }
+                if (bytes < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                return bytes == 0;
+            }
+        }
+
+        class scoped_fd
+        {
+        public:
+            explicit scoped_fd(int fd) : fd_(fd) {}
+            ~scoped_fd()
+            {
+                if (fd_ >= 0)
+                {
+                    ::close(fd_);
+                }
+            }
+            scoped_fd(const scoped_fd&) = delete;
+            scoped_fd& operator=(const scoped_fd&) = delete;
+
+            [[nodiscard]] int get() const { return fd_; }
+
+        private:
+            int fd_;
+        };
+    } // namespace
+
     file_info::verify_result file_info::verify_file(const file_info::path_t& root_path) const
     {
         // Obtain (relative) path to file as recorded in manifest file
@@ -43,50 +107,39 @@ namespace manifest
         replace(file_path.begin(), file_path.end(), '\\', '/');
 
         // Open file
-        fstream file(file_path.c_str(), ios::in | ios::binary);
-        if (!file) // could not open file
+        scoped_fd file(::open(file_path.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file.get() < 0) // could not open file
         {
             return file_missing;
         }
 
-        // Compare recorded and actual checksum
-        if (sha1().size() == VerificationToolCrypto::sha1size())
+        if (sha1().size() != VerificationToolCrypto::sha1size())
         {
-            std::string actualSHA1 = VerificationToolCrypto::sha1sum(file);
-            if (sha1() != actualSHA1)
-            {
-                //		    PRINT("Incorrect SHA1: expected="<<checksum()<< " actual="<<actualSHA1);
-                return file_invalid;
-            }
+            return file_invalid;
         }
-        else
+
+        // Every recorded checksum is calculated from a single read of the file
+        crypto::hash digests(algorithms_);
+        if (!hash_file(file.get(), digests))
+        {
+            return file_invalid;
+        }
+
+        // Compare recorded and actual checksum
+        if (!digests.is_eq(crypto::ALGO_SHA1, sha1()))
         {
             return file_invalid;
         }
 
         // Check SHA256 comment - enforce sha256 externally if required
-        if (!sha256().empty())
+        if (!sha256().empty() && !digests.is_eq(crypto::ALGO_SHA256, sha256()))
         {
-            file.clear();
-            file.seekg(0, fstream::beg);
-            std::string actualSHA256 = VerificationToolCrypto::sha256sum(file);
-            //        PRINT("Checking SHA256: expected="<<sha256()<< " actual="<<actualSHA256);
-            if (sha256() != actualSHA256)
-            {
-                return file_invalid;
-            }
+            return file_invalid;
         }
 
-        if (!sha384().empty())
+        if (!sha384().empty() && !digests.is_eq(crypto::ALGO_SHA384, sha384()))
         {
-            file.clear();
-            file.seekg(0, fstream::beg);
-            std::string actual = VerificationToolCrypto::sha384sum(file);
-            //        PRINT("Checking SHA256: expected="<<sha256()<< " actual="<<actualSHA256);
-            if (sha384() != actual)
-            {
-                return file_invalid;
-            }
+            return file_invalid;
         }
 
         // File exists and has recorded checksum
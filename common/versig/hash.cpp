@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "hash.h"
 
@@ -165,6 +165,8 @@ crypto::hash::hash(int algorithms)
 {
 }
 
+crypto::hash::~hash() = default;
+
 void crypto::hash::add_data(const char * p, size_t n) const
 {
     bytes_ += n;
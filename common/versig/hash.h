@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #ifndef VERSIG_HASH_H
 #define VERSIG_HASH_H
@@ -24,6 +24,8 @@ namespace crypto
     public:
         using hash_t = std::string;
         explicit hash(int algorithms);
+        // Defined where hash_impl is complete, so hashes can be created outside hash.cpp
+        ~hash();
 
         virtual void add_data(const char *p, size_t n) const;
         virtual void add_stream(std::istream &) const;
@@ -6,12 +6,14 @@
 
 #include "manifest_file.h"
 
+#include "manifest_verifier.h"
 #include "verify_exceptions.h"
 
 #include <cassert>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 using namespace verify_exceptions;
 
@@ -51,28 +53,25 @@ namespace VerificationTool
 
         bool bAllFilesOK = true;
         std::string errorMessage("");
-        ManifestFile::files_iter p = FileRecordsBegin();
-        while (bAllFilesOK && (p != FileRecordsEnd()))
+
+        // Checking stops at the first file without a SHA256 when one is required, so that file is the last one
+        // that needs verifying
+        std::vector<const file_info*> files;
+        for (ManifestFile::files_iter p = FileRecordsBegin(); p != FileRecordsEnd(); ++p)
         {
+            files.push_back(&*p);
             if (requireSHA256 && p->sha256().empty())
             {
                 bAllFilesOK = false;
+                break;
             }
-            switch (p->verify_file(DataDirpath))
-            {
-                case file_info::file_ok:
-                case file_info::file_missing:
-                    break;
-
-                case file_info::file_invalid:
-                    errorMessage = "Invalid file found: " + p->path();
-                    bAllFilesOK = false;
-                    break;
-                default:
-                    bAllFilesOK = false;
-                    break;
-            }
-            ++p;
+        }
+
+        size_t firstInvalid = find_first_invalid_file(files, DataDirpath);
+        if (firstInvalid < files.size())
+        {
+            errorMessage = "Invalid file found: " + files[firstInvalid]->path();
+            bAllFilesOK = false;
         }
 
         return std::make_tuple(bAllFilesOK, errorMessage);
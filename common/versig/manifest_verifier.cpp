@@ -0,0 +1,85 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "manifest_verifier.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace manifest
+{
+    unsigned int default_verify_threads()
+    {
+        return std::clamp(std::thread::hardware_concurrency(), 1U, MAX_VERIFY_THREADS);
+    }
+
+    std::size_t find_first_invalid_file(
+        const std::vector<const file_info*>& files,
+        const file_info::path_t& root_path,
+        unsigned int max_threads)
+    {
+        std::atomic<std::size_t> next { 0 };
+        // The lowest index found to be invalid or to throw so far. Only indices below it still need checking.
+        std::atomic<std::size_t> first_failing { files.size() };
+        std::mutex result_mutex;
+        std::size_t first_invalid = files.size();
+        std::size_t first_error = files.size();
+        std::exception_ptr error;
+
+        auto record_failure = [&first_failing](std::size_t i)
+        {
+            std::size_t current = first_failing;
+            while (i < current && !first_failing.compare_exchange_weak(current, i))
+            {
+            }
+        };
+
+        // Files are handed out in order and every file below the lowest failure is still checked, so the result is
+        // the same as checking the files one at a time.
+        auto worker = [&]()
+        {
+            for (std::size_t i = next++; i < first_failing; i = next++)
+            {
+                try
+                {
+                    if (files[i]->verify_file(root_path) != file_info::file_invalid)
+                    {
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    first_invalid = std::min(first_invalid, i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    if (i < first_error)
+                    {
+                        first_error = i;
+                        error = std::current_exception();
+                    }
+                }
+                record_failure(i);
+            }
+        };
+
+        std::size_t thread_count = std::min<std::size_t>(std::max(max_threads, 1U), files.size());
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < thread_count; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (first_error < first_invalid)
+        {
+            std::rethrow_exception(error);
+        }
+        return first_invalid;
+    }
+} // namespace manifest
@@ -0,0 +1,26 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "file_info.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace manifest
+{
+    // Most threads used to verify files, since verification is limited by disk reads as much as by hashing
+    constexpr unsigned int MAX_VERIFY_THREADS = 8;
+
+    [[nodiscard]] unsigned int default_verify_threads();
+
+    // Verifies each file against its manifest entry, on up to max_threads threads.
+    // Once a file is found to be invalid, only files before it are still handed out.
+    // Missing files are not treated as invalid.
+    // Returns the index of the first invalid file, or files.size() if none are invalid.
+    // An exception from a file before the first invalid one is rethrown once all threads have stopped.
+    [[nodiscard]] std::size_t find_first_invalid_file(
+        const std::vector<const file_info*>& files,
+        const file_info::path_t& root_path,
+        unsigned int max_threads = default_verify_threads());
+} // namespace manifest
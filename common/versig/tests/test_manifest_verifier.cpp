@@ -0,0 +1,135 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "common/versig/digest_body.h"
+#include "common/versig/hash.h"
+#include "common/versig/manifest_verifier.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    using manifest::file_info;
+
+    class TestManifestVerifier : public ::testing::Test
+    {
+    public:
+        void SetUp() override
+        {
+            const auto* test_info = ::testing::UnitTest::GetInstance()->current_test_info();
+            root_ = std::filesystem::temp_directory_path() / (std::string("versig_") + test_info->name());
+            std::filesystem::remove_all(root_);
+            std::filesystem::create_directories(root_);
+        }
+
+        void TearDown() override
+        {
+            std::filesystem::remove_all(root_);
+        }
+
+        file_info write_file(const std::string& name, const std::string& contents)
+        {
+            std::ofstream(root_ / name, std::ios::binary) << contents;
+            file_info info(
+                "./" + name, contents.size(), crypto::hash::digest(crypto::ALGO_SHA1, contents));
+            info.sha256(crypto::hash::digest(crypto::ALGO_SHA256, contents));
+            return info;
+        }
+
+        std::filesystem::path root_;
+    };
+
+    std::vector<const file_info*> pointers(const std::vector<file_info>& files)
+    {
+        std::vector<const file_info*> result;
+        for (const auto& file : files)
+        {
+            result.push_back(&file);
+        }
+        return result;
+    }
+
+    TEST_F(TestManifestVerifier, sha_comments_are_attached_to_previous_file)
+    {
+        std::string sha256(64, 'a');
+        std::string sha384(96, 'b');
+        std::istringstream body(
+            "\"./a\" 1 " + std::string(40, '0') + "\n#sha256 " + sha256 + "\n#sha384 " + sha384 + "\n#other comment\n");
+        VerificationTool::digest_file_body parsed;
+        body >> parsed;
+        ASSERT_FALSE(body.fail());
+        ASSERT_NE(parsed.files_begin(), parsed.files_end());
+        EXPECT_EQ(parsed.files_begin()->sha256(), sha256);
+        EXPECT_EQ(parsed.files_begin()->sha384(), sha384);
+    }
+
+    TEST_F(TestManifestVerifier, malformed_sha_comments_are_ignored)
+    {
+        std::istringstream body(
+            "\"./a\" 1 " + std::string(40, '0') + "\n#sha256 " + std::string(63, 'a') + "\n#sha256 " +
+            std::string(64, 'A') + "\n#sha256 " + std::string(64, 'a') + " \n");
+        VerificationTool::digest_file_body parsed;
+        body >> parsed;
+        ASSERT_FALSE(body.fail());
+        ASSERT_NE(parsed.files_begin(), parsed.files_end());
+        EXPECT_TRUE(parsed.files_begin()->sha256().empty());
+    }
+
+    TEST_F(TestManifestVerifier, verify_file_checks_every_recorded_digest)
+    {
+        auto info = write_file("file", "contents");
+        EXPECT_EQ(info.verify_file(root_.string()), file_info::file_ok);
+
+        info.sha256(std::string(64, '0'));
+        EXPECT_EQ(info.verify_file(root_.string()), file_info::file_invalid);
+    }
+
+    TEST_F(TestManifestVerifier, missing_files_are_not_invalid)
+    {
+        std::vector<file_info> files;
+        files.push_back(write_file("present", "present"));
+        files.emplace_back("./missing", 0, std::string(40, '0'));
+
+        EXPECT_EQ(files[1].verify_file(root_.string()), file_info::file_missing);
+        EXPECT_EQ(manifest::find_first_invalid_file(pointers(files), root_.string()), files.size());
+    }
+
+    TEST_F(TestManifestVerifier, first_invalid_file_is_found_with_many_threads)
+    {
+        std::vector<file_info> files;
+        for (int i = 0; i < 200; ++i)
+        {
+            files.push_back(write_file(std::to_string(i), std::string(i * 100, 'x')));
+        }
+        std::ofstream(root_ / "57", std::ios::binary) << "changed";
+        std::ofstream(root_ / "150", std::ios::binary) << "changed";
+
+        EXPECT_EQ(manifest::find_first_invalid_file(pointers(files), root_.string(), 8), 57);
+        EXPECT_EQ(manifest::find_first_invalid_file(pointers(files), root_.string(), 1), 57);
+    }
+
+    TEST_F(TestManifestVerifier, earlier_invalid_file_is_found_after_a_later_one_fails_first)
+    {
+        std::vector<file_info> files;
+        // Slow to hash, so the later invalid files are found while it is still being checked
+        std::string large(32 * 1024 * 1024, 'x');
+        files.push_back(write_file("large", large));
+        large.back() = 'y';
+        std::ofstream(root_ / "large", std::ios::binary) << large;
+        for (int i = 1; i < 50; ++i)
+        {
+            files.push_back(write_file(std::to_string(i), "contents"));
+            std::ofstream(root_ / std::to_string(i), std::ios::binary) << "changed!";
+        }
+
+        EXPECT_EQ(manifest::find_first_invalid_file(pointers(files), root_.string(), 8), 0);
+    }
+
+    TEST_F(TestManifestVerifier, empty_file_list_is_valid)
+    {
+        EXPECT_EQ(manifest::find_first_invalid_file({}, root_.string()), 0);
+    }
+} // namespace
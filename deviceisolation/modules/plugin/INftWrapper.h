@@ -21,6 +21,9 @@ namespace Plugin
         // Flush all Sophos isolation rules
         virtual IsolateResult clearIsolateRules() = 0;
 
+        // Change the allowed exclusions of the rules applied by applyIsolateRules, without lifting isolation
+        virtual IsolateResult updateIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList) = 0;
+
     };
 
     using INftWrapperPtr = std::shared_ptr<INftWrapper>;
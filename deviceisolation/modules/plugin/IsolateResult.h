@@ -7,7 +7,7 @@ namespace Plugin
     enum class IsolateResult
     {
         SUCCESS,
-        // The rules were not present when trying to remove them
+        // The rules were not present when trying to remove them, or not known when trying to update them
         RULES_NOT_PRESENT,
         // The sophos rules table already exists in nft ruleset
         RULES_ALREADY_PRESENT,
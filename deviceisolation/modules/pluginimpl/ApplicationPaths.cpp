@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "ApplicationPaths.h"
 
@@ -45,6 +45,11 @@ std::string Plugin::networkRulesFile()
     return Common::FileSystem::join(pluginVarDir(), "nft_rules.conf");
 }
 
+std::string Plugin::networkRulesUpdateFile()
+{
+    return Common::FileSystem::join(pluginVarDir(), "nft_rules_update.conf");
+}
+
 std::string Plugin::nftBinary()
 {
     return Common::FileSystem::join(pluginBinDir(), "nft");
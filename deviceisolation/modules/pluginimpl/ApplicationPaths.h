@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 #pragma once
 
 #include <string>
@@ -11,5 +11,6 @@ namespace Plugin
     std::string pluginVarDir();
     std::string pluginLibDir();
     std::string networkRulesFile();
+    std::string networkRulesUpdateFile();
     std::string nftBinary();
 } // namespace Plugin
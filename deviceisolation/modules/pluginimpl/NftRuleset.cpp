@@ -0,0 +1,399 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "NftRuleset.h"
+
+#include "NftWrapper.h"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <tuple>
+
+namespace
+{
+    using Plugin::IsolationExclusion;
+
+    constexpr const char* INDENT = "            ";
+    constexpr const char* INPUT_ALLOW_CHAIN = "INPUT_ALLOW";
+    constexpr const char* OUTPUT_ALLOW_CHAIN = "OUTPUT_ALLOW";
+
+    enum class Chain
+    {
+        INPUT,
+        OUTPUT
+    };
+
+    struct SetDefinition
+    {
+        std::string name;
+        Chain chain;
+        // ip or ip6 for address sets, empty for port sets
+        std::string ipType;
+        // saddr or daddr for address sets, sport or dport for port sets
+        std::string field;
+        // Only accepts TCP packets that don't open a connection, and UDP
+        bool established;
+    };
+
+    std::string setName(Chain chain, const std::string& ipType, const std::string& field, bool established)
+    {
+        std::string name = chain == Chain::INPUT ? "in_" : "out_";
+        if (!ipType.empty())
+        {
+            name += ipType + "_";
+        }
+        name += field;
+        if (established)
+        {
+            name += "_est";
+        }
+        return name;
+    }
+
+    const std::vector<SetDefinition>& setDefinitions()
+    {
+        static const std::vector<SetDefinition> definitions = []()
+        {
+            std::vector<SetDefinition> result;
+            for (auto chain : { Chain::INPUT, Chain::OUTPUT })
+            {
+                const std::string addressField = chain == Chain::INPUT ? "saddr" : "daddr";
+                for (const std::string ipType : { IsolationExclusion::IPv4, IsolationExclusion::IPv6 })
+                {
+                    for (bool established : { false, true })
+                    {
+                        result.push_back({ setName(chain, ipType, addressField, established),
+                                           chain,
+                                           ipType,
+                                           addressField,
+                                           established });
+                    }
+                }
+                for (const std::string portField : { "dport", "sport" })
+                {
+                    for (bool established : { false, true })
+                    {
+                        result.push_back(
+                            { setName(chain, "", portField, established), chain, "", portField, established });
+                    }
+                }
+            }
+            return result;
+        }();
+        return definitions;
+    }
+
+    std::string join(const Plugin::NftRuleset::elements_t& elements)
+    {
+        std::string joined;
+        for (const auto& element : elements)
+        {
+            if (!joined.empty())
+            {
+                joined += ", ";
+            }
+            joined += element;
+        }
+        return joined;
+    }
+
+    // Address, port field and whether only established traffic is accepted, to the ports matched with them
+    using port_groups_t =
+        std::map<std::tuple<std::string, std::string, std::string, bool>, Plugin::NftRuleset::elements_t>;
+
+    std::vector<std::string> groupRules(const port_groups_t& groups, const std::string& addressField)
+    {
+        std::vector<std::string> rules;
+        for (const auto& [key, ports] : groups)
+        {
+            const auto& [ipType, address, portField, established] = key;
+            std::string addressMatch = ipType + " " + addressField + " " + address;
+            std::string portMatch = portField + " " + (ports.size() == 1 ? *ports.begin() : "{ " + join(ports) + " }");
+            rules.push_back(
+                addressMatch + " tcp " + portMatch + (established ? " tcp flags != syn" : "") + " accept");
+            rules.push_back(addressMatch + " udp " + portMatch + " accept");
+        }
+        return rules;
+    }
+
+    void appendSetRules(std::ostream& rules, Chain chain)
+    {
+        for (const auto& set : setDefinitions())
+        {
+            if (set.chain != chain)
+            {
+                continue;
+            }
+            if (!set.ipType.empty())
+            {
+                std::string match = set.ipType + " " + set.field + " @" + set.name;
+                if (set.established)
+                {
+                    rules << INDENT << match << " tcp flags != syn accept\n"
+                          << INDENT << match << " meta l4proto udp accept\n";
+                }
+                else
+                {
+                    rules << INDENT << match << " accept\n";
+                }
+            }
+            else
+            {
+                rules << INDENT << "tcp " << set.field << " @" << set.name
+                      << (set.established ? " tcp flags != syn accept\n" : " accept\n")
+                      << INDENT << "udp " << set.field << " @" << set.name << " accept\n";
+            }
+        }
+    }
+
+    void appendChain(std::ostream& rules, const std::string& name, const std::vector<std::string>& chainRules)
+    {
+        rules << "    chain " << name << " {\n";
+        for (const auto& rule : chainRules)
+        {
+            rules << INDENT << rule << "\n";
+        }
+        rules << "    }\n\n";
+    }
+
+    void appendChainUpdate(
+        std::ostream& update,
+        const std::string& name,
+        const std::vector<std::string>& chainRules,
+        const std::vector<std::string>& previousRules)
+    {
+        if (chainRules == previousRules)
+        {
+            return;
+        }
+        const std::string chain = std::string("inet ") + Plugin::TABLE_NAME + " " + name;
+        update << "flush chain " << chain << "\n";
+        for (const auto& rule : chainRules)
+        {
+            update << "add rule " << chain << " " << rule << "\n";
+        }
+    }
+} // namespace
+
+namespace Plugin
+{
+    NftRuleset NftRuleset::compile(const std::vector<IsolationExclusion>& allowList)
+    {
+        NftRuleset ruleset;
+        for (const auto& set : setDefinitions())
+        {
+            ruleset.sets_[set.name];
+        }
+
+        port_groups_t inputGroups;
+        port_groups_t outputGroups;
+        for (const auto& exclusion : allowList)
+        {
+            // Traffic in the opposite direction to the exclusion is only accepted for connections it allowed
+            const bool inputEstablished = exclusion.direction() == IsolationExclusion::OUT;
+            const bool outputEstablished = exclusion.direction() == IsolationExclusion::IN;
+            const auto addresses = exclusion.remoteAddressesAndIpTypes();
+            const auto localPorts = exclusion.localPorts();
+            const auto remotePorts = exclusion.remotePorts();
+
+            // Local ports are the destination of incoming packets and the source of outgoing ones
+            if (addresses.empty())
+            {
+                for (const auto& port : localPorts)
+                {
+                    ruleset.sets_[setName(Chain::INPUT, "", "dport", inputEstablished)].insert(port);
+                    ruleset.sets_[setName(Chain::OUTPUT, "", "sport", outputEstablished)].insert(port);
+                }
+                for (const auto& port : remotePorts)
+                {
+                    ruleset.sets_[setName(Chain::INPUT, "", "sport", inputEstablished)].insert(port);
+                    ruleset.sets_[setName(Chain::OUTPUT, "", "dport", outputEstablished)].insert(port);
+                }
+                continue;
+            }
+
+            for (const auto& [address, type] : addresses)
+            {
+                const std::string ipType = type == IsolationExclusion::IPv6 ? IsolationExclusion::IPv6
+                                                                            : IsolationExclusion::IPv4;
+                if (localPorts.empty() && remotePorts.empty())
+                {
+                    ruleset.sets_[setName(Chain::INPUT, ipType, "saddr", inputEstablished)].insert(address);
+                    ruleset.sets_[setName(Chain::OUTPUT, ipType, "daddr", outputEstablished)].insert(address);
+                    continue;
+                }
+                for (const auto& port : localPorts)
+                {
+                    inputGroups[{ ipType, address, "dport", inputEstablished }].insert(port);
+                    outputGroups[{ ipType, address, "sport", outputEstablished }].insert(port);
+                }
+                for (const auto& port : remotePorts)
+                {
+                    inputGroups[{ ipType, address, "sport", inputEstablished }].insert(port);
+                    outputGroups[{ ipType, address, "dport", outputEstablished }].insert(port);
+                }
+            }
+        }
+
+        ruleset.inputAllowRules_ = groupRules(inputGroups, "saddr");
+        ruleset.outputAllowRules_ = groupRules(outputGroups, "daddr");
+        return ruleset;
+    }
+
+    const NftRuleset::elements_t& NftRuleset::elements(const std::string& setName) const
+    {
+        return sets_.at(setName);
+    }
+
+    std::string NftRuleset::render(gid_t sophosGroupId) const
+    {
+        std::stringstream rules;
+        rules << "table inet " << TABLE_NAME << " {\n";
+
+        for (const auto& set : setDefinitions())
+        {
+            rules << "    set " << set.name << " {\n";
+            if (set.ipType.empty())
+            {
+                rules << INDENT << "type inet_service\n";
+            }
+            else
+            {
+                // Addresses can be CIDRs, which may overlap
+                rules << INDENT << "type " << (set.ipType == IsolationExclusion::IPv6 ? "ipv6_addr" : "ipv4_addr")
+                      << "\n"
+                      << INDENT << "flags interval\n"
+                      << INDENT << "auto-merge\n";
+            }
+            const auto& elements = sets_.at(set.name);
+            if (!elements.empty())
+            {
+                rules << INDENT << "elements = { " << join(elements) << " }\n";
+            }
+            rules << "    }\n\n";
+        }
+
+        appendChain(rules, INPUT_ALLOW_CHAIN, inputAllowRules_);
+        appendChain(rules, OUTPUT_ALLOW_CHAIN, outputAllowRules_);
+
+        // Note - Some platforms automatically convert icmp to 1 and vice versa
+
+        /*
+         * Drop invalid packets by conntrack
+            ct state invalid drop
+         * Allow localhost loopback:
+            iif "lo" accept
+        * Allow dns responses
+            tcp sport 53 tcp flags != syn accept
+            udp sport 53 accept
+
+        * Allow ICMP
+            ip protocol icmp accept
+            meta l4proto ipv6-icmp accept
+
+        * Allow DHCP
+            ip6 version 6 udp dport 546 accept
+            ip version 4 udp dport 68 accept
+         */
+        rules << R"(    chain INPUT {
+            type filter hook input priority filter; policy drop;
+            ct state invalid drop
+            iif "lo" accept
+            tcp sport 53 tcp flags != syn accept
+            udp sport 53 accept
+            ip protocol icmp accept
+            meta l4proto ipv6-icmp accept
+            ip6 version 6 udp dport 546 accept
+            ip version 4 udp dport 68 accept
+)";
+        appendSetRules(rules, Chain::INPUT);
+        rules << INDENT << "jump " << INPUT_ALLOW_CHAIN << "\n";
+        // Allow Sophos Processes by group:
+        rules << INDENT << "meta skgid " << sophosGroupId << " accept";
+
+        /*
+         * Allow localhost loopback:
+                oif "lo" accept
+
+        * Allow DNS
+                tcp dport 53 accept
+                udp dport 53 accept
+
+        * Allow ICMP
+                ip protocol icmp accept
+                meta l4proto ipv6-icmp accept
+
+        * Allow DHCP
+                ip version 4 udp dport 67 accept
+                ip6 version 6 udp dport 547 accept
+         */
+        rules << R"(
+    }
+
+    chain FORWARD {
+            type filter hook forward priority filter; policy drop;
+    }
+
+    chain OUTPUT {
+            type filter hook output priority filter; policy drop;
+            oif "lo" accept
+            tcp dport 53 accept
+            udp dport 53 accept
+            ip protocol icmp accept
+            meta l4proto ipv6-icmp accept
+            ip version 4 udp dport 67 accept
+            ip6 version 6 udp dport 547 accept
+)";
+        appendSetRules(rules, Chain::OUTPUT);
+        rules << INDENT << "jump " << OUTPUT_ALLOW_CHAIN << "\n";
+        rules << INDENT << "meta skgid " << sophosGroupId << " accept";
+        rules << R"(
+            reject with tcp reset
+    }
+})";
+
+        return rules.str();
+    }
+
+    std::string NftRuleset::renderUpdate(const NftRuleset& previous) const
+    {
+        std::stringstream update;
+        const std::string table = std::string("inet ") + TABLE_NAME;
+
+        for (const auto& set : setDefinitions())
+        {
+            const auto& current = sets_.at(set.name);
+            const auto& old = previous.sets_.at(set.name);
+            if (current == old)
+            {
+                continue;
+            }
+
+            elements_t added;
+            elements_t removed;
+            std::set_difference(
+                current.begin(), current.end(), old.begin(), old.end(), std::inserter(added, added.end()));
+            std::set_difference(
+                old.begin(), old.end(), current.begin(), current.end(), std::inserter(removed, removed.end()));
+
+            if (!removed.empty() && !set.ipType.empty())
+            {
+                // Deleting an address fails once it has been merged into an overlapping range, so the set is refilled
+                update << "flush set " << table << " " << set.name << "\n";
+                added = current;
+            }
+            else if (!removed.empty())
+            {
+                update << "delete element " << table << " " << set.name << " { " << join(removed) << " }\n";
+            }
+            if (!added.empty())
+            {
+                update << "add element " << table << " " << set.name << " { " << join(added) << " }\n";
+            }
+        }
+
+        appendChainUpdate(update, INPUT_ALLOW_CHAIN, inputAllowRules_, previous.inputAllowRules_);
+        appendChainUpdate(update, OUTPUT_ALLOW_CHAIN, outputAllowRules_, previous.outputAllowRules_);
+        return update.str();
+    }
+} // namespace Plugin
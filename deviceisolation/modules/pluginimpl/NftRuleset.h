@@ -0,0 +1,56 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "IsolationExclusion.h"
+
+#include <sys/types.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Plugin
+{
+    /**
+     * The isolation ruleset compiled from an allow-list.
+     *
+     * Exclusions that match only on remote addresses, or only on ports, become elements of named sets, each matched
+     * by a fixed rule with a single set lookup, rather than a rule per address or port. Exclusions that match on both
+     * are grouped by address into the INPUT_ALLOW and OUTPUT_ALLOW chains, one rule per address and protocol.
+     *
+     * Every set and chain exists whatever the allow-list, so a new allow-list can be applied by changing set elements
+     * and replacing the rules of the allow chains in one nft transaction, without lifting isolation.
+     */
+    class NftRuleset
+    {
+    public:
+        using elements_t = std::set<std::string>;
+
+        static NftRuleset compile(const std::vector<IsolationExclusion>& allowList);
+
+        /**
+         * @throws std::out_of_range if there is no set called setName
+         */
+        [[nodiscard]] const elements_t& elements(const std::string& setName) const;
+        [[nodiscard]] const std::vector<std::string>& inputAllowRules() const { return inputAllowRules_; }
+        [[nodiscard]] const std::vector<std::string>& outputAllowRules() const { return outputAllowRules_; }
+
+        /**
+         * The complete table, for nft -f
+         */
+        [[nodiscard]] std::string render(gid_t sophosGroupId) const;
+
+        /**
+         * The nft commands that turn the previous ruleset into this one, or an empty string if they're the same.
+         * The previous ruleset must be the one applied, as elements are added and deleted relative to it.
+         */
+        [[nodiscard]] std::string renderUpdate(const NftRuleset& previous) const;
+
+    private:
+        std::map<std::string, elements_t> sets_;
+        std::vector<std::string> inputAllowRules_;
+        std::vector<std::string> outputAllowRules_;
+    };
+} // namespace Plugin
@@ -24,7 +24,10 @@ namespace Plugin
             LOGERROR("nft binary is not executable");
             return IsolateResult::FAILED;
         }
-        auto rules = createIsolateRules(allowList);
+        appliedRuleset_.reset();
+        LOGDEBUG("Processing " << allowList.size() << " allow-listed exclusions");
+        auto ruleset = NftRuleset::compile(allowList);
+        auto rules = ruleset.render(sophosGroupId());
         LOGDEBUG("Entire nftables ruleset: " << rules);
 
         const mode_t mode = static_cast<int>(std::filesystem::perms::owner_read) |
@@ -71,6 +74,7 @@ namespace Plugin
             return IsolateResult::FAILED;
         }
 
+        appliedRuleset_ = std::move(ruleset);
         LOGINFO("Successfully set network filtering rules");
         return IsolateResult::SUCCESS;
     }
@@ -82,6 +86,7 @@ namespace Plugin
         // nft flush table inet TABLE
         // nft delete table inet TABLE
 
+        appliedRuleset_.reset();
         auto fs = Common::FileSystem::fileSystem();
         if (!fs->exists(Plugin::nftBinary()))
         {
@@ -161,333 +166,84 @@ namespace Plugin
         return IsolateResult::SUCCESS;
     }
 
-    std::string NftWrapper::createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList)
-    {
-        const auto* fp = Common::FileSystem::filePermissions();
-        const auto groupId = fp->getGroupId("sophos-spl-group");
-        return createIsolateRules(allowList, groupId);
-    }
-
-    std::string NftWrapper::createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList, gid_t groupId)
+    IsolateResult NftWrapper::updateIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList)
     {
-        std::stringstream rules;
+        if (!appliedRuleset_)
+        {
+            LOGDEBUG("The applied network filtering rules are not known, they can't be updated in place");
+            return IsolateResult::RULES_NOT_PRESENT;
+        }
 
-        std::stringstream outgoingAllowListString;
-        std::stringstream incomingAllowListString;
+        auto fs = Common::FileSystem::fileSystem();
+        if (!fs->exists(Plugin::nftBinary()))
+        {
+            LOGERROR("nft binary does not exist: " << Plugin::nftBinary());
+            return IsolateResult::FAILED;
+        }
+        if (!fs->isExecutable(Plugin::nftBinary()))
+        {
+            LOGERROR("nft binary is not executable");
+            return IsolateResult::FAILED;
+        }
 
         LOGDEBUG("Processing " << allowList.size() << " allow-listed exclusions");
-        constexpr const char* indent = "            ";
-        for (const auto &exclusion: allowList)
+        auto ruleset = NftRuleset::compile(allowList);
+        auto update = ruleset.renderUpdate(*appliedRuleset_);
+        if (update.empty())
+        {
+            LOGINFO("Network filtering rules are already up to date");
+            return IsolateResult::SUCCESS;
+        }
+        LOGDEBUG("nftables update: " << update);
+
+        const mode_t mode = static_cast<int>(std::filesystem::perms::owner_read) |
+                            static_cast<int>(std::filesystem::perms::owner_write);
+        const auto updateFile = Plugin::networkRulesUpdateFile();
+        fs->writeFileAtomically(updateFile, update, Plugin::pluginTempDir(), mode);
+
+        // nft applies a file as a single transaction, so the table never holds a partial update
+        auto process = ::Common::Process::createProcess();
+        process->exec(Plugin::nftBinary(), {"-f", updateFile});
+        auto status = process->wait(std::chrono::milliseconds(100), NFT_TIMEOUT_DS);
+        if (status != Common::Process::ProcessStatus::FINISHED)
         {
-            // Generate both direction rules
-            if (exclusion.direction() == Plugin::IsolationExclusion::BOTH)
-            {
-                // If there are no addresses specified, then we allow all specified ports to all addresses
-                if (exclusion.remoteAddressesAndIpTypes().empty())
-                {
-                    for (const auto &localPort: exclusion.localPorts())
-                    {
-                        // Allow incoming to that port, and outgoing on that port
-                        incomingAllowListString << indent << "tcp dport " << localPort << " accept\n"
-                                                << indent << "udp dport " << localPort << " accept\n";
-
-                        outgoingAllowListString << indent << "tcp sport " << localPort << " accept\n"
-                                                << indent << "udp sport " << localPort << " accept\n";
-                    }
-                    for (const auto &remotePort: exclusion.remotePorts())
-                    {
-                        // Allow incoming from that port, and outgoing to that port
-                        incomingAllowListString << indent << "tcp sport " << remotePort << " accept\n"
-                                                << indent << "udp sport " << remotePort << " accept\n";
-
-                        outgoingAllowListString << indent << "tcp dport " << remotePort << " accept\n"
-                                                << indent << "udp dport " << remotePort << " accept\n";
-                    }
-                }
-                else
-                {
-                    // If there are remote addresses specified, then we only allow ports to those remote addresses
-                    for (const auto& [remoteAddress, ipType] : exclusion.remoteAddressesAndIpTypes())
-                    {
-                        if (exclusion.remotePorts().empty() && exclusion.localPorts().empty())
-                        {
-                            // Both + IP + no port
-                            // Allow all traffic to and from that IP address
-                            outgoingAllowListString << indent << ipType << " daddr " << remoteAddress << " accept\n";
-                            incomingAllowListString << indent << ipType << " saddr " << remoteAddress << " accept\n";
-                        }
-                        else
-                        {
-                            // Both directions + IP + port
-                            for (const auto &localPort: exclusion.localPorts())
-                            {
-                                // Allow incoming to that port, and outgoing on that port
-
-                                incomingAllowListString
-                                    << indent << ipType << " saddr " << remoteAddress
-                                    << " tcp dport " << localPort << " accept\n"
-                                    << indent << ipType << " saddr " << remoteAddress
-                                    << " udp dport " << localPort << " accept\n";
-
-                                outgoingAllowListString
-                                    << indent << ipType << " daddr " << remoteAddress
-                                    << " tcp sport " << localPort << " accept\n"
-                                    << indent << ipType << " daddr " << remoteAddress
-                                    << " udp sport " << localPort << " accept\n";
-                            }
-                            for (const auto &remotePort: exclusion.remotePorts())
-                            {
-
-                                incomingAllowListString
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " tcp sport " << remotePort << " accept\n"
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " udp sport " << remotePort << " accept\n";
-
-                                outgoingAllowListString
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " tcp dport " << remotePort << " accept\n"
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " udp dport " << remotePort << " accept\n";
-                            }
-                        }
-                    }
-                }
-            }
-            // Generate outbound rules
-            else if (exclusion.direction() == Plugin::IsolationExclusion::OUT)
-            {
-                // If there are no addresses specified, then we allow all specified ports to all addresses
-                if (exclusion.remoteAddressesAndIpTypes().empty())
-                {
-                    for (const auto &localPort: exclusion.localPorts())
-                    {
-                        // Allow incoming to that port, and outgoing on that port
-                        incomingAllowListString
-                            << indent << "tcp dport " << localPort
-                            << " tcp flags != syn accept\n" // Ban new connections incoming
-                            << indent << "udp dport " << localPort << " accept\n"; // Can't restrict incoming to established
-
-                        outgoingAllowListString << indent << "tcp sport " << localPort << " accept\n"
-                                                << indent << "udp sport " << localPort << " accept\n";
-                    }
-                    for (const auto &remotePort: exclusion.remotePorts())
-                    {
-                        // Allow incoming from that port, and outgoing to that port
-                        incomingAllowListString
-                                << indent << "tcp sport " << remotePort
-                                << " tcp flags != syn accept\n" // Ban new connections incoming
-                                << indent << "udp sport " << remotePort << " accept\n";
-
-                        outgoingAllowListString << indent << "tcp dport " << remotePort << " accept\n"
-                                                << indent << "udp dport " << remotePort << " accept\n";
-                    }
-                }
-                else
-                {
-                    // OUT-only, With remote IPs:
-
-                    // If there are remote addresses specified, then we only allow ports to those remote addresses
-                    for (const auto& [remoteAddress, ipType] : exclusion.remoteAddressesAndIpTypes())
-                    {
-                        if (exclusion.remotePorts().empty() && exclusion.localPorts().empty())
-                        {
-                            outgoingAllowListString << indent << ipType << " daddr " << remoteAddress << " accept\n";
-
-                            incomingAllowListString << indent << ipType << " saddr " << remoteAddress << " tcp flags != syn accept\n";
-                            incomingAllowListString << indent << ipType << " saddr " << remoteAddress << " meta l4proto udp accept\n";
-                        }
-                        else
-                        {
-                            for (const auto &localPort: exclusion.localPorts())
-                            {
-                                incomingAllowListString
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " tcp dport " << localPort << " tcp flags != syn accept\n"
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " udp dport " << localPort << " accept\n";
-
-                                outgoingAllowListString
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " tcp sport " << localPort << " accept\n"
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " udp sport " << localPort << " accept\n";
-                            }
-                            for (const auto &remotePort: exclusion.remotePorts())
-                            {
-                                incomingAllowListString
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " tcp sport " << remotePort << " tcp flags != syn accept\n"
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " udp sport " << remotePort << " accept\n";
-
-                                outgoingAllowListString
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " tcp dport " << remotePort << " accept\n"
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " udp dport " << remotePort << " accept\n";
-                            }
-                        }
-                    }
-                }
-            }
-            // Generate inbound rules
-            else if (exclusion.direction() == Plugin::IsolationExclusion::IN)
-            {
-                // If there are no addresses specified, then we allow all specified ports to all addresses
-                if (exclusion.remoteAddressesAndIpTypes().empty())
-                {
-                    for (const auto &localPort: exclusion.localPorts())
-                    {
-                        // Allow incoming to that port, and outgoing on that port
-                        incomingAllowListString
-                            << indent << "tcp dport " << localPort << " accept\n"
-                            << indent << "udp dport " << localPort << " accept\n";
-
-                        outgoingAllowListString
-                            << indent << "tcp sport " << localPort << " tcp flags != syn accept\n" // Ban new connections outbound
-                            << indent << "udp sport " << localPort << " accept\n"; // Can't restrict UDP outbound
-                    }
-                    for (const auto &remotePort: exclusion.remotePorts())
-                    {
-                        // Allow incoming from that port, and outgoing to that port
-                        incomingAllowListString
-                            << indent << "tcp sport " << remotePort << " accept\n"
-                            << indent << "udp sport " << remotePort << " accept\n";
-
-                        outgoingAllowListString
-                            << indent << "tcp dport " << remotePort << " tcp flags != syn accept\n"
-                            << indent << "udp dport " << remotePort << " accept\n";
-                    }
-                }
-                else
-                {
-                    // IN-only, With remote IPs:
-
-                    // If there are remote addresses specified, then we only allow ports to those remote addresses
-                    for (const auto& [remoteAddress, ipType] : exclusion.remoteAddressesAndIpTypes())
-                    {
-                        if (exclusion.remotePorts().empty() && exclusion.localPorts().empty())
-                        {
-                            incomingAllowListString << indent << ipType << " saddr " << remoteAddress << " accept\n";
-
-                            outgoingAllowListString
-                                << indent << ipType << " daddr " << remoteAddress << " tcp flags != syn accept\n"
-                                << indent << ipType << " daddr " << remoteAddress << " meta l4proto udp accept\n";
-                        }
-                        else
-                        {
-                            for (const auto &localPort: exclusion.localPorts())
-                            {
-                                incomingAllowListString
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " tcp dport " << localPort << " accept\n"
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " udp dport " << localPort << " accept\n";
-
-                                outgoingAllowListString
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " tcp sport " << localPort << " tcp flags != syn accept\n"
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " udp sport " << localPort << " accept\n";
-                            }
-                            for (const auto &remotePort: exclusion.remotePorts())
-                            {
-                                incomingAllowListString
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " tcp sport " << remotePort << " accept\n"
-                                        << indent << ipType << " saddr " << remoteAddress
-                                        << " udp sport " << remotePort << " accept\n";
-
-                                outgoingAllowListString
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " tcp dport " << remotePort << " tcp flags != syn accept\n"
-                                        << indent << ipType << " daddr " << remoteAddress
-                                        << " udp dport " << remotePort << " accept\n";
-                            }
-                        }
-                    }
-                }
-            }
+            LOGERROR("The nft update command did not complete in time, killing process");
+            process->kill();
+            appliedRuleset_.reset();
+            return IsolateResult::FAILED;
         }
 
-        // Allow Sophos Processes by group:
-        outgoingAllowListString << indent << "meta skgid " << groupId << " accept";
-        incomingAllowListString << indent << "meta skgid " << groupId << " accept";
-
-        // Note - Some platforms automatically convert icmp to 1 and vice versa
-
-        /*
-         * Drop invalid packets by conntrack
-            ct state invalid drop
-         * Allow localhost loopback:
-            iif "lo" accept
-        * Allow dns responses
-            tcp sport 53 tcp flags != syn accept
-            udp sport 53 accept
-
-        * Allow ICMP
-            ip protocol icmp accept
-            meta l4proto ipv6-icmp accept
-
-        * Allow DHCP
-            ip6 version 6 udp dport 546 accept
-            ip version 4 udp dport 68 accept
-         */
-        rules << "table inet " << TABLE_NAME << R"( {
-    chain INPUT {
-            type filter hook input priority filter; policy drop;
-            ct state invalid drop
-            iif "lo" accept
-            tcp sport 53 tcp flags != syn accept
-            udp sport 53 accept
-            ip protocol icmp accept
-            meta l4proto ipv6-icmp accept
-            ip6 version 6 udp dport 546 accept
-            ip version 4 udp dport 68 accept
-)" << incomingAllowListString.str()
-
-   /*
-    * Allow localhost loopback:
-            oif "lo" accept
-
-    * Allow established connections:
-            ct state established,related accept
-
-    * Allow DNS
-            tcp dport 53 accept
-            udp dport 53 accept
-
-   * Allow ICMP
-            ip protocol icmp accept
-            meta l4proto ipv6-icmp accept
-
-   * Allow DHCP
-            ip version 4 udp dport 67 accept
-            ip6 version 6 udp dport 547 accept
-    */
-
-<< R"(
+        int exitCode = process->exitCode();
+        if (exitCode != 0)
+        {
+            LOGERROR("Failed to update network rules, nft exit code: " << exitCode);
+            LOGDEBUG("nft output for update network: " << process->output());
+            appliedRuleset_.reset();
+            return IsolateResult::FAILED;
+        }
+
+        // Keep the full ruleset on disk matching what is enforced
+        fs->writeFileAtomically(
+            Plugin::networkRulesFile(), ruleset.render(sophosGroupId()), Plugin::pluginTempDir(), mode);
+        appliedRuleset_ = std::move(ruleset);
+        LOGINFO("Successfully updated network filtering rules");
+        return IsolateResult::SUCCESS;
     }
 
-    chain FORWARD {
-            type filter hook forward priority filter; policy drop;
+    gid_t NftWrapper::sophosGroupId()
+    {
+        const auto* fp = Common::FileSystem::filePermissions();
+        return fp->getGroupId("sophos-spl-group");
     }
 
-    chain OUTPUT {
-            type filter hook output priority filter; policy drop;
-            oif "lo" accept
-            tcp dport 53 accept
-            udp dport 53 accept
-            ip protocol icmp accept
-            meta l4proto ipv6-icmp accept
-            ip version 4 udp dport 67 accept
-            ip6 version 6 udp dport 547 accept
-)" << outgoingAllowListString.str() << R"(
-            reject with tcp reset
+    std::string NftWrapper::createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList)
+    {
+        return createIsolateRules(allowList, sophosGroupId());
     }
-})";
 
-        return rules.str();
+    std::string NftWrapper::createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList, gid_t groupId)
+    {
+        LOGDEBUG("Processing " << allowList.size() << " allow-listed exclusions");
+        return NftRuleset::compile(allowList).render(groupId);
     }
 } // namespace Plugin
\ No newline at end of file
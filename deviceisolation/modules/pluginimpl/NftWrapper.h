@@ -2,10 +2,12 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "IsolationExclusion.h"
+#include "NftRuleset.h"
 
 #include "deviceisolation/modules/plugin/INftWrapper.h"
 
@@ -27,6 +29,9 @@ namespace Plugin
         // Flush all Sophos isolation rules
         IsolateResult clearIsolateRules() override;
 
+        // Change the allowed exclusions of the rules applied by applyIsolateRules, without lifting isolation
+        IsolateResult updateIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList) override;
+
     TEST_PUBLIC:
         /**
          * Timeout for nft commands in deci-seconds (1/10 second)
@@ -37,5 +42,10 @@ namespace Plugin
         static std::string createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList);
         static std::string createIsolateRules(const std::vector<Plugin::IsolationExclusion>& allowList, gid_t gid);
 
+    private:
+        static gid_t sophosGroupId();
+
+        // The ruleset this wrapper last applied, if the table still holds it
+        std::optional<NftRuleset> appliedRuleset_;
     };
 } // namespace Plugin
@@ -223,6 +223,23 @@ namespace Plugin
 
         ntpPolicy_ = newPolicy;
         LOGINFO("Updating network filtering rules with new policy");
+        auto result = nftWrapper_->updateIsolateRules(ntpPolicy_->exclusions());
+        if (result == IsolateResult::SUCCESS)
+        {
+            LOGINFO("Device is now isolated with the updated exclusions");
+            return;
+        }
+
+        // The applied rules are unknown, or couldn't be changed, so replace them
+        if (result == IsolateResult::RULES_NOT_PRESENT)
+        {
+            // Expected after a restart, as the rules applied by the previous instance aren't known
+            LOGINFO("No record of the applied network filtering rules, reapplying them");
+        }
+        else
+        {
+            LOGWARN("Could not update network filtering rules in place, reapplying them");
+        }
         disableIsolation(nftWrapper_);
         enableIsolation(nftWrapper_);
     }
@@ -13,4 +13,5 @@ class MockNftWrapper : public Plugin::INftWrapper
 public:
     MOCK_METHOD(Plugin::IsolateResult, applyIsolateRules, (const std::vector<Plugin::IsolationExclusion>&), (override));
     MOCK_METHOD(Plugin::IsolateResult, clearIsolateRules, (), (override));
+    MOCK_METHOD(Plugin::IsolateResult, updateIsolateRules, (const std::vector<Plugin::IsolationExclusion>&), (override));
 };
\ No newline at end of file
@@ -41,6 +41,7 @@ namespace
 
     constexpr const auto* NFT_BINARY = "/opt/sophos-spl/plugins/deviceisolation/bin/nft";
     constexpr const auto* RULES_FILE = "/opt/sophos-spl/plugins/deviceisolation/var/nft_rules.conf";
+    constexpr const auto* UPDATE_FILE = "/opt/sophos-spl/plugins/deviceisolation/var/nft_rules_update.conf";
 }
 
 using namespace Plugin;
@@ -728,6 +729,140 @@ TEST_F(TestNftWrapper, clearIsolateRulesTimesOutIfNftHangsDeletingTable)
     EXPECT_TRUE(appenderContains("The nft delete table command did not complete in time"));
 }
 
+namespace
+{
+    using Plugin::IsolationExclusion;
+
+    std::unique_ptr<Common::Process::IProcess> nftProcess(const std::vector<std::string>& args, int exitCode)
+    {
+        auto mockProcess = new StrictMock<MockProcess>();
+
+        InSequence s;
+
+        EXPECT_CALL(*mockProcess, exec(NFT_BINARY, args)).Times(1);
+        EXPECT_CALL(*mockProcess, wait(Common::Process::milli(100), TestNftWrapper::NFT_TIMEOUT_DS))
+            .WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+        EXPECT_CALL(*mockProcess, exitCode()).WillOnce(Return(exitCode));
+        if (exitCode != 0)
+        {
+            EXPECT_CALL(*mockProcess, output()).WillOnce(Return(""));
+        }
+
+        return std::unique_ptr<Common::Process::IProcess>(mockProcess);
+    }
+
+    // Applies the rules for allowList, then the processes for each later nft command are made by updateProcesses
+    void replaceNftProcesses(std::vector<std::function<std::unique_ptr<Common::Process::IProcess>()>> updateProcesses)
+    {
+        auto count = std::make_shared<size_t>(0);
+        Common::ProcessImpl::ProcessFactory::instance().replaceCreator(
+            [count, updateProcesses]() -> std::unique_ptr<Common::Process::IProcess>
+            {
+                if ((*count)++ == 0)
+                {
+                    auto mockProcess = new StrictMock<MockProcess>();
+
+                    InSequence s;
+
+                    std::vector<std::string> args = { "list", "table", "inet", "sophos_device_isolation" };
+                    EXPECT_CALL(*mockProcess, exec(NFT_BINARY, args)).Times(1);
+                    EXPECT_CALL(*mockProcess, wait(Common::Process::milli(100), TestNftWrapper::NFT_TIMEOUT_DS))
+                        .WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+                    EXPECT_CALL(*mockProcess, exitCode()).WillOnce(Return(1));
+
+                    args = { "-f", RULES_FILE };
+                    EXPECT_CALL(*mockProcess, exec(NFT_BINARY, args)).Times(1);
+                    EXPECT_CALL(*mockProcess, wait(Common::Process::milli(100), TestNftWrapper::NFT_TIMEOUT_DS))
+                        .WillOnce(Return(Common::Process::ProcessStatus::FINISHED));
+                    EXPECT_CALL(*mockProcess, exitCode()).WillOnce(Return(0));
+
+                    return std::unique_ptr<Common::Process::IProcess>(mockProcess);
+                }
+                return updateProcesses.at(*count - 2)();
+            });
+    }
+
+    IsolationExclusion portExclusion(const std::string& localPort)
+    {
+        IsolationExclusion excl;
+        excl.setLocalPorts({ localPort });
+        return excl;
+    }
+}
+
+TEST_F(TestNftWrapper, updateIsolateRulesReturnsRulesNotPresentIfNoRulesWereApplied)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    auto mockFileSystem = std::make_unique<StrictMock<MockFileSystem>>();
+    Tests::ScopedReplaceFileSystem replaceFileSystem{std::move(mockFileSystem)};
+
+    auto nftWrapper = NftWrapper();
+    EXPECT_EQ(nftWrapper.updateIsolateRules({ portExclusion("22") }), IsolateResult::RULES_NOT_PRESENT);
+}
+
+TEST_F(TestNftWrapper, updateIsolateRulesChangesOnlyTheSetElements)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    auto mockFileSystem = std::make_unique<StrictMock<MockFileSystem>>();
+    EXPECT_CALL(*mockFileSystem, exists(NFT_BINARY)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockFileSystem, isExecutable(NFT_BINARY)).WillRepeatedly(Return(true));
+    const mode_t mode = static_cast<int>(std::filesystem::perms::owner_read) |
+                        static_cast<int>(std::filesystem::perms::owner_write);
+    const std::string tempDir = "/opt/sophos-spl/plugins/deviceisolation/tmp";
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(RULES_FILE, NftWrapper::createIsolateRules({ portExclusion("22") }, 1),
+                                                     tempDir, mode)).WillOnce(Return());
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(UPDATE_FILE,
+                                                     "delete element inet sophos_device_isolation in_dport { 22 }\n"
+                                                     "add element inet sophos_device_isolation in_dport { 443 }\n"
+                                                     "delete element inet sophos_device_isolation out_sport { 22 }\n"
+                                                     "add element inet sophos_device_isolation out_sport { 443 }\n",
+                                                     tempDir, mode)).WillOnce(Return());
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(RULES_FILE, NftWrapper::createIsolateRules({ portExclusion("443") }, 1),
+                                                     tempDir, mode)).WillOnce(Return());
+    Tests::ScopedReplaceFileSystem replaceFileSystem{std::move(mockFileSystem)};
+
+    auto mockFilePermissions = std::make_unique<StrictMock<MockFilePermissions>>();
+    EXPECT_CALL(*mockFilePermissions, getGroupId("sophos-spl-group")).WillRepeatedly(Return(1));
+    Tests::ScopedReplaceFilePermissions replaceFilePermissions{std::move(mockFilePermissions)};
+
+    replaceNftProcesses({ []() { return nftProcess({ "-f", UPDATE_FILE }, 0); } });
+
+    auto nftWrapper = NftWrapper();
+    ASSERT_EQ(nftWrapper.applyIsolateRules({ portExclusion("22") }), IsolateResult::SUCCESS);
+    EXPECT_EQ(nftWrapper.updateIsolateRules({ portExclusion("443") }), IsolateResult::SUCCESS);
+    EXPECT_TRUE(appenderContains("Successfully updated network filtering rules"));
+
+    // Nothing has changed, so nft isn't run again
+    EXPECT_EQ(nftWrapper.updateIsolateRules({ portExclusion("443") }), IsolateResult::SUCCESS);
+    EXPECT_TRUE(appenderContains("Network filtering rules are already up to date"));
+}
+
+TEST_F(TestNftWrapper, updateIsolateRulesHandlesNftFailure)
+{
+    UsingMemoryAppender memoryAppenderHolder(*this);
+
+    auto mockFileSystem = std::make_unique<StrictMock<MockFileSystem>>();
+    EXPECT_CALL(*mockFileSystem, exists(NFT_BINARY)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockFileSystem, isExecutable(NFT_BINARY)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(RULES_FILE, _, _, _)).WillOnce(Return());
+    EXPECT_CALL(*mockFileSystem, writeFileAtomically(UPDATE_FILE, _, _, _)).WillOnce(Return());
+    Tests::ScopedReplaceFileSystem replaceFileSystem{std::move(mockFileSystem)};
+
+    expectGroupLookup(1);
+
+    replaceNftProcesses({ []() { return nftProcess({ "-f", UPDATE_FILE }, 1); } });
+
+    auto nftWrapper = NftWrapper();
+    ASSERT_EQ(nftWrapper.applyIsolateRules({ portExclusion("22") }), IsolateResult::SUCCESS);
+    EXPECT_EQ(nftWrapper.updateIsolateRules({ portExclusion("443") }), IsolateResult::FAILED);
+    EXPECT_TRUE(appenderContains("Failed to update network rules, nft exit code: 1"));
+
+    // What the table holds is no longer known, so the rules have to be applied again
+    EXPECT_EQ(nftWrapper.updateIsolateRules({ portExclusion("443") }), IsolateResult::RULES_NOT_PRESENT);
+}
+
 TEST_F(TestNftWrapper, createRulesWithNoExclusions)
 {
     expectGroupLookup(1);
@@ -735,6 +870,92 @@ TEST_F(TestNftWrapper, createRulesWithNoExclusions)
     auto actualRulesContents = NftWrapper::createIsolateRules({});
 
     const std::string expectedRulesContents = R"SOPHOS(table inet sophos_device_isolation {
+    set in_ip_saddr {
+            type ipv4_addr
+            flags interval
+            auto-merge
+    }
+
+    set in_ip_saddr_est {
+            type ipv4_addr
+            flags interval
+            auto-merge
+    }
+
+    set in_ip6_saddr {
+            type ipv6_addr
+            flags interval
+            auto-merge
+    }
+
+    set in_ip6_saddr_est {
+            type ipv6_addr
+            flags interval
+            auto-merge
+    }
+
+    set in_dport {
+            type inet_service
+    }
+
+    set in_dport_est {
+            type inet_service
+    }
+
+    set in_sport {
+            type inet_service
+    }
+
+    set in_sport_est {
+            type inet_service
+    }
+
+    set out_ip_daddr {
+            type ipv4_addr
+            flags interval
+            auto-merge
+    }
+
+    set out_ip_daddr_est {
+            type ipv4_addr
+            flags interval
+            auto-merge
+    }
+
+    set out_ip6_daddr {
+            type ipv6_addr
+            flags interval
+            auto-merge
+    }
+
+    set out_ip6_daddr_est {
+            type ipv6_addr
+            flags interval
+            auto-merge
+    }
+
+    set out_dport {
+            type inet_service
+    }
+
+    set out_dport_est {
+            type inet_service
+    }
+
+    set out_sport {
+            type inet_service
+    }
+
+    set out_sport_est {
+            type inet_service
+    }
+
+    chain INPUT_ALLOW {
+    }
+
+    chain OUTPUT_ALLOW {
+    }
+
     chain INPUT {
             type filter hook input priority filter; policy drop;
             ct state invalid drop
@@ -745,6 +966,21 @@ TEST_F(TestNftWrapper, createRulesWithNoExclusions)
             meta l4proto ipv6-icmp accept
             ip6 version 6 udp dport 546 accept
             ip version 4 udp dport 68 accept
+            ip saddr @in_ip_saddr accept
+            ip saddr @in_ip_saddr_est tcp flags != syn accept
+            ip saddr @in_ip_saddr_est meta l4proto udp accept
+            ip6 saddr @in_ip6_saddr accept
+            ip6 saddr @in_ip6_saddr_est tcp flags != syn accept
+            ip6 saddr @in_ip6_saddr_est meta l4proto udp accept
+            tcp dport @in_dport accept
+            udp dport @in_dport accept
+            tcp dport @in_dport_est tcp flags != syn accept
+            udp dport @in_dport_est accept
+            tcp sport @in_sport accept
+            udp sport @in_sport accept
+            tcp sport @in_sport_est tcp flags != syn accept
+            udp sport @in_sport_est accept
+            jump INPUT_ALLOW
             meta skgid 1 accept
     }
 
@@ -761,6 +997,21 @@ TEST_F(TestNftWrapper, createRulesWithNoExclusions)
             meta l4proto ipv6-icmp accept
             ip version 4 udp dport 67 accept
             ip6 version 6 udp dport 547 accept
+            ip daddr @out_ip_daddr accept
+            ip daddr @out_ip_daddr_est tcp flags != syn accept
+            ip daddr @out_ip_daddr_est meta l4proto udp accept
+            ip6 daddr @out_ip6_daddr accept
+            ip6 daddr @out_ip6_daddr_est tcp flags != syn accept
+            ip6 daddr @out_ip6_daddr_est meta l4proto udp accept
+            tcp dport @out_dport accept
+            udp dport @out_dport accept
+            tcp dport @out_dport_est tcp flags != syn accept
+            udp dport @out_dport_est accept
+            tcp sport @out_sport accept
+            udp sport @out_sport accept
+            tcp sport @out_sport_est tcp flags != syn accept
+            udp sport @out_sport_est accept
+            jump OUTPUT_ALLOW
             meta skgid 1 accept
             reject with tcp reset
     }
@@ -846,22 +1097,6 @@ namespace
         excl.setRemoteAddressesAndIpTypes(std::move(addresses));
         return excl;
     }
-
-    struct Rules
-    {
-        Rules(const std::string&);
-        std::string inbound;
-        std::string outbound;
-    };
-
-    Rules::Rules(const std::string& rules)
-    {
-        auto input = rules.find("INPUT");
-        auto forward = rules.find("FORWARD", input);
-        auto output = rules.find("OUTPUT", forward);
-        inbound = rules.substr(input, forward-input);
-        outbound = rules.substr(output);
-    }
 }
 
 TEST_F(TestNftWrapper, createRulesWithInAllowPort)
@@ -870,16 +1105,15 @@ TEST_F(TestNftWrapper, createRulesWithInAllowPort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(IsolationExclusion::Direction::IN, {"443"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("tcp dport 443 accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("udp dport 443 accept"));
+    EXPECT_THAT(ruleset.elements("in_dport"), ElementsAre("443"));
+    EXPECT_THAT(ruleset.elements("in_dport_est"), IsEmpty());
 
-    // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("tcp sport 443 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("udp sport 443 accept"));
+    // outbound rules, only for connections made inbound
+    EXPECT_THAT(ruleset.elements("out_sport_est"), ElementsAre("443"));
+    EXPECT_THAT(ruleset.elements("out_sport"), IsEmpty());
 }
 
 TEST_F(TestNftWrapper, testOutWithIP)
@@ -889,15 +1123,16 @@ TEST_F(TestNftWrapper, testOutWithIP)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(IsolationExclusion::Direction::OUT, address_iptype_list_t{{"192.168.1.9", "ip"}}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
-    // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 192.168.1.9 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 192.168.1.9 meta l4proto udp accept"));
+    // inbound rules, only for connections made outbound
+    EXPECT_THAT(ruleset.elements("in_ip_saddr_est"), ElementsAre("192.168.1.9"));
+    EXPECT_THAT(ruleset.elements("in_ip_saddr"), IsEmpty());
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 192.168.1.9 accept"));
+    EXPECT_THAT(ruleset.elements("out_ip_daddr"), ElementsAre("192.168.1.9"));
+    EXPECT_THAT(ruleset.inputAllowRules(), IsEmpty());
+    EXPECT_THAT(ruleset.outputAllowRules(), IsEmpty());
 }
 
 TEST_F(TestNftWrapper, testBothDirectionsWithRemoteIPAndLocalPort)
@@ -907,19 +1142,18 @@ TEST_F(TestNftWrapper, testBothDirectionsWithRemoteIPAndLocalPort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion({"22"}, address_iptype_list_t{{"192.168.1.1", "ip"}}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 192.168.1.1 tcp dport 22 accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 192.168.1.1 udp dport 22 accept"));
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 192.168.1.1 tcp dport 22 accept",
+                                                       "ip saddr 192.168.1.1 udp dport 22 accept"));
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 192.168.1.1 tcp sport 22 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 192.168.1.1 udp sport 22 accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 192.168.1.1 tcp sport 22 accept",
+                                                        "ip daddr 192.168.1.1 udp sport 22 accept"));
+    EXPECT_THAT(ruleset.elements("in_ip_saddr"), IsEmpty());
 }
 
-
 TEST_F(TestNftWrapper, testBothDirectionsWithRemoteIPAndRemotePort)
 {
     using Plugin::IsolationExclusion;
@@ -927,16 +1161,15 @@ TEST_F(TestNftWrapper, testBothDirectionsWithRemoteIPAndRemotePort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(address_iptype_list_t{{"100.78.0.42", "ip"}}, {"5671"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 tcp sport 5671 accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 udp sport 5671 accept"));
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 100.78.0.42 tcp sport 5671 accept",
+                                                       "ip saddr 100.78.0.42 udp sport 5671 accept"));
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 udp dport 5671 accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 100.78.0.42 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.42 udp dport 5671 accept"));
 }
 
 TEST_F(TestNftWrapper, testOutboundWithRemoteIPAndRemotePort)
@@ -946,16 +1179,15 @@ TEST_F(TestNftWrapper, testOutboundWithRemoteIPAndRemotePort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(IsolationExclusion::Direction::OUT, address_iptype_list_t{{"100.78.0.42", "ip"}}, {"5671"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 udp sport 5671 accept"));
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept",
+                                                       "ip saddr 100.78.0.42 udp sport 5671 accept"));
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 udp dport 5671 accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 100.78.0.42 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.42 udp dport 5671 accept"));
 }
 
 TEST_F(TestNftWrapper, testOutboundWithMultipleRemoteIPsAndRemotePort)
@@ -965,23 +1197,22 @@ TEST_F(TestNftWrapper, testOutboundWithMultipleRemoteIPsAndRemotePort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(IsolationExclusion::Direction::OUT, address_iptype_list_t{
         {"100.78.0.42", "ip"},
-        {"100.78.0.43", "ip"},
-        }, {"5671"}));
+        {"100.78.0.43", "ip"}
+    }, {"5671"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 udp sport 5671 accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.43 tcp sport 5671 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.43 udp sport 5671 accept"));
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept",
+                                                       "ip saddr 100.78.0.42 udp sport 5671 accept",
+                                                       "ip saddr 100.78.0.43 tcp sport 5671 tcp flags != syn accept",
+                                                       "ip saddr 100.78.0.43 udp sport 5671 accept"));
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 udp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.43 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.43 udp dport 5671 accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 100.78.0.42 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.42 udp dport 5671 accept",
+                                                        "ip daddr 100.78.0.43 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.43 udp dport 5671 accept"));
 }
 
 TEST_F(TestNftWrapper, testOutboundWithRemoteIPsAndRemotePortMultipleRules)
@@ -992,20 +1223,35 @@ TEST_F(TestNftWrapper, testOutboundWithRemoteIPsAndRemotePortMultipleRules)
     allowList.push_back(createExclusion(IsolationExclusion::Direction::OUT, address_list_t{{"100.78.0.42", "ip"}}, {"5671"}));
     allowList.push_back(createExclusion(IsolationExclusion::Direction::OUT, address_list_t{{"100.78.0.43", "ip"}}, {"5671"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
     // inbound rules
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.42 udp sport 5671 accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.43 tcp sport 5671 tcp flags != syn accept"));
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 100.78.0.43 udp sport 5671 accept"));
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 100.78.0.42 tcp sport 5671 tcp flags != syn accept",
+                                                       "ip saddr 100.78.0.42 udp sport 5671 accept",
+                                                       "ip saddr 100.78.0.43 tcp sport 5671 tcp flags != syn accept",
+                                                       "ip saddr 100.78.0.43 udp sport 5671 accept"));
 
     // outbound rules
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.42 udp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.43 tcp dport 5671 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 100.78.0.43 udp dport 5671 accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 100.78.0.42 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.42 udp dport 5671 accept",
+                                                        "ip daddr 100.78.0.43 tcp dport 5671 accept",
+                                                        "ip daddr 100.78.0.43 udp dport 5671 accept"));
+}
+
+TEST_F(TestNftWrapper, portsForTheSameAddressShareOneRule)
+{
+    using Plugin::IsolationExclusion;
+    using address_list_t = Plugin::IsolationExclusion::address_iptype_list_t;
+    std::vector<IsolationExclusion> allowList;
+    allowList.push_back(createExclusion(address_list_t{{"100.78.0.42", "ip"}}, {"443"}));
+    allowList.push_back(createExclusion(address_list_t{{"100.78.0.42", "ip"}}, {"5671", "8443"}));
+
+    auto ruleset = NftRuleset::compile(allowList);
+
+    EXPECT_THAT(ruleset.inputAllowRules(), ElementsAre("ip saddr 100.78.0.42 tcp sport { 443, 5671, 8443 } accept",
+                                                       "ip saddr 100.78.0.42 udp sport { 443, 5671, 8443 } accept"));
+    EXPECT_THAT(ruleset.outputAllowRules(), ElementsAre("ip daddr 100.78.0.42 tcp dport { 443, 5671, 8443 } accept",
+                                                        "ip daddr 100.78.0.42 udp dport { 443, 5671, 8443 } accept"));
 }
 
 TEST_F(TestNftWrapper, createRulesWithIPv6)
@@ -1015,11 +1261,11 @@ TEST_F(TestNftWrapper, createRulesWithIPv6)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(address_list_t{{"2a00:1450:4009:823::200e", "ip6"}}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip6 saddr 2a00:1450:4009:823::200e accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip6 daddr 2a00:1450:4009:823::200e accept"));
+    EXPECT_THAT(ruleset.elements("in_ip6_saddr"), ElementsAre("2a00:1450:4009:823::200e"));
+    EXPECT_THAT(ruleset.elements("out_ip6_daddr"), ElementsAre("2a00:1450:4009:823::200e"));
+    EXPECT_THAT(ruleset.elements("in_ip_saddr"), IsEmpty());
 }
 
 TEST_F(TestNftWrapper, createRulesWithIPv6CIDR)
@@ -1029,11 +1275,10 @@ TEST_F(TestNftWrapper, createRulesWithIPv6CIDR)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(address_list_t{{"2a00::/32", "ip6"}}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
 
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip6 saddr 2a00::/32 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip6 daddr 2a00::/32 accept"));
+    EXPECT_THAT(ruleset.elements("in_ip6_saddr"), ElementsAre("2a00::/32"));
+    EXPECT_THAT(ruleset.elements("out_ip6_daddr"), ElementsAre("2a00::/32"));
 }
 
 TEST_F(TestNftWrapper, createRulesWithIPv4CIDR)
@@ -1043,11 +1288,15 @@ TEST_F(TestNftWrapper, createRulesWithIPv4CIDR)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion(address_list_t{{"8.8.8.8/16", "ip"}}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto ruleset = NftRuleset::compile(allowList);
+
+    EXPECT_THAT(ruleset.elements("in_ip_saddr"), ElementsAre("8.8.8.8/16"));
+    EXPECT_THAT(ruleset.elements("out_ip_daddr"), ElementsAre("8.8.8.8/16"));
 
-    EXPECT_THAT(actualRules.inbound, HasSubstr("ip saddr 8.8.8.8/16 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("ip daddr 8.8.8.8/16 accept"));
+    auto rules = ruleset.render(1);
+    EXPECT_THAT(rules, HasSubstr("elements = { 8.8.8.8/16 }"));
+    EXPECT_THAT(rules, HasSubstr("ip saddr @in_ip_saddr accept"));
+    EXPECT_THAT(rules, HasSubstr("ip daddr @out_ip_daddr accept"));
 }
 
 // TODO LINUXDAR-8675
@@ -1059,9 +1308,58 @@ TEST_F(TestNftWrapper, DISABLED_createRulesWithLocalAndRemotePort)
     std::vector<IsolationExclusion> allowList;
     allowList.push_back(createExclusion({"100"}, {"200"}));
 
-    auto actualRulesContents = NftWrapper::createIsolateRules(allowList, 1);
-    Rules actualRules{actualRulesContents};
+    auto rules = NftRuleset::compile(allowList).render(1);
+
+    EXPECT_THAT(rules, HasSubstr("tcp dport 100 sport 200 accept"));
+    EXPECT_THAT(rules, HasSubstr("tcp dport 200 sport 100 accept"));
+}
 
-    EXPECT_THAT(actualRules.inbound, HasSubstr("tcp dport 100 sport 200 accept"));
-    EXPECT_THAT(actualRules.outbound, HasSubstr("tcp dport 200 sport 100 accept"));
+TEST_F(TestNftWrapper, renderUpdateIsEmptyForTheSameAllowList)
+{
+    using address_list_t = Plugin::IsolationExclusion::address_iptype_list_t;
+    std::vector<IsolationExclusion> allowList;
+    allowList.push_back(createExclusion(address_list_t{{"100.78.0.42", "ip"}}, {"5671"}));
+    allowList.push_back(createExclusion(address_list_t{{"8.8.8.8", "ip"}}));
+
+    EXPECT_EQ(NftRuleset::compile(allowList).renderUpdate(NftRuleset::compile(allowList)), "");
+}
+
+TEST_F(TestNftWrapper, renderUpdateAddsAddressesToTheirSet)
+{
+    using address_list_t = Plugin::IsolationExclusion::address_iptype_list_t;
+    auto previous = NftRuleset::compile({ createExclusion(address_list_t{{"8.8.8.8", "ip"}}) });
+    auto current = NftRuleset::compile({ createExclusion(address_list_t{{"8.8.8.8", "ip"}, {"1.1.1.1", "ip"}}) });
+
+    EXPECT_EQ(current.renderUpdate(previous),
+              "add element inet sophos_device_isolation in_ip_saddr { 1.1.1.1 }\n"
+              "add element inet sophos_device_isolation out_ip_daddr { 1.1.1.1 }\n");
+}
+
+TEST_F(TestNftWrapper, renderUpdateRefillsAnAddressSetWhenAddressesAreRemoved)
+{
+    using address_list_t = Plugin::IsolationExclusion::address_iptype_list_t;
+    auto previous = NftRuleset::compile({ createExclusion(address_list_t{{"8.0.0.0/8", "ip"}, {"8.8.8.8", "ip"}}) });
+    auto current = NftRuleset::compile({ createExclusion(address_list_t{{"8.8.8.8", "ip"}}) });
+
+    // 8.8.8.8 was merged into 8.0.0.0/8, so 8.0.0.0/8 can't be deleted on its own
+    EXPECT_EQ(current.renderUpdate(previous),
+              "flush set inet sophos_device_isolation in_ip_saddr\n"
+              "add element inet sophos_device_isolation in_ip_saddr { 8.8.8.8 }\n"
+              "flush set inet sophos_device_isolation out_ip_daddr\n"
+              "add element inet sophos_device_isolation out_ip_daddr { 8.8.8.8 }\n");
+}
+
+TEST_F(TestNftWrapper, renderUpdateReplacesTheRulesOfAChangedAllowChain)
+{
+    using address_list_t = Plugin::IsolationExclusion::address_iptype_list_t;
+    auto previous = NftRuleset::compile({ createExclusion(address_list_t{{"100.78.0.42", "ip"}}, {"5671"}) });
+    auto current = NftRuleset::compile({ createExclusion(address_list_t{{"100.78.0.42", "ip"}}, {"443"}) });
+
+    EXPECT_EQ(current.renderUpdate(previous),
+              "flush chain inet sophos_device_isolation INPUT_ALLOW\n"
+              "add rule inet sophos_device_isolation INPUT_ALLOW ip saddr 100.78.0.42 tcp sport 443 accept\n"
+              "add rule inet sophos_device_isolation INPUT_ALLOW ip saddr 100.78.0.42 udp sport 443 accept\n"
+              "flush chain inet sophos_device_isolation OUTPUT_ALLOW\n"
+              "add rule inet sophos_device_isolation OUTPUT_ALLOW ip daddr 100.78.0.42 tcp dport 443 accept\n"
+              "add rule inet sophos_device_isolation OUTPUT_ALLOW ip daddr 100.78.0.42 udp dport 443 accept\n");
 }
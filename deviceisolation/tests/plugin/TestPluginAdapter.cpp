@@ -640,6 +640,8 @@ TEST_F(PluginAdapterTests, pluginStartsUpIsolatedIfItWasEnabledBeforeStopping)
     auto mockBaseService = std::make_shared<NaggyMock<MockApiBaseServices>>();
 
     auto mockNftWrapper = std::make_shared<StrictMock<MockNftWrapper>>();
+    // A new process doesn't know the rules that were applied, so can't update them in place
+    EXPECT_CALL(*mockNftWrapper, updateIsolateRules(_)).WillOnce(Return(IsolateResult::RULES_NOT_PRESENT));
     // To apply policy rules we clear them first, so an enable triggered by policy change will always clear first
     EXPECT_CALL(*mockNftWrapper, clearIsolateRules()).Times(1);
     EXPECT_CALL(*mockNftWrapper, applyIsolateRules(_)).WillOnce(Return(IsolateResult::SUCCESS));
@@ -654,12 +656,88 @@ TEST_F(PluginAdapterTests, pluginStartsUpIsolatedIfItWasEnabledBeforeStopping)
     auto mainLoopFuture = std::async(std::launch::async, &TestablePluginAdapter::mainLoop, &plugin);
     EXPECT_TRUE(waitForLog("Device Isolation policy applied", std::chrono::milliseconds {50}));
     EXPECT_TRUE(waitForLog("Enabling Device Isolation", std::chrono::milliseconds {50}));
+    EXPECT_TRUE(appenderContains("No record of the applied network filtering rules, reapplying them"));
+    EXPECT_FALSE(appenderContains("Could not update network filtering rules in place"));
     EXPECT_EQ(plugin.isIsolationEnabled(), true);
     queue->pushStop();
     mainLoopFuture.get();
     EXPECT_EQ(plugin.isIsolationEnabled(), true);
 }
 
+TEST_F(PluginAdapterTests, exclusionsAreUpdatedInPlaceWhenPolicyChangesWhileIsolated)
+{
+    UsingMemoryAppender appender(*this);
+
+    auto mockFileSystem = std::make_unique<NaggyMock<MockFileSystem>>();
+    EXPECT_CALL(*mockFileSystem, exists("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationEnabled")).WillOnce(
+            Return(true));
+    EXPECT_CALL(*mockFileSystem, exists("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationActionValue")).WillOnce(
+            Return(true));
+    EXPECT_CALL(*mockFileSystem, readFile("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationEnabled")).WillOnce(
+            Return("1"));
+    EXPECT_CALL(*mockFileSystem, readFile("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationActionValue")).WillOnce(
+            Return("1"));
+    Tests::replaceFileSystem(std::move(mockFileSystem));
+
+    auto mockBaseService = std::make_shared<NaggyMock<MockApiBaseServices>>();
+
+    // Isolation is not lifted to change the exclusions
+    auto mockNftWrapper = std::make_shared<StrictMock<MockNftWrapper>>();
+    EXPECT_CALL(*mockNftWrapper, updateIsolateRules(_)).WillOnce(Return(IsolateResult::SUCCESS));
+    auto queue = std::make_shared<TaskQueue>();
+    TestablePluginAdapter plugin(queue, mockBaseService, mockNftWrapper);
+
+    plugin.setQueueTimeout(std::chrono::milliseconds{1});
+    plugin.setWarnTimeout(std::chrono::milliseconds {2});
+
+    Task policyTask {.taskType = Plugin::Task::TaskType::Policy, .Content = POLICY_EXAMPLE, .appId = "NTP"};
+    queue->push(policyTask);
+    auto mainLoopFuture = std::async(std::launch::async, &TestablePluginAdapter::mainLoop, &plugin);
+    EXPECT_TRUE(waitForLog("Device Isolation policy applied", std::chrono::milliseconds {50}));
+    EXPECT_TRUE(appenderContains("Device is now isolated with the updated exclusions"));
+    queue->pushStop();
+    mainLoopFuture.get();
+    EXPECT_EQ(plugin.isIsolationEnabled(), true);
+}
+
+TEST_F(PluginAdapterTests, exclusionsThatCannotBeUpdatedInPlaceAreReappliedWithAWarning)
+{
+    UsingMemoryAppender appender(*this);
+
+    auto mockFileSystem = std::make_unique<NaggyMock<MockFileSystem>>();
+    EXPECT_CALL(*mockFileSystem, exists("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationEnabled")).WillOnce(
+            Return(true));
+    EXPECT_CALL(*mockFileSystem, exists("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationActionValue")).WillOnce(
+            Return(true));
+    EXPECT_CALL(*mockFileSystem, readFile("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationEnabled")).WillOnce(
+            Return("1"));
+    EXPECT_CALL(*mockFileSystem, readFile("/opt/sophos-spl/plugins/deviceisolation/var/persist-isolationActionValue")).WillOnce(
+            Return("1"));
+    Tests::replaceFileSystem(std::move(mockFileSystem));
+
+    auto mockBaseService = std::make_shared<NaggyMock<MockApiBaseServices>>();
+
+    auto mockNftWrapper = std::make_shared<StrictMock<MockNftWrapper>>();
+    EXPECT_CALL(*mockNftWrapper, updateIsolateRules(_)).WillOnce(Return(IsolateResult::FAILED));
+    EXPECT_CALL(*mockNftWrapper, clearIsolateRules()).Times(1);
+    EXPECT_CALL(*mockNftWrapper, applyIsolateRules(_)).WillOnce(Return(IsolateResult::SUCCESS));
+    auto queue = std::make_shared<TaskQueue>();
+    TestablePluginAdapter plugin(queue, mockBaseService, mockNftWrapper);
+
+    plugin.setQueueTimeout(std::chrono::milliseconds{1});
+    plugin.setWarnTimeout(std::chrono::milliseconds {2});
+
+    Task policyTask {.taskType = Plugin::Task::TaskType::Policy, .Content = POLICY_EXAMPLE, .appId = "NTP"};
+    queue->push(policyTask);
+    auto mainLoopFuture = std::async(std::launch::async, &TestablePluginAdapter::mainLoop, &plugin);
+    EXPECT_TRUE(waitForLog("Device Isolation policy applied", std::chrono::milliseconds {50}));
+    EXPECT_TRUE(waitForLog("Enabling Device Isolation", std::chrono::milliseconds {50}));
+    EXPECT_TRUE(appenderContains("WARN - Could not update network filtering rules in place, reapplying them"));
+    queue->pushStop();
+    mainLoopFuture.get();
+    EXPECT_EQ(plugin.isIsolationEnabled(), true);
+}
+
 TEST_F(PluginAdapterTests, isolationIsEnabledOncePolicyIsReceivedIfDeviceWasIsolatedBeforeGettingPolicy)
 {
     UsingMemoryAppender appender(*this);
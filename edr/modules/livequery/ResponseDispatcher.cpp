@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 
 #include "ResponseDispatcher.h"
 
@@ -9,13 +9,16 @@
 #include "Common/ApplicationConfiguration/IApplicationPathManager.h"
 #include "Common/FileSystem/IFilePermissions.h"
 #include "Common/FileSystem/IFileSystem.h"
+#include "Common/FileSystem/IFileSystemException.h"
 #include "Common/UtilityImpl/StringUtils.h"
 
 // Thirdparty
 #include <nlohmann/json.hpp>
 
 // System
+#include <ostream>
 #include <sstream>
+#include <vector>
 
 namespace
 {
@@ -148,39 +151,124 @@ namespace
         return safeDumpJson(columnMetaData);
     }
 
-    std::string columnDataObject(const livequery::QueryResponse& queryResponse)
+    // Responses whose columnData would serialise to more than this are reported as RESPONSEEXCEEDLIMIT.
+    constexpr size_t MAX_COLUMN_DATA_BYTES = 10 * 1024 * 1024;
+
+    /**
+     * Serialises the columnData array one row at a time. The serialised rows are kept to be written out,
+     * but only while they fit in the size limit, so no more than the limit is ever held in memory.
+     */
+    class ColumnDataSerialiser
     {
-        const auto& headers = queryResponse.data().columnHeaders();
-        const auto& columnData = queryResponse.data().columnData();
-        std::vector<AppendToJsonArray> dataExtractors {};
-        for (auto& entry : headers)
+    public:
+        explicit ColumnDataSerialiser(const livequery::QueryResponse& queryResponse) :
+            m_columnData(queryResponse.data().columnData())
         {
-            dataExtractors.emplace_back(entry);
+            for (auto& entry : queryResponse.data().columnHeaders())
+            {
+                m_dataExtractors.emplace_back(entry);
+            }
+        }
+
+        /**
+         * Serialise the columnData, keeping the result for writeTo.
+         * Once the size goes over limit the rows serialised so far are dropped, and the remaining rows are
+         * only counted so that the full size can still be reported.
+         * @param limit maximum accepted size in bytes
+         * @param limitExceeded set to true if the serialised size is larger than limit
+         * @return the number of bytes the whole columnData serialises to
+         */
+        size_t serialise(size_t limit, bool& limitExceeded)
+        {
+            limitExceeded = false;
+            m_rows.clear();
+            m_rows.reserve(m_columnData.size());
+            size_t sizeBytes = 1; // opening bracket
+            bool first = true;
+            for (auto& rowData : m_columnData)
+            {
+                if (!first)
+                {
+                    sizeBytes += 1; // separator
+                }
+                first = false;
+                if (limitExceeded)
+                {
+                    sizeBytes += serialiseRow(rowData).size();
+                    continue;
+                }
+                m_rows.push_back(serialiseRow(rowData));
+                sizeBytes += m_rows.back().size();
+                if (sizeBytes > limit)
+                {
+                    limitExceeded = true;
+                    m_rows.clear();
+                    m_rows.shrink_to_fit();
+                }
+            }
+            sizeBytes += 1; // closing bracket
+            if (sizeBytes > limit && !limitExceeded)
+            {
+                limitExceeded = true;
+                m_rows.clear();
+                m_rows.shrink_to_fit();
+            }
+            return sizeBytes;
         }
 
-        nlohmann::json columnDataJson = nlohmann::json::array();
+        void writeTo(std::ostream& out) const
+        {
+            out << '[';
+            bool first = true;
+            for (auto& row : m_rows)
+            {
+                if (!first)
+                {
+                    out << ',';
+                }
+                first = false;
+                out << row;
+            }
+            out << ']';
+        }
 
-        for (auto& rowData : columnData)
+    private:
+        [[nodiscard]] std::string serialiseRow(const livequery::ResponseData::RowData& rowData) const
         {
             nlohmann::json rowDataJson = nlohmann::json::array();
-            for (auto& dataExtractor : dataExtractors)
+            for (auto& dataExtractor : m_dataExtractors)
             {
                 dataExtractor.extractValueAndAddToJson(rowData, rowDataJson);
             }
-            columnDataJson.push_back(rowDataJson);
+            return safeDumpJson(rowDataJson);
         }
-        return safeDumpJson(columnDataJson);
-    }
+
+        const livequery::ResponseData::ColumnData& m_columnData;
+        std::vector<AppendToJsonArray> m_dataExtractors;
+        std::vector<std::string> m_rows;
+    };
 } // namespace
 
 namespace livequery
 {
     void ResponseDispatcher::sendResponse(const std::string& correlationId, const livequery::QueryResponse& response)
     {
-        std::string fileContent;
+        std::string tmpPath = Common::ApplicationConfiguration::applicationPathManager().getTempPath();
+        std::string rootInstall = Common::ApplicationConfiguration::applicationPathManager().sophosInstall();
+        std::string targetDir = Common::FileSystem::join(rootInstall, "base/mcs/response");
+        std::string fileName = "LiveQuery_" + correlationId + "_response.json";
+        std::string fullTargetName = Common::FileSystem::join(targetDir, fileName);
+
+        // The response is streamed straight into the temporary file. If serialisation fails part way through,
+        // createAtomicFileToSophosUser removes the temporary file so no partial response is ever published.
         try
         {
-            fileContent = serializeToJson(response);
+            Common::FileSystem::createAtomicFileToSophosUser(
+                [this, &response](std::ostream& out) { serializeToJson(response, out); }, fullTargetName, tmpPath);
+        }
+        catch (const Common::FileSystem::IFileSystemException&)
+        {
+            throw;
         }
         catch (const std::exception & error)
         {
@@ -189,16 +277,10 @@ namespace livequery
             QueryResponse error102{ResponseStatus{ErrorCode::UNEXPECTEDERROR},
                                    ResponseData::emptyResponse(),
                                    ResponseMetaData()};
-            fileContent = serializeToJson(error102);
+            Common::FileSystem::createAtomicFileToSophosUser(
+                [this, &error102](std::ostream& out) { serializeToJson(error102, out); }, fullTargetName, tmpPath);
         }
-        LOGDEBUG("Query result: " << fileContent);
-        std::string tmpPath = Common::ApplicationConfiguration::applicationPathManager().getTempPath();
-        std::string rootInstall = Common::ApplicationConfiguration::applicationPathManager().sophosInstall();
-        std::string targetDir = Common::FileSystem::join(rootInstall, "base/mcs/response");
-        std::string fileName = "LiveQuery_" + correlationId + "_response.json";
-        std::string fullTargetName = Common::FileSystem::join(targetDir, fileName);
-
-        Common::FileSystem::createAtomicFileToSophosUser(fileContent, fullTargetName, tmpPath);
+        LOGDEBUG("Query result written to: " << fullTargetName);
     }
 
     /**
@@ -211,28 +293,28 @@ namespace livequery
      *  https://wiki.sophos.net/pages/viewpage.action?spaceKey=SophosCloud&title=EMP%3A+action-run-live-query
      *
      *  Since this is not enforced by the json library, it has been composed in directly.
+     *  The columnData is serialised one row at a time before anything is written, as its size is needed for
+     *  queryMetaData. Rows are only counted, not kept, once the 10MB limit is crossed.
      * @param response the QueryResponse which contain all the information for the json
-     * @return  The content of the serialized json.
+     * @param serializedJson stream the serialized json is written to.
      * @exceptions Will throw std::exception if it fails serialize the response
      */
-    std::string ResponseDispatcher::serializeToJson(const QueryResponse&  response)
+    void ResponseDispatcher::serializeToJson(const QueryResponse& response, std::ostream& serializedJson)
     {
-        std::string columnDataObjectSerialized;
+        ColumnDataSerialiser columnDataSerialiser{ response };
+        bool hasColumnData = !response.data().columnData().empty();
         bool limitExceeded = false;
         size_t sizeBytes = 0;
-        if (!response.data().columnData().empty())
+        if (hasColumnData)
         {
-            columnDataObjectSerialized = columnDataObject(response);
-            sizeBytes = columnDataObjectSerialized.size();
-            if (sizeBytes > 10 * 1024 * 1024)
+            // queryMetaData has to precede columnData, so the size is worked out before anything is written
+            sizeBytes = columnDataSerialiser.serialise(MAX_COLUMN_DATA_BYTES, limitExceeded);
+            if (limitExceeded)
             {
-                LOGWARN("Limit exceeded. Response would have: " << sizeBytes << " bytes");
-                limitExceeded = true;
+                LOGWARN("Limit exceeded. Response would have more than: " << sizeBytes << " bytes");
             }
         }
 
-        std::stringstream serializedJson;
-
         serializedJson << R"({
 "type": "sophos.mgt.response.RunLiveQuery")";
 
@@ -252,10 +334,11 @@ namespace livequery
             serializedJson << R"(,
 "columnMetaData":[])";
         }
-        if ( !limitExceeded && !columnDataObjectSerialized.empty())
+        if ( !limitExceeded && hasColumnData)
         {
             serializedJson << R"(,
-"columnData": )" << columnDataObjectSerialized ;
+"columnData": )";
+            columnDataSerialiser.writeTo(serializedJson);
         }
         else if (response.status().errorCode() == livequery::ErrorCode::SUCCESS && !limitExceeded)
         {
@@ -270,6 +353,12 @@ namespace livequery
 
 
         setTelemetry(safeDumpJson(telemetryJson));
+    }
+
+    std::string ResponseDispatcher::serializeToJson(const QueryResponse&  response)
+    {
+        std::ostringstream serializedJson;
+        serializeToJson(response, serializedJson);
         return serializedJson.str();
     }
 
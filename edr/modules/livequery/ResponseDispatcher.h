@@ -8,6 +8,8 @@ Copyright 2019-2020 Sophos Limited.  All rights reserved.
 #include "IResponseDispatcher.h"
 #include "QueryResponse.h"
 
+#include <ostream>
+
 namespace livequery
 {
     class ResponseDispatcher : public IResponseDispatcher
@@ -16,6 +18,7 @@ namespace livequery
         void sendResponse(const std::string& correlationId, const QueryResponse& response) override;
         std::unique_ptr<IResponseDispatcher> clone() override;
         std::string serializeToJson(const QueryResponse& response);
+        void serializeToJson(const QueryResponse& response, std::ostream& out);
         std::string getTelemetry() override;
         void setTelemetry(const std::string& json) override;
 
@@ -10,6 +10,7 @@
 
 #include "Common/UtilityImpl/Factory.h"
 
+#include <chrono>
 #include <stdexcept>
 
 namespace osqueryclient
@@ -26,6 +27,14 @@ namespace osqueryclient
         virtual ~IOsqueryClient() = default;
 
         virtual void connect(const std::string& socketPath) = 0;
+        /**
+         * Connect with a specific limit on how long each query may take before the call fails.
+         * By default the limit chosen by connect(socketPath) is kept.
+         */
+        virtual void connect(const std::string& socketPath, std::chrono::seconds /*queryTimeout*/)
+        {
+            connect(socketPath);
+        }
         virtual OsquerySDK::Status query(const std::string& sql, OsquerySDK::QueryData& qd) = 0;
         virtual OsquerySDK::Status getQueryColumns(const std::string& sql, OsquerySDK::QueryColumns& qc) = 0;
     };
@@ -15,15 +15,17 @@
 
 namespace osquery
 {
-    std::unique_ptr<OsquerySDK::OsqueryClientInterface> makeClient(const std::string& socket)
+    // set a maximum time that a query can be take. Set to 90 minutes.
+    constexpr std::chrono::seconds DEFAULT_QUERY_TIMEOUT{ 90 * 60 };
+
+    std::unique_ptr<OsquerySDK::OsqueryClientInterface> makeClient(
+        const std::string& socket,
+        std::chrono::seconds timeout)
     {
         for (int i = 0; i < 15; i++)
         {
             try
             {
-                // set a maximum time that a query can be take. Set to 90 minutes.
-                constexpr int Timeout=90*60;
-                std::chrono::seconds timeout = std::chrono::seconds(Timeout);
                 return OsquerySDK::CreateOsqueryClient(socket, timeout);
             }
             catch (apache::thrift::transport::TTransportException& ex)
@@ -40,7 +42,12 @@ namespace osqueryclient
 {
     void OsqueryClientImpl::connect(const std::string& socketPath)
     {
-        m_client = osquery::makeClient(socketPath);
+        m_client = osquery::makeClient(socketPath, osquery::DEFAULT_QUERY_TIMEOUT);
+    }
+
+    void OsqueryClientImpl::connect(const std::string& socketPath, std::chrono::seconds queryTimeout)
+    {
+        m_client = osquery::makeClient(socketPath, queryTimeout);
     }
 
     OsquerySDK::Status OsqueryClientImpl::query(const std::string& sql, OsquerySDK::QueryData& qd)
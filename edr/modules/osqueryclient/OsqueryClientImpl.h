@@ -16,6 +16,7 @@ namespace osqueryclient
         ~OsqueryClientImpl() = default;
 
         void connect(const std::string& socketPath) override;
+        void connect(const std::string& socketPath, std::chrono::seconds queryTimeout) override;
         OsquerySDK::Status query(const std::string& sql, OsquerySDK::QueryData& qd) override;
         OsquerySDK::Status getQueryColumns(const std::string& sql, OsquerySDK::QueryColumns& qc) override;
 
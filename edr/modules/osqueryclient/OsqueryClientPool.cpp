@@ -0,0 +1,163 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "OsqueryClientPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace osqueryclient
+{
+    OsqueryClientPool::Lease::Lease(OsqueryClientPool& pool, std::unique_ptr<IOsqueryClient> client, bool reused) :
+        m_pool(&pool), m_client(std::move(client)), m_reused(reused)
+    {
+    }
+
+    OsqueryClientPool::Lease::Lease(Lease&& other) noexcept :
+        m_pool(other.m_pool), m_client(std::move(other.m_client)), m_reused(other.m_reused)
+    {
+        other.m_pool = nullptr;
+    }
+
+    OsqueryClientPool::Lease::~Lease()
+    {
+        if (m_pool != nullptr)
+        {
+            bool reuse = static_cast<bool>(m_client);
+            m_pool->release(std::move(m_client), reuse);
+        }
+    }
+
+    IOsqueryClient& OsqueryClientPool::Lease::client()
+    {
+        assert(m_client);
+        return *m_client;
+    }
+
+    void OsqueryClientPool::Lease::discard()
+    {
+        m_client.reset();
+    }
+
+    OsqueryClientPool::OsqueryClientPool(
+        std::string socketPath,
+        size_t maxClients,
+        std::chrono::seconds queryTimeout) :
+        m_socketPath(std::move(socketPath)), m_maxClients(std::max<size_t>(maxClients, 1)), m_queryTimeout(queryTimeout)
+    {
+    }
+
+    OsqueryClientPool::~OsqueryClientPool()
+    {
+        joinQueryThreads();
+    }
+
+    OsqueryClientPool::Lease OsqueryClientPool::acquire(
+        std::chrono::milliseconds timeout,
+        const std::atomic_bool& cancelled)
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        bool available = m_clientReleased.wait_for(lock, timeout, [this, &cancelled]() {
+            return cancelled || !m_idleClients.empty() || m_clientsInUse < m_maxClients;
+        });
+        if (cancelled)
+        {
+            throw FailedToStablishConnectionException("Query was aborted while waiting for an osquery connection");
+        }
+        if (!available)
+        {
+            throw FailedToStablishConnectionException("No osquery connection became available in time");
+        }
+
+        m_clientsInUse++;
+        if (!m_idleClients.empty())
+        {
+            auto client = std::move(m_idleClients.back());
+            m_idleClients.pop_back();
+            return Lease{ *this, std::move(client), true };
+        }
+
+        // Connecting can take a few seconds, so do it without holding the pool lock
+        lock.unlock();
+        try
+        {
+            return Lease{ *this, connectNewClient(), false };
+        }
+        catch (...)
+        {
+            release(nullptr, false);
+            throw;
+        }
+    }
+
+    void OsqueryClientPool::interruptWaits()
+    {
+        {
+            // Taking the lock makes sure a waiter that has just checked its cancelled flag is already waiting
+            std::lock_guard<std::mutex> lock{ m_mutex };
+        }
+        m_clientReleased.notify_all();
+    }
+
+    void OsqueryClientPool::keepQueryThread(std::thread thread, std::function<bool()> finished)
+    {
+        std::lock_guard<std::mutex> lock{ m_queryThreadsMutex };
+        // Threads kept earlier that have since finished only need joining
+        auto stillRunning = std::partition(
+            m_queryThreads.begin(),
+            m_queryThreads.end(),
+            [](const QueryThread& queryThread) { return !queryThread.finished(); });
+        for (auto it = stillRunning; it != m_queryThreads.end(); ++it)
+        {
+            it->thread.join();
+        }
+        m_queryThreads.erase(stillRunning, m_queryThreads.end());
+        m_queryThreads.push_back({ std::move(thread), std::move(finished) });
+    }
+
+    void OsqueryClientPool::joinQueryThreads()
+    {
+        std::vector<QueryThread> queryThreads;
+        {
+            std::lock_guard<std::mutex> lock{ m_queryThreadsMutex };
+            queryThreads.swap(m_queryThreads);
+        }
+        for (auto& queryThread : queryThreads)
+        {
+            // A kept thread can hold the last reference to the pool, in which case it is already on its way out
+            if (queryThread.thread.get_id() == std::this_thread::get_id())
+            {
+                queryThread.thread.detach();
+            }
+            else
+            {
+                queryThread.thread.join();
+            }
+        }
+    }
+
+    size_t OsqueryClientPool::idleClients() const
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_idleClients.size();
+    }
+
+    void OsqueryClientPool::release(std::unique_ptr<IOsqueryClient> client, bool reuse)
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_clientsInUse--;
+            if (reuse && client)
+            {
+                m_idleClients.emplace_back(std::move(client));
+            }
+        }
+        m_clientReleased.notify_one();
+    }
+
+    std::unique_ptr<IOsqueryClient> OsqueryClientPool::connectNewClient()
+    {
+        auto client = osqueryclient::factory().create();
+        client->connect(m_socketPath, m_queryTimeout);
+        return client;
+    }
+} // namespace osqueryclient
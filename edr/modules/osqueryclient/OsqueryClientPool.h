@@ -0,0 +1,103 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#pragma once
+
+#include "IOsqueryClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osqueryclient
+{
+    /**
+     * Bounded pool of osquery clients that stay connected between queries, so that running a live query does not
+     * have to pay for creating a new connection each time.
+     * Connections are made on demand and kept afterwards. At most maxClients connections exist at any time;
+     * acquire blocks until one of them is available.
+     * Each connection is made with queryTimeout as its socket timeout, so an osquery call that never answers fails
+     * with a timeout and its connection slot is freed.
+     */
+    class OsqueryClientPool
+    {
+    public:
+        /**
+         * Exclusive use of one of the clients of the pool. The client is given back to the pool on destruction
+         * unless discard has been called, which should be done if the connection can no longer be trusted.
+         */
+        class Lease
+        {
+        public:
+            Lease(OsqueryClientPool& pool, std::unique_ptr<IOsqueryClient> client, bool reused);
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+            Lease(Lease&& other) noexcept;
+            ~Lease();
+
+            IOsqueryClient& client();
+            void discard();
+            /** True if the connection was already used by earlier queries, so it may have gone stale */
+            [[nodiscard]] bool reused() const { return m_reused; }
+
+        private:
+            OsqueryClientPool* m_pool;
+            std::unique_ptr<IOsqueryClient> m_client;
+            bool m_reused;
+        };
+
+        OsqueryClientPool(std::string socketPath, size_t maxClients, std::chrono::seconds queryTimeout);
+        ~OsqueryClientPool();
+
+        /**
+         * Get a connected client, waiting up to timeout for one to become available, or until cancelled is set
+         * and interruptWaits is called.
+         * @throws FailedToStablishConnectionException if no client became available or it failed to connect.
+         */
+        Lease acquire(std::chrono::milliseconds timeout, const std::atomic_bool& cancelled);
+
+        /**
+         * Wake up everything waiting in acquire, so that those whose query has been cancelled give up.
+         */
+        void interruptWaits();
+
+        /**
+         * Take over a query thread that its owner stopped waiting for. It is joined once finished returns true,
+         * which happens at the latest when its osquery call times out.
+         */
+        void keepQueryThread(std::thread thread, std::function<bool()> finished);
+
+        /**
+         * Wait for all the threads given to keepQueryThread to end.
+         */
+        void joinQueryThreads();
+
+        [[nodiscard]] size_t maxClients() const { return m_maxClients; }
+        [[nodiscard]] size_t idleClients() const;
+
+    private:
+        void release(std::unique_ptr<IOsqueryClient> client, bool reuse);
+        std::unique_ptr<IOsqueryClient> connectNewClient();
+
+        struct QueryThread
+        {
+            std::thread thread;
+            std::function<bool()> finished;
+        };
+
+        const std::string m_socketPath;
+        const size_t m_maxClients;
+        const std::chrono::seconds m_queryTimeout;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_clientReleased;
+        std::vector<std::unique_ptr<IOsqueryClient>> m_idleClients;
+        size_t m_clientsInUse = 0;
+        std::mutex m_queryThreadsMutex;
+        std::vector<QueryThread> m_queryThreads;
+    };
+} // namespace osqueryclient
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "IOsqueryClient.h"
 #include "Logger.h"
@@ -66,6 +66,19 @@ namespace
 
         return livequery::QueryResponse {status, livequery::ResponseData::emptyResponse(), livequery::ResponseMetaData()};
     }
+
+    size_t approximateSize(const OsquerySDK::TableRow& row)
+    {
+        size_t sizeBytes = 0;
+        for (const auto& [column, value] : row)
+        {
+            sizeBytes += column.size() + value.size();
+        }
+        return sizeBytes;
+    }
+
+    // How long to wait for a free pool connection before failing the query
+    constexpr std::chrono::seconds POOLED_CLIENT_WAIT_TIMEOUT{ 60 };
 } // namespace
 
 namespace osqueryclient
@@ -74,38 +87,48 @@ namespace osqueryclient
     {
     }
 
+    OsqueryProcessor::OsqueryProcessor(
+        std::shared_ptr<OsqueryClientPool> clientPool,
+        size_t maxResponseBytes,
+        std::shared_ptr<const std::atomic_bool> cancelled) :
+        m_clientPool(std::move(clientPool)),
+        m_maxResponseBytes(maxResponseBytes),
+        m_cancelled(cancelled ? std::move(cancelled) : std::make_shared<const std::atomic_bool>(false))
+    {
+    }
+
     livequery::QueryResponse OsqueryProcessor::query(const std::string& query)
     {
         try
         {
-            OsquerySDK::QueryData queryData;
-            auto client = osqueryclient::factory().create();
-            client->connect(m_socketPath);
-
-            // Metadata includes query duration
-            long start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-
-            auto osqueryStatus = client->query(query, queryData);
-            if (osqueryStatus.code != 0)
+            if (!m_clientPool)
             {
-                return failureQueryResponse(livequery::ErrorCode::OSQUERYERROR, osqueryStatus.message);
+                auto client = osqueryclient::factory().create();
+                client->connect(m_socketPath);
+                return runQuery(*client, query);
             }
 
-            OsquerySDK::QueryColumns queryColumnsInfo;
-
-            osqueryStatus = client->getQueryColumns(query, queryColumnsInfo);
-            if (osqueryStatus.code != 0)
+            for (int attempt = 0;; attempt++)
             {
-                return failureQueryResponse(livequery::ErrorCode::OSQUERYERROR, osqueryStatus.message);
+                auto lease = m_clientPool->acquire(POOLED_CLIENT_WAIT_TIMEOUT, *m_cancelled);
+                try
+                {
+                    return runQuery(lease.client(), query);
+                }
+                catch (apache::thrift::transport::TTransportException& ex)
+                {
+                    // the connection is in an unknown state, so it is not given back to the pool
+                    lease.discard();
+                    if (attempt > 0 || !lease.reused() ||
+                        ex.getType() == apache::thrift::transport::TTransportException::TIMED_OUT)
+                    {
+                        throw;
+                    }
+                    // A kept connection fails straight away once osquery has been restarted, so give the query
+                    // one more go on a new connection
+                    LOGDEBUG("Osquery connection went stale, reconnecting: " << ex.what());
+                }
             }
-
-            livequery::ResponseData::ColumnHeaders headers = updateColumnDataFromValues(queryColumnsInfo, queryData);
-
-            livequery::ResponseStatus status { livequery::ErrorCode::SUCCESS };
-
-            livequery::QueryResponse response { status, livequery::ResponseData { headers, queryData }, livequery::ResponseMetaData{start}};
-
-            return response;
         }
         catch (osqueryclient::FailedToStablishConnectionException& ex)
         {
@@ -121,7 +144,65 @@ namespace osqueryclient
         }
     }
 
+    livequery::QueryResponse OsqueryProcessor::runQuery(IOsqueryClient& client, const std::string& query)
+    {
+        OsquerySDK::QueryData queryData;
+
+        // Metadata includes query duration
+        long start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        auto osqueryStatus = client.query(query, queryData);
+        if (osqueryStatus.code != 0)
+        {
+            return failureQueryResponse(livequery::ErrorCode::OSQUERYERROR, osqueryStatus.message);
+        }
+
+        OsquerySDK::QueryColumns queryColumnsInfo;
+
+        osqueryStatus = client.getQueryColumns(query, queryColumnsInfo);
+        if (osqueryStatus.code != 0)
+        {
+            return failureQueryResponse(livequery::ErrorCode::OSQUERYERROR, osqueryStatus.message);
+        }
+
+        livequery::ResponseData::ColumnHeaders headers = updateColumnDataFromValues(queryColumnsInfo, queryData);
+
+        // osquery hands back the complete result, so the limit is on the size of the response rather than on the
+        // memory used. The rows are moved out of it one at a time, never copied, and as soon as the limit is
+        // crossed the rest of them are released
+        livequery::ResponseData::ColumnData columnData;
+        columnData.reserve(queryData.size());
+        size_t sizeBytes = 0;
+        for (auto& row : queryData)
+        {
+            sizeBytes += approximateSize(row);
+            if (m_maxResponseBytes != 0 && sizeBytes > m_maxResponseBytes)
+            {
+                LOGWARN("Live query response exceeded " << m_maxResponseBytes << " bytes, discarding the rows");
+                OsquerySDK::QueryData().swap(queryData);
+                livequery::ResponseData::ColumnData().swap(columnData);
+                return livequery::QueryResponse{ livequery::ResponseStatus{ livequery::ErrorCode::RESPONSEEXCEEDLIMIT },
+                                                 livequery::ResponseData{ headers,
+                                                                          livequery::ResponseData::MarkDataExceeded::DataExceedLimit },
+                                                 livequery::ResponseMetaData{ start } };
+            }
+            columnData.push_back(std::move(row));
+        }
+        OsquerySDK::QueryData().swap(queryData);
+
+        livequery::ResponseStatus status { livequery::ErrorCode::SUCCESS };
+
+        livequery::QueryResponse response { status, livequery::ResponseData { headers, std::move(columnData) }, livequery::ResponseMetaData{start}};
+
+        return response;
+    }
+
     std::unique_ptr<livequery::IQueryProcessor> OsqueryProcessor::clone() {
+        if (m_clientPool)
+        {
+            return std::unique_ptr<livequery::IQueryProcessor>(
+                new OsqueryProcessor(m_clientPool, m_maxResponseBytes, m_cancelled));
+        }
         return std::unique_ptr<livequery::IQueryProcessor>(new OsqueryProcessor(m_socketPath));
     }
 
@@ -1,18 +1,40 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 #pragma once
 
+#include "IOsqueryClient.h"
+#include "OsqueryClientPool.h"
+
 #include "livequery/IQueryProcessor.h"
 
+#include <atomic>
+#include <memory>
+
 namespace osqueryclient
 {
     class OsqueryProcessor : public livequery::IQueryProcessor
     {
     public:
         explicit OsqueryProcessor(std::string socketPath);
+        /**
+         * Run queries over the connections of clientPool instead of connecting for each query.
+         * Responses whose rows add up to more than maxResponseBytes are reported as exceeding the limit. This limits
+         * the size of the response, not the memory used, as osquery returns all the rows before they are checked.
+         * Setting cancelled stops a query waiting for a pool connection; a query already running in osquery can not
+         * be interrupted.
+         */
+        OsqueryProcessor(
+            std::shared_ptr<OsqueryClientPool> clientPool,
+            size_t maxResponseBytes,
+            std::shared_ptr<const std::atomic_bool> cancelled = nullptr);
         livequery::QueryResponse query(const std::string& query) override;
         virtual std::unique_ptr<IQueryProcessor> clone() override ;
 
     private:
+        livequery::QueryResponse runQuery(IOsqueryClient& client, const std::string& query);
+
         std::string m_socketPath;
+        std::shared_ptr<OsqueryClientPool> m_clientPool;
+        size_t m_maxResponseBytes = 0;
+        std::shared_ptr<const std::atomic_bool> m_cancelled;
     };
 } // namespace osqueryclient
@@ -0,0 +1,157 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "PooledQueryRunner.h"
+
+#include "Logger.h"
+#include "OsqueryProcessor.h"
+
+#include "livequery/IQueryProcessor.h"
+#include "livequery/ResponseDispatcher.h"
+#include "queryrunner/QueryRunnerImpl.h"
+
+namespace
+{
+    // Same limit applied to the livequery process by QueryRunnerImpl
+    constexpr std::chrono::minutes QUERY_TIMEOUT{ 10 };
+    // Limit on the size of the rows osquery returns, past which they are dropped rather than handed on. osquery
+    // still sends the whole result first. The response file itself is limited to 10MB by the ResponseDispatcher.
+    constexpr size_t MAX_RESPONSE_BYTES = 50 * 1024 * 1024;
+    // Exit code livequery_main uses when processQuery fails
+    constexpr int QUERY_FAILED_EXIT_CODE = 3;
+    // How long destroying a runner waits for its query before handing its thread over to the pool
+    constexpr std::chrono::seconds SHUTDOWN_TIMEOUT{ 2 };
+} // namespace
+
+namespace osqueryclient
+{
+    PooledQueryRunner::PooledQueryRunner(std::shared_ptr<OsqueryClientPool> clientPool, size_t maxResponseBytes) :
+        m_clientPool(std::move(clientPool)), m_maxResponseBytes(maxResponseBytes), m_state(std::make_shared<State>())
+    {
+    }
+
+    PooledQueryRunner::~PooledQueryRunner()
+    {
+        if (!m_thread.joinable())
+        {
+            return;
+        }
+        requestAbort();
+        bool finished = false;
+        {
+            std::unique_lock<std::mutex> l{ m_state->mutex };
+            finished =
+                m_state->finishedCondition.wait_for(l, SHUTDOWN_TIMEOUT, [this]() { return m_state->finished; });
+        }
+        {
+            // The owner of the callback may be going away with this runner
+            std::lock_guard<std::mutex> l{ m_state->notifyMutex };
+            m_state->notifyFinished = nullptr;
+        }
+        if (finished && m_thread.get_id() != std::this_thread::get_id())
+        {
+            m_thread.join();
+            return;
+        }
+        if (!finished)
+        {
+            LOGWARN(
+                "Live query " << m_correlationId
+                              << " is still running, it will finish in the background or time out");
+        }
+        m_clientPool->keepQueryThread(
+            std::move(m_thread),
+            [state = m_state]()
+            {
+                std::lock_guard<std::mutex> l{ state->mutex };
+                return state->finished;
+            });
+    }
+
+    void PooledQueryRunner::triggerQuery(
+        const std::string& correlationid,
+        const std::string& query,
+        std::function<void(std::string id)> notifyFinished)
+    {
+        m_correlationId = correlationid;
+        {
+            std::lock_guard<std::mutex> l{ m_state->notifyMutex };
+            m_state->notifyFinished = std::move(notifyFinished);
+        }
+        m_thread = std::thread(
+            [state = m_state, clientPool = m_clientPool, maxResponseBytes = m_maxResponseBytes, correlationid, query]()
+            {
+                try
+                {
+                    LOGINFO("Running livequery in process for query : " << correlationid);
+                    livequery::ResponseDispatcher dispatcher;
+                    OsqueryProcessor osqueryProcessor{ clientPool, maxResponseBytes, state->cancelled };
+                    int returnCode = livequery::processQuery(osqueryProcessor, dispatcher, query, correlationid);
+                    if (returnCode != 0)
+                    {
+                        setStatus(*state, QUERY_FAILED_EXIT_CODE, "");
+                    }
+                    else
+                    {
+                        setStatus(*state, 0, dispatcher.getTelemetry());
+                    }
+                }
+                catch (std::exception& ex)
+                {
+                    LOGERROR("Error while running LiveQuery: " << ex.what());
+                    setStatus(*state, 2, "");
+                }
+
+                {
+                    // Called under the lock so the runner can't drop the callback while it is running
+                    std::lock_guard<std::mutex> l{ state->notifyMutex };
+                    if (state->notifyFinished)
+                    {
+                        state->notifyFinished(correlationid);
+                    }
+                }
+                std::lock_guard<std::mutex> l{ state->mutex };
+                state->finished = true;
+                state->finishedCondition.notify_all();
+            });
+    }
+
+    void PooledQueryRunner::requestAbort()
+    {
+        *m_state->cancelled = true;
+        m_clientPool->interruptWaits();
+    }
+
+    std::string PooledQueryRunner::id()
+    {
+        return m_correlationId;
+    }
+
+    queryrunner::QueryRunnerStatus PooledQueryRunner::getResult()
+    {
+        std::lock_guard<std::mutex> l{ m_state->mutex };
+        return m_state->runnerStatus;
+    }
+
+    std::unique_ptr<queryrunner::IQueryRunner> PooledQueryRunner::clone()
+    {
+        return std::unique_ptr<queryrunner::IQueryRunner>{ new PooledQueryRunner(m_clientPool, m_maxResponseBytes) };
+    }
+
+    void PooledQueryRunner::setStatus(State& state, int exitCode, const std::string& output)
+    {
+        std::lock_guard<std::mutex> l{ state.mutex };
+        queryrunner::QueryRunnerImpl::setStatusFromExitResult(state.runnerStatus, exitCode, output);
+        LOGDEBUG(
+            "Query finished: " << state.runnerStatus.name << ", exit code: "
+                               << livequery::ResponseStatus::errorCodeName(state.runnerStatus.errorCode)
+                               << ". Duration: " << state.runnerStatus.queryDuration
+                               << ". Rows: " << state.runnerStatus.rowCount);
+    }
+
+    std::unique_ptr<queryrunner::IQueryRunner> createPooledQueryRunner(const std::string& osquerySocket, size_t poolSize)
+    {
+        auto clientPool = std::make_shared<OsqueryClientPool>(
+            osquerySocket, poolSize, std::chrono::duration_cast<std::chrono::seconds>(QUERY_TIMEOUT));
+        return std::make_unique<PooledQueryRunner>(std::move(clientPool), MAX_RESPONSE_BYTES);
+    }
+} // namespace osqueryclient
@@ -0,0 +1,69 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+#pragma once
+
+#include "OsqueryClientPool.h"
+
+#include "queryrunner/IQueryRunner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace osqueryclient
+{
+    /**
+     * Query runner that executes live queries inside the plugin process, over the long-lived connections of a
+     * shared OsqueryClientPool, instead of starting a sophos livequery process for each query.
+     *
+     * Each query is still bounded: the pool connections are created with the same timeout used to stop the
+     * livequery process, so an osquery call that never answers fails once it expires, and responses whose rows
+     * are larger than maxResponseBytes are dropped and reported as exceeding the response limit. Destroying a
+     * runner waits a few seconds for its query, after which its thread is handed to the pool, to be joined once
+     * the query has finished or timed out, and the query no longer reports back.
+     */
+    class PooledQueryRunner : public queryrunner::IQueryRunner
+    {
+    public:
+        PooledQueryRunner(std::shared_ptr<OsqueryClientPool> clientPool, size_t maxResponseBytes);
+        ~PooledQueryRunner() override;
+        void triggerQuery(
+            const std::string& correlationid,
+            const std::string& query,
+            std::function<void(std::string id)> notifyFinished) override;
+        /* Stops this query if it is still waiting for a pool connection. An osquery call already in flight can not be
+         * interrupted and will complete or time out. Other queries sharing the pool are not affected */
+        void requestAbort() override;
+        std::string id() override;
+        queryrunner::QueryRunnerStatus getResult() override;
+        std::unique_ptr<IQueryRunner> clone() override;
+
+    private:
+        // Shared with the query thread, so that it stays valid if the runner gives up waiting for the thread
+        struct State
+        {
+            std::mutex mutex;
+            std::condition_variable finishedCondition;
+            bool finished = false;
+            // Held while the callback runs, which reads the result under mutex
+            std::mutex notifyMutex;
+            std::function<void(std::string id)> notifyFinished;
+            queryrunner::QueryRunnerStatus runnerStatus{};
+            std::shared_ptr<std::atomic_bool> cancelled = std::make_shared<std::atomic_bool>(false);
+        };
+
+        static void setStatus(State& state, int exitCode, const std::string& output);
+
+        std::shared_ptr<OsqueryClientPool> m_clientPool;
+        size_t m_maxResponseBytes;
+        std::string m_correlationId;
+        std::shared_ptr<State> m_state;
+        std::thread m_thread;
+    };
+
+    /**
+     * Create a query runner whose clones share one pool of at most poolSize connections to osquery.
+     */
+    std::unique_ptr<queryrunner::IQueryRunner> createPooledQueryRunner(const std::string& osquerySocket, size_t poolSize);
+} // namespace osqueryclient
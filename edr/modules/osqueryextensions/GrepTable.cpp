@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #include "GrepTable.h"
 
@@ -7,22 +7,354 @@
 
 #include "Common/FileSystem/IFileSystem.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /*
+     * Regular file opened for reading its chunks with pread.
+     * The file is read rather than mapped because log files can be truncated by logrotate while they are searched,
+     * which would raise SIGBUS on a mapping. A truncated file just gives short reads.
+     * Empty and non-regular files are not readable this way and are read as streams instead, since files in /proc
+     * and similar report a size of zero.
+     */
+    class ChunkedFile
+    {
+    public:
+        explicit ChunkedFile(const std::string& path)
+        {
+            m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+            if (m_fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "Failed to open");
+            }
+
+            struct stat statbuf{};
+            if (::fstat(m_fd, &statbuf) == 0 && S_ISREG(statbuf.st_mode) && statbuf.st_size > 0)
+            {
+                m_size = statbuf.st_size;
+                ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+        }
+
+        ~ChunkedFile()
+        {
+            ::close(m_fd);
+        }
+
+        ChunkedFile(const ChunkedFile&) = delete;
+        ChunkedFile& operator=(const ChunkedFile&) = delete;
+
+        bool readable() const { return m_size > 0; }
+        // Size when the file was opened, the file may have shrunk or grown since
+        size_t size() const { return m_size; }
+
+        /*
+         * Appends up to length bytes from offset to buffer, returning how many were read.
+         * Fewer bytes are read only at the end of the file.
+         */
+        size_t read(size_t offset, size_t length, std::string& buffer) const
+        {
+            size_t previousSize = buffer.size();
+            buffer.resize(previousSize + length);
+            size_t total = 0;
+            while (total < length)
+            {
+                ssize_t count = ::pread(m_fd, &buffer[previousSize + total], length - total, offset + total);
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (count < 0)
+                {
+                    buffer.resize(previousSize + total);
+                    throw std::system_error(errno, std::generic_category(), "Failed to read");
+                }
+                if (count == 0)
+                {
+                    break;
+                }
+                total += count;
+            }
+            buffer.resize(previousSize + total);
+            return total;
+        }
+
+    private:
+        int m_fd = -1;
+        size_t m_size = 0;
+    };
+
+    /*
+     * Reads the lines that start in [begin, end) of file into buffer, and returns the offset in buffer of the
+     * first of them. The last line is read past end up to its newline, unless it is already too long to be matched.
+     */
+    size_t readChunkLines(const ChunkedFile& file, size_t begin, size_t end, std::string& buffer)
+    {
+        buffer.clear();
+        // The byte before the chunk shows whether a line starts right at begin
+        size_t readFrom = begin == 0 ? 0 : begin - 1;
+        file.read(readFrom, end - readFrom, buffer);
+
+        size_t firstLine = 0;
+        if (begin != 0)
+        {
+            auto newline = static_cast<const char*>(::memchr(buffer.data(), '\n', buffer.size()));
+            if (newline == nullptr || static_cast<size_t>(newline - buffer.data()) + 1 >= end - readFrom)
+            {
+                // No line starts in this chunk
+                buffer.clear();
+                return 0;
+            }
+            firstLine = newline - buffer.data() + 1;
+        }
+
+        if (buffer.size() < end - readFrom || buffer.back() == '\n' || end >= file.size())
+        {
+            return firstLine;
+        }
+
+        auto lastNewline = static_cast<const char*>(::memrchr(buffer.data(), '\n', buffer.size()));
+        size_t lastLine = lastNewline == nullptr ? 0 : lastNewline - buffer.data() + 1;
+        lastLine = std::max(lastLine, firstLine);
+        constexpr size_t EXTEND_BYTES = 4096;
+        while (buffer.size() - lastLine < MAX_LINE_LENGTH)
+        {
+            size_t searchFrom = buffer.size();
+            if (file.read(readFrom + searchFrom, EXTEND_BYTES, buffer) == 0)
+            {
+                break;
+            }
+            auto newline =
+                static_cast<const char*>(::memchr(buffer.data() + searchFrom, '\n', buffer.size() - searchFrom));
+            if (newline != nullptr)
+            {
+                buffer.resize(newline - buffer.data() + 1);
+                break;
+            }
+        }
+        return firstLine;
+    }
+
+    /*
+     * Calls onLine for each line in [begin, end) that contains pattern and is shorter than MAX_LINE_LENGTH.
+     * Lines are split the same way std::getline splits them. begin must be the start of a line.
+     */
+    template<typename OnLine>
+    void grepBuffer(const char* begin, const char* end, const std::string& pattern, OnLine&& onLine)
+    {
+        if (pattern.find('\n') != std::string::npos)
+        {
+            // A line can never contain a newline
+            return;
+        }
+
+        const char* lineStart = begin;
+        while (lineStart < end)
+        {
+            const char* searchFrom = lineStart;
+            if (!pattern.empty())
+            {
+                auto match = static_cast<const char*>(
+                    ::memmem(lineStart, end - lineStart, pattern.data(), pattern.size()));
+                if (match == nullptr)
+                {
+                    return;
+                }
+                auto previousNewline = static_cast<const char*>(::memrchr(lineStart, '\n', match - lineStart));
+                if (previousNewline != nullptr)
+                {
+                    lineStart = previousNewline + 1;
+                }
+                searchFrom = match;
+            }
+
+            auto lineEnd = static_cast<const char*>(::memchr(searchFrom, '\n', end - searchFrom));
+            if (lineEnd == nullptr)
+            {
+                lineEnd = end;
+            }
+            if (static_cast<size_t>(lineEnd - lineStart) < MAX_LINE_LENGTH)
+            {
+                onLine(lineStart, lineEnd);
+            }
+            if (lineEnd == end)
+            {
+                return;
+            }
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    struct GrepWork
+    {
+        size_t fileIndex = 0;
+        // Not set until a worker has opened the file
+        std::shared_ptr<const ChunkedFile> file;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+} // namespace
+
 namespace OsquerySDK
 {
+    GrepTable::GrepTable(size_t maxThreads, size_t chunkBytes) :
+        m_maxThreads(std::max<size_t>(maxThreads, 1)), m_chunkBytes(std::max<size_t>(chunkBytes, 1))
+    {
+    }
 
-    void GrepTable::GrepFolder(
-        const std::string& filePath,
+    void GrepTable::GrepFiles(
         const std::string& grepPath,
+        const std::vector<std::string>& filePaths,
         const std::string& pattern,
         OsquerySDK::TableRows& results,
-        OsquerySDK::QueryContextInterface& context)
+        const GrepColumns& columns)
     {
-        auto fs = Common::FileSystem::fileSystem();
-        std::vector<std::string> paths = fs->listFilesAndDirectories(filePath);
-        for (auto const& subPath : paths)
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::deque<GrepWork> queue;
+        size_t busyWorkers = 0;
+        // Keyed on file index then offset so the rows come out in file order
+        std::map<std::pair<size_t, size_t>, OsquerySDK::TableRows> rowsByChunk;
+
+        for (size_t fileIndex = 0; fileIndex < filePaths.size(); ++fileIndex)
+        {
+            queue.push_back(GrepWork{ fileIndex, nullptr, 0, 0 });
+        }
+
+        auto grepWork = [&](GrepWork& work, OsquerySDK::TableRows& rows)
+        {
+            const std::string& filePath = filePaths[work.fileIndex];
+            if (!work.file)
+            {
+                auto file = std::make_shared<const ChunkedFile>(filePath);
+                if (!file->readable())
+                {
+                    GrepFile(grepPath, filePath, pattern, rows, columns);
+                    return;
+                }
+
+                // Split big files and hand all but the first chunk to the other workers. Each chunk takes the
+                // lines that start in it.
+                std::vector<GrepWork> chunks;
+                for (size_t begin = 0; begin < file->size(); begin += m_chunkBytes)
+                {
+                    chunks.push_back(
+                        GrepWork{ work.fileIndex, file, begin, std::min(begin + m_chunkBytes, file->size()) });
+                }
+                if (chunks.size() > 1)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.insert(queue.begin(), chunks.begin() + 1, chunks.end());
+                    workAvailable.notify_all();
+                }
+                work = chunks.front();
+            }
+
+            std::string buffer;
+            size_t firstLine = readChunkLines(*work.file, work.begin, work.end, buffer);
+            grepBuffer(
+                buffer.data() + firstLine,
+                buffer.data() + buffer.size(),
+                pattern,
+                [&](const char* lineStart, const char* lineEnd)
+                {
+                    OsquerySDK::TableRow row;
+                    if (columns.path)
+                    {
+                        row["path"] = grepPath;
+                    }
+                    if (columns.pattern)
+                    {
+                        row["pattern"] = pattern;
+                    }
+                    if (columns.filepath)
+                    {
+                        row["filepath"] = filePath;
+                    }
+                    if (columns.line)
+                    {
+                        row["line"] = std::string(lineStart, lineEnd);
+                    }
+                    rows.push_back(std::move(row));
+                });
+        };
+
+        auto worker = [&]()
+        {
+            while (true)
+            {
+                GrepWork work;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    // Busy workers may still split a file into more chunks
+                    workAvailable.wait(lock, [&]() { return !queue.empty() || busyWorkers == 0; });
+                    if (queue.empty())
+                    {
+                        return;
+                    }
+                    work = std::move(queue.front());
+                    queue.pop_front();
+                    ++busyWorkers;
+                }
+
+                OsquerySDK::TableRows rows;
+                try
+                {
+                    grepWork(work, rows);
+                }
+                catch (const std::exception& e)
+                {
+                    std::string err = "Failed to grep file " + filePaths[work.fileIndex] + ". Error: " + e.what();
+                    LOGERROR(err);
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!rows.empty())
+                {
+                    rowsByChunk[{ work.fileIndex, work.begin }] = std::move(rows);
+                }
+                --busyWorkers;
+                workAvailable.notify_all();
+            }
+        };
+
+        size_t threadCount = std::min(m_maxThreads, filePaths.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; ++i)
+        {
+            try
+            {
+                threads.emplace_back(worker);
+            }
+            catch (const std::system_error& e)
+            {
+                LOGWARN("Failed to start grep thread: " << e.what());
+                break;
+            }
+        }
+        worker();
+        for (auto& thread : threads)
         {
-            GrepFile(grepPath, subPath, pattern, results, context);
+            thread.join();
+        }
+
+        for (auto& [chunk, rows] : rowsByChunk)
+        {
+            std::move(rows.begin(), rows.end(), std::back_inserter(results));
         }
     }
 
@@ -31,7 +363,7 @@ namespace OsquerySDK
         const std::string& filePath,
         const std::string& pattern,
         OsquerySDK::TableRows& results,
-        OsquerySDK::QueryContextInterface& context)
+        const GrepColumns& columns)
     {
         try
         {
@@ -43,19 +375,19 @@ namespace OsquerySDK
                 if (line.size() < MAX_LINE_LENGTH && (pattern.empty() || line.find(pattern, 0) != std::string::npos))
                 {
                     OsquerySDK::TableRow row;
-                    if (context.IsColumnUsed("path"))
+                    if (columns.path)
                     {
                         row["path"] = grepPath;
                     }
-                    if (context.IsColumnUsed("pattern"))
+                    if (columns.pattern)
                     {
                         row["pattern"] = pattern;
                     }
-                    if (context.IsColumnUsed("filepath"))
+                    if (columns.filepath)
                     {
                         row["filepath"] = filePath;
                     }
-                    if (context.IsColumnUsed("line"))
+                    if (columns.line)
                     {
                         row["line"] = line;
                     }
@@ -107,13 +439,19 @@ namespace OsquerySDK
             return results;
         }
 
+        // The query context is only read here, not from the grep threads
+        GrepColumns columns{ context.IsColumnUsed("path"),
+                             context.IsColumnUsed("filepath"),
+                             context.IsColumnUsed("pattern"),
+                             context.IsColumnUsed("line") };
+
         if (fs->isDirectory(path))
         {
-            GrepFolder(path, path, pattern, results, context);
+            GrepFiles(path, fs->listFilesAndDirectories(path), pattern, results, columns);
         }
         else
         {
-            GrepFile(path, path, pattern, results, context);
+            GrepFiles(path, { path }, pattern, results, columns);
         }
 
         return results;
@@ -1,4 +1,4 @@
-// Copyright 2023 Sophos Limited. All rights reserved.
+// Copyright 2023-2024 Sophos Limited. All rights reserved.
 
 #pragma once
 
@@ -10,10 +10,17 @@
 #include "OsquerySDK/OsquerySDK.h"
 #endif
 
+#include <cstddef>
+#include <string>
+#include <vector>
 
 namespace
 {
     const unsigned int MAX_LINE_LENGTH = 1000;
+    // Files are grepped by at most this many threads at once
+    const size_t MAX_GREP_THREADS = 4;
+    // Files bigger than this are split so several threads can search them. Each thread reads one chunk at a time.
+    const size_t GREP_CHUNK_BYTES = 1024 * 1024;
 } // namespace
 namespace OsquerySDK
 {
@@ -21,6 +28,7 @@ namespace OsquerySDK
     {
     public:
         GrepTable() = default;
+        GrepTable(size_t maxThreads, size_t chunkBytes);
         /*
      * @description
      * Search a given path for a given pattern
@@ -66,20 +74,29 @@ namespace OsquerySDK
         OsquerySDK::TableRows Generate(OsquerySDK::QueryContextInterface& context) override;
 
     private:
-        void GrepFolder(
-            const std::string& path,
+        struct GrepColumns
+        {
+            bool path;
+            bool filepath;
+            bool pattern;
+            bool line;
+        };
+
+        void GrepFiles(
             const std::string& grepPath,
+            const std::vector<std::string>& filePaths,
             const std::string& pattern,
             OsquerySDK::TableRows& results,
-            OsquerySDK::QueryContextInterface& context);
+            const GrepColumns& columns);
 
         void GrepFile(
-            const std::string& path,
+            const std::string& grepPath,
             const std::string& filePath,
             const std::string& pattern,
             OsquerySDK::TableRows& results,
-            OsquerySDK::QueryContextInterface& context);
-
+            const GrepColumns& columns);
 
+        size_t m_maxThreads = MAX_GREP_THREADS;
+        size_t m_chunkBytes = GREP_CHUNK_BYTES;
     };
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "ResultsSender.h"
 
@@ -42,6 +42,13 @@ ResultsSender::ResultsSender(
     m_hitLimitThisPeriod(pluginVarDir, "xdrLimitHit", false)
 {
     LOGDEBUG("Created results sender");
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+    m_resultWriter.reset(writerBuilder.newStreamWriter());
+    Json::CharReaderBuilder readerBuilder;
+    m_resultReader.reset(readerBuilder.newCharReader());
+    m_storedDataUsage = m_currentDataUsage.getValue();
+
     try
     {
         loadScheduledQueryTags();
@@ -63,8 +70,11 @@ std::optional<std::string> ResultsSender::PrepareSingleResult(const std::string&
     std::string queryName;
     try
     {
-        std::stringstream logLineStream(result);
-        logLineStream >> logLine;
+        std::string errors;
+        if (!m_resultReader->parse(result.data(), result.data() + result.size(), &logLine, &errors))
+        {
+            throw std::runtime_error(errors);
+        }
         queryName = logLine["name"].asString();
         if (result.size() > EdrCommon::DEFAULT_MAX_BATCH_SIZE_BYTES)
         {
@@ -98,12 +108,11 @@ std::optional<std::string> ResultsSender::PrepareSingleResult(const std::string&
             logLine["decorations"]["licence"] = "MTR";
         }
     }
-    std::stringstream ss;
-    Json::StreamWriterBuilder writerBuilder;
-    writerBuilder["indentation"] = "";
-    ss << Json::writeString(writerBuilder, logLine);
+    std::ostringstream ss;
+    m_resultWriter->write(logLine, &ss);
+    std::string preparedResult = ss.str();
 
-    m_currentDataUsage.setValue(m_currentDataUsage.getValue() + ss.str().length());
+    m_currentDataUsage.setValue(m_currentDataUsage.getValue() + preparedResult.length());
 
     // Record that this data has caused us to go over limit.
     if (m_currentDataUsage.getValue() > m_dataLimit && !m_hitLimitThisPeriod.getValue())
@@ -120,7 +129,7 @@ std::optional<std::string> ResultsSender::PrepareSingleResult(const std::string&
         }
     }
 
-    return ss.str();
+    return preparedResult;
 }
 
 void ResultsSender::Add(const std::string& result)
@@ -130,24 +139,35 @@ void ResultsSender::Add(const std::string& result)
         return;
     }
 
-    std::string stringToAppend;
+    if (!m_batchStream)
+    {
+        openBatchStream();
+    }
+
+    std::ostream& batch = *m_batchStream;
     if (!m_firstEntry)
     {
-        stringToAppend = ",";
+        batch.put(',');
+    }
+    batch.write(result.data(), static_cast<std::streamsize>(result.size()));
+    if (!batch)
+    {
+        m_batchStream.reset();
+        throw Common::FileSystem::IFileSystemException("Failed to append result to " + m_intermediaryPath);
     }
 
-    stringToAppend.append(result);
-    auto filesystem = Common::FileSystem::fileSystem();
-    filesystem->appendFile(m_intermediaryPath, stringToAppend);
+    m_batchFileSize += m_firstEntry ? result.size() : result.size() + 1;
     m_firstEntry = false;
 }
 
 void ResultsSender::Send()
 {
+    storeDataUsage();
     if (m_hitLimitThisPeriod.getValue())
     {
         return;
     }
+    closeBatchStream();
     auto filesystem = Common::FileSystem::fileSystem();
     if (filesystem->exists(m_intermediaryPath))
     {
@@ -169,17 +189,68 @@ void ResultsSender::Send()
 void ResultsSender::Reset()
 {
     LOGDEBUG("ResultsSender::Reset");
+    storeDataUsage();
+    // Anything still buffered belongs to the batch being discarded
+    m_batchStream.reset();
     auto filesystem = Common::FileSystem::fileSystem();
     if (filesystem->exists(m_intermediaryPath))
     {
         filesystem->removeFile(m_intermediaryPath);
     }
-    filesystem->appendFile(m_intermediaryPath, "[");
     m_firstEntry = true;
+    m_batchStream = filesystem->openFileForWrite(m_intermediaryPath);
+    *m_batchStream << '[';
+    m_batchFileSize = 1;
+}
+
+void ResultsSender::openBatchStream()
+{
+    // Resuming a batch file that was written by SaveBatchResults or left over from a previous run
+    auto filesystem = Common::FileSystem::fileSystem();
+    m_batchFileSize = filesystem->exists(m_intermediaryPath) ? filesystem->fileSize(m_intermediaryPath) : 0;
+    m_batchStream = filesystem->openFileForAppend(m_intermediaryPath);
+}
+
+void ResultsSender::closeBatchStream()
+{
+    if (!m_batchStream)
+    {
+        return;
+    }
+    auto batchStream = std::move(m_batchStream);
+    batchStream->flush();
+    if (!*batchStream)
+    {
+        throw Common::FileSystem::IFileSystemException("Failed to write results to " + m_intermediaryPath);
+    }
+}
+
+void ResultsSender::storeDataUsage()
+{
+    if (m_currentDataUsage.getValue() == m_storedDataUsage)
+    {
+        return;
+    }
+    try
+    {
+        m_currentDataUsage.setValueAndForceStore(m_currentDataUsage.getValue());
+        m_hitLimitThisPeriod.setValueAndForceStore(m_hitLimitThisPeriod.getValue());
+        m_storedDataUsage = m_currentDataUsage.getValue();
+    }
+    catch (const std::exception& exception)
+    {
+        LOGWARN("Failed to store XDR data usage: " << exception.what());
+    }
 }
 
 uintmax_t ResultsSender::GetFileSize()
 {
+    if (m_batchStream)
+    {
+        // Add 2 here for the , and ] that gets added
+        return m_batchFileSize + 2;
+    }
+
     uintmax_t size = 0;
     auto filesystem = Common::FileSystem::fileSystem();
     if (filesystem->exists(m_intermediaryPath))
@@ -339,6 +410,8 @@ void ResultsSender::SaveBatchResults(const Json::Value& results)
     try
     {
         LOGDEBUG("Saving batch results");
+        // The saved results replace whatever the open batch stream had written
+        m_batchStream.reset();
         Json::StreamWriterBuilder builder;
         std::stringstream resultsStringStream;
 
@@ -366,6 +439,7 @@ Json::Value ResultsSender::PrepareBatchResults()
         bool batchFileIsValidJson = false;
         try
         {
+            closeBatchStream();
             filesystem->appendFile(m_intermediaryPath, "]");
             batchResults = readJsonFile(m_intermediaryPath);
             batchFileIsValidJson = true;
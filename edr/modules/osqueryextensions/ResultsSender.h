@@ -1,4 +1,4 @@
-// Copyright 2020-2023 Sophos Limited. All rights reserved.
+// Copyright 2020-2024 Sophos Limited. All rights reserved.
 
 #include "Common/FileSystem/IFilePermissions.h"
 #include "Common/FileSystem/IFileSystem.h"
@@ -12,9 +12,13 @@
 
 
 
+#include <json/reader.h>
 #include <json/value.h>
+#include <json/writer.h>
 
 #include <functional>
+#include <memory>
+#include <ostream>
 
 struct ScheduledQuery
 {
@@ -79,7 +83,17 @@ private:
     // This is set to true once we have hit the limit during the period.
     Common::PersistentValue<bool> m_hitLimitThisPeriod;
 
+    // The batch file is kept open from Reset (or the first Add) until Send, so rows go through one buffered stream
+    std::unique_ptr<std::ostream> m_batchStream;
+    uintmax_t m_batchFileSize = 0;
+    std::unique_ptr<Json::CharReader> m_resultReader;
+    std::unique_ptr<Json::StreamWriter> m_resultWriter;
+    unsigned int m_storedDataUsage = 0;
+
     Json::Value readJsonFile(const std::string& path);
+    void openBatchStream();
+    void closeBatchStream();
+    void storeDataUsage();
 
     void loadScheduledQueryTagsFromFile(std::vector<ScheduledQuery> &scheduledQueries, Path queryPackFilePath);
 };
\ No newline at end of file
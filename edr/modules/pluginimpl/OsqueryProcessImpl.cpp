@@ -1,4 +1,4 @@
-// Copyright 2019-2023 Sophos Limited. All rights reserved.
+// Copyright 2019-2024 Sophos Limited. All rights reserved.
 #include "OsqueryProcessImpl.h"
 
 #include "EdrCommon/ApplicationPaths.h"
@@ -140,7 +140,9 @@ namespace Plugin
                 LOGWARN("Exception on destroying processmonitor " << ex.what());
             }
         }
-        // output should be empty. In case the output has only a few white spaces or new lines or even so few characters
+        // output should be empty, as complete lines have been passed to the OsqueryLogIngest, so it only holds an
+        // unfinished last line written before osquery exited.
+        // In case the output has only a few white spaces or new lines or even so few characters
         // that it would not give any help to identify the problem, it is better to avoid having an useless line with :
         // ERROR: <blank>
         // For this reason, applying a minimum threshold (arbitrary) of characters to allow it to be displayed as error
@@ -19,6 +19,7 @@
 #include "Common/TelemetryHelperImpl/TelemetryHelper.h"
 #include "Common/UtilityImpl/TimeUtils.h"
 #include "Common/ZeroMQWrapper/IIPCException.h"
+#include "osqueryclient/PooledQueryRunner.h"
 
 #include <cmath>
 #include <fstream>
@@ -64,6 +65,20 @@ public:
     }
 };
 
+namespace
+{
+    std::unique_ptr<queryrunner::IQueryRunner> createLiveQueryRunner()
+    {
+        unsigned int poolSize = Plugin::PluginUtils::getLiveQueryWorkerPoolSizeFromConfig();
+        if (poolSize > 0)
+        {
+            LOGINFO("Live queries will run in process over up to " << poolSize << " osquery connections");
+            return osqueryclient::createPooledQueryRunner(Plugin::osquerySocket(), poolSize);
+        }
+        return queryrunner::createQueryRunner(Plugin::osquerySocket(), Plugin::livequeryExecutable());
+    }
+} // namespace
+
 namespace Plugin
 {
     PluginAdapter::PluginAdapter(
@@ -73,7 +88,7 @@ namespace Plugin
             m_queueTask(std::move(queueTask)),
             m_baseService(std::move(baseService)),
             m_callback(std::move(callback)),
-            m_parallelQueryProcessor{queryrunner::createQueryRunner(Plugin::osquerySocket(), Plugin::livequeryExecutable())},
+            m_parallelQueryProcessor{createLiveQueryRunner()},
             m_dataLimit(EdrCommon::DEFAULT_XDR_DATA_LIMIT_BYTES),
             m_loggerExtensionPtr(
                     std::make_shared<LoggerExtension>(
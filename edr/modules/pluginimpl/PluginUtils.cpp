@@ -392,6 +392,33 @@ namespace Plugin
         return eventsMaxValue;
     }
 
+    unsigned int PluginUtils::getLiveQueryWorkerPoolSizeFromConfig()
+    {
+        unsigned int poolSize = 0;
+        try
+        {
+            std::pair<std::string,std::string> value = Common::UtilityImpl::FileUtils::extractValueFromFile(Plugin::edrConfigFilePath(), LIVEQUERY_WORKER_POOL_SIZE);
+            if (!value.first.empty())
+            {
+                if (PluginUtils::isInteger(value.first))
+                {
+                    poolSize = std::min<unsigned long>(stoul(value.first), MAXIMUM_LIVEQUERY_WORKER_POOL_SIZE);
+                    LOGINFO("Setting " << LIVEQUERY_WORKER_POOL_SIZE << " to " << poolSize << " as per value in " << Plugin::edrConfigFilePath());
+                }
+                else
+                {
+                    LOGWARN(LIVEQUERY_WORKER_POOL_SIZE << " value in '" << Plugin::edrConfigFilePath() << "' not an integer, so using default of " << poolSize);
+                }
+            }
+        }
+        catch (const std::exception& exception)
+        {
+            LOGWARN("Failed to retrieve " << LIVEQUERY_WORKER_POOL_SIZE << " value from " << Plugin::edrConfigFilePath() << " with exception: " << exception.what());
+        }
+
+        return poolSize;
+    }
+
     std::string PluginUtils::getIntegerFlagFromConfig(const std::string& flag, int defaultValue)
     {
         try
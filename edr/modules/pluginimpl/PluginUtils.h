@@ -90,6 +90,12 @@ namespace Plugin
 
         static unsigned int getEventsMaxFromConfig();
 
+        /*
+         * Get the number of osquery connections kept for running live queries in process (livequery_worker_pool_size).
+         * 0, the default, means live queries are run by starting the livequery executable for each query.
+         */
+        static unsigned int getLiveQueryWorkerPoolSizeFromConfig();
+
         static std::vector<std::string>  getWatchdogFlagsFromConfig();
 
         /*
@@ -109,6 +115,9 @@ namespace Plugin
         inline static const unsigned long DEFAULT_WATCHDOG_DELAY_SECONDS = 60;
         inline static const unsigned long DEFAULT_WATCHDOG_LATENCY_SECONDS = 0;
 
+        inline static const std::string LIVEQUERY_WORKER_POOL_SIZE = "livequery_worker_pool_size";
+        inline static const unsigned int MAXIMUM_LIVEQUERY_WORKER_POOL_SIZE = 16;
+
         inline static const std::string DISCOVERY_QUERY_INTERVAL = "pack_refresh_interval";
         static constexpr unsigned long DEFAULT_DISCOVERY_QUERY_INTERVAL = 3600;
     private:
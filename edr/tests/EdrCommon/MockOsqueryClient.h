@@ -1,6 +1,6 @@
 /******************************************************************************************************
 
-Copyright 2020 Sophos Limited.  All rights reserved.
+Copyright 2020-2024 Sophos Limited.  All rights reserved.
 
 ******************************************************************************************************/
 #pragma once
@@ -9,6 +9,7 @@ Copyright 2020 Sophos Limited.  All rights reserved.
 
 #include "osqueryclient/IOsqueryClient.h"
 
+#include <chrono>
 #include <string>
 
 using namespace ::testing;
@@ -17,6 +18,7 @@ class MockIOsqueryClient : public osqueryclient::IOsqueryClient
 {
 public:
     MOCK_METHOD1(connect, void(const std::string&));
+    MOCK_METHOD2(connect, void(const std::string&, std::chrono::seconds));
     MOCK_METHOD2(query, OsquerySDK::Status(const std::string&, OsquerySDK::QueryData&));
     MOCK_METHOD2(getQueryColumns, OsquerySDK::Status(const std::string&, OsquerySDK::QueryColumns&));
 };
\ No newline at end of file
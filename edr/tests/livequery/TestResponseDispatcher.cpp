@@ -29,6 +29,8 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include <sstream>
+
 using namespace ::testing;
 using namespace livequery;
 
@@ -499,7 +501,34 @@ TEST_F(ResposeDispatcherWithMockFileSystem, sendResponseShouldCreateFileAsExpect
 
     std::string rootInstall = Common::ApplicationConfiguration::applicationPathManager().sophosInstall();
     std::string expectedPath = rootInstall + "/base/mcs/response/LiveQuery_correlation_response.json";
+    EXPECT_CALL(*mockFileSystem, openFileForWrite(_))
+        .WillOnce(Return(ByMove(std::unique_ptr<std::ostream>(new std::ostringstream()))));
     EXPECT_CALL(*mockFileSystem, moveFile(_, expectedPath));
     EXPECT_CALL(*mockFilePermissions, chown(_,"sophos-spl-user","sophos-spl-group"));
     dispatcher.sendResponse("correlation", response);
 }
+
+TEST_F(ResposeDispatcherWithMockFileSystem, sendResponseStreamsSameContentAsSerializeToJson)
+{
+    ResponseData::ColumnData columnData;
+    ResponseData::RowData  rowData;
+    rowData["pathname"] = "/usr/bin/bash";
+    rowData["sophosPID"] = "17984:132164677472649892";
+    rowData["start_time"] = "50330";
+    columnData.push_back(rowData);
+    QueryResponse response{ResponseStatus{ErrorCode::SUCCESS},
+                           ResponseData{headerExample(), columnData},
+                           ResponseMetaData()};
+    ResponseDispatcher dispatcher;
+
+    std::string expected = dispatcher.serializeToJson(response);
+
+    std::stringbuf written;
+    EXPECT_CALL(*mockFileSystem, openFileForWrite(_))
+        .WillOnce(Invoke([&written](const Path&) { return std::make_unique<std::ostream>(&written); }));
+    EXPECT_CALL(*mockFilePermissions, chown(_,"sophos-spl-user","sophos-spl-group"));
+    EXPECT_CALL(*mockFileSystem, moveFile(_, _));
+    dispatcher.sendResponse("correlation", response);
+
+    EXPECT_EQ(written.str(), expected);
+}
@@ -0,0 +1,104 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+// Measures how quickly ResultsSender can batch scheduled query rows, the way the logger extension drives it:
+// PrepareSingleResult, Add and GetFileSize for every row, then Send and Reset at the end of each batch.
+//
+// Usage: ResultsSenderBenchmark [rows per batch] [batches]
+
+#include "osqueryextensions/ResultsSender.h"
+
+#include "Common/FileSystem/IFileSystem.h"
+#include "Common/Logging/ConsoleLoggingSetup.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const std::string BENCHMARK_QUERY_PACK = R"({
+    "schedule": {
+        "benchmark_query": {
+            "query": "SELECT * FROM processes;",
+            "interval": 60,
+            "tag": "stream"
+        }
+    }
+})";
+
+    std::string makeRow(unsigned long rowNumber)
+    {
+        return R"({"name":"benchmark_query","hostIdentifier":"benchmark","calendarTime":"Mon Jan  1 00:00:00 2024 UTC",)"
+               R"("unixTime":1704067200,"epoch":0,"counter":)" + std::to_string(rowNumber) +
+               R"(,"numerics":false,"decorations":{"host_uuid":"00000000-0000-0000-0000-000000000000"},)"
+               R"("columns":{"pid":")" + std::to_string(rowNumber) +
+               R"(","name":"benchmark","path":"/usr/bin/benchmark","cmdline":"/usr/bin/benchmark --arg"},"action":"added"})";
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned long rowsPerBatch = argc > 1 ? std::stoul(argv[1]) : 50000;
+    unsigned long batches = argc > 2 ? std::stoul(argv[2]) : 5;
+
+    std::string mainDir = "/tmp/results-sender-benchmark";
+    std::string intermediaryFile = mainDir + "/xdr-inter";
+    std::string datafeedOutputDir = mainDir + "/datafeed";
+    std::string pluginVarDir = mainDir + "/var";
+    std::string queryPack = mainDir + "/querypack.conf";
+    std::string mtrQueryPack = mainDir + "/querypack.mtr.conf";
+    std::string customQueryPack = mainDir + "/querypack.custom.conf";
+    const unsigned long long DATA_LIMIT_BYTES = 1000000000000; // Large enough that the limit is never hit.
+    const unsigned int PERIOD_SECONDS = 1000000000;
+
+    Common::Logging::ConsoleLoggingSetup loggingSetup;
+
+    auto fs = Common::FileSystem::fileSystem();
+    fs->makedirs(datafeedOutputDir);
+    fs->makedirs(pluginVarDir);
+    fs->writeFile(queryPack, BENCHMARK_QUERY_PACK);
+    fs->writeFile(mtrQueryPack, "{}");
+
+    ResultsSender resultsSender(
+        intermediaryFile,
+        datafeedOutputDir,
+        queryPack,
+        mtrQueryPack,
+        customQueryPack,
+        pluginVarDir,
+        DATA_LIMIT_BYTES,
+        PERIOD_SECONDS,
+        []() {});
+
+    uintmax_t bytesWritten = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long batch = 0; batch < batches; ++batch)
+    {
+        resultsSender.Reset();
+        uintmax_t batchSize = 0;
+        for (unsigned long row = 0; row < rowsPerBatch; ++row)
+        {
+            auto preparedRow = resultsSender.PrepareSingleResult(makeRow(row));
+            if (preparedRow)
+            {
+                resultsSender.Add(preparedRow.value());
+            }
+            batchSize = resultsSender.GetFileSize();
+        }
+        bytesWritten += batchSize;
+        resultsSender.Send();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned long totalRows = rowsPerBatch * batches;
+    std::cout << "Rows: " << totalRows << " in " << batches << " batches" << std::endl;
+    std::cout << "Elapsed: " << elapsed << " s" << std::endl;
+    std::cout << "Throughput: " << static_cast<double>(totalRows) / elapsed << " rows/s, "
+              << static_cast<double>(bytesWritten) / elapsed / (1024 * 1024) << " MiB/s" << std::endl;
+
+    for (const auto& file : fs->listFiles(datafeedOutputDir))
+    {
+        fs->removeFile(file);
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "edr/tests/EdrCommon/MockOsqueryClient.h"
+
+#include "osqueryclient/OsqueryClientPool.h"
+#include "osqueryclient/OsqueryProcessor.h"
+
+#ifdef SPL_BAZEL
+#include "tests/Common/Helpers/LogInitializedTests.h"
+#else
+#include "Common/Helpers/LogInitializedTests.h"
+#endif
+
+#include <thrift/transport/TTransportException.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace ::testing;
+
+namespace
+{
+    class TestOsqueryClientPool : public LogOffInitializedTests
+    {
+    public:
+        TestOsqueryClientPool()
+        {
+            osqueryclient::factory().replace(
+                [this]()
+                {
+                    m_clientsCreated++;
+                    auto client = std::make_unique<NiceMock<MockIOsqueryClient>>();
+                    if (m_setupClient)
+                    {
+                        m_setupClient(*client);
+                    }
+                    return client;
+                });
+        }
+
+        ~TestOsqueryClientPool() override
+        {
+            osqueryclient::factory().restore();
+        }
+
+        int m_clientsCreated = 0;
+        std::atomic_bool m_cancelled{ false };
+        std::function<void(MockIOsqueryClient&)> m_setupClient;
+    };
+} // namespace
+
+TEST_F(TestOsqueryClientPool, connectionIsKeptForTheNextQuery)
+{
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 2, std::chrono::seconds(600) };
+    {
+        auto lease = pool.acquire(std::chrono::milliseconds(0), m_cancelled);
+        EXPECT_FALSE(lease.reused());
+    }
+    {
+        auto lease = pool.acquire(std::chrono::milliseconds(0), m_cancelled);
+        EXPECT_TRUE(lease.reused());
+    }
+    EXPECT_EQ(m_clientsCreated, 1);
+    EXPECT_EQ(pool.idleClients(), 1);
+}
+
+TEST_F(TestOsqueryClientPool, numberOfConnectionsIsBounded)
+{
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 1, std::chrono::seconds(600) };
+    auto lease = pool.acquire(std::chrono::milliseconds(0), m_cancelled);
+    EXPECT_THROW(
+        pool.acquire(std::chrono::milliseconds(10), m_cancelled), osqueryclient::FailedToStablishConnectionException);
+    EXPECT_EQ(m_clientsCreated, 1);
+}
+
+TEST_F(TestOsqueryClientPool, discardedConnectionIsReplaced)
+{
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 1, std::chrono::seconds(600) };
+    {
+        auto lease = pool.acquire(std::chrono::milliseconds(0), m_cancelled);
+        lease.discard();
+    }
+    EXPECT_EQ(pool.idleClients(), 0);
+    auto lease = pool.acquire(std::chrono::milliseconds(0), m_cancelled);
+    EXPECT_FALSE(lease.reused());
+    EXPECT_EQ(m_clientsCreated, 2);
+}
+
+TEST_F(TestOsqueryClientPool, failureToConnectFreesTheSlot)
+{
+    m_setupClient = [](MockIOsqueryClient& client)
+    {
+        EXPECT_CALL(client, connect(_, _))
+            .WillOnce(Throw(osqueryclient::FailedToStablishConnectionException("Could not connect")));
+    };
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 1, std::chrono::seconds(600) };
+    EXPECT_THROW(
+        pool.acquire(std::chrono::milliseconds(0), m_cancelled), osqueryclient::FailedToStablishConnectionException);
+    EXPECT_THROW(
+        pool.acquire(std::chrono::milliseconds(0), m_cancelled), osqueryclient::FailedToStablishConnectionException);
+    EXPECT_EQ(m_clientsCreated, 2);
+}
+
+TEST_F(TestOsqueryClientPool, cancelledWaitGivesUpWithoutAffectingOtherQueries)
+{
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 1, std::chrono::seconds(600) };
+    auto lease = std::make_unique<osqueryclient::OsqueryClientPool::Lease>(
+        pool.acquire(std::chrono::milliseconds(0), m_cancelled));
+
+    std::atomic_bool cancelled{ false };
+    auto waiting = std::async(
+        std::launch::async,
+        [&pool, &cancelled]() { pool.acquire(std::chrono::seconds(60), cancelled); });
+    cancelled = true;
+    pool.interruptWaits();
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_THROW(waiting.get(), osqueryclient::FailedToStablishConnectionException);
+
+    lease.reset();
+    EXPECT_TRUE(pool.acquire(std::chrono::milliseconds(0), m_cancelled).reused());
+}
+
+TEST_F(TestOsqueryClientPool, staleConnectionIsRetriedOnANewConnection)
+{
+    int clientNumber = 0;
+    m_setupClient = [&clientNumber](MockIOsqueryClient& client)
+    {
+        if (clientNumber++ == 0)
+        {
+            // second query, on the kept connection, finds osquery has been restarted
+            EXPECT_CALL(client, query(_, _))
+                .WillOnce(Return(OsquerySDK::Status{ 0, "" }))
+                .WillOnce(Throw(apache::thrift::transport::TTransportException(
+                    apache::thrift::transport::TTransportException::END_OF_FILE)));
+        }
+        else
+        {
+            ON_CALL(client, query(_, _)).WillByDefault(Return(OsquerySDK::Status{ 0, "" }));
+        }
+        ON_CALL(client, getQueryColumns(_, _)).WillByDefault(Return(OsquerySDK::Status{ 0, "" }));
+    };
+    auto pool = std::make_shared<osqueryclient::OsqueryClientPool>("/fake/osquery.sock", 1, std::chrono::seconds(600));
+    osqueryclient::OsqueryProcessor processor{ pool, 0 };
+
+    EXPECT_EQ(processor.query("select 1").status().errorCode(), livequery::ErrorCode::SUCCESS);
+    EXPECT_EQ(processor.query("select 1").status().errorCode(), livequery::ErrorCode::SUCCESS);
+    EXPECT_EQ(m_clientsCreated, 2);
+}
+
+TEST_F(TestOsqueryClientPool, timedOutQueryFreesItsConnection)
+{
+    int clientNumber = 0;
+    m_setupClient = [&clientNumber](MockIOsqueryClient& client)
+    {
+        // The connection timeout is what stops a call osquery never answers
+        EXPECT_CALL(client, connect(_, std::chrono::seconds(600)));
+        if (clientNumber++ == 0)
+        {
+            EXPECT_CALL(client, query(_, _))
+                .WillOnce(Throw(apache::thrift::transport::TTransportException(
+                    apache::thrift::transport::TTransportException::TIMED_OUT)));
+        }
+    };
+    auto pool = std::make_shared<osqueryclient::OsqueryClientPool>("/fake/osquery.sock", 1, std::chrono::seconds(600));
+    osqueryclient::OsqueryProcessor processor{ pool, 0 };
+
+    EXPECT_EQ(processor.query("select 1").status().errorCode(), livequery::ErrorCode::EXTENSIONEXITEDWHILERUNNING);
+    EXPECT_EQ(pool->idleClients(), 0);
+    EXPECT_FALSE(pool->acquire(std::chrono::milliseconds(0), m_cancelled).reused());
+    EXPECT_EQ(m_clientsCreated, 2);
+}
+
+TEST_F(TestOsqueryClientPool, keptQueryThreadsAreJoined)
+{
+    osqueryclient::OsqueryClientPool pool{ "/fake/osquery.sock", 1, std::chrono::seconds(600) };
+    auto release = std::make_shared<std::promise<void>>();
+    std::atomic_bool finished{ false };
+    std::thread queryThread{ [release, &finished]()
+                             {
+                                 release->get_future().wait();
+                                 finished = true;
+                             } };
+    pool.keepQueryThread(std::move(queryThread), [&finished]() { return finished.load(); });
+
+    release->set_value();
+    pool.joinQueryThreads();
+    EXPECT_TRUE(finished);
+}
+
+TEST_F(TestOsqueryClientPool, responseLargerThanSizeLimitIsReportedAsExceeded)
+{
+    OsquerySDK::QueryData queryData;
+    queryData.push_back({ { "name", std::string(100, 'a') } });
+    queryData.push_back({ { "name", std::string(100, 'b') } });
+    m_setupClient = [&queryData](MockIOsqueryClient& client)
+    {
+        EXPECT_CALL(client, query(_, _))
+            .WillOnce(DoAll(SetArgReferee<1>(queryData), Return(OsquerySDK::Status{ 0, "" })));
+        EXPECT_CALL(client, getQueryColumns(_, _)).WillOnce(Return(OsquerySDK::Status{ 0, "" }));
+    };
+    auto pool = std::make_shared<osqueryclient::OsqueryClientPool>("/fake/osquery.sock", 1, std::chrono::seconds(600));
+    osqueryclient::OsqueryProcessor processor{ pool, 150 };
+
+    auto response = processor.query("select name from processes");
+    EXPECT_EQ(response.status().errorCode(), livequery::ErrorCode::RESPONSEEXCEEDLIMIT);
+    EXPECT_TRUE(response.data().hasDataExceededLimit());
+    EXPECT_TRUE(response.data().columnData().empty());
+}
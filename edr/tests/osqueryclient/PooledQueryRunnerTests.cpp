@@ -0,0 +1,108 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "edr/tests/EdrCommon/MockOsqueryClient.h"
+
+#include "osqueryclient/OsqueryClientPool.h"
+#include "osqueryclient/PooledQueryRunner.h"
+
+#ifdef SPL_BAZEL
+#include "tests/Common/Helpers/LogInitializedTests.h"
+#else
+#include "Common/Helpers/LogInitializedTests.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+
+using namespace ::testing;
+
+namespace
+{
+    const std::string QUERY = R"({"type": "sophos.mgt.action.RunLiveQuery", "name": "test", "query": "select 1"})";
+
+    class TestPooledQueryRunner : public LogOffInitializedTests
+    {
+    public:
+        TestPooledQueryRunner()
+        {
+            osqueryclient::factory().replace(
+                [this]()
+                {
+                    auto client = std::make_unique<NiceMock<MockIOsqueryClient>>();
+                    if (m_setupClient)
+                    {
+                        m_setupClient(*client);
+                    }
+                    return client;
+                });
+        }
+
+        ~TestPooledQueryRunner() override
+        {
+            // Queries left running by destroyed runners still use the mocks
+            m_pool->joinQueryThreads();
+            osqueryclient::factory().restore();
+        }
+
+        std::function<void(MockIOsqueryClient&)> m_setupClient;
+        std::atomic_bool m_notCancelled{ false };
+        std::shared_ptr<osqueryclient::OsqueryClientPool> m_pool =
+            std::make_shared<osqueryclient::OsqueryClientPool>("/fake/osquery.sock", 1, std::chrono::seconds(600));
+    };
+} // namespace
+
+TEST_F(TestPooledQueryRunner, abortStopsAQueryWaitingForTheSharedPool)
+{
+    auto lease = std::make_unique<osqueryclient::OsqueryClientPool::Lease>(
+        m_pool->acquire(std::chrono::milliseconds(0), m_notCancelled));
+
+    osqueryclient::PooledQueryRunner runner{ m_pool, 1024 };
+    std::promise<void> finished;
+    runner.triggerQuery("correlation", QUERY, [&finished](const std::string&) { finished.set_value(); });
+    runner.requestAbort();
+
+    ASSERT_EQ(finished.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_NE(runner.getResult().errorCode, livequery::ErrorCode::SUCCESS);
+
+    // The pool is still usable by the other queries
+    lease.reset();
+    EXPECT_TRUE(m_pool->acquire(std::chrono::milliseconds(0), m_notCancelled).reused());
+}
+
+TEST_F(TestPooledQueryRunner, destructionDoesNotWaitForAQueryStuckInOsquery)
+{
+    auto releaseQuery = std::make_shared<std::promise<void>>();
+    auto queryDone = std::make_shared<std::promise<void>>();
+    m_setupClient = [releaseQuery, queryDone](MockIOsqueryClient& client)
+    {
+        ON_CALL(client, query(_, _))
+            .WillByDefault(Invoke(
+                [releaseQuery](const std::string&, OsquerySDK::QueryData&)
+                {
+                    releaseQuery->get_future().wait();
+                    return OsquerySDK::Status{ 0, "" };
+                }));
+        ON_CALL(client, getQueryColumns(_, _))
+            .WillByDefault(Invoke(
+                [queryDone](const std::string&, OsquerySDK::QueryColumns&)
+                {
+                    queryDone->set_value();
+                    return OsquerySDK::Status{ 0, "" };
+                }));
+    };
+
+    std::atomic_bool notified{ false };
+    auto start = std::chrono::steady_clock::now();
+    {
+        osqueryclient::PooledQueryRunner runner{ m_pool, 1024 };
+        runner.triggerQuery("correlation", QUERY, [&notified](const std::string&) { notified = true; });
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+
+    // Once it completes the query must not report back to the owner of the destroyed runner
+    releaseQuery->set_value();
+    ASSERT_EQ(queryDone->get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_FALSE(notified);
+}
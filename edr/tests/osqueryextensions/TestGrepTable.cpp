@@ -0,0 +1,153 @@
+// Copyright 2024 Sophos Limited. All rights reserved.
+
+#include "MockQueryContext.h"
+
+#include "osqueryextensions/GrepTable.h"
+
+#ifdef SPL_BAZEL
+#include "tests/Common/Helpers/LogInitializedTests.h"
+#include "tests/Common/Helpers/TempDir.h"
+#else
+#include "Common/Helpers/LogInitializedTests.h"
+#include "Common/Helpers/TempDir.h"
+#endif
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+namespace
+{
+    class TestGrepTable : public LogOffInitializedTests
+    {
+    protected:
+        void expectQuery(const std::string& path, const std::string& pattern)
+        {
+            ON_CALL(context_, GetConstraints("path", EQUALS)).WillByDefault(Return(std::set<std::string>{ path }));
+            ON_CALL(context_, GetConstraints("pattern", EQUALS))
+                .WillByDefault(Return(pattern.empty() ? std::set<std::string>{} : std::set<std::string>{ pattern }));
+            ON_CALL(context_, IsColumnUsed(_)).WillByDefault(Return(true));
+        }
+
+        static std::vector<std::string> lines(const TableRows& rows)
+        {
+            std::vector<std::string> result;
+            for (const auto& row : rows)
+            {
+                result.push_back(row.at("line"));
+            }
+            return result;
+        }
+
+        Tests::TempDir tempDir_{ "/tmp" };
+        NiceMock<MockQueryContext> context_;
+    };
+} // namespace
+
+TEST_F(TestGrepTable, returnsMatchingLinesFromFile)
+{
+    tempDir_.createFile("file.log", "first line\nsecond match\n\nthird match");
+    expectQuery(tempDir_.absPath("file.log"), "match");
+
+    auto rows = OsquerySDK::GrepTable().Generate(context_);
+
+    ASSERT_EQ(rows.size(), 2);
+    EXPECT_EQ(rows[0].at("path"), tempDir_.absPath("file.log"));
+    EXPECT_EQ(rows[0].at("filepath"), tempDir_.absPath("file.log"));
+    EXPECT_EQ(rows[0].at("pattern"), "match");
+    EXPECT_EQ(lines(rows), (std::vector<std::string>{ "second match", "third match" }));
+}
+
+TEST_F(TestGrepTable, emptyPatternReturnsEveryLineLikeGetline)
+{
+    tempDir_.createFile("file.log", "a\n\nb\r\n");
+    expectQuery(tempDir_.absPath("file.log"), "");
+
+    auto rows = OsquerySDK::GrepTable().Generate(context_);
+
+    EXPECT_EQ(lines(rows), (std::vector<std::string>{ "a", "", "b\r" }));
+}
+
+TEST_F(TestGrepTable, linesOfMaxLineLengthOrLongerAreSkipped)
+{
+    std::string longLine(MAX_LINE_LENGTH, 'x');
+    std::string shortLine(MAX_LINE_LENGTH - 1, 'x');
+    tempDir_.createFile("file.log", longLine + "\n" + shortLine + "\n" + longLine);
+    expectQuery(tempDir_.absPath("file.log"), "x");
+
+    auto rows = OsquerySDK::GrepTable().Generate(context_);
+
+    EXPECT_EQ(lines(rows), (std::vector<std::string>{ shortLine }));
+}
+
+TEST_F(TestGrepTable, unusedColumnsAreNotPopulated)
+{
+    tempDir_.createFile("file.log", "match\n");
+    expectQuery(tempDir_.absPath("file.log"), "match");
+    EXPECT_CALL(context_, IsColumnUsed(_)).WillRepeatedly(Return(false));
+    EXPECT_CALL(context_, IsColumnUsed("line")).WillRepeatedly(Return(true));
+
+    auto rows = OsquerySDK::GrepTable().Generate(context_);
+
+    ASSERT_EQ(rows.size(), 1);
+    EXPECT_EQ(rows[0], (TableRow{ { "line", "match" } }));
+}
+
+TEST_F(TestGrepTable, chunkedFileGivesSameRowsInSameOrder)
+{
+    std::string content;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 1000; ++i)
+    {
+        std::string line = "line " + std::to_string(i) + (i % 3 == 0 ? " match" : "");
+        content += line + "\n";
+        if (i % 3 == 0)
+        {
+            expected.push_back(line);
+        }
+    }
+    tempDir_.createFile("file.log", content);
+    expectQuery(tempDir_.absPath("file.log"), "match");
+
+    // Chunks far smaller than a line force every boundary case
+    for (size_t chunkBytes : { 1, 7, 64, 4096 })
+    {
+        auto rows = OsquerySDK::GrepTable(4, chunkBytes).Generate(context_);
+        EXPECT_EQ(lines(rows), expected) << "chunk size " << chunkBytes;
+    }
+}
+
+TEST_F(TestGrepTable, directoryFilesAreAllSearchedAndReturnedInListingOrder)
+{
+    for (int i = 0; i < 20; ++i)
+    {
+        tempDir_.createFile("logs/file" + std::to_string(i), "no\nmatch " + std::to_string(i) + "\n");
+    }
+    expectQuery(tempDir_.absPath("logs"), "match");
+
+    auto singleThreaded = OsquerySDK::GrepTable(1, GREP_CHUNK_BYTES).Generate(context_);
+    auto multiThreaded = OsquerySDK::GrepTable(4, GREP_CHUNK_BYTES).Generate(context_);
+
+    EXPECT_EQ(singleThreaded.size(), 20);
+    EXPECT_EQ(singleThreaded, multiThreaded);
+    for (const auto& row : multiThreaded)
+    {
+        EXPECT_EQ(row.at("path"), tempDir_.absPath("logs"));
+        EXPECT_EQ(row.at("line"), "match " + row.at("filepath").substr(row.at("filepath").rfind("file") + 4));
+    }
+}
+
+TEST_F(TestGrepTable, emptyFileReturnsNoRows)
+{
+    tempDir_.createFile("file.log", "");
+    expectQuery(tempDir_.absPath("file.log"), "");
+
+    EXPECT_TRUE(OsquerySDK::GrepTable().Generate(context_).empty());
+}
+
+TEST_F(TestGrepTable, missingPathReturnsNoRows)
+{
+    expectQuery(tempDir_.absPath("missing"), "match");
+
+    EXPECT_TRUE(OsquerySDK::GrepTable().Generate(context_).empty());
+}
@@ -16,6 +16,7 @@
 #include "Common/Helpers/FileSystemReplaceAndRestore.h"
 #endif
 
+#include "Common/FileSystem/IFileSystemException.h"
 #include "Common/TelemetryHelperImpl/TelemetryHelper.h"
 
 #include <gtest/gtest.h>
@@ -308,9 +309,44 @@ TEST_F(TestResultSender, resetRemovesExistingBatchFile)
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
 
+    std::stringbuf batchFile;
     EXPECT_CALL(*mockFileSystem, removeFile(INTERMEDIARY_PATH)).Times(1);
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, "[")).Times(1);
+    EXPECT_CALL(*mockFileSystem, openFileForWrite(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
     resultsSender.Reset();
+    EXPECT_EQ(batchFile.str(), "[");
+}
+
+TEST_F(TestResultSender, addAfterResetWritesToOpenBatchFileAndTracksSize)
+{
+    auto mockFileSystem = new ::testing::StrictMock<MockFileSystem>();
+    Tests::replaceFileSystem(std::unique_ptr<Common::FileSystem::IFileSystem> { mockFileSystem });
+    std::string testResult = R"({"name":"","test":"value"})";
+    ResultSenderForUnitTests::mockNoQueryPack(mockFileSystem);
+    ResultSenderForUnitTests::mockPersistentValues(mockFileSystem);
+    bool callbackCalled = false;
+    ResultsSender resultsSender(
+        INTERMEDIARY_PATH,
+        DATAFEED_PATH,
+        QUERY_PACK_PATH,
+        MTR_QUERY_PACK_PATH,
+        CUSTOM_QUERY_PACK_PATH,
+        PLUGIN_VAR_DIR,
+        DATA_LIMIT,
+        PERIOD_IN_SECONDS,
+        [&callbackCalled]()mutable{callbackCalled = true;});
+
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForWrite(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
+    resultsSender.Reset();
+
+    // Neither adding nor sizing the batch should reopen or stat the file
+    resultsSender.Add(testResult);
+    resultsSender.Add(testResult);
+    EXPECT_EQ(batchFile.str(), "[" + testResult + "," + testResult);
+    EXPECT_EQ(resultsSender.GetFileSize(), batchFile.str().size() + 2);
 }
 
 TEST_F(TestResultSender, addWritesToFile)
@@ -332,8 +368,12 @@ TEST_F(TestResultSender, addWritesToFile)
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
 
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, testResult)).Times(1);
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
     resultsSender.Add(testResult);
+    EXPECT_EQ(batchFile.str(), testResult);
 }
 
 TEST_F(TestResultSenderWithLogger, addDoesNotRegenTagMap)
@@ -362,10 +402,13 @@ TEST_F(TestResultSenderWithLogger, addDoesNotRegenTagMap)
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
 
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, testResult)).Times(1);
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, "," + testResult)).Times(1);
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
     resultsSender.Add(testResult);
     resultsSender.Add(testResult);
+    EXPECT_EQ(batchFile.str(), testResult + "," + testResult);
     std::string logMessage = testing::internal::GetCapturedStderr();
     std::string alreadyInQueryMapLogLine = "already in query map";
     EXPECT_THAT(logMessage, ::testing::HasSubstr(alreadyInQueryMapLogLine));
@@ -399,10 +442,13 @@ TEST_F(TestResultSender, addAppendsToFileExistinEntries)
         [&callbackCalled]()mutable{callbackCalled = true;});
     std::string testResultString1 = R"({"name":"","test":"value"})";
     std::string testResultString2 = R"({"name":"","test2":"value2"})";
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, testResultString1)).Times(1);
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, "," + testResultString2)).Times(1);
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
     resultsSender.Add(testResultString1);
     resultsSender.Add(testResultString2);
+    EXPECT_EQ(batchFile.str(), testResultString1 + "," + testResultString2);
 }
 
 TEST_F(TestResultSender, addingInvalidJsonLogsErrorButNoExceptionThrown)
@@ -422,7 +468,7 @@ TEST_F(TestResultSender, addingInvalidJsonLogsErrorButNoExceptionThrown)
         DATA_LIMIT,
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
-    EXPECT_CALL(*mockFileSystem, appendFile(_, _)).Times(0);
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(_)).Times(0);
     EXPECT_NO_THROW(resultsSender.PrepareSingleResult(R"(not json)"));
 }
 
@@ -443,10 +489,35 @@ TEST_F(TestResultSender, addThrowsWhenAppendThrows)
         DATA_LIMIT,
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
-    EXPECT_CALL(*mockFileSystem, appendFile(_, _)).WillOnce(Throw(std::runtime_error("TEST")));
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(_)).WillOnce(Throw(std::runtime_error("TEST")));
     EXPECT_THROW(resultsSender.Add("{\"test\":\"value\"}"), std::runtime_error);
 }
 
+TEST_F(TestResultSender, addThrowsWhenBatchStreamFails)
+{
+    auto mockFileSystem = new ::testing::StrictMock<MockFileSystem>();
+    Tests::replaceFileSystem(std::unique_ptr<Common::FileSystem::IFileSystem> { mockFileSystem });
+    ResultSenderForUnitTests::mockNoQueryPack(mockFileSystem);
+    ResultSenderForUnitTests::mockPersistentValues(mockFileSystem);
+    bool callbackCalled = false;
+    ResultsSender resultsSender(
+        INTERMEDIARY_PATH,
+        DATAFEED_PATH,
+        QUERY_PACK_PATH,
+        MTR_QUERY_PACK_PATH,
+        CUSTOM_QUERY_PACK_PATH,
+        PLUGIN_VAR_DIR,
+        DATA_LIMIT,
+        PERIOD_IN_SECONDS,
+        [&callbackCalled]()mutable{callbackCalled = true;});
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    // A stream without a buffer fails every write
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(_))
+        .WillOnce(Invoke([](const Path&) { return std::make_unique<std::ostream>(nullptr); }));
+    EXPECT_THROW(resultsSender.Add("{\"test\":\"value\"}"), Common::FileSystem::IFileSystemException);
+}
+
 TEST_F(TestResultSender, getFileSizeQueriesFile)
 {
     auto mockFileSystem = new ::testing::StrictMock<MockFileSystem>();
@@ -599,6 +670,44 @@ TEST_F(TestResultSender, sendThrowsWhenFileMoveThrows)
     EXPECT_THROW(resultsSender.Send(), std::runtime_error);
 }
 
+TEST_F(TestResultSender, sendStoresDataUsageOnlyWhenItHasChanged)
+{
+    auto mockFileSystem = new ::testing::StrictMock<MockFileSystem>();
+    Tests::replaceFileSystem(std::unique_ptr<Common::FileSystem::IFileSystem> { mockFileSystem });
+
+    auto mockFilePermissions = new ::testing::NiceMock<MockFilePermissions>();
+    Tests::replaceFilePermissions(std::unique_ptr<Common::FileSystem::IFilePermissions>{mockFilePermissions});
+
+    ResultSenderForUnitTests::mockNoQueryPack(mockFileSystem);
+    ResultSenderForUnitTests::mockPersistentValues(mockFileSystem);
+    bool callbackCalled = false;
+    ResultsSender resultsSender(
+        INTERMEDIARY_PATH,
+        DATAFEED_PATH,
+        QUERY_PACK_PATH,
+        MTR_QUERY_PACK_PATH,
+        CUSTOM_QUERY_PACK_PATH,
+        PLUGIN_VAR_DIR,
+        DATA_LIMIT,
+        PERIOD_IN_SECONDS,
+        [&callbackCalled]()mutable{callbackCalled = true;});
+
+    std::string testResult = R"({"name":"","test":"value"})";
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false)).WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
+    resultsSender.Add(resultsSender.PrepareSingleResult(testResult).value());
+
+    EXPECT_CALL(*mockFileSystem, writeFile(PLUGIN_VAR_DIR + "/persist-xdrDataUsage", std::to_string(testResult.size())))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*mockFileSystem, writeFile(PLUGIN_VAR_DIR + "/persist-xdrLimitHit", "0")).RetiresOnSaturation();
+    EXPECT_CALL(*mockFileSystem, moveFile(INTERMEDIARY_PATH, StartsWith(DATAFEED_PATH + "/scheduled_query"))).Times(2);
+    resultsSender.Send();
+    resultsSender.Send();
+    EXPECT_EQ(batchFile.str(), testResult);
+}
+
 TEST_F(TestResultSender, FirstAddFailureDoesNotAddCommaNext)
 {
     auto mockFileSystem = new ::testing::StrictMock<MockFileSystem>();
@@ -617,12 +726,15 @@ TEST_F(TestResultSender, FirstAddFailureDoesNotAddCommaNext)
         PERIOD_IN_SECONDS,
         [&callbackCalled]()mutable{callbackCalled = true;});
     std::string testJsonResult = R"({"name":"","test":"value"})";
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, testJsonResult))
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).Times(2).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
         .Times(2)
         .WillOnce(Throw(std::runtime_error("TEST")))
-        .WillOnce(Return());
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
     EXPECT_THROW(resultsSender.Add(testJsonResult), std::runtime_error);
     resultsSender.Add(testJsonResult);
+    EXPECT_EQ(batchFile.str(), testJsonResult);
 }
 
 TEST_F(TestResultSender, dataLimitHitInSingleResultInvokesCallback)
@@ -659,9 +771,10 @@ TEST_F(TestResultSender, dataLimitHitGraduallyInvokesCallback)
     std::string testResult = R"({"name":"","test":"value"})";
     int callbackCount = 0;
     int timesToAddResult = 5;
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, "{\"name\":\"\",\"test\":\"value\"}")).Times(1);
-    // -1 here because of the first result without a "," being added above
-    EXPECT_CALL(*mockFileSystem, appendFile(INTERMEDIARY_PATH, ",{\"name\":\"\",\"test\":\"value\"}")).Times(timesToAddResult-1);
+    std::stringbuf batchFile;
+    EXPECT_CALL(*mockFileSystem, exists(INTERMEDIARY_PATH)).WillOnce(Return(false));
+    EXPECT_CALL(*mockFileSystem, openFileForAppend(INTERMEDIARY_PATH))
+        .WillOnce(Invoke([&batchFile](const Path&) { return std::make_unique<std::ostream>(&batchFile); }));
 
     ResultsSender resultsSender(
         INTERMEDIARY_PATH,
@@ -681,6 +794,7 @@ TEST_F(TestResultSender, dataLimitHitGraduallyInvokesCallback)
     }
 
     ASSERT_EQ(callbackCount, 1);
+    EXPECT_EQ(batchFile.str(), testResult + "," + testResult + "," + testResult + "," + testResult + "," + testResult);
 }
 
 TEST_F(TestResultSenderWithLogger, maxBatchSizeHitInSingleResultInvokesCallback)
@@ -1,4 +1,4 @@
-// Copyright 2021-2023 Sophos Limited. All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #include "EdrCommon/ApplicationPaths.h"
 #include "pluginimpl/PluginUtils.h"
@@ -527,4 +527,44 @@ TEST_F(TestPluginUtilsWithStrictMockFileSystem, testEnableCustomQueries)
     bool restartNeeded2 = false;
     Plugin::PluginUtils::enableCustomQueries("content", restartNeeded2, true);
     EXPECT_TRUE(restartNeeded2);
-}
\ No newline at end of file
+}
+
+TEST_F(TestPluginUtils, liveQueryWorkerPoolSizeIsReadFromPluginConf)
+{
+    Tests::TempDir tempDir("/tmp");
+    tempDir.createFile("plugins/edr/etc/plugin.conf", "livequery_worker_pool_size=4\n");
+    Common::ApplicationConfiguration::applicationConfiguration().setData(
+            Common::ApplicationConfiguration::SOPHOS_INSTALL, tempDir.dirPath());
+
+    EXPECT_EQ(Plugin::PluginUtils::getLiveQueryWorkerPoolSizeFromConfig(), 4u);
+}
+
+TEST_F(TestPluginUtils, liveQueryWorkerPoolSizeIsCapped)
+{
+    Tests::TempDir tempDir("/tmp");
+    tempDir.createFile("plugins/edr/etc/plugin.conf", "livequery_worker_pool_size=1000\n");
+    Common::ApplicationConfiguration::applicationConfiguration().setData(
+            Common::ApplicationConfiguration::SOPHOS_INSTALL, tempDir.dirPath());
+
+    EXPECT_EQ(Plugin::PluginUtils::getLiveQueryWorkerPoolSizeFromConfig(), 16u);
+}
+
+TEST_F(TestPluginUtils, liveQueryWorkerPoolIsDisabledByDefault)
+{
+    Tests::TempDir tempDir("/tmp");
+    tempDir.createFile("plugins/edr/etc/plugin.conf", "running_mode=0\n");
+    Common::ApplicationConfiguration::applicationConfiguration().setData(
+            Common::ApplicationConfiguration::SOPHOS_INSTALL, tempDir.dirPath());
+
+    EXPECT_EQ(Plugin::PluginUtils::getLiveQueryWorkerPoolSizeFromConfig(), 0u);
+}
+
+TEST_F(TestPluginUtils, liveQueryWorkerPoolIsDisabledWhenSizeIsNotAnInteger)
+{
+    Tests::TempDir tempDir("/tmp");
+    tempDir.createFile("plugins/edr/etc/plugin.conf", "livequery_worker_pool_size=many\n");
+    Common::ApplicationConfiguration::applicationConfiguration().setData(
+            Common::ApplicationConfiguration::SOPHOS_INSTALL, tempDir.dirPath());
+
+    EXPECT_EQ(Plugin::PluginUtils::getLiveQueryWorkerPoolSizeFromConfig(), 0u);
+}
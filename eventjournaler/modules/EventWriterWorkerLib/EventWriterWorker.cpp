@@ -1,4 +1,4 @@
-// Copyright 2021-2023 Sophos Limited. All rights reserved.
+// Copyright 2021-2024 Sophos Limited. All rights reserved.
 
 #include "EventWriterWorker.h"
 #include "Logger.h"
@@ -14,6 +14,24 @@
 
 static constexpr uint ACCEPTABLE_DAILY_DROPPED_EVENTS = 5;
 
+namespace
+{
+    // Counted for every event, so the keys are only looked up once
+    Common::Telemetry::TelemetryCounter& attemptedJournalWrites()
+    {
+        static auto counter = Common::Telemetry::TelemetryHelper::getInstance().registerCounter(
+            JournalerCommon::Telemetry::telemetryAttemptedJournalWrites);
+        return counter;
+    }
+
+    Common::Telemetry::TelemetryCounter& failedEventWrites()
+    {
+        static auto counter = Common::Telemetry::TelemetryHelper::getInstance().registerCounter(
+            JournalerCommon::Telemetry::telemetryFailedEventWrites);
+        return counter;
+    }
+} // namespace
+
 namespace EventWriterLib
 {
     EventWriterWorker::EventWriterWorker::EventWriterWorker(
@@ -140,8 +158,7 @@ namespace EventWriterLib
 
     void EventWriterWorker::writeEvent(const JournalerCommon::Event& event)
     {
-        auto& telemetry = Common::Telemetry::TelemetryHelper::getInstance();
-        telemetry.increment(JournalerCommon::Telemetry::telemetryAttemptedJournalWrites, 1L);
+        attemptedJournalWrites().increment();
         const std::string& journalSubType = JournalerCommon::EventTypeToJournalJsonSubtypeMap.at(event.type);
         EventJournal::Detection detection{ journalSubType, event.data };
         auto encodedDetection = EventJournal::encode(detection);
@@ -153,7 +170,7 @@ namespace EventWriterLib
         {
             LOGERROR("Failed to store " << journalSubType << " event in journal: " << ex.what());
             m_heartbeatPinger->pushDroppedEvent();
-            telemetry.increment(JournalerCommon::Telemetry::telemetryFailedEventWrites, 1L);
+            failedEventWrites().increment();
         }
     }
 